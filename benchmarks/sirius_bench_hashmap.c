@@ -0,0 +1,273 @@
+/**
+ * @name sirius_bench_hashmap.c
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief hash map against glibc hsearch_r
+ * 
+ * @details
+ * sirius_bench_hashmap [-n keys] [-t threads]
+ * 
+ * `keys` keys are inserted, then looked up once each as hits and as
+ * misses; string keys are also run through `hsearch_r`, sized for
+ * them up front since it cannot grow. at last `threads` threads look
+ * up integer keys in a map with stripes while one thread writes.
+ */
+
+#define _GNU_SOURCE
+
+#include "sirius_hashmap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <search.h>
+#include <pthread.h>
+
+/* default keys */
+#define I_BENCH_KEYS_DEF    (1000000UL)
+/* default reader threads */
+#define I_BENCH_THREADS_DEF (4U)
+/* lookups per reader thread */
+#define I_BENCH_READS       (4000000UL)
+
+static volatile size_t g_sink;
+
+static uint64_t
+i_bench_mono()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* scattered keys, also formatted as session ids; a miss is an odd one */
+static inline uint64_t
+i_bench_key(unsigned long i)
+{
+    return (uint64_t)i * 0x9e3779b97f4a7c16ULL;
+}
+
+static void
+i_bench_row(const char *p_name, uint64_t t, unsigned long n)
+{
+    printf("%-28s %10.2f\n", p_name, (double)t / n);
+}
+
+static void
+i_bench_int(unsigned long n)
+{
+    sirius_hashmap_cr_t cr = {0};
+    cr.key_type = SIRIUS_HASHMAP_KEY_INT;
+    sirius_hashmap_handle h;
+    if (sirius_hashmap_cr(&cr, &h)) return;
+
+    uint64_t t0 = i_bench_mono();
+    for (unsigned long i = 0; i < n; i++) {
+        sirius_hashmap_put_int(h, i_bench_key(i), i);
+    }
+    i_bench_row("int put", i_bench_mono() - t0, n);
+
+    size_t v = 0;
+    t0 = i_bench_mono();
+    for (unsigned long i = 0; i < n; i++) {
+        sirius_hashmap_get_int(h, i_bench_key(i), &v);
+        g_sink = v;
+    }
+    i_bench_row("int get hit", i_bench_mono() - t0, n);
+
+    t0 = i_bench_mono();
+    for (unsigned long i = 0; i < n; i++) {
+        g_sink = sirius_hashmap_get_int(h, i_bench_key(i) | 1, &v);
+    }
+    i_bench_row("int get miss", i_bench_mono() - t0, n);
+
+    sirius_hashmap_del(h);
+}
+
+static void
+i_bench_str(char **pp_keys, char **pp_miss, unsigned long n)
+{
+    sirius_hashmap_cr_t cr = {0};
+    cr.key_type = SIRIUS_HASHMAP_KEY_BYTES;
+    sirius_hashmap_handle h;
+    if (sirius_hashmap_cr(&cr, &h)) return;
+
+    uint64_t t0 = i_bench_mono();
+    for (unsigned long i = 0; i < n; i++) {
+        sirius_hashmap_put(h, pp_keys[i], strlen(pp_keys[i]), i);
+    }
+    i_bench_row("str put", i_bench_mono() - t0, n);
+
+    size_t v = 0;
+    t0 = i_bench_mono();
+    for (unsigned long i = 0; i < n; i++) {
+        sirius_hashmap_get(h, pp_keys[i], strlen(pp_keys[i]), &v);
+        g_sink = v;
+    }
+    i_bench_row("str get hit", i_bench_mono() - t0, n);
+
+    t0 = i_bench_mono();
+    for (unsigned long i = 0; i < n; i++) {
+        g_sink = sirius_hashmap_get(h, pp_miss[i], strlen(pp_miss[i]), &v);
+    }
+    i_bench_row("str get miss", i_bench_mono() - t0, n);
+
+    sirius_hashmap_del(h);
+}
+
+static void
+i_bench_hsearch(char **pp_keys, char **pp_miss, unsigned long n)
+{
+    struct hsearch_data htab;
+    memset(&htab, 0, sizeof(htab));
+    if (!(hcreate_r(n + n / 4, &htab))) return;
+
+    ENTRY e, *p_e;
+    uint64_t t0 = i_bench_mono();
+    for (unsigned long i = 0; i < n; i++) {
+        e.key = pp_keys[i];
+        e.data = (void *)i;
+        hsearch_r(e, ENTER, &p_e, &htab);
+    }
+    i_bench_row("hsearch_r enter", i_bench_mono() - t0, n);
+
+    t0 = i_bench_mono();
+    for (unsigned long i = 0; i < n; i++) {
+        e.key = pp_keys[i];
+        hsearch_r(e, FIND, &p_e, &htab);
+        g_sink = (size_t)p_e->data;
+    }
+    i_bench_row("hsearch_r find hit", i_bench_mono() - t0, n);
+
+    t0 = i_bench_mono();
+    for (unsigned long i = 0; i < n; i++) {
+        e.key = pp_miss[i];
+        g_sink = hsearch_r(e, FIND, &p_e, &htab);
+    }
+    i_bench_row("hsearch_r find miss", i_bench_mono() - t0, n);
+
+    hdestroy_r(&htab);
+}
+
+typedef struct {
+    sirius_hashmap_handle h;
+    unsigned long n;
+    unsigned long seed;
+    volatile int *p_stop;
+} i_bench_arg_t;
+
+static void *
+i_bench_reader(void *p)
+{
+    i_bench_arg_t *p_a = (i_bench_arg_t *)p;
+    unsigned long x = p_a->seed;
+    size_t v = 0;
+    for (unsigned long i = 0; i < I_BENCH_READS; i++) {
+        x = x * 6364136223846793005UL + 1442695040888963407UL;
+        sirius_hashmap_get_int(p_a->h, i_bench_key((x >> 16) % p_a->n), &v);
+        g_sink = v;
+    }
+    return NULL;
+}
+
+static void *
+i_bench_writer(void *p)
+{
+    i_bench_arg_t *p_a = (i_bench_arg_t *)p;
+    for (unsigned long i = 0; !(*p_a->p_stop); i = (i + 1) % p_a->n) {
+        sirius_hashmap_put_int(p_a->h, i_bench_key(i), i);
+    }
+    return NULL;
+}
+
+static void
+i_bench_striped(unsigned long n, unsigned int threads)
+{
+    sirius_hashmap_cr_t cr = {0};
+    cr.key_type = SIRIUS_HASHMAP_KEY_INT;
+    cr.capacity = n;
+    cr.stripes = 64;
+    sirius_hashmap_handle h;
+    if (sirius_hashmap_cr(&cr, &h)) return;
+    for (unsigned long i = 0; i < n; i++) {
+        sirius_hashmap_put_int(h, i_bench_key(i), i);
+    }
+
+    volatile int stop = 0;
+    i_bench_arg_t w = {h, n, 0, &stop};
+    i_bench_arg_t a[threads];
+    pthread_t tid[threads], wid;
+    pthread_create(&wid, NULL, i_bench_writer, &w);
+
+    uint64_t t0 = i_bench_mono();
+    for (unsigned int i = 0; i < threads; i++) {
+        a[i] = (i_bench_arg_t){h, n, i + 1, &stop};
+        pthread_create(&(tid[i]), NULL, i_bench_reader, &(a[i]));
+    }
+    for (unsigned int i = 0; i < threads; i++) pthread_join(tid[i], NULL);
+    uint64_t t = i_bench_mono() - t0;
+    stop = 1;
+    pthread_join(wid, NULL);
+
+    char name[64];
+    snprintf(name, sizeof(name), "striped get, %u readers", threads);
+    /* wall time per lookup across all readers */
+    i_bench_row(name, t, I_BENCH_READS * threads);
+
+    sirius_hashmap_del(h);
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned long n = I_BENCH_KEYS_DEF;
+    unsigned int threads = I_BENCH_THREADS_DEF;
+    int opt;
+
+    while (-1 != (opt = getopt(argc, argv, "n:t:h"))) {
+        switch (opt) {
+            case 'n':
+                n = strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                threads = (unsigned int)strtoul(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n keys] [-t threads]\n",
+                    argv[0]);
+                return 'h' == opt ? 0 : 1;
+        }
+    }
+    if (0 == n || 0 == threads || threads > 256) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    char **pp_keys = (char **)malloc(sizeof(char *) * n * 2);
+    if (!(pp_keys)) return 1;
+    char **pp_miss = pp_keys + n;
+    for (unsigned long i = 0; i < n; i++) {
+        if (asprintf(&(pp_keys[i]), "sid-%016llx",
+                (unsigned long long)i_bench_key(i)) < 0 ||
+            asprintf(&(pp_miss[i]), "sid-%016llx",
+                (unsigned long long)i_bench_key(i) | 1) < 0) {
+            return 1;
+        }
+    }
+
+    printf("keys: %lu, probing: %s\n", n, sirius_hashmap_isa());
+    printf("%-28s %10s\n", "case", "ns/op");
+    i_bench_int(n);
+    i_bench_str(pp_keys, pp_miss, n);
+    i_bench_hsearch(pp_keys, pp_miss, n);
+    i_bench_striped(n, threads);
+
+    for (unsigned long i = 0; i < n * 2; i++) free(pp_keys[i]);
+    free(pp_keys);
+    return 0;
+}
@@ -0,0 +1,350 @@
+/**
+ * @name sirius_bench_log.c
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief benchmark of `sirius_log_print`
+ * 
+ * @details
+ * sirius_bench_log [-t threads] [-n calls] [-f file] [-j json]
+ *  -t: the maximum number of threads, runs 1, 2, 4 ... threads
+ *  -n: calls per thread
+ *  -f: the file stdout/stderr are redirected to in the file case
+ *  -j: write the results as JSON to this path
+ * 
+ * every case is run with stdout/stderr redirected to /dev/null and
+ * to a regular file, with an enabled and a filtered level, and with
+ * a short and a `LOG_PRNT_BUF_SIZE` long message. the latency of
+ * every call is recorded, the report is written to the original
+ * stdout.
+ */
+
+#include "sirius_common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+
+/* default calls per thread */
+#define I_BENCH_CALLS_DEF   (100000)
+/* default maximum number of threads */
+#define I_BENCH_THREADS_DEF (4)
+/* default redirection file */
+#define I_BENCH_FILE_DEF    "./sirius_bench_log.out"
+
+/* length of the short message */
+#define I_BENCH_MSG_SHORT   (16)
+
+typedef struct {
+    const char *p_name;
+    sirius_log_lv_t lv;
+} i_bench_lv_t;
+
+typedef struct {
+    /* redirection target */
+    const char *p_sink;
+    const char *p_lv;
+    size_t msg_len;
+    unsigned int threads;
+    unsigned long long calls;
+
+    double wall_s;
+    double ns_mean;
+    double lines_per_s;
+    unsigned long long p50;
+    unsigned long long p99;
+    unsigned long long p999;
+    unsigned long long max;
+} i_bench_res_t;
+
+typedef struct {
+    pthread_t id;
+    sirius_log_lv_t lv;
+    const char *p_msg;
+    unsigned long long calls;
+    /* latency of every call, unit: ns */
+    unsigned long long *p_lat;
+    /* first and last timestamp of the thread */
+    unsigned long long t_beg;
+    unsigned long long t_end;
+    pthread_barrier_t *p_barrier;
+} i_bench_thd_t;
+
+static inline unsigned long long
+i_bench_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *
+i_bench_thd(void *args)
+{
+    i_bench_thd_t *p_t = (i_bench_thd_t *)args;
+
+    pthread_barrier_wait(p_t->p_barrier);
+    p_t->t_beg = i_bench_now();
+
+    if (SIRIUS_LOG_LV_INFO == p_t->lv) {
+        for (unsigned long long i = 0; i < p_t->calls; i++) {
+            unsigned long long t0 = i_bench_now();
+            SIRIUS_INFO("%s\n", p_t->p_msg);
+            p_t->p_lat[i] = i_bench_now() - t0;
+        }
+    } else {
+        for (unsigned long long i = 0; i < p_t->calls; i++) {
+            unsigned long long t0 = i_bench_now();
+            SIRIUS_DEBG("%s\n", p_t->p_msg);
+            p_t->p_lat[i] = i_bench_now() - t0;
+        }
+    }
+
+    p_t->t_end = i_bench_now();
+    return NULL;
+}
+
+static int
+i_bench_cmp(const void *p_a, const void *p_b)
+{
+    unsigned long long a = *(const unsigned long long *)p_a;
+    unsigned long long b = *(const unsigned long long *)p_b;
+    return (a > b) - (a < b);
+}
+
+static int
+i_bench_run(i_bench_res_t *p_res, sirius_log_lv_t lv,
+    const char *p_msg)
+{
+    unsigned int nr = p_res->threads;
+    unsigned long long calls = p_res->calls;
+
+    i_bench_thd_t *p_thds =
+        (i_bench_thd_t *)calloc(nr, sizeof(i_bench_thd_t));
+    unsigned long long *p_lat = (unsigned long long *)malloc(
+        sizeof(unsigned long long) * calls * nr);
+    if (!(p_thds) || !(p_lat)) {
+        free(p_thds);
+        free(p_lat);
+        return -1;
+    }
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, nr + 1);
+
+    for (unsigned int i = 0; i < nr; i++) {
+        p_thds[i].lv = lv;
+        p_thds[i].p_msg = p_msg;
+        p_thds[i].calls = calls;
+        p_thds[i].p_lat = p_lat + calls * i;
+        p_thds[i].p_barrier = &barrier;
+        pthread_create(&(p_thds[i].id), NULL,
+            i_bench_thd, &(p_thds[i]));
+    }
+
+    pthread_barrier_wait(&barrier);
+    unsigned long long t_beg = ~0ULL;
+    unsigned long long t_end = 0;
+    for (unsigned int i = 0; i < nr; i++) {
+        pthread_join(p_thds[i].id, NULL);
+        t_beg = p_thds[i].t_beg < t_beg ? p_thds[i].t_beg : t_beg;
+        t_end = p_thds[i].t_end > t_end ? p_thds[i].t_end : t_end;
+    }
+    unsigned long long wall = t_end - t_beg;
+    pthread_barrier_destroy(&barrier);
+
+    unsigned long long total = calls * nr;
+    unsigned long long sum = 0;
+    for (unsigned long long i = 0; i < total; i++) {
+        sum += p_lat[i];
+    }
+    qsort(p_lat, total, sizeof(unsigned long long), i_bench_cmp);
+
+    p_res->wall_s = wall / 1e9;
+    p_res->ns_mean = (double)sum / total;
+    p_res->lines_per_s = total / p_res->wall_s;
+    p_res->p50 = p_lat[total / 2];
+    p_res->p99 = p_lat[total * 99 / 100];
+    p_res->p999 = p_lat[total * 999 / 1000];
+    p_res->max = p_lat[total - 1];
+
+    free(p_lat);
+    free(p_thds);
+    return 0;
+}
+
+static void
+i_bench_json(FILE *fp, const i_bench_res_t *p_res, size_t nr)
+{
+    fprintf(fp, "{\n  \"version\": \"%s\",\n  \"results\": [\n",
+        sirius_get_version());
+    for (size_t i = 0; i < nr; i++) {
+        const i_bench_res_t *p = &(p_res[i]);
+        fprintf(fp,
+            "    {\"sink\": \"%s\", \"level\": \"%s\", "
+            "\"msg_len\": %zu, \"threads\": %u, \"calls\": %llu, "
+            "\"ns_per_call\": %.1f, \"lines_per_s\": %.0f, "
+            "\"p50_ns\": %llu, \"p99_ns\": %llu, "
+            "\"p999_ns\": %llu, \"max_ns\": %llu}%s\n",
+            p->p_sink, p->p_lv, p->msg_len, p->threads, p->calls,
+            p->ns_mean, p->lines_per_s,
+            p->p50, p->p99, p->p999, p->max,
+            i + 1 < nr ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned int threads_max = I_BENCH_THREADS_DEF;
+    unsigned long long calls = I_BENCH_CALLS_DEF;
+    const char *p_file = I_BENCH_FILE_DEF;
+    const char *p_json = NULL;
+    int opt;
+
+    while (-1 != (opt = getopt(argc, argv, "t:n:f:j:h"))) {
+        switch (opt) {
+            case 't':
+                threads_max = (unsigned int)atoi(optarg);
+                break;
+            case 'n':
+                calls = strtoull(optarg, NULL, 10);
+                break;
+            case 'f':
+                p_file = optarg;
+                break;
+            case 'j':
+                p_json = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-t threads] [-n calls] "
+                    "[-f file] [-j json]\n", argv[0]);
+                return 'h' == opt ? 0 : 1;
+        }
+    }
+    if (0 == threads_max || 0 == calls) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    /* the report goes to the original stdout */
+    FILE *p_rep = fdopen(dup(STDOUT_FILENO), "w");
+    int saved_out = dup(STDOUT_FILENO);
+    int saved_err = dup(STDERR_FILENO);
+    if (!(p_rep) || -1 == saved_out || -1 == saved_err) {
+        perror("dup");
+        return 1;
+    }
+
+    static char msg_long[LOG_PRNT_BUF_SIZE];
+    memset(msg_long, 'x', sizeof(msg_long) - 1);
+    static char msg_short[I_BENCH_MSG_SHORT + 1];
+    memset(msg_short, 'x', I_BENCH_MSG_SHORT);
+
+    const char *sinks[] = {"/dev/null", p_file};
+    const i_bench_lv_t lvs[] = {
+        {"enabled", SIRIUS_LOG_LV_INFO},
+        {"filtered", SIRIUS_LOG_LV_DEBG},
+    };
+    const char *msgs[] = {msg_short, msg_long};
+
+    size_t res_cap = 64;
+    size_t res_nr = 0;
+    i_bench_res_t *p_res =
+        (i_bench_res_t *)calloc(res_cap, sizeof(i_bench_res_t));
+    if (!(p_res)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    sirius_init_t init = {0};
+    init.log_lv = SIRIUS_LOG_LV_INFO;
+    if (sirius_init(&init)) {
+        fprintf(stderr, "sirius_init\n");
+        return 1;
+    }
+
+    fprintf(p_rep, "%-10s %-9s %6s %4s %12s %14s %9s %9s %9s %10s\n",
+        "sink", "level", "msg", "thd", "ns/call", "lines/s",
+        "p50", "p99", "p99.9", "max");
+
+    for (size_t s = 0; s < sizeof(sinks) / sizeof(sinks[0]); s++) {
+        int fd = open(sinks[s], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (-1 == fd) {
+            perror(sinks[s]);
+            continue;
+        }
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+
+        for (size_t l = 0; l < sizeof(lvs) / sizeof(lvs[0]); l++) {
+            for (size_t m = 0; m < sizeof(msgs) / sizeof(msgs[0]); m++) {
+                for (unsigned int t = 1; t <= threads_max;
+                    t = (t << 1) > threads_max && t != threads_max ?
+                        threads_max : t << 1) {
+                    if (res_nr == res_cap) {
+                        i_bench_res_t *p_new = (i_bench_res_t *)realloc(
+                            p_res, (res_cap << 1) * sizeof(i_bench_res_t));
+                        if (!(p_new)) {
+                            fprintf(p_rep, "out of memory\n");
+                            goto label_restore;
+                        }
+                        p_res = p_new;
+                        res_cap <<= 1;
+                    }
+
+                    i_bench_res_t *p = &(p_res[res_nr]);
+                    memset(p, 0, sizeof(*p));
+                    p->p_sink = 0 == s ? "devnull" : "file";
+                    p->p_lv = lvs[l].p_name;
+                    p->msg_len = strlen(msgs[m]);
+                    p->threads = t;
+                    /* calls per thread while running */
+                    p->calls = calls;
+                    if (i_bench_run(p, lvs[l].lv, msgs[m])) {
+                        fprintf(p_rep, "out of memory\n");
+                        continue;
+                    }
+                    p->calls = calls * t;
+                    res_nr++;
+
+                    fprintf(p_rep, "%-10s %-9s %6zu %4u %12.1f "
+                        "%14.0f %9llu %9llu %9llu %10llu\n",
+                        p->p_sink, p->p_lv, p->msg_len, p->threads,
+                        p->ns_mean, p->lines_per_s,
+                        p->p50, p->p99, p->p999, p->max);
+                    fflush(p_rep);
+                }
+            }
+        }
+    }
+
+label_restore:
+    dup2(saved_out, STDOUT_FILENO);
+    dup2(saved_err, STDERR_FILENO);
+    close(saved_out);
+    close(saved_err);
+    sirius_deinit();
+
+    if (p_json) {
+        FILE *fp = fopen(p_json, "w");
+        if (fp) {
+            i_bench_json(fp, p_res, res_nr);
+            fclose(fp);
+        } else {
+            perror(p_json);
+        }
+    }
+
+    free(p_res);
+    fclose(p_rep);
+    return 0;
+}
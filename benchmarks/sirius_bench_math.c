@@ -0,0 +1,505 @@
+/**
+ * @name sirius_bench_math.c
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief benchmark of the `sirius_math_*` array kernels
+ * 
+ * @details
+ * sirius_bench_math [-i isa] [-s max_bytes] [-r rounds] [-j json]
+ *  -i: "scalar", "sse2", "avx2", "avx512", or "all" (default) for
+ *      every instruction set the cpu supports
+ *  -s: the largest array in bytes, sizes run from 4 KiB upward by 4x
+ *  -r: repetitions of every case, the fastest one is reported
+ *  -j: append the results to this path, one JSON object per line
+ * 
+ * every kernel is timed against a scalar reference loop, from arrays
+ * that fit in L1 to arrays that only fit in DRAM, and its result is
+ * checked against the reference. an instruction set is forced through
+ * `SIRIUS_MATH_ISA_ENV`, which is read at load time, so "all" runs
+ * the benchmark once per instruction set in a child process.
+ * cycles are counted by the time stamp counter where there is one.
+ * the exit status is non-zero if any result is wrong.
+ */
+
+#include "sirius_common.h"
+#include "sirius_math.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define I_BENCH_TSC
+#endif
+
+/* default largest array, unit: byte */
+#define I_BENCH_BYTES_DEF   (64ULL * 1024 * 1024)
+/* default repetitions */
+#define I_BENCH_ROUNDS_DEF  (3)
+/* smallest array, unit: byte */
+#define I_BENCH_BYTES_MIN   (4ULL * 1024)
+/* bytes streamed per measurement at least */
+#define I_BENCH_TOUCH       (64ULL * 1024 * 1024)
+/* k of the top-k case */
+#define I_BENCH_TOPK        (10)
+
+static const char *g_isa_names[] = {
+    "scalar", "sse2", "avx2", "avx512",
+};
+#define I_BENCH_ISA_NR (sizeof(g_isa_names) / sizeof(g_isa_names[0]))
+
+typedef struct {
+    const char *p_name;
+    /* bytes of an element, the arrays hold `bytes / elem` elements */
+    size_t elem;
+    /* floating point elements */
+    int flt;
+    /* the second array is read too */
+    int two;
+    double (*p_lib)(const void *p_x, const void *p_y, size_t n);
+    double (*p_ref)(const void *p_x, const void *p_y, size_t n);
+    /* accepted relative difference, 0 for an exact result */
+    double tol;
+} i_bench_case_t;
+
+typedef struct {
+    unsigned long long ns;
+    unsigned long long cycles;
+    double val;
+} i_bench_time_t;
+
+/* keeps the results alive */
+static volatile double g_sink;
+
+static inline unsigned long long
+i_bench_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline unsigned long long
+i_bench_cycles()
+{
+#ifdef I_BENCH_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/* library kernels */
+
+#define I_BENCH_EXTREME(op, name, T) \
+static double \
+i_lib_##op##_##name(const void *p_x, const void *p_y, size_t n) \
+{ \
+    return (double)sirius_math_##op##_##name((const T *)p_x, n); \
+} \
+static double \
+i_ref_##op##_##name(const void *p_x, const void *p_y, size_t n) \
+{ \
+    const T *x = (const T *)p_x; \
+    T r = x[0]; \
+    for (size_t i = 1; i < n; i++) { \
+        if (I_BENCH_##op(x[i], r)) r = x[i]; \
+    } \
+    return (double)r; \
+}
+
+#define I_BENCH_max(a, b) ((a) > (b))
+#define I_BENCH_min(a, b) ((a) < (b))
+
+I_BENCH_EXTREME(max, u8, uint8_t)
+I_BENCH_EXTREME(max, i16, int16_t)
+I_BENCH_EXTREME(max, i32, int32_t)
+I_BENCH_EXTREME(min, u64, uint64_t)
+I_BENCH_EXTREME(max, f32, float)
+I_BENCH_EXTREME(min, f64, double)
+
+static double
+i_lib_minmax_f32(const void *p_x, const void *p_y, size_t n)
+{
+    float mn, mx;
+    sirius_math_minmax_f32((const float *)p_x, n, &mn, &mx);
+    return (double)mx - mn;
+}
+
+static double
+i_ref_minmax_f32(const void *p_x, const void *p_y, size_t n)
+{
+    const float *x = (const float *)p_x;
+    float mn = x[0];
+    float mx = x[0];
+    for (size_t i = 1; i < n; i++) {
+        if (x[i] < mn) mn = x[i];
+        if (x[i] > mx) mx = x[i];
+    }
+    return (double)mx - mn;
+}
+
+#define I_BENCH_SUM(name, T, acc, ACC) \
+static double \
+i_lib_sum_##name##_##acc(const void *p_x, const void *p_y, size_t n) \
+{ \
+    return sirius_math_sum_##name((const T *)p_x, n, ACC); \
+} \
+static double \
+i_lib_dot_##name##_##acc(const void *p_x, const void *p_y, size_t n) \
+{ \
+    return sirius_math_dot_##name((const T *)p_x, (const T *)p_y, n, ACC); \
+}
+
+I_BENCH_SUM(f32, float, fast, SIRIUS_MATH_ACC_FAST)
+I_BENCH_SUM(f64, double, fast, SIRIUS_MATH_ACC_FAST)
+I_BENCH_SUM(f32, float, comp, SIRIUS_MATH_ACC_COMP)
+I_BENCH_SUM(f64, double, comp, SIRIUS_MATH_ACC_COMP)
+
+/* the references accumulate in double, the results are compared */
+static double
+i_ref_sum_f32(const void *p_x, const void *p_y, size_t n)
+{
+    const float *x = (const float *)p_x;
+    double s = 0;
+    for (size_t i = 0; i < n; i++) s += x[i];
+    return s;
+}
+
+static double
+i_ref_sum_f64(const void *p_x, const void *p_y, size_t n)
+{
+    const double *x = (const double *)p_x;
+    double s = 0;
+    for (size_t i = 0; i < n; i++) s += x[i];
+    return s;
+}
+
+static double
+i_ref_dot_f32(const void *p_x, const void *p_y, size_t n)
+{
+    const float *x = (const float *)p_x;
+    const float *y = (const float *)p_y;
+    double s = 0;
+    for (size_t i = 0; i < n; i++) s += x[i] * y[i];
+    return s;
+}
+
+static double
+i_ref_dot_f64(const void *p_x, const void *p_y, size_t n)
+{
+    const double *x = (const double *)p_x;
+    const double *y = (const double *)p_y;
+    double s = 0;
+    for (size_t i = 0; i < n; i++) s += x[i] * y[i];
+    return s;
+}
+
+/* top-k, the result is a checksum of the indices in order */
+
+static double
+i_lib_topk_f32(const void *p_x, const void *p_y, size_t n)
+{
+    size_t idx[I_BENCH_TOPK];
+    size_t k = n < I_BENCH_TOPK ? n : I_BENCH_TOPK;
+    sirius_math_topk_f32((const float *)p_x, n, k,
+        SIRIUS_MATH_TOPK_LARGEST, NULL, idx);
+    double r = 0;
+    for (size_t i = 0; i < k; i++) r += (double)idx[i] * (i + 1);
+    return r;
+}
+
+static double
+i_ref_topk_f32(const void *p_x, const void *p_y, size_t n)
+{
+    const float *x = (const float *)p_x;
+    size_t idx[I_BENCH_TOPK];
+    size_t k = 0;
+    /* insertion into a sorted list, ties keep the lower index */
+    for (size_t i = 0; i < n; i++) {
+        if (k == I_BENCH_TOPK && !(x[i] > x[idx[k - 1]])) continue;
+        size_t j = k < I_BENCH_TOPK ? k++ : k - 1;
+        for (; j > 0 && x[i] > x[idx[j - 1]]; j--) idx[j] = idx[j - 1];
+        idx[j] = i;
+    }
+    double r = 0;
+    for (size_t i = 0; i < k; i++) r += (double)idx[i] * (i + 1);
+    return r;
+}
+
+/* sorts of 64 elements over the whole array, a checksum in order */
+
+static int
+i_bench_cmp_f32(const void *p_a, const void *p_b)
+{
+    float a = *(const float *)p_a;
+    float b = *(const float *)p_b;
+    return (a > b) - (a < b);
+}
+
+static double
+i_bench_sort64(const void *p_x, size_t n, int lib)
+{
+    const float *x = (const float *)p_x;
+    float buf[SIRIUS_MATH_SORT_MAX];
+    double r = 0;
+    for (size_t i = 0; i + SIRIUS_MATH_SORT_MAX <= n;
+        i += SIRIUS_MATH_SORT_MAX) {
+        memcpy(buf, x + i, sizeof(buf));
+        if (lib) {
+            sirius_math_sort_f32(buf, SIRIUS_MATH_SORT_MAX);
+        } else {
+            qsort(buf, SIRIUS_MATH_SORT_MAX, sizeof(float),
+                i_bench_cmp_f32);
+        }
+        r += buf[0] - buf[SIRIUS_MATH_SORT_MAX / 2] +
+            buf[SIRIUS_MATH_SORT_MAX - 1];
+    }
+    return r;
+}
+
+static double
+i_lib_sort64_f32(const void *p_x, const void *p_y, size_t n)
+{
+    return i_bench_sort64(p_x, n, 1);
+}
+
+static double
+i_ref_sort64_f32(const void *p_x, const void *p_y, size_t n)
+{
+    return i_bench_sort64(p_x, n, 0);
+}
+
+static const i_bench_case_t g_cases[] = {
+    {"max_u8", 1, 0, 0, i_lib_max_u8, i_ref_max_u8, 0},
+    {"max_i16", 2, 0, 0, i_lib_max_i16, i_ref_max_i16, 0},
+    {"max_i32", 4, 0, 0, i_lib_max_i32, i_ref_max_i32, 0},
+    {"min_u64", 8, 0, 0, i_lib_min_u64, i_ref_min_u64, 0},
+    {"max_f32", 4, 1, 0, i_lib_max_f32, i_ref_max_f32, 0},
+    {"min_f64", 8, 1, 0, i_lib_min_f64, i_ref_min_f64, 0},
+    {"minmax_f32", 4, 1, 0, i_lib_minmax_f32, i_ref_minmax_f32, 0},
+    {"sum_f32", 4, 1, 0, i_lib_sum_f32_fast, i_ref_sum_f32, 1e-5},
+    {"sum_f32_comp", 4, 1, 0, i_lib_sum_f32_comp, i_ref_sum_f32, 1e-6},
+    {"sum_f64", 8, 1, 0, i_lib_sum_f64_fast, i_ref_sum_f64, 1e-12},
+    {"sum_f64_comp", 8, 1, 0, i_lib_sum_f64_comp, i_ref_sum_f64, 1e-12},
+    {"dot_f32", 4, 1, 1, i_lib_dot_f32_fast, i_ref_dot_f32, 1e-5},
+    {"dot_f32_comp", 4, 1, 1, i_lib_dot_f32_comp, i_ref_dot_f32, 1e-6},
+    {"dot_f64", 8, 1, 1, i_lib_dot_f64_fast, i_ref_dot_f64, 1e-12},
+    {"dot_f64_comp", 8, 1, 1, i_lib_dot_f64_comp, i_ref_dot_f64, 1e-12},
+    {"topk10_f32", 4, 1, 0, i_lib_topk_f32, i_ref_topk_f32, 0},
+    {"sort64_f32", 4, 1, 0, i_lib_sort64_f32, i_ref_sort64_f32, 0},
+};
+#define I_BENCH_CASE_NR (sizeof(g_cases) / sizeof(g_cases[0]))
+
+static void
+i_bench_time(double (*p_fn)(const void *, const void *, size_t),
+    const void *p_x, const void *p_y, size_t n,
+    unsigned long long reps, unsigned int rounds, i_bench_time_t *p_t)
+{
+    p_t->ns = ~0ULL;
+    p_t->cycles = ~0ULL;
+    for (unsigned int r = 0; r < rounds; r++) {
+        unsigned long long t0 = i_bench_now();
+        unsigned long long c0 = i_bench_cycles();
+        for (unsigned long long j = 0; j < reps; j++) {
+            p_t->val = p_fn(p_x, p_y, n);
+            g_sink = p_t->val;
+        }
+        unsigned long long c = i_bench_cycles() - c0;
+        unsigned long long t = i_bench_now() - t0;
+        p_t->ns = t < p_t->ns ? t : p_t->ns;
+        p_t->cycles = c < p_t->cycles ? c : p_t->cycles;
+    }
+}
+
+/**
+ * @brief every case at every size on the dispatched instruction set
+ * 
+ * @return the number of wrong results
+ */
+static int
+i_bench_run(unsigned long long bytes_max, unsigned int rounds,
+    const char *p_json)
+{
+    unsigned char *p_x = (unsigned char *)malloc(bytes_max);
+    unsigned char *p_y = (unsigned char *)malloc(bytes_max);
+    if (!(p_x) || !(p_y)) {
+        fprintf(stderr, "out of memory\n");
+        free(p_x);
+        free(p_y);
+        return 1;
+    }
+    FILE *p_js = NULL;
+    if (p_json && !(p_js = fopen(p_json, "a"))) perror("fopen");
+
+    const char *p_isa = sirius_math_isa();
+    int bad = 0;
+    printf("isa: %s\n", p_isa);
+    printf("%-13s %10s %10s %10s %10s %10s %8s %s\n", "case", "bytes",
+        "GB/s", "ref GB/s", "cyc/elem", "ref cyc", "speedup", "check");
+
+    for (size_t c = 0; c < I_BENCH_CASE_NR; c++) {
+        const i_bench_case_t *p_c = &(g_cases[c]);
+        /* positive floats of mixed magnitude, random integers */
+        unsigned long long r = 0x2545f4914f6cdd1dULL ^ (c + 1);
+        for (size_t i = 0; i < bytes_max; i += p_c->elem) {
+            r ^= r << 13;
+            r ^= r >> 7;
+            r ^= r << 17;
+            if (p_c->flt && 4 == p_c->elem) {
+                float v = (float)ldexp(0.5 + (r >> 40) / 16777216.0,
+                    (int)(r % 9) - 4);
+                memcpy(p_x + i, &v, sizeof(v));
+                v = (float)(0.5 + (r >> 41) / 8388608.0);
+                memcpy(p_y + i, &v, sizeof(v));
+            } else if (p_c->flt) {
+                double v = ldexp(0.5 + (r >> 11) / 9007199254740992.0,
+                    (int)(r % 9) - 4);
+                memcpy(p_x + i, &v, sizeof(v));
+                v = 0.5 + (r >> 12) / 4503599627370496.0;
+                memcpy(p_y + i, &v, sizeof(v));
+            } else {
+                memcpy(p_x + i, &r, p_c->elem);
+                memcpy(p_y + i, &r, p_c->elem);
+            }
+        }
+
+        for (unsigned long long bytes = I_BENCH_BYTES_MIN;
+            bytes <= bytes_max; bytes *= 4) {
+            size_t n = bytes / p_c->elem;
+            double stream = (double)bytes * (p_c->two ? 2 : 1);
+            unsigned long long reps = I_BENCH_TOUCH / stream;
+            reps = reps ? reps : 1;
+
+            i_bench_time_t lib, ref;
+            i_bench_time(p_c->p_lib, p_x, p_y, n, reps, rounds, &lib);
+            i_bench_time(p_c->p_ref, p_x, p_y, n, reps, rounds, &ref);
+
+            double diff = fabs(lib.val - ref.val);
+            int ok = 0 == p_c->tol ? lib.val == ref.val :
+                diff <= p_c->tol * fabs(ref.val);
+            bad += !ok;
+
+            double gbs = stream * reps / lib.ns;
+            double ref_gbs = stream * reps / ref.ns;
+            double cyc = (double)lib.cycles / reps / n;
+            double ref_cyc = (double)ref.cycles / reps / n;
+            printf("%-13s %10llu %10.2f %10.2f %10.3f %10.3f %7.2fx %s\n",
+                p_c->p_name, bytes, gbs, ref_gbs, cyc, ref_cyc,
+                (double)ref.ns / lib.ns, ok ? "ok" : "WRONG");
+            if (p_js) {
+                fprintf(p_js,
+                    "{\"version\": \"%s\", \"isa\": \"%s\", "
+                    "\"case\": \"%s\", \"bytes\": %llu, "
+                    "\"gb_per_s\": %.3f, \"ref_gb_per_s\": %.3f, "
+                    "\"cycles_per_elem\": %.4f, "
+                    "\"ref_cycles_per_elem\": %.4f, \"ok\": %s}\n",
+                    sirius_get_version(), p_isa, p_c->p_name, bytes,
+                    gbs, ref_gbs, cyc, ref_cyc, ok ? "true" : "false");
+            }
+        }
+    }
+
+    if (p_js) fclose(p_js);
+    free(p_y);
+    free(p_x);
+    return bad;
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned long long bytes_max = I_BENCH_BYTES_DEF;
+    unsigned int rounds = I_BENCH_ROUNDS_DEF;
+    const char *p_isa = "all";
+    const char *p_json = NULL;
+    int opt;
+
+    while (-1 != (opt = getopt(argc, argv, "i:s:r:j:h"))) {
+        switch (opt) {
+            case 'i':
+                p_isa = optarg;
+                break;
+            case 's':
+                bytes_max = strtoull(optarg, NULL, 10);
+                break;
+            case 'r':
+                rounds = (unsigned int)atoi(optarg);
+                break;
+            case 'j':
+                p_json = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-i isa] [-s max_bytes] "
+                    "[-r rounds] [-j json]\n", argv[0]);
+                return 'h' == opt ? 0 : 1;
+        }
+    }
+    if (bytes_max < I_BENCH_BYTES_MIN || 0 == rounds) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    if (0 != strcmp(p_isa, "all")) {
+        if (0 == strcmp(p_isa, sirius_math_isa())) {
+            return i_bench_run(bytes_max, rounds, p_json) ? 2 : 0;
+        }
+        const char *p_env = getenv(SIRIUS_MATH_ISA_ENV);
+        if (p_env && 0 == strcmp(p_env, p_isa)) {
+            /* already forced, the cpu lacks it */
+            printf("isa: %s not supported, skipped\n", p_isa);
+            return 0;
+        }
+        /* the kernels are chosen at load time, start over */
+        setenv(SIRIUS_MATH_ISA_ENV, p_isa, 1);
+        execv("/proc/self/exe", argv);
+        perror("execv");
+        return 1;
+    }
+
+    if (p_json) {
+        /* the children append to it */
+        FILE *fp = fopen(p_json, "w");
+        if (fp) fclose(fp);
+    }
+
+    /* every instruction set up to the dispatched one */
+    const char *p_top = sirius_math_isa();
+    char bytes_arg[32];
+    char rounds_arg[16];
+    snprintf(bytes_arg, sizeof(bytes_arg), "%llu", bytes_max);
+    snprintf(rounds_arg, sizeof(rounds_arg), "%u", rounds);
+    int ret = 0;
+    for (size_t i = 0; i < I_BENCH_ISA_NR; i++) {
+        char *args[] = {
+            argv[0], "-i", (char *)g_isa_names[i], "-s", bytes_arg,
+            "-r", rounds_arg, p_json ? "-j" : NULL, (char *)p_json, NULL,
+        };
+        fflush(stdout);
+        pid_t pid = fork();
+        if (-1 == pid) {
+            perror("fork");
+            return 1;
+        }
+        if (0 == pid) {
+            setenv(SIRIUS_MATH_ISA_ENV, g_isa_names[i], 1);
+            execv("/proc/self/exe", args);
+            perror("execv");
+            _exit(1);
+        }
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || 0 != WEXITSTATUS(status)) ret = 2;
+        if (0 == strcmp(g_isa_names[i], p_top)) break;
+    }
+    return ret;
+}
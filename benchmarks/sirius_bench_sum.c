@@ -0,0 +1,323 @@
+/**
+ * @name sirius_bench_sum.c
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief benchmark of `sirius_math_sum_*` and `sirius_math_dot_*`
+ * 
+ * @details
+ * sirius_bench_sum [-s max_bytes] [-r rounds] [-j json]
+ *  -s: the largest array in bytes, sizes run from 4 KiB upward by 4x
+ *  -r: repetitions of every case, the fastest one is reported
+ *  -j: write the results as JSON to this path
+ * 
+ * every size is run with a naive loop, `SIRIUS_MATH_ACC_FAST` and
+ * `SIRIUS_MATH_ACC_COMP`, for f32 and f64, sum and dot. the relative
+ * error is measured against a long double reference over values
+ * of mixed magnitude, so that the naive loop visibly loses precision.
+ */
+
+#include "sirius_common.h"
+#include "sirius_math.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+/* default largest array, unit: byte */
+#define I_BENCH_BYTES_DEF   (64ULL * 1024 * 1024)
+/* default repetitions */
+#define I_BENCH_ROUNDS_DEF  (5)
+/* smallest array, unit: byte */
+#define I_BENCH_BYTES_MIN   (4ULL * 1024)
+/* bytes touched per case and repetition at least */
+#define I_BENCH_TOUCH       (64ULL * 1024 * 1024)
+
+typedef enum {
+    I_BENCH_NAIVE = 0,
+    I_BENCH_FAST,
+    I_BENCH_COMP,
+    I_BENCH_MODE_MAX,
+} i_bench_mode_t;
+
+static const char *g_mode_name[I_BENCH_MODE_MAX] = {
+    "naive", "fast", "comp",
+};
+
+typedef struct {
+    const char *p_op;
+    const char *p_type;
+    const char *p_mode;
+    size_t bytes;
+
+    double ns_per_elem;
+    double gb_per_s;
+    double rel_err;
+} i_bench_res_t;
+
+/* keeps the results alive */
+static volatile double g_sink;
+
+static inline unsigned long long
+i_bench_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static float
+i_bench_naive_sum_f32(const float *p_x, size_t n)
+{
+    float s = 0;
+    for (size_t i = 0; i < n; i++)
+        s += p_x[i];
+    return s;
+}
+
+static double
+i_bench_naive_sum_f64(const double *p_x, size_t n)
+{
+    double s = 0;
+    for (size_t i = 0; i < n; i++)
+        s += p_x[i];
+    return s;
+}
+
+static float
+i_bench_naive_dot_f32(const float *p_x, const float *p_y, size_t n)
+{
+    float s = 0;
+    for (size_t i = 0; i < n; i++)
+        s += p_x[i] * p_y[i];
+    return s;
+}
+
+static double
+i_bench_naive_dot_f64(const double *p_x, const double *p_y, size_t n)
+{
+    double s = 0;
+    for (size_t i = 0; i < n; i++)
+        s += p_x[i] * p_y[i];
+    return s;
+}
+
+/**
+ * @brief one call of the case, returns the result as a double
+ */
+static double
+i_bench_call(int dot, int f64, i_bench_mode_t mode,
+    const void *p_x, const void *p_y, size_t n)
+{
+    sirius_math_acc_t acc = I_BENCH_COMP == mode ?
+        SIRIUS_MATH_ACC_COMP : SIRIUS_MATH_ACC_FAST;
+
+    if (f64) {
+        const double *x = (const double *)p_x;
+        const double *y = (const double *)p_y;
+        if (I_BENCH_NAIVE == mode)
+            return dot ? i_bench_naive_dot_f64(x, y, n) :
+                i_bench_naive_sum_f64(x, n);
+        return dot ? sirius_math_dot_f64(x, y, n, acc) :
+            sirius_math_sum_f64(x, n, acc);
+    }
+
+    const float *x = (const float *)p_x;
+    const float *y = (const float *)p_y;
+    if (I_BENCH_NAIVE == mode)
+        return dot ? i_bench_naive_dot_f32(x, y, n) :
+            i_bench_naive_sum_f32(x, n);
+    return dot ? sirius_math_dot_f32(x, y, n, acc) :
+        sirius_math_sum_f32(x, n, acc);
+}
+
+static long double
+i_bench_ref(int dot, int f64, const void *p_x, const void *p_y, size_t n)
+{
+    long double s = 0;
+    for (size_t i = 0; i < n; i++) {
+        long double a = f64 ? ((const double *)p_x)[i] :
+            ((const float *)p_x)[i];
+        long double b = f64 ? ((const double *)p_y)[i] :
+            ((const float *)p_y)[i];
+        /* the kernels round the product to the element type first */
+        if (dot)
+            s += f64 ? (long double)(double)(a * b) :
+                (long double)(float)(a * b);
+        else
+            s += a;
+    }
+    return s;
+}
+
+static void
+i_bench_fill(double *p_d, float *p_f, size_t n, unsigned int seed)
+{
+    unsigned long long r = 0x9e3779b97f4a7c15ULL ^ seed;
+    for (size_t i = 0; i < n; i++) {
+        r ^= r << 13;
+        r ^= r >> 7;
+        r ^= r << 17;
+        /* magnitudes between 2^-8 and 2^8, mostly positive */
+        double m = (double)(r >> 11) / (double)(1ULL << 53);
+        double v = ldexp(0.5 + m, (int)(r % 17) - 8);
+        v = 0 == (r >> 60) % 8 ? -v : v;
+        if (p_d)
+            p_d[i] = v;
+        if (p_f)
+            p_f[i] = (float)v;
+    }
+}
+
+static void
+i_bench_json(FILE *fp, const i_bench_res_t *p_res, size_t nr)
+{
+    fprintf(fp, "{\n  \"version\": \"%s\",\n  \"isa\": \"%s\",\n"
+        "  \"results\": [\n", sirius_get_version(), sirius_math_isa());
+    for (size_t i = 0; i < nr; i++) {
+        const i_bench_res_t *p = &(p_res[i]);
+        fprintf(fp,
+            "    {\"op\": \"%s\", \"type\": \"%s\", \"mode\": \"%s\", "
+            "\"bytes\": %zu, \"ns_per_elem\": %.4f, "
+            "\"gb_per_s\": %.2f, \"rel_err\": %.3e}%s\n",
+            p->p_op, p->p_type, p->p_mode, p->bytes,
+            p->ns_per_elem, p->gb_per_s, p->rel_err,
+            i + 1 < nr ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned long long bytes_max = I_BENCH_BYTES_DEF;
+    unsigned int rounds = I_BENCH_ROUNDS_DEF;
+    const char *p_json = NULL;
+    int opt;
+
+    while (-1 != (opt = getopt(argc, argv, "s:r:j:h"))) {
+        switch (opt) {
+            case 's':
+                bytes_max = strtoull(optarg, NULL, 10);
+                break;
+            case 'r':
+                rounds = (unsigned int)atoi(optarg);
+                break;
+            case 'j':
+                p_json = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-s max_bytes] [-r rounds] "
+                    "[-j json]\n", argv[0]);
+                return 'h' == opt ? 0 : 1;
+        }
+    }
+    if (bytes_max < I_BENCH_BYTES_MIN || 0 == rounds) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    /* the largest f64 case needs two arrays of `bytes_max` */
+    size_t n_max = bytes_max / sizeof(double);
+    double *p_xd = (double *)malloc(n_max * sizeof(double));
+    double *p_yd = (double *)malloc(n_max * sizeof(double));
+    float *p_xf = (float *)malloc(n_max * 2 * sizeof(float));
+    float *p_yf = (float *)malloc(n_max * 2 * sizeof(float));
+    size_t res_cap = 256;
+    i_bench_res_t *p_res =
+        (i_bench_res_t *)calloc(res_cap, sizeof(i_bench_res_t));
+    size_t res_nr = 0;
+    if (!(p_xd) || !(p_yd) || !(p_xf) || !(p_yf) || !(p_res)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    /* the f32 arrays hold twice as many elements */
+    i_bench_fill(NULL, p_xf, n_max * 2, 1);
+    i_bench_fill(NULL, p_yf, n_max * 2, 2);
+    i_bench_fill(p_xd, NULL, n_max, 1);
+    i_bench_fill(p_yd, NULL, n_max, 2);
+
+    printf("isa: %s\n", sirius_math_isa());
+    printf("%-4s %-4s %-6s %10s %12s %10s %12s\n",
+        "op", "type", "mode", "bytes", "ns/elem", "GB/s", "rel_err");
+
+    for (unsigned long long bytes = I_BENCH_BYTES_MIN; bytes <= bytes_max;
+        bytes *= 4) {
+        for (int dot = 0; dot < 2; dot++) {
+            for (int f64 = 0; f64 < 2; f64++) {
+                size_t es = f64 ? sizeof(double) : sizeof(float);
+                size_t n = bytes / es;
+                const void *p_x = f64 ? (const void *)p_xd :
+                    (const void *)p_xf;
+                const void *p_y = f64 ? (const void *)p_yd :
+                    (const void *)p_yf;
+                long double ref = i_bench_ref(dot, f64, p_x, p_y, n);
+                /* streams `bytes` per array */
+                double stream = (double)bytes * (dot ? 2 : 1);
+                unsigned long long reps = I_BENCH_TOUCH / stream;
+                reps = reps ? reps : 1;
+
+                for (int m = 0; m < I_BENCH_MODE_MAX; m++) {
+                    unsigned long long best = ~0ULL;
+                    double r = 0;
+                    for (unsigned int k = 0; k < rounds; k++) {
+                        unsigned long long t0 = i_bench_now();
+                        for (unsigned long long j = 0; j < reps; j++) {
+                            r = i_bench_call(dot, f64,
+                                (i_bench_mode_t)m, p_x, p_y, n);
+                            g_sink = r;
+                        }
+                        unsigned long long t = i_bench_now() - t0;
+                        best = t < best ? t : best;
+                    }
+
+                    if (res_nr == res_cap) {
+                        res_cap *= 2;
+                        i_bench_res_t *p_new = (i_bench_res_t *)realloc(
+                            p_res, res_cap * sizeof(i_bench_res_t));
+                        if (!(p_new)) {
+                            fprintf(stderr, "out of memory\n");
+                            return 1;
+                        }
+                        p_res = p_new;
+                    }
+                    i_bench_res_t *p = &(p_res[res_nr++]);
+                    p->p_op = dot ? "dot" : "sum";
+                    p->p_type = f64 ? "f64" : "f32";
+                    p->p_mode = g_mode_name[m];
+                    p->bytes = bytes;
+                    p->ns_per_elem = (double)best / reps / n;
+                    p->gb_per_s = stream * reps / best;
+                    p->rel_err = 0 == ref ? fabs(r) :
+                        (double)fabsl((r - ref) / ref);
+
+                    printf("%-4s %-4s %-6s %10zu %12.4f %10.2f %12.3e\n",
+                        p->p_op, p->p_type, p->p_mode, p->bytes,
+                        p->ns_per_elem, p->gb_per_s, p->rel_err);
+                }
+            }
+        }
+    }
+
+    if (p_json) {
+        FILE *fp = fopen(p_json, "w");
+        if (!(fp)) {
+            perror("fopen");
+        } else {
+            i_bench_json(fp, p_res, res_nr);
+            fclose(fp);
+        }
+    }
+
+    free(p_res);
+    free(p_yf);
+    free(p_xf);
+    free(p_yd);
+    free(p_xd);
+    return 0;
+}
@@ -0,0 +1,116 @@
+/**
+ * @name sirius_bench_time.c
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief cost of a timestamp
+ * 
+ * @details
+ * sirius_bench_time [-n calls]
+ * 
+ * every clock is read `calls` times in a loop, the mean cost of a
+ * read is reported next to `clock_gettime` and `time`.
+ */
+
+#include "sirius_common.h"
+#include "sirius_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+/* default calls per clock */
+#define I_BENCH_CALLS_DEF   (10000000ULL)
+
+/* keeps the readings alive */
+static volatile uint64_t g_sink;
+
+static uint64_t
+i_bench_mono()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t
+i_bench_real()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t
+i_bench_time()
+{
+    return (uint64_t)time(NULL);
+}
+
+static uint64_t
+i_bench_ns()
+{
+    return sirius_time_ns();
+}
+
+static uint64_t
+i_bench_cycles()
+{
+    return sirius_time_cycles();
+}
+
+typedef struct {
+    const char *p_name;
+    uint64_t (*p_fn)();
+} i_bench_case_t;
+
+static const i_bench_case_t g_case[] = {
+    {"sirius_time_ns", i_bench_ns},
+    {"sirius_time_cycles", i_bench_cycles},
+    {"sirius_time_coarse_ns", sirius_time_coarse_ns},
+    {"clock_gettime(MONOTONIC)", i_bench_mono},
+    {"clock_gettime(REALTIME)", i_bench_real},
+    {"time", i_bench_time},
+};
+
+int
+main(int argc, char *argv[])
+{
+    unsigned long long calls = I_BENCH_CALLS_DEF;
+    int opt;
+
+    while (-1 != (opt = getopt(argc, argv, "n:h"))) {
+        switch (opt) {
+            case 'n':
+                calls = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n calls]\n", argv[0]);
+                return 'h' == opt ? 0 : 1;
+        }
+    }
+    if (0 == calls) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    sirius_time_init();
+    printf("clock: %s, %.3f MHz\n", sirius_time_tsc() ? "tsc" :
+        "clock_gettime", (double)sirius_time_hz() / 1e6);
+    printf("%-26s %10s\n", "clock", "ns/call");
+
+    for (size_t i = 0; i < sizeof(g_case) / sizeof(g_case[0]); i++) {
+        uint64_t (*p_fn)() = g_case[i].p_fn;
+        uint64_t t0 = i_bench_mono();
+        for (unsigned long long j = 0; j < calls; j++) {
+            g_sink = p_fn();
+        }
+        uint64_t t = i_bench_mono() - t0;
+        printf("%-26s %10.2f\n", g_case[i].p_name, (double)t / calls);
+    }
+
+    return 0;
+}
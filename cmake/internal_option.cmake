@@ -1,7 +1,6 @@
 # 内部选项
 
 add_definitions(-DLOG_MODULE_NAME="lib-sirius")
-add_definitions(-DLOG_PRNT_BUF_SIZE=1024)
 
 if(USER_ASAN)
     add_compile_options(-fsanitize=address -fno-omit-frame-pointer -fsanitize-recover=address)
@@ -31,3 +30,6 @@ if(BUILD_SHARED_LIBS)
 else()
     add_library(${TARGET_NAME} STATIC ${_src_list})
 endif()
+
+# 日志缓冲区大小是头文件的一部分，链接本库的目标（基准、测试、工具）使用同一个值
+target_compile_definitions(${TARGET_NAME} PUBLIC LOG_PRNT_BUF_SIZE=1024)
@@ -26,6 +26,24 @@ typedef struct {
 
     /* pipe path */
     char *p_pipe;
+
+    /* precision of the timestamp */
+    sirius_log_time_prec_t time_prec;
+
+    /* drop identical repeated records */
+    bool dup_suppress;
+
+    /* initial sink */
+    sirius_log_sink_t sink;
+
+    /* log file sink */
+    const sirius_log_file_t *p_file;
+
+    /* shared-memory sink */
+    const sirius_log_shm_t *p_shm;
+
+    /* flight recorder */
+    const sirius_log_recorder_t *p_rec;
 } sirius_log_cr_t;
 
 void
@@ -34,4 +52,193 @@ sirius_log_deinit();
 int
 sirius_log_init(const sirius_log_cr_t *p_cr);
 
+/**
+ * diagnostic output of the log module itself,
+ * it never goes through the log sinks
+ */
+void
+sirius_log_diag(const char *p_color,
+    FILE *stream,
+    const char *p_type,
+    const char *p_file,
+    const char *p_func,
+    int line,
+    const char *p_fmt, ...);
+
+#define I_LOG_PRNT(color, stream, type, fmt, ...) \
+    sirius_log_diag(color, stream, #type, \
+        SIRIUS_FILE, __FUNCTION__, __LINE__, \
+        fmt, ##__VA_ARGS__)
+
+#define I_LOG_INFO(fmt, ...) \
+    I_LOG_PRNT(LOG_GREEN, \
+        stdout, info, fmt, ##__VA_ARGS__)
+#define I_LOG_WARN(fmt, ...) \
+    I_LOG_PRNT(LOG_YELLOW, \
+        stderr, warn, fmt, ##__VA_ARGS__)
+#define I_LOG_ERROR(fmt, ...) \
+    I_LOG_PRNT(LOG_RED, \
+        stderr, error, fmt, ##__VA_ARGS__)
+
+/* records are passed to the sinks as segments */
+
+static inline size_t
+sirius_log_iov_len(const struct iovec *p_iov, int iov_nr)
+{
+    size_t len = 0;
+    for (int i = 0; i < iov_nr; i++) {
+        len += p_iov[i].iov_len;
+    }
+    return len;
+}
+
+/**
+ * @brief copy the segments into `p_dst`, at most `cap` bytes
+ * 
+ * @return the number of bytes copied
+ */
+static inline size_t
+sirius_log_iov_gather(char *p_dst, size_t cap,
+    const struct iovec *p_iov, int iov_nr)
+{
+    size_t len = 0;
+    for (int i = 0; i < iov_nr && len < cap; i++) {
+        size_t n = p_iov[i].iov_len;
+        if (n > cap - len) n = cap - len;
+        memcpy(p_dst + len, p_iov[i].iov_base, n);
+        len += n;
+    }
+    return len;
+}
+
+/* log levels */
+void
+sirius_log_lv_deinit();
+
+void
+sirius_log_lv_init(sirius_log_lv_t log_lv);
+
+/**
+ * @brief the level recorded by the flight recorder,
+ *  it takes part in `sirius_log_lv_threshold`
+ */
+void
+sirius_log_lv_rec_set(sirius_log_lv_t log_lv);
+
+sirius_log_lv_t
+sirius_log_lv_rec_get();
+
+/**
+ * @brief the level of a call site's module, the key is looked up
+ *  by name only when the site has none for the current table
+ */
+sirius_log_lv_t
+sirius_log_lv_mod_get(sirius_log_mod_t *p_mod);
+
+/* cached clock */
+
+/* "HH:MM:SS.uuuuuu" */
+#define SIRIUS_LOG_CLOCK_BUF_SIZE (16)
+
+void
+sirius_log_clock_init(sirius_log_time_prec_t prec);
+
+/**
+ * @brief format the current time into `p_buf`,
+ *  whose size is at least `SIRIUS_LOG_CLOCK_BUF_SIZE`
+ * 
+ * @return the length of the string
+ */
+int
+sirius_log_clock_fmt(char *p_buf);
+
+/**
+ * @brief the kernel thread id of the caller, cached per thread
+ */
+pid_t
+sirius_log_tid();
+
+/* file sink */
+void
+sirius_log_file_deinit();
+
+int
+sirius_log_file_init(const sirius_log_file_t *p_cr);
+
+/**
+ * @brief append a record to the file sink,
+ *  a record larger than the buffer is written directly
+ * 
+ * @param[in] p_iov: segments of the record
+ * @param[in] iov_nr: number of segments
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_log_file_write(const struct iovec *p_iov, int iov_nr);
+
+/**
+ * @brief ask the background thread to reopen the log file
+ */
+void
+sirius_log_file_reopen();
+
+/**
+ * @brief ask the background thread to write the buffer out
+ */
+void
+sirius_log_file_flush();
+
+/**
+ * @brief print the statistics of the file sink
+ */
+void
+sirius_log_file_stats();
+
+/* shared-memory sink */
+void
+sirius_log_shm_deinit();
+
+int
+sirius_log_shm_init(const sirius_log_shm_t *p_cr);
+
+/**
+ * @brief publish a record into the shared-memory ring,
+ *  the part beyond a slot is truncated
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_log_shm_write(sirius_log_lv_t log_lv,
+    const struct iovec *p_iov, int iov_nr);
+
+/**
+ * @brief print the statistics of the shared-memory sink
+ */
+void
+sirius_log_shm_stats();
+
+/* flight recorder */
+void
+sirius_log_rec_deinit();
+
+int
+sirius_log_rec_init(const sirius_log_recorder_t *p_cr);
+
+/**
+ * @brief append a record, colour codes excluded,
+ *  the part beyond a slot is truncated
+ */
+void
+sirius_log_rec_write(const struct iovec *p_iov, int iov_nr);
+
+/* rate limit */
+
+/**
+ * @brief count a record dropped by rate limiting,
+ *  on the shard of the calling thread
+ */
+void
+sirius_log_ratelimit_drop();
+
 #endif // __SIRIUS_INTERNAL_LOG_H__
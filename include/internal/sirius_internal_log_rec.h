@@ -0,0 +1,207 @@
+#ifndef __SIRIUS_INTERNAL_LOG_REC_H__
+#define __SIRIUS_INTERNAL_LOG_REC_H__
+
+#include "sirius_internal_sys.h"
+
+#include <stdint.h>
+
+/**
+ * layout of the flight recorder ring, shared by the writer in the
+ * library and the readers such as `sirius_logrec`.
+ *
+ * the ring is `slice_nr` slices of `slot_nr` fixed-size slots. a
+ * writer reserves a position with a fetch-add on the position of its
+ * slice, claims the slot by swapping its sequence to the odd
+ * `I_LOG_REC_BUSY`, copies the record with a cycle stamp and
+ * publishes it by storing `I_LOG_REC_SEQ(pos)`. a slot that another
+ * writer holds (threads sharing a slice, or a slice that lapped a
+ * slow writer) is not written, the record is counted in `busy_nr`.
+ * nothing is shared between the slices, the dump merges them by
+ * stamp.
+ *
+ * a reader copies a slot and re-reads its sequence, like a seqlock:
+ * a slot whose sequence is 0, odd or changed under the copy is skipped.
+ */
+
+#define I_LOG_REC_MAGIC         (0x53495252)    // "SIRR"
+#define I_LOG_REC_VERSION       (3)
+
+/* sequence of a slot being written */
+#define I_LOG_REC_BUSY          (1ULL)
+/* sequence of the slot published at slice position `pos`, even */
+#define I_LOG_REC_SEQ(pos)      (((unsigned long long)(pos) + 1) << 1)
+
+/* maximum number of slices */
+#define I_LOG_REC_SLICE_NR_MAX  (64)
+
+typedef struct {
+    /* next slot to write, only ever increases */
+    atomic_ullong pos;
+    char pad[64 - sizeof(atomic_ullong)];
+} i_log_rec_slice_t;
+
+/* head of the mapped region */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    /* size of a slot including its head */
+    uint32_t slot_size;
+    /* number of slices */
+    uint32_t slice_nr;
+    /* slots per slice */
+    uint32_t slot_nr;
+    uint32_t reserved;
+    /* number of records that did not fit in a slot */
+    atomic_ullong trunc_nr;
+    /* number of records dropped, their slot was being written */
+    atomic_ullong busy_nr;
+    char pad[64 - 40];
+    i_log_rec_slice_t slices[I_LOG_REC_SLICE_NR_MAX];
+} i_log_rec_hdr_t;
+
+typedef struct {
+    /* `I_LOG_REC_SEQ` once published, 0 while empty, odd while written */
+    atomic_ullong seq;
+    /* `sirius_time_cycles` when the record was written, the order */
+    unsigned long long stamp;
+    /* length of the record */
+    uint32_t len;
+    uint32_t reserved;
+    char data[];
+} i_log_rec_slot_t;
+
+/* a published slot, as found by `i_log_rec_collect` */
+typedef struct {
+    unsigned long long stamp;
+    unsigned long long seq;
+    size_t idx;
+} i_log_rec_ent_t;
+
+static inline size_t
+i_log_rec_slot_total(const i_log_rec_hdr_t *p_hdr)
+{
+    return (size_t)p_hdr->slice_nr * p_hdr->slot_nr;
+}
+
+static inline size_t
+i_log_rec_map_size(const i_log_rec_hdr_t *p_hdr)
+{
+    return sizeof(i_log_rec_hdr_t) +
+        i_log_rec_slot_total(p_hdr) * p_hdr->slot_size;
+}
+
+/**
+ * @param[in] idx: `slice * slot_nr + pos % slot_nr`
+ */
+static inline i_log_rec_slot_t *
+i_log_rec_slot(i_log_rec_hdr_t *p_hdr, size_t idx)
+{
+    return (i_log_rec_slot_t *)((char *)(p_hdr + 1) +
+        idx * p_hdr->slot_size);
+}
+
+/**
+ * @brief the published slots, unordered
+ *
+ * @param[out] p_ent: room for `i_log_rec_slot_total` entries
+ *
+ * @return the number of entries
+ */
+static inline size_t
+i_log_rec_collect(i_log_rec_hdr_t *p_hdr, i_log_rec_ent_t *p_ent)
+{
+    size_t n = 0;
+    size_t total = i_log_rec_slot_total(p_hdr);
+    for (size_t i = 0; i < total; i++) {
+        i_log_rec_slot_t *p_slot = i_log_rec_slot(p_hdr, i);
+        unsigned long long seq = atomic_load_explicit(
+            &(p_slot->seq), memory_order_acquire);
+        if (seq && !(seq & I_LOG_REC_BUSY)) {
+            /* a stamp torn by a rewrite is caught by `i_log_rec_emit` */
+            p_ent[n].stamp = p_slot->stamp;
+            p_ent[n].seq = seq;
+            p_ent[n].idx = i;
+            n++;
+        }
+    }
+    return n;
+}
+
+/* by stamp, then by position within a slice */
+static inline bool
+i_log_rec_before(const i_log_rec_ent_t *p_a, const i_log_rec_ent_t *p_b)
+{
+    if (p_a->stamp != p_b->stamp) return p_a->stamp < p_b->stamp;
+    return p_a->seq < p_b->seq;
+}
+
+static inline void
+i_log_rec_sift(i_log_rec_ent_t *p_ent, size_t i, size_t n)
+{
+    i_log_rec_ent_t e = p_ent[i];
+    for (size_t c; (c = 2 * i + 1) < n; i = c) {
+        if (c + 1 < n && i_log_rec_before(&(p_ent[c]), &(p_ent[c + 1]))) {
+            c++;
+        }
+        if (!(i_log_rec_before(&e, &(p_ent[c])))) break;
+        p_ent[i] = p_ent[c];
+    }
+    p_ent[i] = e;
+}
+
+/**
+ * @brief sort the entries by stamp
+ *
+ * @note heapsort, no allocation and no recursion, async-signal-safe
+ */
+static inline void
+i_log_rec_sort(i_log_rec_ent_t *p_ent, size_t n)
+{
+    for (size_t i = n / 2; i-- > 0;) {
+        i_log_rec_sift(p_ent, i, n);
+    }
+    while (n-- > 1) {
+        i_log_rec_ent_t e = p_ent[0];
+        p_ent[0] = p_ent[n];
+        p_ent[n] = e;
+        i_log_rec_sift(p_ent, 0, n);
+    }
+}
+
+/**
+ * @brief write the sorted entries to `fd`
+ *
+ * @param[in] p_buf: room for `slot_size` bytes
+ *
+ * @return the number of slots skipped because they were rewritten
+ *
+ * @note async-signal-safe
+ */
+static inline size_t
+i_log_rec_emit(i_log_rec_hdr_t *p_hdr, int fd,
+    const i_log_rec_ent_t *p_ent, size_t n, char *p_buf)
+{
+    size_t torn = 0;
+    size_t cap = p_hdr->slot_size - sizeof(i_log_rec_slot_t);
+
+    for (size_t i = 0; i < n; i++) {
+        i_log_rec_slot_t *p_slot = i_log_rec_slot(p_hdr, p_ent[i].idx);
+        size_t len = p_slot->len;
+        if (len > cap) len = cap;
+        memcpy(p_buf, p_slot->data, len);
+        atomic_thread_fence(memory_order_acquire);
+        if (p_ent[i].seq != atomic_load_explicit(
+                &(p_slot->seq), memory_order_relaxed)) {
+            torn++;
+            continue;
+        }
+
+        (void)!write(fd, p_buf, len);
+        if (0 == len || '\n' != p_buf[len - 1]) {
+            (void)!write(fd, "\n", 1);
+        }
+    }
+    return torn;
+}
+
+#endif // __SIRIUS_INTERNAL_LOG_REC_H__
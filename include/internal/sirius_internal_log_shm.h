@@ -0,0 +1,142 @@
+#ifndef __SIRIUS_INTERNAL_LOG_SHM_H__
+#define __SIRIUS_INTERNAL_LOG_SHM_H__
+
+#include "sirius_internal_sys.h"
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include <linux/futex.h>
+
+/**
+ * layout of the shared-memory log ring, shared by the writer
+ * in the library and the readers such as `sirius_logtail`.
+ *
+ * the ring is an array of fixed-size slots. a writer reserves
+ * a position with a fetch-add on `head`, copies the record into
+ * slot `pos % slot_nr` and publishes it by storing `pos + 1` into
+ * the slot sequence. writers never wait for readers: a reader
+ * that falls more than `slot_nr` records behind finds its slots
+ * overwritten and counts them as lost.
+ *
+ * `i_log_shm_read` is the read step of such a reader.
+ *
+ * a reader that caught up sets `waiters` and sleeps on the futex
+ * `notify`, which writers bump only while `waiters` is non-zero.
+ */
+
+#define I_LOG_SHM_MAGIC         (0x5349524c)    // "SIRL"
+#define I_LOG_SHM_VERSION       (1)
+
+/* default name of the shared-memory object */
+#define I_LOG_SHM_NAME_DEF      "/sirius-log"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    /* size of a slot including its head */
+    uint32_t slot_size;
+    /* number of slots */
+    uint32_t slot_nr;
+    /* number of records that did not fit in a slot */
+    atomic_ullong trunc_nr;
+    char pad0[64 - 24];
+
+    /* next position to write */
+    atomic_ullong head;
+    char pad1[64 - sizeof(atomic_ullong)];
+
+    /* futex word readers sleep on */
+    atomic_uint notify;
+    /* number of sleeping readers */
+    atomic_uint waiters;
+    char pad2[64 - 2 * sizeof(atomic_uint)];
+} i_log_shm_hdr_t;
+
+typedef struct {
+    /* `pos + 1` once published, 0 while being written */
+    atomic_ullong seq;
+    /* length of the record */
+    uint32_t len;
+    /* log level */
+    uint32_t lv;
+    char data[];
+} i_log_shm_slot_t;
+
+static inline i_log_shm_slot_t *
+i_log_shm_slot(i_log_shm_hdr_t *p_hdr, unsigned long long pos)
+{
+    return (i_log_shm_slot_t *)((char *)(p_hdr + 1) +
+        (size_t)(pos % p_hdr->slot_nr) * p_hdr->slot_size);
+}
+
+/* `i_log_shm_read`: the reader caught up with the writers */
+#define I_LOG_SHM_READ_EMPTY    (-1)
+/* `i_log_shm_read`: the next slot is still being written */
+#define I_LOG_SHM_READ_BUSY     (-2)
+
+/**
+ * @brief copy the record at `*p_rd` and move past it
+ *
+ * @param[in,out] p_rd: position of the reader
+ * @param[out] p_buf: room for `slot_size - sizeof(i_log_shm_slot_t)`
+ * @param[in,out] p_lost: incremented by the records overwritten
+ *  before they could be read, the position skips them
+ *
+ * @return the length of the record,
+ *  `I_LOG_SHM_READ_EMPTY` or `I_LOG_SHM_READ_BUSY` otherwise
+ */
+static inline long
+i_log_shm_read(i_log_shm_hdr_t *p_hdr, unsigned long long *p_rd,
+    char *p_buf, unsigned long long *p_lost)
+{
+    unsigned long long slot_nr = p_hdr->slot_nr;
+    size_t cap = p_hdr->slot_size - sizeof(i_log_shm_slot_t);
+
+    while (true) {
+        unsigned long long rd = *p_rd;
+        unsigned long long head = atomic_load_explicit(
+            &(p_hdr->head), memory_order_acquire);
+
+        if (head < rd) {
+            /* the ring was reset */
+            *p_rd = rd = head;
+        }
+        if (rd == head) return I_LOG_SHM_READ_EMPTY;
+        if (head - rd > slot_nr) {
+            *p_lost += head - slot_nr - rd;
+            *p_rd = rd = head - slot_nr;
+        }
+
+        i_log_shm_slot_t *p_slot = i_log_shm_slot(p_hdr, rd);
+        unsigned long long seq = atomic_load_explicit(
+            &(p_slot->seq), memory_order_acquire);
+        if (seq < rd + 1) return I_LOG_SHM_READ_BUSY;
+
+        *p_rd = rd + 1;
+        if (seq > rd + 1) {
+            /* overwritten before we got to it */
+            (*p_lost)++;
+            continue;
+        }
+
+        size_t len = p_slot->len;
+        if (len > cap) len = cap;
+        memcpy(p_buf, p_slot->data, len);
+        atomic_thread_fence(memory_order_acquire);
+        if (seq != atomic_load_explicit(
+                &(p_slot->seq), memory_order_relaxed)) {
+            (*p_lost)++;
+            continue;
+        }
+        return (long)len;
+    }
+}
+
+static inline long
+i_log_shm_futex(atomic_uint *p_addr, int op, unsigned int val,
+    const struct timespec *p_ts)
+{
+    return syscall(SYS_futex, p_addr, op, val, p_ts, NULL, 0);
+}
+
+#endif // __SIRIUS_INTERNAL_LOG_SHM_H__
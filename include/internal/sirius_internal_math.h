@@ -0,0 +1,53 @@
+#ifndef __SIRIUS_INTERNAL_MATH_H__
+#define __SIRIUS_INTERNAL_MATH_H__
+
+#include "sirius_internal_sys.h"
+#include "sirius_cpu.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define I_MATH_X86
+#endif
+
+/**
+ * @brief `sirius_cpu_select` for the kernel tables: the leading
+ *  implementations above the level named by `SIRIUS_MATH_ISA_ENV`
+ *  ("scalar", "sse2", "avx2" or "avx512") are skipped
+ * 
+ * @note the modules fill their tables from it in a constructor,
+ *  the table should end with an entry needing 0
+ */
+sirius_cpu_fn_t
+sirius_math_internal_select(const sirius_cpu_impl_t *p_impl, size_t nr);
+
+/* name, type, lowest value, highest value */
+#define I_MATH_TYPES(X) \
+    X(i8,  int8_t,   INT8_MIN,  INT8_MAX) \
+    X(i16, int16_t,  INT16_MIN, INT16_MAX) \
+    X(i32, int32_t,  INT32_MIN, INT32_MAX) \
+    X(i64, int64_t,  INT64_MIN, INT64_MAX) \
+    X(u8,  uint8_t,  0,         UINT8_MAX) \
+    X(u16, uint16_t, 0,         UINT16_MAX) \
+    X(u32, uint32_t, 0,         UINT32_MAX) \
+    X(u64, uint64_t, 0,         UINT64_MAX) \
+    X(f32, float,    -INFINITY, INFINITY) \
+    X(f64, double,   -INFINITY, INFINITY)
+
+/**
+ * kernels shared between the array functions, dispatched with
+ * the min/max ones:
+ * 
+ * sirius_math_above_*: the index of the first element greater
+ *  than `thr`, `n` if there is none
+ * sirius_math_below_*: the same for less than `thr`
+ * sirius_math_network_*: sort `nr` elements in ascending order with
+ *  a bitonic network, `nr` is a power of 2 in [2, SIRIUS_MATH_SORT_MAX]
+ */
+#define I_MATH_SHARED(name, T, lo, hi) \
+    size_t sirius_math_above_##name(const T *p_arr, size_t n, T thr); \
+    size_t sirius_math_below_##name(const T *p_arr, size_t n, T thr); \
+    void sirius_math_network_##name(T *p_arr, size_t nr);
+
+I_MATH_TYPES(I_MATH_SHARED)
+
+#endif // __SIRIUS_INTERNAL_MATH_H__
@@ -21,6 +21,7 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/select.h>
+#include <sys/uio.h>
 #include <sys/syscall.h>
 
 #if defined(__STDC_NO_ATOMICS__)
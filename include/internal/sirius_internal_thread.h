@@ -0,0 +1,28 @@
+#ifndef __SIRIUS_INTERNAL_THREAD_H__
+#define __SIRIUS_INTERNAL_THREAD_H__
+
+#include "sirius_internal_sys.h"
+
+#include "sirius_thread.h"
+
+/**
+ * @brief placement of the threads of the library, from the `thread`
+ *  member of `sirius_init_t`; NULL restores the defaults
+ * 
+ * @note threads created before are not moved
+ */
+void
+sirius_thread_internal_set(const sirius_thread_attr_t *p_attr);
+
+/**
+ * @brief create a thread of the library named `p_name`, placed as
+ *  set by `sirius_thread_internal_set`; if the placement cannot be
+ *  applied the thread is created with the defaults and a warning
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_thread_internal_create(pthread_t *p_id, const char *p_name,
+    bool detached, void *(*p_fn)(void *), void *p_arg);
+
+#endif // __SIRIUS_INTERNAL_THREAD_H__
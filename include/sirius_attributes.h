@@ -96,6 +96,33 @@ inline __attribute__((always_inline))
 #endif
 #endif // compiler
 
+/**
+ * @brief the function is resolved once at load time: `resolver`
+ *  returns the implementation to bind, refer to `sirius_cpu_select`
+ * 
+ * @note defined only where GNU ifunc is available
+ */
+#ifndef ifunc_symbol
+#if (gcc_version_check_at_least(4, 6) || \
+    clang_version_check_at_least(3, 9)) && \
+    defined(__linux__) && defined(__ELF__)
+#define ifunc_symbol(resolver) __attribute__((ifunc(#resolver)))
+#endif
+#endif // ifunc_symbol
+
+/**
+ * @brief `fn` is called with the address of the variable when it
+ *  goes out of scope
+ * 
+ * @note defined only for gcc and clang
+ */
+#ifndef scope_cleanup
+#if gcc_version_check_at_least(3, 3) || \
+    defined(__clang__)
+#define scope_cleanup(fn) __attribute__((cleanup(fn)))
+#endif
+#endif // scope_cleanup
+
 /**
  * @brief the probability of selecting a branch is high
  */
@@ -0,0 +1,165 @@
+/**
+ * @name sirius_config.h
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief 运行时配置
+ * 
+ * @details
+ * (1) 每个配置项是一个整数，由模块注册，注册后不会被删除
+ * 
+ * (2) 读取单个配置项： sirius_cfg_get(id)，一次原子读，无锁、无等待
+ * 
+ * (3) 读取多个配置项的一致视图：
+ *  sirius_cfg_snap_acquire() / sirius_cfg_snap_release()
+ *  快照不会被修改，旧快照在所有读者离开后释放
+ * 
+ * (4) 通过管道修改配置： echo config [key] [value] > log_pipe
+ *  列出所有配置项： echo config > log_pipe
+ * 
+ * (5) 修改配置的线程互斥，读者不受影响
+ */
+
+#ifndef __SIRIUS_CONFIG_H__
+#define __SIRIUS_CONFIG_H__
+
+#include "sirius_attributes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 配置项的最大数量
+ */
+#ifndef SIRIUS_CFG_KEY_MAX
+#define SIRIUS_CFG_KEY_MAX 64
+#endif // SIRIUS_CFG_KEY_MAX
+
+/* maximum length of a key name, including '\0' */
+#define SIRIUS_CFG_NAME_SIZE 80
+
+typedef struct {
+    /* key name, such as "log.sink" */
+    const char *p_name;
+
+    /* default value */
+    long long def;
+    /* valid range, inclusive */
+    long long min;
+    long long max;
+
+    /**
+     * optional, returns an error code to reject a value
+     * that lies within the range
+     */
+    int (*p_check)(long long val);
+
+    /**
+     * optional, called once the new value is published,
+     * with the writers serialized
+     *
+     * @note `sirius_cfg_set` must not be called from it
+     */
+    void (*p_notify)(long long val);
+} sirius_cfg_attr_t;
+
+/**
+ * @brief an immutable view of all the keys
+ */
+typedef struct {
+    /* incremented by every update */
+    unsigned long long version;
+    /* number of registered keys */
+    unsigned int nr;
+    long long vals[SIRIUS_CFG_KEY_MAX];
+} sirius_cfg_snap_t;
+
+/**
+ * @brief the current value of every key, read by `sirius_cfg_get`
+ * 
+ * @note do not write it, use `sirius_cfg_set`
+ */
+extern long long sirius_cfg_val[SIRIUS_CFG_KEY_MAX];
+
+/**
+ * @brief register a key, registering an existing name returns
+ *  its id and leaves the value unchanged
+ * 
+ * @param[in] p_attr: key attributes
+ * 
+ * @note like `sirius_cfg_set`, it fails inside a read section
+ * 
+ * @return the key id on success, error code otherwise
+ */
+int
+sirius_cfg_register(const sirius_cfg_attr_t *p_attr);
+
+/**
+ * @return the key id, error code if the name is not registered
+ */
+int
+sirius_cfg_find(const char *p_name);
+
+/**
+ * @return the name of the key, NULL if the id is not registered
+ */
+const char *
+sirius_cfg_name(int id);
+
+/**
+ * @brief publish a new value, waits until the readers of the
+ *  previous snapshot have left
+ * 
+ * @param[in] id: key id
+ * @param[in] val: new value
+ * 
+ * @note a thread between `sirius_cfg_snap_acquire` and
+ *  `sirius_cfg_snap_release` would wait for itself, the call
+ *  fails with `SIRIUS_ERR_RESOURCE_REQUEST` instead
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_cfg_set(int id, long long val);
+
+/**
+ * @brief `sirius_cfg_set` by the key name
+ */
+int
+sirius_cfg_set_name(const char *p_name, long long val);
+
+/**
+ * @brief the current value of a key, a single relaxed load
+ * 
+ * @param[in] id: key id returned by `sirius_cfg_register`
+ */
+static force_inline long long
+sirius_cfg_get(int id)
+{
+    return __atomic_load_n(&(sirius_cfg_val[id]), __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief enter a read section and get the current snapshot
+ * 
+ * @note wait-free; nested calls in a thread return the snapshot
+ *  of the outermost one, each call needs its own release
+ */
+const sirius_cfg_snap_t *
+sirius_cfg_snap_acquire();
+
+/**
+ * @brief leave the read section, the snapshot must not be
+ *  used afterwards
+ */
+void
+sirius_cfg_snap_release();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIRIUS_CONFIG_H__
@@ -0,0 +1,142 @@
+/**
+ * @name sirius_cpu.h
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief cpu 特性与缓存信息，按指令集分派函数
+ * 
+ * @details
+ * (1) 指令集特性来自 cpuid，并检查操作系统是否保存了对应的寄存器
+ *  状态（xgetbv），第一次查询时检测，不调用 libc，可在 ifunc 解析函数
+ *  与构造函数中使用
+ * 
+ * (2) 缓存信息优先读取 /sys/devices/system/cpu/cpu0/cache，
+ *  读不到时使用 cpuid 的确定性缓存参数，由 `sirius_cpu_init` 检测，
+ *  `sirius_init` 会调用它
+ * 
+ * (3) 模块以 `sirius_cpu_impl_t` 数组列出同一函数的各个实现，
+ *  或填写一组函数指针的函数，`sirius_cpu_select` 选出 cpu 支持的
+ *  第一个，由模块在构造函数、ifunc 解析函数或第一次调用时解析一次
+ */
+
+#ifndef __SIRIUS_CPU_H__
+#define __SIRIUS_CPU_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "sirius_attributes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief instruction set features, a bit each
+ * 
+ * @note a feature whose registers the os does not save is reported
+ *  as missing
+ */
+typedef enum {
+    SIRIUS_CPU_SSE2         = 1U << 0,
+    SIRIUS_CPU_SSE42        = 1U << 1,
+    SIRIUS_CPU_POPCNT       = 1U << 2,
+    SIRIUS_CPU_AVX          = 1U << 3,
+    SIRIUS_CPU_AVX2         = 1U << 4,
+    SIRIUS_CPU_FMA          = 1U << 5,
+    SIRIUS_CPU_BMI1         = 1U << 6,
+    SIRIUS_CPU_BMI2         = 1U << 7,
+    SIRIUS_CPU_AVX512F      = 1U << 8,
+    SIRIUS_CPU_AVX512BW     = 1U << 9,
+    SIRIUS_CPU_AVX512DQ     = 1U << 10,
+    SIRIUS_CPU_AVX512VL     = 1U << 11,
+
+    SIRIUS_CPU_FEAT_NR      = 12,
+} sirius_cpu_feat_t;
+
+/**
+ * @brief cache geometry, unit: byte, 0 if unknown
+ */
+typedef struct {
+    unsigned int line;
+    size_t l1d;
+    size_t l2;
+    size_t l3;
+} sirius_cpu_cache_t;
+
+/**
+ * @return the features of the cpu, OR of `sirius_cpu_feat_t`
+ */
+unsigned int
+sirius_cpu_features();
+
+/**
+ * @brief whether the cpu has every feature of `feats`
+ */
+static force_inline bool
+sirius_cpu_has(unsigned int feats)
+{
+    return feats == (sirius_cpu_features() & feats);
+}
+
+/**
+ * @return the name of a single feature, such as "avx2",
+ *  NULL if `feat` is not one
+ */
+const char *
+sirius_cpu_feat_name(sirius_cpu_feat_t feat);
+
+/**
+ * @brief detect the caches, called by `sirius_init`
+ * 
+ * @note repeated calls keep the first result
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_cpu_init();
+
+/**
+ * @return the cache geometry, detected on first use if
+ *  `sirius_cpu_init` has not been called
+ */
+const sirius_cpu_cache_t *
+sirius_cpu_cache();
+
+/**
+ * @brief generic function pointer of a dispatch table,
+ *  cast to and from the real type
+ */
+typedef void (*sirius_cpu_fn_t)();
+
+/**
+ * @brief one implementation of a dispatched function
+ */
+typedef struct {
+    /* features it needs, 0 for the portable one */
+    unsigned int need;
+    sirius_cpu_fn_t p_fn;
+} sirius_cpu_impl_t;
+
+/**
+ * @brief pick an implementation
+ * 
+ * @param[in] p_impl: implementations, the preferred one first
+ * @param[in] nr: number of implementations
+ * 
+ * @note safe in an ifunc resolver; end the table with an entry
+ *  needing 0 so that there always is a match
+ * 
+ * @return the first implementation whose needs the cpu meets,
+ *  NULL if there is none
+ */
+sirius_cpu_fn_t
+sirius_cpu_select(const sirius_cpu_impl_t *p_impl, size_t nr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIRIUS_CPU_H__
@@ -18,6 +18,7 @@
 #define SIRIUS_ERR_TIMEOUT              (-10000)        // 超时
 #define SIRIUS_ERR_NULL_POINTER         (-10001)        // 指针为空
 #define SIRIUS_ERR_INVALID_PARAMETER    (-10002)        // 参数无效
+#define SIRIUS_ERR_NOT_FOUND            (-10003)        // 未找到
 
 /* function */
 #define SIRIUS_ERR_INVALID_ENTRY        (-11000)        // 函数入参无效
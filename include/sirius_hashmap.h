@@ -0,0 +1,237 @@
+/**
+ * @name sirius_hashmap.h
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief 开放寻址哈希表
+ * 
+ * @details
+ * (1) Swiss table 结构：每个槽位有一个控制字节（空、已删除或哈希的低 7 位），
+ *  查找时一次比较一组控制字节（SSE2 16 个，AVX2 32 个，其余平台 8 个），
+ *  只有控制字节相同的槽位才比较键；指令集与 sirius_math 相同，
+ *  可由 SIRIUS_MATH_ISA 环境变量降低
+ * 
+ * (2) 键为 64 位整数或字节串（复制保存），值为 size_t；
+ *  可指定哈希函数与种子
+ * 
+ * (3) 负载超过 7/8 时容量翻倍；sirius_hashmap_reserve 预留容量，
+ *  sirius_hashmap_rehash 重建（清除删除标记或缩小容量）
+ * 
+ * (4) 遍历不申请内存：sirius_hashmap_next 或 sirius_hashmap_foreach
+ * 
+ * (5) 创建时 `stripes` 非 0 则为并发哈希表：按哈希分为多个分段，
+ *  每段一个读写锁，查找只加读锁，适合读多写少的场景
+ */
+
+#ifndef __SIRIUS_HASHMAP_H__
+#define __SIRIUS_HASHMAP_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sirius_attributes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* upper limit of `stripes` */
+#define SIRIUS_HASHMAP_STRIPE_MAX   (1024)
+
+typedef enum {
+    /* uint64_t keys */
+    SIRIUS_HASHMAP_KEY_INT = 0,
+    /* byte strings, copied into the map */
+    SIRIUS_HASHMAP_KEY_BYTES,
+
+    SIRIUS_HASHMAP_KEY_MAX,
+} sirius_hashmap_key_t;
+
+/**
+ * @brief hash function, an integer key is passed as its 8 bytes;
+ *  all 64 bits of the result are used
+ */
+typedef uint64_t (*sirius_hashmap_hash_t)(const void *p_key, size_t len,
+    uint64_t seed);
+
+typedef void* sirius_hashmap_handle;
+
+typedef struct {
+    sirius_hashmap_key_t key_type;
+    /* hash function, NULL for the built-in one */
+    sirius_hashmap_hash_t p_hash;
+    uint64_t seed;
+    /* number of elements to make room for, may be 0 */
+    size_t capacity;
+    /**
+     * 0 for a map without locking; otherwise the number of lock
+     * stripes, rounded up to a power of 2, and every call is
+     * thread-safe except `sirius_hashmap_next`
+     */
+    unsigned int stripes;
+} sirius_hashmap_cr_t;
+
+typedef struct {
+    /* integer key */
+    uint64_t key;
+    /* byte-string key, NULL for integer keys */
+    const void *p_key;
+    size_t len;
+    /* the value in the map, may be written */
+    size_t *p_value;
+} sirius_hashmap_entry_t;
+
+/* iterator, initialized to `SIRIUS_HASHMAP_ITER_INIT` */
+typedef struct {
+    unsigned int stripe;
+    size_t pos;
+} sirius_hashmap_iter_t;
+
+#define SIRIUS_HASHMAP_ITER_INIT {0, 0}
+
+/**
+ * @brief the built-in hash of byte strings
+ */
+uint64_t
+sirius_hashmap_hash(const void *p_key, size_t len, uint64_t seed);
+
+/**
+ * @brief create a hash map,
+ *  the resulting handle must be deleted using `sirius_hashmap_del`
+ * 
+ * @param[in] p_cr: creation parameters
+ * @param[out] p_handle: hash map handle
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_hashmap_cr(const sirius_hashmap_cr_t *p_cr,
+    sirius_hashmap_handle *p_handle);
+
+int
+sirius_hashmap_del(sirius_hashmap_handle handle);
+
+/**
+ * @brief insert an integer key or replace its value
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_hashmap_put_int(sirius_hashmap_handle handle, uint64_t key,
+    size_t value);
+
+/**
+ * @param[out] p_value: the value, may be NULL
+ * 
+ * @return 0 if found, `SIRIUS_ERR_NOT_FOUND` if not, error code otherwise
+ */
+int
+sirius_hashmap_get_int(sirius_hashmap_handle handle, uint64_t key,
+    size_t *p_value);
+
+/**
+ * @return 0 if removed, `SIRIUS_ERR_NOT_FOUND` if not, error code otherwise
+ */
+int
+sirius_hashmap_erase_int(sirius_hashmap_handle handle, uint64_t key);
+
+/**
+ * @brief insert a byte-string key or replace its value
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_hashmap_put(sirius_hashmap_handle handle, const void *p_key,
+    size_t len, size_t value);
+
+/**
+ * @param[out] p_value: the value, may be NULL
+ * 
+ * @return 0 if found, `SIRIUS_ERR_NOT_FOUND` if not, error code otherwise
+ */
+int
+sirius_hashmap_get(sirius_hashmap_handle handle, const void *p_key,
+    size_t len, size_t *p_value);
+
+/**
+ * @return 0 if removed, `SIRIUS_ERR_NOT_FOUND` if not, error code otherwise
+ */
+int
+sirius_hashmap_erase(sirius_hashmap_handle handle, const void *p_key,
+    size_t len);
+
+/**
+ * @return the number of elements
+ */
+size_t
+sirius_hashmap_size(sirius_hashmap_handle handle);
+
+/**
+ * @return the number of elements that fit before the map grows
+ */
+size_t
+sirius_hashmap_capacity(sirius_hashmap_handle handle);
+
+/**
+ * @brief make room for `n` elements in total
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_hashmap_reserve(sirius_hashmap_handle handle, size_t n);
+
+/**
+ * @brief rebuild the map to fit `n` elements, or the current ones if
+ *  there are more; it drops the deletion marks and may shrink it
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_hashmap_rehash(sirius_hashmap_handle handle, size_t n);
+
+/**
+ * @brief remove all elements, the capacity is kept
+ */
+int
+sirius_hashmap_clear(sirius_hashmap_handle handle);
+
+/**
+ * @brief the next element
+ * 
+ * @note the map must not be modified during the iteration, except
+ *  through `p_value` and by erasing the current element; on a map
+ *  with stripes no other thread may write it
+ * 
+ * @return false at the end
+ */
+bool
+sirius_hashmap_next(sirius_hashmap_handle handle,
+    sirius_hashmap_iter_t *p_it, sirius_hashmap_entry_t *p_ent);
+
+/**
+ * @brief call `p_fn` on every element until it returns non-zero;
+ *  on a map with stripes each stripe is write-locked in turn
+ * 
+ * @note `p_fn` may write `p_value` but must not modify the map
+ * 
+ * @return 0 if all elements were visited, else the value of `p_fn`
+ */
+int
+sirius_hashmap_foreach(sirius_hashmap_handle handle,
+    int (*p_fn)(const sirius_hashmap_entry_t *p_ent, void *p_arg),
+    void *p_arg);
+
+/**
+ * @brief the instruction set of the probing, "avx2", "sse2" or "scalar"
+ */
+const char *
+sirius_hashmap_isa();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIRIUS_HASHMAP_H__
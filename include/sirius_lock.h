@@ -0,0 +1,337 @@
+/**
+ * @name sirius_lock.h
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief 轻量级锁
+ * 
+ * @details
+ * (1) sirius_mtx_t: 先自旋后休眠（futex）的互斥锁，
+ *  无竞争时加锁、解锁各为一次原子操作
+ * 
+ * (2) sirius_ticket_t: 排队自旋锁，按申请顺序获得锁，
+ *  适合临界区很短且需要公平性的场景
+ * 
+ * (3) sirius_rwlock_t: 基于 futex 的读写锁，写者优先
+ * 
+ * (4) sirius_seqlock_t: 顺序锁，读者不写共享内存，
+ *  读到的数据不一致时重试
+ * 
+ * (5) 所有锁均以 0 初始化，可静态定义，不需要销毁；
+ *  futex 为进程私有，不能放在进程间共享内存中
+ */
+
+#ifndef __SIRIUS_LOCK_H__
+#define __SIRIUS_LOCK_H__
+
+#include <stdbool.h>
+
+#include "sirius_attributes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief hint the cpu that the caller is spinning
+ */
+#ifndef sirius_cpu_relax
+#if defined(__x86_64__) || defined(__i386__)
+#define sirius_cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define sirius_cpu_relax() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define sirius_cpu_relax() __asm__ __volatile__("" ::: "memory")
+#endif
+#endif // sirius_cpu_relax
+
+/**
+ * 指数退避的最大自旋次数
+ * CFLAGS += -DSIRIUS_BACKOFF_MAX=$(SIRIUS_BACKOFF_MAX)
+ */
+#ifndef SIRIUS_BACKOFF_MAX
+#define SIRIUS_BACKOFF_MAX 1024
+#endif // SIRIUS_BACKOFF_MAX
+
+/**
+ * @brief exponential backoff, spins `*p_n` times and doubles it
+ *  up to `SIRIUS_BACKOFF_MAX`
+ * 
+ * @param[in,out] p_n: backoff state, initialized to 1
+ * 
+ * @return true once the maximum has been reached
+ */
+static force_inline bool
+sirius_backoff(unsigned int *p_n)
+{
+    for (unsigned int i = 0; i < *p_n; i++) {
+        sirius_cpu_relax();
+    }
+    if (*p_n >= SIRIUS_BACKOFF_MAX) return true;
+    *p_n <<= 1;
+    return false;
+}
+
+/* spin-then-futex mutex */
+
+typedef struct {
+    /* 0: unlocked, 1: locked, 2: locked and contended */
+    unsigned int state;
+} sirius_mtx_t;
+
+#define SIRIUS_MTX_INITIALIZER {0}
+
+void
+sirius_mtx_lock_slow(sirius_mtx_t *p_mtx);
+
+void
+sirius_mtx_unlock_slow(sirius_mtx_t *p_mtx);
+
+static force_inline void
+sirius_mtx_init(sirius_mtx_t *p_mtx)
+{
+    __atomic_store_n(&(p_mtx->state), 0, __ATOMIC_RELAXED);
+}
+
+static force_inline void
+sirius_mtx_lock(sirius_mtx_t *p_mtx)
+{
+    unsigned int c = 0;
+    if (likely(__atomic_compare_exchange_n(&(p_mtx->state), &c, 1,
+            false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))) {
+        return;
+    }
+    sirius_mtx_lock_slow(p_mtx);
+}
+
+/**
+ * @return true if the lock is acquired
+ */
+static force_inline bool
+sirius_mtx_trylock(sirius_mtx_t *p_mtx)
+{
+    unsigned int c = 0;
+    return __atomic_compare_exchange_n(&(p_mtx->state), &c, 1,
+        false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static force_inline void
+sirius_mtx_unlock(sirius_mtx_t *p_mtx)
+{
+    if (likely(1 == __atomic_fetch_sub(&(p_mtx->state), 1,
+            __ATOMIC_RELEASE))) {
+        return;
+    }
+    sirius_mtx_unlock_slow(p_mtx);
+}
+
+/* ticket lock */
+
+typedef struct {
+    /* the next ticket handed out */
+    unsigned int next;
+    /* the ticket being served */
+    unsigned int owner;
+} sirius_ticket_t;
+
+#define SIRIUS_TICKET_INITIALIZER {0, 0}
+
+void
+sirius_ticket_lock_slow(sirius_ticket_t *p_tk, unsigned int ticket);
+
+static force_inline void
+sirius_ticket_init(sirius_ticket_t *p_tk)
+{
+    __atomic_store_n(&(p_tk->next), 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&(p_tk->owner), 0, __ATOMIC_RELAXED);
+}
+
+static force_inline void
+sirius_ticket_lock(sirius_ticket_t *p_tk)
+{
+    unsigned int ticket = __atomic_fetch_add(&(p_tk->next), 1,
+        __ATOMIC_RELAXED);
+    if (likely(ticket == __atomic_load_n(&(p_tk->owner),
+            __ATOMIC_ACQUIRE))) {
+        return;
+    }
+    sirius_ticket_lock_slow(p_tk, ticket);
+}
+
+/**
+ * @return true if the lock is acquired
+ */
+static force_inline bool
+sirius_ticket_trylock(sirius_ticket_t *p_tk)
+{
+    unsigned int owner = __atomic_load_n(&(p_tk->owner),
+        __ATOMIC_ACQUIRE);
+    return __atomic_compare_exchange_n(&(p_tk->next), &owner,
+        owner + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static force_inline void
+sirius_ticket_unlock(sirius_ticket_t *p_tk)
+{
+    __atomic_store_n(&(p_tk->owner),
+        __atomic_load_n(&(p_tk->owner), __ATOMIC_RELAXED) + 1,
+        __ATOMIC_RELEASE);
+}
+
+/* futex-based rwlock, writers are preferred */
+
+typedef struct {
+    /* reader count, `SIRIUS_RWLOCK_WRITER` and `SIRIUS_RWLOCK_WAIT` */
+    unsigned int state;
+    /* number of threads sleeping on `state` */
+    unsigned int waiters;
+    /* number of writers in the slow path */
+    unsigned int writers;
+} sirius_rwlock_t;
+
+#define SIRIUS_RWLOCK_INITIALIZER {0, 0, 0}
+
+/* a writer holds the lock */
+#define SIRIUS_RWLOCK_WRITER    (0x80000000U)
+/**
+ * a writer is waiting, new readers hold back;
+ * a writer keeps it on acquiring while others still wait,
+ * so the lock passes from writer to writer
+ */
+#define SIRIUS_RWLOCK_WAIT      (0x40000000U)
+
+void
+sirius_rwlock_rdlock_slow(sirius_rwlock_t *p_rw);
+
+void
+sirius_rwlock_wrlock_slow(sirius_rwlock_t *p_rw);
+
+void
+sirius_rwlock_wake(sirius_rwlock_t *p_rw);
+
+static force_inline void
+sirius_rwlock_init(sirius_rwlock_t *p_rw)
+{
+    __atomic_store_n(&(p_rw->state), 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&(p_rw->waiters), 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&(p_rw->writers), 0, __ATOMIC_RELAXED);
+}
+
+static force_inline void
+sirius_rwlock_rdlock(sirius_rwlock_t *p_rw)
+{
+    unsigned int s = __atomic_load_n(&(p_rw->state), __ATOMIC_RELAXED);
+    if (likely(!(s & (SIRIUS_RWLOCK_WRITER | SIRIUS_RWLOCK_WAIT)) &&
+        __atomic_compare_exchange_n(&(p_rw->state), &s, s + 1,
+            false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))) {
+        return;
+    }
+    sirius_rwlock_rdlock_slow(p_rw);
+}
+
+static force_inline void
+sirius_rwlock_rdunlock(sirius_rwlock_t *p_rw)
+{
+    unsigned int s = __atomic_sub_fetch(&(p_rw->state), 1,
+        __ATOMIC_SEQ_CST);
+    /* the last reader lets a waiting writer in */
+    if (unlikely(SIRIUS_RWLOCK_WAIT == s)) {
+        sirius_rwlock_wake(p_rw);
+    }
+}
+
+static force_inline void
+sirius_rwlock_wrlock(sirius_rwlock_t *p_rw)
+{
+    unsigned int s = 0;
+    if (likely(__atomic_compare_exchange_n(&(p_rw->state), &s,
+            SIRIUS_RWLOCK_WRITER, false,
+            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))) {
+        return;
+    }
+    sirius_rwlock_wrlock_slow(p_rw);
+}
+
+static force_inline void
+sirius_rwlock_wrunlock(sirius_rwlock_t *p_rw)
+{
+    __atomic_and_fetch(&(p_rw->state), ~SIRIUS_RWLOCK_WRITER,
+        __ATOMIC_SEQ_CST);
+    sirius_rwlock_wake(p_rw);
+}
+
+/* seqlock */
+
+typedef struct {
+    /* odd while a writer is inside */
+    unsigned int seq;
+} sirius_seqlock_t;
+
+#define SIRIUS_SEQLOCK_INITIALIZER {0}
+
+void
+sirius_seqlock_wrlock_slow(sirius_seqlock_t *p_sl);
+
+static force_inline void
+sirius_seqlock_init(sirius_seqlock_t *p_sl)
+{
+    __atomic_store_n(&(p_sl->seq), 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief start a read section
+ * 
+ * @return the sequence to pass to `sirius_seqlock_read_retry`
+ */
+static force_inline unsigned int
+sirius_seqlock_read_begin(const sirius_seqlock_t *p_sl)
+{
+    unsigned int seq;
+    unsigned int n = 1;
+    while ((seq = __atomic_load_n(&(p_sl->seq), __ATOMIC_ACQUIRE)) & 1) {
+        (void)sirius_backoff(&n);
+    }
+    return seq;
+}
+
+/**
+ * @return true if a writer got in, the data read must be discarded
+ */
+static force_inline bool
+sirius_seqlock_read_retry(const sirius_seqlock_t *p_sl, unsigned int seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return seq != __atomic_load_n(&(p_sl->seq), __ATOMIC_RELAXED);
+}
+
+/**
+ * @note writers are serialized by the sequence itself
+ */
+static force_inline void
+sirius_seqlock_wrlock(sirius_seqlock_t *p_sl)
+{
+    unsigned int seq = __atomic_load_n(&(p_sl->seq), __ATOMIC_RELAXED);
+    if (likely(!(seq & 1) &&
+        __atomic_compare_exchange_n(&(p_sl->seq), &seq, seq + 1,
+            false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))) {
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        return;
+    }
+    sirius_seqlock_wrlock_slow(p_sl);
+}
+
+static force_inline void
+sirius_seqlock_wrunlock(sirius_seqlock_t *p_sl)
+{
+    __atomic_store_n(&(p_sl->seq),
+        __atomic_load_n(&(p_sl->seq), __ATOMIC_RELAXED) + 1,
+        __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIRIUS_LOCK_H__
@@ -12,11 +12,43 @@
  * 
  * (2) 控制日志打印等级方式： echo loglevel [lv] > log_pipe
  *  lv 参考 sirius_log_lv_t
+ *  单独控制某个模块的日志等级： echo loglevel [module] [lv] > log_pipe
+ *  module 即 LOG_MODULE_NAME
+ * 
+ * (3) 限频打印： SIRIUS_WARN_RATELIMIT(interval, burst, fmt, ...)
+ *  每个调用点在 interval 毫秒内最多打印 burst 条，
+ *  被丢弃的条数在下一次打印前输出
+ * 
+ * (4) 启用文件输出后，重新打开日志文件： echo logreopen > log_pipe
+ *  立即写出文件缓存： echo logflush > log_pipe
+ *  切换日志输出： echo logsink [stdout | file | shm] > log_pipe
+ * 
+ * (5) 输出日志统计信息： echo logstats > log_pipe
+ * 
+ * (6) 初始化时管道路径为空则不创建管道及控制线程
+ * 
+ * (7) 导出飞行记录器中的日志： echo logdump [path] > log_pipe
+ * 
+ * (8) 查看及修改运行时配置： echo config [key] [value] > log_pipe
+ *  日志等级为 log.lv、log.lv.rec、log.lv.[module]，输出为 log.sink
+ * 
+ * (9) 直接输出字节序列（协议帧、JSON 等），不格式化也不截断：
+ *  SIRIUS_INFO_BYTES(p_data, len)
+ * 
+ * (10) 区间追踪： echo trace [start | stop [path]] > log_pipe，
+ *  参考 sirius_trace.h
+ * 
+ * (11) 导出指标： echo metrics [path] > log_pipe，参考 sirius_metrics.h
  */
 
 #ifndef __SIRIUS_LOG_H__
 #define __SIRIUS_LOG_H__
 
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "sirius_attributes.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -30,6 +62,15 @@ extern "C" {
 #endif // LOG_MODULE_NAME
 
 
+/**
+ * 编译期日志等级，高于该等级的日志在编译期被移除，参数也不会被求值
+ * CFLAGS += -DSIRIUS_LOG_COMPILE_LV=$(SIRIUS_LOG_COMPILE_LV)
+ * 取值参考 sirius_log_lv_t
+ */
+#ifndef SIRIUS_LOG_COMPILE_LV
+#define SIRIUS_LOG_COMPILE_LV 5
+#endif // SIRIUS_LOG_COMPILE_LV
+
 #ifndef LOG_PRNT_BUF_SIZE_MAX
 #define LOG_PRNT_BUF_SIZE_MAX 20480
 #endif
@@ -62,6 +103,18 @@ extern "C" {
 #endif
 #endif // LOG_PRNT_BUF_SIZE
 
+/**
+ * 单条格式化日志内容的最大长度（含结尾 '\0'），
+ * 超过 LOG_PRNT_BUF_SIZE 的内容在线程缓存中重新格式化，
+ * 超过 LOG_PRNT_LEN_MAX - 1 字节的部分被截断；
+ * 线程缓存申请失败时截断到 LOG_PRNT_BUF_SIZE 以内。
+ * 更长的内容使用 SIRIUS_*_BYTES 输出，不受此限制
+ * CFLAGS += -DLOG_PRNT_LEN_MAX=$(LOG_PRNT_LEN_MAX)
+ */
+#ifndef LOG_PRNT_LEN_MAX
+#define LOG_PRNT_LEN_MAX (16 * 1024 * 1024)
+#endif // LOG_PRNT_LEN_MAX
+
 #ifndef SIRIUS_FILE
 #include <libgen.h>
 /**
@@ -85,6 +138,30 @@ extern "C" {
 /* 调整日志等级管道输入命令 */
 #define LOG_CMD_LV      "loglevel"
 
+/* 重新打开日志文件管道输入命令 */
+#define LOG_CMD_REOPEN  "logreopen"
+
+/* 立即写出日志文件缓存管道输入命令 */
+#define LOG_CMD_FLUSH   "logflush"
+
+/* 输出日志统计信息管道输入命令 */
+#define LOG_CMD_STATS   "logstats"
+
+/* 切换日志输出管道输入命令： logsink [stdout | file | shm] */
+#define LOG_CMD_SINK    "logsink"
+
+/* 导出飞行记录器管道输入命令： logdump [path] */
+#define LOG_CMD_DUMP    "logdump"
+
+/* 运行时配置管道输入命令： config [key] [value]，参考 sirius_config.h */
+#define LOG_CMD_CFG     "config"
+
+/* 区间追踪管道输入命令： trace [start | stop [path]]，参考 sirius_trace.h */
+#define LOG_CMD_TRACE   "trace"
+
+/* 导出指标管道输入命令： metrics [path]，参考 sirius_metrics.h */
+#define LOG_CMD_METRICS "metrics"
+
 /* 日志打印等级枚举 */
 typedef enum {
     SIRIUS_LOG_LV_0         = 0,    // 关闭日志打印
@@ -100,12 +177,221 @@ typedef enum {
     SIRIUS_LOG_LV_MAX,
 } sirius_log_lv_t;
 
+/* 日志时间戳精度 */
+typedef enum {
+    SIRIUS_LOG_TIME_PREC_SEC    = 0,    // HH:MM:SS, default
+    SIRIUS_LOG_TIME_PREC_MS     = 1,    // HH:MM:SS.mmm
+    SIRIUS_LOG_TIME_PREC_US     = 2,    // HH:MM:SS.uuuuuu
+
+    SIRIUS_LOG_TIME_PREC_MAX,
+} sirius_log_time_prec_t;
+
+/**
+ * @brief log file sink configuration
+ * 
+ * @details
+ * (1) the file is opened with `O_APPEND`, records are collected
+ *  in a user-space buffer and written out by a background thread
+ *  when the buffer is full or `flush_ms` has elapsed
+ * 
+ * (2) on rotation `path` is renamed to `path.1`, `path.1` to
+ *  `path.2` and so on, at most `retention` old files are kept
+ * 
+ * (3) the rename and reopen are done by the background thread,
+ *  logging threads are never blocked by them
+ * 
+ * (4) if `path` cannot be opened again, the records keep going to
+ *  the previous file and the open is retried about every second,
+ *  no rotation happens in between
+ */
+typedef struct {
+    /* log file path, the file sink is disabled when it is NULL */
+    char *p_path;
+
+    /* size of the write buffer, unit: byte, 0 means default */
+    unsigned int buf_size;
+    /* buffer flush interval, unit: ms, 0 means default */
+    unsigned int flush_ms;
+
+    /* rotate when the file reaches this size, unit: byte, 0 disables */
+    size_t rotate_size;
+    /* rotate at this interval, unit: s, 0 disables */
+    unsigned int rotate_sec;
+    /* number of rotated files kept */
+    unsigned int retention;
+
+    /* reopen the log file when SIGHUP is received */
+    bool sighup_reopen;
+} sirius_log_file_t;
+
+/* 日志输出目标 */
+typedef enum {
+    /* the shared-memory sink if configured, else the file sink
+     * if configured, else stdout/stderr */
+    SIRIUS_LOG_SINK_DEFAULT = 0,
+
+    SIRIUS_LOG_SINK_STDOUT  = 1,    // stdout/stderr
+    SIRIUS_LOG_SINK_FILE    = 2,    // refer to `sirius_log_file_t`
+    SIRIUS_LOG_SINK_SHM     = 3,    // refer to `sirius_log_shm_t`
+
+    SIRIUS_LOG_SINK_MAX,
+} sirius_log_sink_t;
+
+/**
+ * @brief shared-memory sink configuration
+ * 
+ * @details
+ * (1) records are published into a ring in a POSIX shared-memory
+ *  object that another process maps and drains, e.g. `sirius_logtail`,
+ *  a record costs one memcpy and no syscall
+ * 
+ * (2) writers never wait for readers, a reader that falls behind
+ *  loses the overwritten records and counts them
+ * 
+ * (3) an existing object of the same name is unlinked and a new one
+ *  created, so a restarted writer never truncates a ring that
+ *  readers still map; `sirius_logtail` follows the new object.
+ *  processes logging at once need distinct names
+ */
+typedef struct {
+    /* create the shared-memory sink */
+    bool enable;
+    /* name of the object, NULL means "/sirius-log" */
+    char *p_name;
+    /* size of the ring, unit: byte, 0 means default */
+    size_t size;
+    /* size of a slot, a longer record is truncated, 0 means default */
+    unsigned int slot_size;
+} sirius_log_shm_t;
+
+/**
+ * @brief flight recorder configuration
+ * 
+ * @details
+ * (1) the recorder keeps the most recent records in a ring,
+ *  including the levels that are filtered out of the sinks,
+ *  a record costs a few stores and takes no lock
+ * 
+ * (2) with `p_path` the ring is a shared mapping of that file,
+ *  so it survives a crash of the process, otherwise it is
+ *  anonymous memory; the file of the previous run is renamed
+ *  to `<p_path>.1`, both are read by the tool `sirius_logrec`
+ * 
+ * (3) the ring is dumped on SIGSEGV/SIGABRT/SIGBUS when
+ *  `crash_dump` is set, or by the pipe command `logdump`,
+ *  the records are written in the order of their cycle stamps,
+ *  which is the order they were logged on a machine with an
+ *  invariant, synchronized TSC
+ * 
+ * (4) a record longer than a slot is truncated, a record whose
+ *  slot is still being written by another thread of the slice
+ *  is dropped and counted, `sirius_logrec` reports both
+ */
+typedef struct {
+    /* size of the ring, unit: byte, 0 disables the recorder */
+    size_t size;
+    /**
+     * number of slices the ring is split into, 0 means default,
+     * threads are spread over the slices, so a single thread
+     * only sees `size / slice_nr` bytes of history
+     */
+    unsigned int slice_nr;
+    /**
+     * size of a slot, unit: byte, 0 means 1024,
+     * a record longer than `slot_size - 24` is truncated
+     */
+    unsigned int slot_size;
+    /* file backing the ring, NULL for anonymous memory */
+    char *p_path;
+    /* file the ring is dumped to, NULL for stderr */
+    char *p_dump;
+
+    /* the highest level recorded */
+    sirius_log_lv_t log_lv;
+
+    /* dump the ring from the crash signal handlers */
+    bool crash_dump;
+} sirius_log_recorder_t;
+
+/**
+ * @brief dump the flight recorder
+ * 
+ * @param[in] p_path: dump file, NULL for the configured one
+ * 
+ * @note async-signal-safe, fails while another dump is running
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_log_rec_dump(const char *p_path);
+
+/**
+ * @brief the highest level that any module currently prints,
+ *  read by `SIRIUS_LOG_ENABLED` before calling `sirius_log_print`
+ * 
+ * @note do not write it, use `sirius_log_lv_set`
+ */
+extern int sirius_log_lv_threshold;
+
+/**
+ * @brief set the log level at runtime
+ * 
+ * @param[in] p_mod: module name (`LOG_MODULE_NAME`),
+ *  NULL sets the level of the modules without their own level
+ * @param[in] log_lv: log level
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_log_lv_set(const char *p_mod, sirius_log_lv_t log_lv);
+
+/**
+ * @brief get the log level of a module
+ * 
+ * @param[in] p_mod: module name, NULL for the default level
+ * 
+ * @return the log level
+ */
+sirius_log_lv_t
+sirius_log_lv_get(const char *p_mod);
+
+/**
+ * @brief whether the level may be printed,
+ *  costs one relaxed load and one branch when it is not
+ * 
+ * @note no branch hint, whether a level is usually printed
+ *  depends on the call site
+ */
+#ifndef SIRIUS_LOG_ENABLED
+#define SIRIUS_LOG_ENABLED(lv) \
+    ((int)(lv) <= SIRIUS_LOG_COMPILE_LV && \
+    (int)(lv) <= \
+        __atomic_load_n(&sirius_log_lv_threshold, __ATOMIC_RELAXED))
+#endif // SIRIUS_LOG_ENABLED
+
+/**
+ * @brief the module of a call site, its level key is looked up
+ *  on the first record and kept here until a module is added
+ *  or removed
+ * 
+ * @note zero-initialize it apart from the name,
+ *  normally with `SIRIUS_LOG_MOD_INIT` in static storage
+ */
+typedef struct {
+    /* module name (`LOG_MODULE_NAME`) */
+    const char *p_name;
+    /* table generation in the high half, key id + 1 in the low */
+    unsigned long long key;
+} sirius_log_mod_t;
+
+#define SIRIUS_LOG_MOD_INIT(name) {(name), 0}
+
 /**
  * @brief log print
  * 
  * @param[in] log_lv: log level
  * @param[in] p_color: print color
- * @param[in] p_mod: module name
+ * @param[in] p_mod: module
  * @param[in] p_file: file
  * @param[in] p_func: function
  * @param[in] line: line
@@ -123,16 +409,138 @@ sirius_log_print(sirius_log_lv_t log_lv,
     int line,
     const char *p_fmt, ...);
 
+/**
+ * @brief `sirius_log_print` for a call site, which keeps the level
+ *  key of its module in `p_mod` instead of looking it up every time
+ * 
+ * @param[in,out] p_mod: module of the call site
+ */
+int
+sirius_log_print_mod(sirius_log_lv_t log_lv,
+    const char *p_color,
+    sirius_log_mod_t *p_mod,
+    const char *p_file,
+    const char *p_func,
+    int line,
+    const char *p_fmt, ...);
+
 #ifndef SIRIUS_LOG_WRITE
 #define SIRIUS_LOG_WRITE(lv, color, format, ...) \
     do { \
-        sirius_log_print(lv, color, \
-            LOG_MODULE_NAME, \
-            SIRIUS_FILE, __FUNCTION__, __LINE__, \
-            format, ##__VA_ARGS__); \
+        static sirius_log_mod_t i_log_mod_ = \
+            SIRIUS_LOG_MOD_INIT(LOG_MODULE_NAME); \
+        if (SIRIUS_LOG_ENABLED(lv)) { \
+            sirius_log_print_mod(lv, color, &i_log_mod_, \
+                SIRIUS_FILE, __FUNCTION__, __LINE__, \
+                format, ##__VA_ARGS__); \
+        } \
     } while (0)
 #endif
 
+/**
+ * @brief log a pre-built byte span, the payload is written
+ *  as it is without formatting, copying or truncation
+ * 
+ * @param[in] log_lv: log level
+ * @param[in] p_color: print color
+ * @param[in] p_mod: module
+ * @param[in] p_file: file
+ * @param[in] p_func: function
+ * @param[in] line: line
+ * @param[in] p_data: payload, a newline is appended
+ *  when it doesn't end with one
+ * @param[in] len: length of the payload
+ * 
+ * @return the length of the record on success,
+ *  error code otherwise
+ */
+int
+sirius_log_bytes(sirius_log_lv_t log_lv,
+    const char *p_color,
+    const char *p_mod,
+    const char *p_file,
+    const char *p_func,
+    int line,
+    const void *p_data,
+    size_t len);
+
+/**
+ * @brief `sirius_log_bytes` for a call site, as `sirius_log_print_mod`
+ * 
+ * @param[in,out] p_mod: module of the call site
+ */
+int
+sirius_log_bytes_mod(sirius_log_lv_t log_lv,
+    const char *p_color,
+    sirius_log_mod_t *p_mod,
+    const char *p_file,
+    const char *p_func,
+    int line,
+    const void *p_data,
+    size_t len);
+
+#ifndef SIRIUS_LOG_WRITE_BYTES
+#define SIRIUS_LOG_WRITE_BYTES(lv, color, p_data, len) \
+    do { \
+        static sirius_log_mod_t i_log_mod_ = \
+            SIRIUS_LOG_MOD_INIT(LOG_MODULE_NAME); \
+        if (SIRIUS_LOG_ENABLED(lv)) { \
+            sirius_log_bytes_mod(lv, color, &i_log_mod_, \
+                SIRIUS_FILE, __FUNCTION__, __LINE__, \
+                p_data, len); \
+        } \
+    } while (0)
+#endif // SIRIUS_LOG_WRITE_BYTES
+
+/**
+ * @brief rate limit state of a call site,
+ *  must be zero-initialized, normally in static storage
+ */
+typedef struct {
+    /* theoretical arrival time, unit: ns */
+    unsigned long long tat;
+    /* number of suppressed records */
+    unsigned int missed;
+} sirius_log_rl_t;
+
+/**
+ * @brief token bucket check of a call site
+ * 
+ * @param[in] p_rl: call site state
+ * @param[in] interval_ms: interval, unit: ms
+ * @param[in] burst: maximum number of records in an interval
+ * 
+ * @return -1 if the record is suppressed, otherwise the number
+ *  of records suppressed since the previous allowed one
+ */
+int
+sirius_log_ratelimit(sirius_log_rl_t *p_rl,
+    unsigned int interval_ms, unsigned int burst);
+
+#ifndef SIRIUS_LOG_WRITE_RATELIMIT
+#define SIRIUS_LOG_WRITE_RATELIMIT(lv, color, interval, burst, \
+    format, ...) \
+    do { \
+        static sirius_log_rl_t i_log_rl_; \
+        static sirius_log_mod_t i_log_mod_ = \
+            SIRIUS_LOG_MOD_INIT(LOG_MODULE_NAME); \
+        if (SIRIUS_LOG_ENABLED(lv)) { \
+            int i_log_missed_ = sirius_log_ratelimit( \
+                &i_log_rl_, interval, burst); \
+            if (unlikely(i_log_missed_ > 0)) { \
+                sirius_log_print_mod(lv, color, &i_log_mod_, \
+                    SIRIUS_FILE, __FUNCTION__, __LINE__, \
+                    "%d messages suppressed\n", i_log_missed_); \
+            } \
+            if (likely(i_log_missed_ >= 0)) { \
+                sirius_log_print_mod(lv, color, &i_log_mod_, \
+                    SIRIUS_FILE, __FUNCTION__, __LINE__, \
+                    format, ##__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+#endif // SIRIUS_LOG_WRITE_RATELIMIT
+
 #ifndef SIRIUS_PRNT
 #define SIRIUS_PRNT(format, ...) \
     SIRIUS_LOG_WRITE(SIRIUS_LOG_LV_DEFAULT, LOG_NONE, \
@@ -163,6 +571,54 @@ sirius_log_print(sirius_log_lv_t log_lv,
         format, ##__VA_ARGS__)
 #endif // SIRIUS_DEBG
 
+#ifndef SIRIUS_INFO_RATELIMIT
+#define SIRIUS_INFO_RATELIMIT(interval, burst, format, ...) \
+    SIRIUS_LOG_WRITE_RATELIMIT(SIRIUS_LOG_LV_INFO, LOG_GREEN, \
+        interval, burst, format, ##__VA_ARGS__)
+#endif // SIRIUS_INFO_RATELIMIT
+
+#ifndef SIRIUS_WARN_RATELIMIT
+#define SIRIUS_WARN_RATELIMIT(interval, burst, format, ...) \
+    SIRIUS_LOG_WRITE_RATELIMIT(SIRIUS_LOG_LV_WARN, LOG_YELLOW, \
+        interval, burst, format, ##__VA_ARGS__)
+#endif // SIRIUS_WARN_RATELIMIT
+
+#ifndef SIRIUS_ERROR_RATELIMIT
+#define SIRIUS_ERROR_RATELIMIT(interval, burst, format, ...) \
+    SIRIUS_LOG_WRITE_RATELIMIT(SIRIUS_LOG_LV_ERROR, LOG_RED, \
+        interval, burst, format, ##__VA_ARGS__)
+#endif // SIRIUS_ERROR_RATELIMIT
+
+#ifndef SIRIUS_DEBG_RATELIMIT
+#define SIRIUS_DEBG_RATELIMIT(interval, burst, format, ...) \
+    SIRIUS_LOG_WRITE_RATELIMIT(SIRIUS_LOG_LV_DEBG, LOG_NONE, \
+        interval, burst, format, ##__VA_ARGS__)
+#endif // SIRIUS_DEBG_RATELIMIT
+
+#ifndef SIRIUS_INFO_BYTES
+#define SIRIUS_INFO_BYTES(p_data, len) \
+    SIRIUS_LOG_WRITE_BYTES(SIRIUS_LOG_LV_INFO, LOG_GREEN, \
+        p_data, len)
+#endif // SIRIUS_INFO_BYTES
+
+#ifndef SIRIUS_WARN_BYTES
+#define SIRIUS_WARN_BYTES(p_data, len) \
+    SIRIUS_LOG_WRITE_BYTES(SIRIUS_LOG_LV_WARN, LOG_YELLOW, \
+        p_data, len)
+#endif // SIRIUS_WARN_BYTES
+
+#ifndef SIRIUS_ERROR_BYTES
+#define SIRIUS_ERROR_BYTES(p_data, len) \
+    SIRIUS_LOG_WRITE_BYTES(SIRIUS_LOG_LV_ERROR, LOG_RED, \
+        p_data, len)
+#endif // SIRIUS_ERROR_BYTES
+
+#ifndef SIRIUS_DEBG_BYTES
+#define SIRIUS_DEBG_BYTES(p_data, len) \
+    SIRIUS_LOG_WRITE_BYTES(SIRIUS_LOG_LV_DEBG, LOG_NONE, \
+        p_data, len)
+#endif // SIRIUS_DEBG_BYTES
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,15 +11,328 @@
 #ifndef __SIRIUS_MATH_H__
 #define __SIRIUS_MATH_H__
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sirius_attributes.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief the maximum element of an array
+ * 
+ * @param[in] p_arr: array
+ * @param[in] n: number of elements
+ * 
+ * @note the kernel is chosen once at load time, refer to
+ *  `sirius_math_isa`; NaN elements give an unspecified result
+ * 
+ * @return the maximum element, the lowest value of the type
+ *  (-INFINITY for floating point) if the array is empty
+ */
+int8_t sirius_math_max_i8(const int8_t *p_arr, size_t n);
+int16_t sirius_math_max_i16(const int16_t *p_arr, size_t n);
+int32_t sirius_math_max_i32(const int32_t *p_arr, size_t n);
+int64_t sirius_math_max_i64(const int64_t *p_arr, size_t n);
+uint8_t sirius_math_max_u8(const uint8_t *p_arr, size_t n);
+uint16_t sirius_math_max_u16(const uint16_t *p_arr, size_t n);
+uint32_t sirius_math_max_u32(const uint32_t *p_arr, size_t n);
+uint64_t sirius_math_max_u64(const uint64_t *p_arr, size_t n);
+float sirius_math_max_f32(const float *p_arr, size_t n);
+double sirius_math_max_f64(const double *p_arr, size_t n);
+
+/**
+ * @brief the minimum element of an array
+ * 
+ * @param[in] p_arr: array
+ * @param[in] n: number of elements
+ * 
+ * @return the minimum element, the highest value of the type
+ *  (INFINITY for floating point) if the array is empty
+ */
+int8_t sirius_math_min_i8(const int8_t *p_arr, size_t n);
+int16_t sirius_math_min_i16(const int16_t *p_arr, size_t n);
+int32_t sirius_math_min_i32(const int32_t *p_arr, size_t n);
+int64_t sirius_math_min_i64(const int64_t *p_arr, size_t n);
+uint8_t sirius_math_min_u8(const uint8_t *p_arr, size_t n);
+uint16_t sirius_math_min_u16(const uint16_t *p_arr, size_t n);
+uint32_t sirius_math_min_u32(const uint32_t *p_arr, size_t n);
+uint64_t sirius_math_min_u64(const uint64_t *p_arr, size_t n);
+float sirius_math_min_f32(const float *p_arr, size_t n);
+double sirius_math_min_f64(const double *p_arr, size_t n);
+
+/**
+ * @brief the minimum and the maximum element of an array
+ *  in a single pass
+ * 
+ * @param[in] p_arr: array
+ * @param[in] n: number of elements
+ * @param[out] p_min: the minimum element
+ * @param[out] p_max: the maximum element
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int sirius_math_minmax_i8(const int8_t *p_arr, size_t n,
+    int8_t *p_min, int8_t *p_max);
+int sirius_math_minmax_i16(const int16_t *p_arr, size_t n,
+    int16_t *p_min, int16_t *p_max);
+int sirius_math_minmax_i32(const int32_t *p_arr, size_t n,
+    int32_t *p_min, int32_t *p_max);
+int sirius_math_minmax_i64(const int64_t *p_arr, size_t n,
+    int64_t *p_min, int64_t *p_max);
+int sirius_math_minmax_u8(const uint8_t *p_arr, size_t n,
+    uint8_t *p_min, uint8_t *p_max);
+int sirius_math_minmax_u16(const uint16_t *p_arr, size_t n,
+    uint16_t *p_min, uint16_t *p_max);
+int sirius_math_minmax_u32(const uint32_t *p_arr, size_t n,
+    uint32_t *p_min, uint32_t *p_max);
+int sirius_math_minmax_u64(const uint64_t *p_arr, size_t n,
+    uint64_t *p_min, uint64_t *p_max);
+int sirius_math_minmax_f32(const float *p_arr, size_t n,
+    float *p_min, float *p_max);
+int sirius_math_minmax_f64(const double *p_arr, size_t n,
+    double *p_min, double *p_max);
+
+/* the largest array `sirius_math_sort_*` accepts */
+#define SIRIUS_MATH_SORT_MAX (64)
+
+/**
+ * @brief sort a small array in ascending order, in place
+ * 
+ * @param[in,out] p_arr: array
+ * @param[in] n: number of elements, [0, SIRIUS_MATH_SORT_MAX]
+ * 
+ * @note the array is padded to the next power of 2 with the highest
+ *  value of the type and sorted by a bitonic network, which is
+ *  vectorized for 32-bit and 64-bit elements once the network spans
+ *  a whole vector; NaN elements give an unspecified result
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int sirius_math_sort_i8(int8_t *p_arr, size_t n);
+int sirius_math_sort_i16(int16_t *p_arr, size_t n);
+int sirius_math_sort_i32(int32_t *p_arr, size_t n);
+int sirius_math_sort_i64(int64_t *p_arr, size_t n);
+int sirius_math_sort_u8(uint8_t *p_arr, size_t n);
+int sirius_math_sort_u16(uint16_t *p_arr, size_t n);
+int sirius_math_sort_u32(uint32_t *p_arr, size_t n);
+int sirius_math_sort_u64(uint64_t *p_arr, size_t n);
+int sirius_math_sort_f32(float *p_arr, size_t n);
+int sirius_math_sort_f64(double *p_arr, size_t n);
+
+typedef enum {
+    /* the largest elements, in descending order */
+    SIRIUS_MATH_TOPK_LARGEST = 0,
+
+    /* the smallest elements, in ascending order */
+    SIRIUS_MATH_TOPK_SMALLEST = 1,
+} sirius_math_topk_t;
+
+/**
+ * @brief the `k` largest or smallest elements of an array
+ *  and their indices
+ * 
+ * @param[in] p_arr: array
+ * @param[in] n: number of elements
+ * @param[in] k: number of elements to select, [0, n]
+ * @param[in] order: refer `sirius_math_topk_t`
+ * @param[out] p_val: `k` elements, the best first, may be NULL
+ * @param[out] p_idx: `k` indices into `p_arr`, may be NULL
+ * 
+ * @note equal elements are ordered by index, the lower first.
+ *  the vectors that cannot beat the k-th best element found so far
+ *  are skipped, the rest is narrowed by partitioning, so a small `k`
+ *  costs about one pass over the array; NaN elements give
+ *  an unspecified result
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int sirius_math_topk_i8(const int8_t *p_arr, size_t n, size_t k,
+    sirius_math_topk_t order, int8_t *p_val, size_t *p_idx);
+int sirius_math_topk_i16(const int16_t *p_arr, size_t n, size_t k,
+    sirius_math_topk_t order, int16_t *p_val, size_t *p_idx);
+int sirius_math_topk_i32(const int32_t *p_arr, size_t n, size_t k,
+    sirius_math_topk_t order, int32_t *p_val, size_t *p_idx);
+int sirius_math_topk_i64(const int64_t *p_arr, size_t n, size_t k,
+    sirius_math_topk_t order, int64_t *p_val, size_t *p_idx);
+int sirius_math_topk_u8(const uint8_t *p_arr, size_t n, size_t k,
+    sirius_math_topk_t order, uint8_t *p_val, size_t *p_idx);
+int sirius_math_topk_u16(const uint16_t *p_arr, size_t n, size_t k,
+    sirius_math_topk_t order, uint16_t *p_val, size_t *p_idx);
+int sirius_math_topk_u32(const uint32_t *p_arr, size_t n, size_t k,
+    sirius_math_topk_t order, uint32_t *p_val, size_t *p_idx);
+int sirius_math_topk_u64(const uint64_t *p_arr, size_t n, size_t k,
+    sirius_math_topk_t order, uint64_t *p_val, size_t *p_idx);
+int sirius_math_topk_f32(const float *p_arr, size_t n, size_t k,
+    sirius_math_topk_t order, float *p_val, size_t *p_idx);
+int sirius_math_topk_f64(const double *p_arr, size_t n, size_t k,
+    sirius_math_topk_t order, double *p_val, size_t *p_idx);
+
+/**
+ * the environment variable that lowers the instruction set of the
+ * array kernels, such as `SIRIUS_MATH_ISA=sse2`; it is read once at
+ * load time, a set the cpu lacks or an unknown name is ignored
+ */
+#define SIRIUS_MATH_ISA_ENV "SIRIUS_MATH_ISA"
+
+/**
+ * @brief the instruction set of the array kernels,
+ *  "avx512", "avx2", "sse2" or "scalar"
+ */
+const char *sirius_math_isa(void);
+
+/**
+ * @brief accumulation of the sums
+ */
+typedef enum {
+    /* pairwise over blocks of SIMD accumulators, error ~ log2(n) */
+    SIRIUS_MATH_ACC_FAST = 0,
+
+    /**
+     * Kahan compensated, error independent of n, about half the speed;
+     * with an inf or an overflow the result is the fast one
+     */
+    SIRIUS_MATH_ACC_COMP = 1,
+} sirius_math_acc_t;
+
+/**
+ * @brief the sum of an array
+ * 
+ * @param[in] p_arr: array
+ * @param[in] n: number of elements
+ * @param[in] acc: accumulation, refer `sirius_math_acc_t`
+ * 
+ * @return the sum, 0 if the array is empty
+ */
+float sirius_math_sum_f32(const float *p_arr, size_t n,
+    sirius_math_acc_t acc);
+double sirius_math_sum_f64(const double *p_arr, size_t n,
+    sirius_math_acc_t acc);
+
+/**
+ * @brief the dot product of two arrays of `n` elements
+ * 
+ * @note the products are rounded before they are summed,
+ *  `SIRIUS_MATH_ACC_COMP` compensates the summation only
+ * 
+ * @return the dot product, 0 if the arrays are empty
+ */
+float sirius_math_dot_f32(const float *p_x, const float *p_y, size_t n,
+    sirius_math_acc_t acc);
+double sirius_math_dot_f64(const double *p_x, const double *p_y, size_t n,
+    sirius_math_acc_t acc);
+
+/**
+ * @brief the euclidean norm, sqrt(dot(x, x))
+ * 
+ * @note when the squares overflow or underflow the elements are
+ *  scaled by the largest magnitude first, as the blas nrm2
+ */
+float sirius_math_l2norm_f32(const float *p_arr, size_t n,
+    sirius_math_acc_t acc);
+double sirius_math_l2norm_f64(const double *p_arr, size_t n,
+    sirius_math_acc_t acc);
+
+/**
+ * @return the arithmetic mean, NAN if the array is empty
+ */
+float sirius_math_mean_f32(const float *p_arr, size_t n,
+    sirius_math_acc_t acc);
+double sirius_math_mean_f64(const double *p_arr, size_t n,
+    sirius_math_acc_t acc);
+
+/**
+ * 并行归约的分块大小（字节），结果只取决于分块，与线程数无关
+ * CFLAGS += -DSIRIUS_MATH_PAR_CHUNK=$(SIRIUS_MATH_PAR_CHUNK)
+ */
+#ifndef SIRIUS_MATH_PAR_CHUNK
+#define SIRIUS_MATH_PAR_CHUNK (256 * 1024)
+#endif // SIRIUS_MATH_PAR_CHUNK
+
+/**
+ * 并行归约的最大线程数（包括调用者）
+ * CFLAGS += -DSIRIUS_MATH_PAR_THREAD_MAX=$(SIRIUS_MATH_PAR_THREAD_MAX)
+ */
+#ifndef SIRIUS_MATH_PAR_THREAD_MAX
+#define SIRIUS_MATH_PAR_THREAD_MAX 64
+#endif // SIRIUS_MATH_PAR_THREAD_MAX
+
+/**
+ * @brief the `_par` variants split the array into chunks of
+ *  `SIRIUS_MATH_PAR_CHUNK` bytes, reduce them on a persistent worker
+ *  team together with the caller and combine the partial results
+ * 
+ * @note configuration keys, refer to sirius_config.h:
+ *  "math.par.min": arrays smaller than this (bytes) are reduced by
+ *   the caller alone
+ *  "math.par.threads": the most threads taking part, 0 for one per
+ *   online cpu
+ *  a call made while another one holds the team runs in the caller
+ * 
+ * @return the same as the single-threaded function
+ */
+int8_t sirius_math_max_i8_par(const int8_t *p_arr, size_t n);
+int16_t sirius_math_max_i16_par(const int16_t *p_arr, size_t n);
+int32_t sirius_math_max_i32_par(const int32_t *p_arr, size_t n);
+int64_t sirius_math_max_i64_par(const int64_t *p_arr, size_t n);
+uint8_t sirius_math_max_u8_par(const uint8_t *p_arr, size_t n);
+uint16_t sirius_math_max_u16_par(const uint16_t *p_arr, size_t n);
+uint32_t sirius_math_max_u32_par(const uint32_t *p_arr, size_t n);
+uint64_t sirius_math_max_u64_par(const uint64_t *p_arr, size_t n);
+float sirius_math_max_f32_par(const float *p_arr, size_t n);
+double sirius_math_max_f64_par(const double *p_arr, size_t n);
+
+int8_t sirius_math_min_i8_par(const int8_t *p_arr, size_t n);
+int16_t sirius_math_min_i16_par(const int16_t *p_arr, size_t n);
+int32_t sirius_math_min_i32_par(const int32_t *p_arr, size_t n);
+int64_t sirius_math_min_i64_par(const int64_t *p_arr, size_t n);
+uint8_t sirius_math_min_u8_par(const uint8_t *p_arr, size_t n);
+uint16_t sirius_math_min_u16_par(const uint16_t *p_arr, size_t n);
+uint32_t sirius_math_min_u32_par(const uint32_t *p_arr, size_t n);
+uint64_t sirius_math_min_u64_par(const uint64_t *p_arr, size_t n);
+float sirius_math_min_f32_par(const float *p_arr, size_t n);
+double sirius_math_min_f64_par(const double *p_arr, size_t n);
+
+int sirius_math_minmax_i8_par(const int8_t *p_arr, size_t n,
+    int8_t *p_min, int8_t *p_max);
+int sirius_math_minmax_i16_par(const int16_t *p_arr, size_t n,
+    int16_t *p_min, int16_t *p_max);
+int sirius_math_minmax_i32_par(const int32_t *p_arr, size_t n,
+    int32_t *p_min, int32_t *p_max);
+int sirius_math_minmax_i64_par(const int64_t *p_arr, size_t n,
+    int64_t *p_min, int64_t *p_max);
+int sirius_math_minmax_u8_par(const uint8_t *p_arr, size_t n,
+    uint8_t *p_min, uint8_t *p_max);
+int sirius_math_minmax_u16_par(const uint16_t *p_arr, size_t n,
+    uint16_t *p_min, uint16_t *p_max);
+int sirius_math_minmax_u32_par(const uint32_t *p_arr, size_t n,
+    uint32_t *p_min, uint32_t *p_max);
+int sirius_math_minmax_u64_par(const uint64_t *p_arr, size_t n,
+    uint64_t *p_min, uint64_t *p_max);
+int sirius_math_minmax_f32_par(const float *p_arr, size_t n,
+    float *p_min, float *p_max);
+int sirius_math_minmax_f64_par(const double *p_arr, size_t n,
+    double *p_min, double *p_max);
+
+/**
+ * @brief `sirius_math_sum_*` in `SIRIUS_MATH_ACC_FAST` mode within a
+ *  chunk, combined pairwise over the chunks in a fixed order: the
+ *  result is bit-identical for any number of threads and for arrays
+ *  below "math.par.min"
+ * 
+ * @return the sum, 0 if the array is empty
+ */
+float sirius_math_sum_f32_par(const float *p_arr, size_t n);
+double sirius_math_sum_f64_par(const double *p_arr, size_t n);
+
 /**
  * @param[in] args_num: the total number of integer numbers
  * @param[in] args: a number of integer numbers
  * 
- * @note: the parameter must be of integer type
+ * @note: the parameter must be of integer type;
+ *  prefer `SIRIUS_MAX`, which needs neither `args_num` nor `va_list`
  * 
  * @return the maximum value in the input parameters
  */
@@ -29,7 +342,8 @@ int sirius_math_max_int(unsigned int args_num, ...);
  * @param[in] args_num: the total number of integer numbers
  * @param[in] args: a number of integer numbers
  * 
- * @note: the parameter must be of integer type
+ * @note: the parameter must be of integer type;
+ *  prefer `SIRIUS_MIN`
  * 
  * @return the minimum value in the input parameters
  */
@@ -39,9 +353,11 @@ int sirius_math_min_int(unsigned int args_num, ...);
  * @param[in] args_num: the total number of double-type numbers
  * @param[in] args: a number of double-type numbers
  * 
- * @note: the parameter must be of double-type type
+ * @note: the parameter must be of double-type type;
+ *  prefer `SIRIUS_MAX`
  * 
- * @return the maximum value in the input argument
+ * @return the maximum value in the input argument,
+ *  -INFINITY if `args_num` is 0
  */
 double sirius_math_max_dbl(unsigned int args_num, ...);
 
@@ -49,9 +365,11 @@ double sirius_math_max_dbl(unsigned int args_num, ...);
  * @param[in] args_num: the total number of double-type numbers
  * @param[in] args: a number of double-type numbers
  * 
- * @note: the parameter must be of double-type type
+ * @note: the parameter must be of double-type type;
+ *  prefer `SIRIUS_MIN`
  * 
- * @return the minimum value in the input parameters
+ * @return the minimum value in the input parameters,
+ *  INFINITY if `args_num` is 0
  */
 double sirius_math_min_dbl(unsigned int args_num, ...);
 
@@ -69,24 +387,247 @@ double sirius_math_min_dbl(unsigned int args_num, ...);
 #define SIRIUS_MIN_T(num1, num2)        ((num1) < (num2) ? (num1) : (num2))
 #endif // SIRIUS_MIN_T
 
+#ifndef __cplusplus
+
+/* two-operand min/max of each arithmetic type, branchless once inlined */
+#define __SIRIUS_MATH_MINMAX2(sfx, T) \
+static force_inline T \
+sirius_math_max2_##sfx(T a, T b) \
+{ \
+    return a > b ? a : b; \
+} \
+static force_inline T \
+sirius_math_min2_##sfx(T a, T b) \
+{ \
+    return a < b ? a : b; \
+}
+
+__SIRIUS_MATH_MINMAX2(i, int)
+__SIRIUS_MATH_MINMAX2(u, unsigned int)
+__SIRIUS_MATH_MINMAX2(l, long)
+__SIRIUS_MATH_MINMAX2(ul, unsigned long)
+__SIRIUS_MATH_MINMAX2(ll, long long)
+__SIRIUS_MATH_MINMAX2(ull, unsigned long long)
+__SIRIUS_MATH_MINMAX2(f, float)
+__SIRIUS_MATH_MINMAX2(d, double)
+__SIRIUS_MATH_MINMAX2(ld, long double)
+
+/* 1 if `x` may hold a negative value */
+#define __SIRIUS_MATH_SIGNED(x) \
+    _Generic((x), \
+        _Bool: 0, \
+        unsigned char: 0, \
+        unsigned short: 0, \
+        unsigned int: 0, \
+        unsigned long: 0, \
+        unsigned long long: 0, \
+        default: 1)
+
+/**
+ * the operands are converted to the type of `a + b`; a signed operand
+ * converted to an unsigned type would turn -1 into the maximum, such
+ * a pair is rejected at compile time
+ */
+#define __SIRIUS_MATH_GENERIC2(op, a, b) \
+    ((void)sizeof(struct { \
+        _Static_assert(__SIRIUS_MATH_SIGNED((a) + (b)) || \
+            !(__SIRIUS_MATH_SIGNED(a) || __SIRIUS_MATH_SIGNED(b)), \
+            "SIRIUS_MAX/SIRIUS_MIN: signed and unsigned operands"); \
+        char c; \
+    }), \
+    _Generic((a) + (b), \
+        int: sirius_math_##op##2_i, \
+        unsigned int: sirius_math_##op##2_u, \
+        long: sirius_math_##op##2_l, \
+        unsigned long: sirius_math_##op##2_ul, \
+        long long: sirius_math_##op##2_ll, \
+        unsigned long long: sirius_math_##op##2_ull, \
+        float: sirius_math_##op##2_f, \
+        double: sirius_math_##op##2_d, \
+        long double: sirius_math_##op##2_ld)((a), (b)))
+
+#define __SIRIUS_MATH_NARG(...) \
+    __SIRIUS_MATH_NARG_N(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define __SIRIUS_MATH_NARG_N(_1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+
+#define __SIRIUS_MATH_CAT(a, b) __SIRIUS_MATH_CAT_I(a, b)
+#define __SIRIUS_MATH_CAT_I(a, b) a##b
+
+#define __SIRIUS_MATH_FOLD(op, ...) \
+    __SIRIUS_MATH_CAT(__SIRIUS_MATH_FOLD, \
+        __SIRIUS_MATH_NARG(__VA_ARGS__))(op, __VA_ARGS__)
+#define __SIRIUS_MATH_FOLD1(op, a) (a)
+#define __SIRIUS_MATH_FOLD2(op, a, b) __SIRIUS_MATH_GENERIC2(op, a, b)
+#define __SIRIUS_MATH_FOLD3(op, a, b, c) \
+    __SIRIUS_MATH_GENERIC2(op, __SIRIUS_MATH_FOLD2(op, a, b), c)
+#define __SIRIUS_MATH_FOLD4(op, a, b, c, d) \
+    __SIRIUS_MATH_GENERIC2(op, __SIRIUS_MATH_FOLD2(op, a, b), \
+        __SIRIUS_MATH_FOLD2(op, c, d))
+#define __SIRIUS_MATH_FOLD5(op, a, b, c, d, e) \
+    __SIRIUS_MATH_GENERIC2(op, __SIRIUS_MATH_FOLD4(op, a, b, c, d), e)
+#define __SIRIUS_MATH_FOLD6(op, a, b, c, d, e, f) \
+    __SIRIUS_MATH_GENERIC2(op, __SIRIUS_MATH_FOLD4(op, a, b, c, d), \
+        __SIRIUS_MATH_FOLD2(op, e, f))
+#define __SIRIUS_MATH_FOLD7(op, a, b, c, d, e, f, g) \
+    __SIRIUS_MATH_GENERIC2(op, __SIRIUS_MATH_FOLD4(op, a, b, c, d), \
+        __SIRIUS_MATH_FOLD3(op, e, f, g))
+#define __SIRIUS_MATH_FOLD8(op, a, b, c, d, e, f, g, h) \
+    __SIRIUS_MATH_GENERIC2(op, __SIRIUS_MATH_FOLD4(op, a, b, c, d), \
+        __SIRIUS_MATH_FOLD4(op, e, f, g, h))
+
+/* min/max of `n` >= 1 values already converted to one type */
+#define __SIRIUS_MATH_MINMAXN(sfx, T) \
+static force_inline T \
+sirius_math_max_##sfx##_n(const T *p_v, size_t n) \
+{ \
+    T m = p_v[0]; \
+    for (size_t i = 1; i < n; i++) m = p_v[i] > m ? p_v[i] : m; \
+    return m; \
+} \
+static force_inline T \
+sirius_math_min_##sfx##_n(const T *p_v, size_t n) \
+{ \
+    T m = p_v[0]; \
+    for (size_t i = 1; i < n; i++) m = p_v[i] < m ? p_v[i] : m; \
+    return m; \
+}
+
+__SIRIUS_MATH_MINMAXN(i, int)
+__SIRIUS_MATH_MINMAXN(d, double)
+
+/* the array initializer converts every value to `T` */
+#define __SIRIUS_MATH_FOLD_AS(op, T, sfx, ...) \
+    sirius_math_##op##_##sfx##_n((const T[]){__VA_ARGS__}, \
+        sizeof((const T[]){__VA_ARGS__}) / sizeof(T))
+
+#endif // __cplusplus
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+#include <type_traits>
+
+/**
+ * @brief constexpr min/max of any number of arithmetic values,
+ *  computed in their common type
+ */
+template <typename T>
+constexpr T
+sirius_max(T a)
+{
+    return a;
+}
+
+/* true if a signed `T` or `U` would be compared as unsigned */
+template <typename T, typename U>
+struct sirius_minmax_mixed {
+    typedef typename std::common_type<T, U>::type C;
+    static constexpr bool value = std::is_unsigned<C>::value &&
+        (std::is_signed<T>::value || std::is_signed<U>::value);
+};
+
+template <typename T, typename U, typename... R>
+constexpr typename std::common_type<T, U, R...>::type
+sirius_max(T a, U b, R... r)
+{
+    static_assert(!(sirius_minmax_mixed<T, U>::value),
+        "SIRIUS_MAX: signed and unsigned operands");
+    typedef typename std::common_type<T, U>::type C;
+    return sirius_max(static_cast<C>(a) > static_cast<C>(b) ?
+        static_cast<C>(a) : static_cast<C>(b), r...);
+}
+
+template <typename T>
+constexpr T
+sirius_min(T a)
+{
+    return a;
+}
+
+template <typename T, typename U, typename... R>
+constexpr typename std::common_type<T, U, R...>::type
+sirius_min(T a, U b, R... r)
+{
+    static_assert(!(sirius_minmax_mixed<T, U>::value),
+        "SIRIUS_MIN: signed and unsigned operands");
+    typedef typename std::common_type<T, U>::type C;
+    return sirius_min(static_cast<C>(a) < static_cast<C>(b) ?
+        static_cast<C>(a) : static_cast<C>(b), r...);
+}
+
+/* every value converted to `C` first */
+template <typename C, typename... A>
+constexpr C
+sirius_max_as(A... a)
+{
+    return sirius_max(static_cast<C>(a)...);
+}
+
+template <typename C, typename... A>
+constexpr C
+sirius_min_as(A... a)
+{
+    return sirius_min(static_cast<C>(a)...);
+}
+
+#define __SIRIUS_MATH_FOLD_AS(op, T, sfx, ...) \
+    sirius_##op##_as<T>(__VA_ARGS__)
+#endif // __cplusplus
+
+/**
+ * @brief the maximum of 1 to 8 arithmetic values, each evaluated once
+ * 
+ * @note the values are compared in the type of their sum, the same
+ *  conversions as `SIRIUS_MAX_T`; a constant expression in C++.
+ *  mixing signed and unsigned integers fails to compile, since
+ *  (-1, 1u) would compare 4294967295 to 1; cast one side, or use
+ *  `SIRIUS_MAX_INT`
+ */
+#ifndef SIRIUS_MAX
+#ifdef __cplusplus
+#define SIRIUS_MAX(...)     sirius_max(__VA_ARGS__)
+#else
+#define SIRIUS_MAX(...)     __SIRIUS_MATH_FOLD(max, __VA_ARGS__)
+#endif
+#endif // SIRIUS_MAX
+
+/**
+ * @brief the minimum of 1 to 8 arithmetic values, each evaluated once
+ */
+#ifndef SIRIUS_MIN
+#ifdef __cplusplus
+#define SIRIUS_MIN(...)     sirius_min(__VA_ARGS__)
+#else
+#define SIRIUS_MIN(...)     __SIRIUS_MATH_FOLD(min, __VA_ARGS__)
+#endif
+#endif // SIRIUS_MIN
+
+/**
+ * `args_num` is kept for compatibility, the values are counted;
+ * as with `sirius_math_max_int`/`sirius_math_max_dbl`, every value is
+ * converted to `int`/`double` before the comparison, and there is no
+ * limit on their number
+ */
 #ifndef SIRIUS_MAX_INT
-#define SIRIUS_MAX_INT(args_num, ...)   sirius_math_max_int(args_num, __VA_ARGS__)
+#define SIRIUS_MAX_INT(args_num, ...) \
+    __SIRIUS_MATH_FOLD_AS(max, int, i, __VA_ARGS__)
 #endif // SIRIUS_MAX_INT
 
 #ifndef SIRIUS_MIN_INT
-#define SIRIUS_MIN_INT(args_num, ...)   sirius_math_min_int(args_num, __VA_ARGS__)
+#define SIRIUS_MIN_INT(args_num, ...) \
+    __SIRIUS_MATH_FOLD_AS(min, int, i, __VA_ARGS__)
 #endif // SIRIUS_MIN_INT
 
 #ifndef SIRIUS_MAX_DBL
-#define SIRIUS_MAX_DBL(args_num, ...)   sirius_math_max_dbl(args_num, __VA_ARGS__)
+#define SIRIUS_MAX_DBL(args_num, ...) \
+    __SIRIUS_MATH_FOLD_AS(max, double, d, __VA_ARGS__)
 #endif // SIRIUS_MAX_DBL
 
 #ifndef SIRIUS_MIN_DBL
-#define SIRIUS_MIN_DBL(args_num, ...)   sirius_math_min_dbl(args_num, __VA_ARGS__)
+#define SIRIUS_MIN_DBL(args_num, ...) \
+    __SIRIUS_MATH_FOLD_AS(min, double, d, __VA_ARGS__)
 #endif // SIRIUS_MIN_DBL
 
-#ifdef __cplusplus
-}
-#endif
-
 #endif // __SIRIUS_MATH_H__
@@ -0,0 +1,192 @@
+/**
+ * @name sirius_metrics.h
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief 指标注册表，以 Prometheus 文本格式导出
+ * 
+ * @details
+ * (1) 计数器按线程分片，每次累加只是本线程分片上的一次 relaxed
+ *  原子加；导出时合并所有分片
+ * 
+ * (2) 仪表为单个值，可设置或增减；也可由回调在导出时计算，
+ *  如队列深度
+ * 
+ * (3) 直方图使用 sirius_hist_handle（按线程分片），
+ *  导出为 summary：分位数 0.5、0.9、0.99、0.999 及 _sum、_count
+ * 
+ * (4) 导出： sirius_metrics_dump(path)，写入临时文件后改名，
+ *  读取者不会看到写了一半的文件；
+ *  管道命令： echo metrics [path] > log_pipe，无路径时输出到日志
+ * 
+ * (5) `sirius_init_t` 中 `metrics.p_path` 非空时，每隔
+ *  `metrics.interval_ms` 毫秒导出一次，`sirius_deinit` 时再导出一次
+ * 
+ * (6) 库自身注册的指标：日志记录数、字节数与丢弃数，
+ *  以及创建时给出名称的队列的深度
+ */
+
+#ifndef __SIRIUS_METRICS_H__
+#define __SIRIUS_METRICS_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sirius_attributes.h"
+#include "sirius_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 计数器的分片数，线程按创建顺序轮流映射到分片
+ * CFLAGS += -DSIRIUS_METRICS_SHARD_NR=$(SIRIUS_METRICS_SHARD_NR)
+ */
+#ifndef SIRIUS_METRICS_SHARD_NR
+#define SIRIUS_METRICS_SHARD_NR 16
+#endif // SIRIUS_METRICS_SHARD_NR
+
+typedef enum {
+    /* monotonically increasing integer */
+    SIRIUS_METRIC_COUNTER = 0,
+    /* value that goes up and down */
+    SIRIUS_METRIC_GAUGE,
+    /* distribution of unsigned integers, exported as a summary */
+    SIRIUS_METRIC_HIST,
+
+    SIRIUS_METRIC_MAX,
+} sirius_metric_type_t;
+
+typedef void* sirius_metric_handle;
+
+typedef struct {
+    sirius_metric_type_t type;
+    /**
+     * metric name, [a-zA-Z_:][a-zA-Z0-9_:]*; metrics of the same
+     * name must have the same type and differ in `p_labels`
+     */
+    const char *p_name;
+    /* help text, may be NULL */
+    const char *p_help;
+    /* labels, such as `que="rx",dir="in"`, may be NULL */
+    const char *p_labels;
+    /**
+     * counters and gauges: if not NULL, the value is `p_fn(p_arg)`
+     * at the time of the export, and it cannot be recorded into;
+     * it is called with the registry locked and must not register
+     * or unregister a metric
+     */
+    double (*p_fn)(void *p_arg);
+    void *p_arg;
+    /* histograms: refer to `sirius_hist_cr_t` */
+    unsigned int sig_bits;
+} sirius_metric_attr_t;
+
+/* periodic export, refer to `sirius_init_t` */
+typedef struct {
+    /* text file, disabled when it is NULL */
+    const char *p_path;
+    /* interval, unit: ms; 0 for 10000 */
+    unsigned int interval_ms;
+} sirius_metrics_export_t;
+
+/**
+ * @brief register a metric,
+ *  the resulting handle must be deleted using `sirius_metrics_unregister`
+ * 
+ * @param[in] p_attr: metric attributes, the strings are copied
+ * @param[out] p_handle: metric handle
+ * 
+ * @return 0 on success, error code if the name or labels are invalid
+ *  or already registered
+ */
+int
+sirius_metrics_register(const sirius_metric_attr_t *p_attr,
+    sirius_metric_handle *p_handle);
+
+/**
+ * @note no thread may be recording into the metric
+ * 
+ * @return 0 on success, error code if it is not registered
+ */
+int
+sirius_metrics_unregister(sirius_metric_handle handle);
+
+/**
+ * @brief add `n` to a counter
+ */
+void
+sirius_metrics_counter_add(sirius_metric_handle handle,
+    unsigned long long n);
+
+static force_inline void
+sirius_metrics_counter_inc(sirius_metric_handle handle)
+{
+    sirius_metrics_counter_add(handle, 1);
+}
+
+void
+sirius_metrics_gauge_set(sirius_metric_handle handle, double v);
+
+void
+sirius_metrics_gauge_add(sirius_metric_handle handle, double d);
+
+/**
+ * @brief record a sample into a histogram
+ */
+void
+sirius_metrics_hist_record(sirius_metric_handle handle, uint64_t v);
+
+/**
+ * @return the value of a counter or a gauge, summed over the shards
+ */
+double
+sirius_metrics_value(sirius_metric_handle handle);
+
+/**
+ * @return the histogram of a `SIRIUS_METRIC_HIST` metric, for
+ *  `sirius_hist_query`; NULL for other types
+ */
+sirius_hist_handle
+sirius_metrics_hist(sirius_metric_handle handle);
+
+/**
+ * @brief write all metrics in the Prometheus text format
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_metrics_write(FILE *p_f);
+
+/**
+ * @brief write all metrics to `p_path`, replaced atomically
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_metrics_dump(const char *p_path);
+
+/**
+ * @brief start the periodic export, called by `sirius_init`
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_metrics_init(const sirius_metrics_export_t *p_exp);
+
+/**
+ * @brief stop the periodic export after a last one,
+ *  called by `sirius_deinit`; the metrics stay registered
+ */
+void
+sirius_metrics_deinit();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIRIUS_METRICS_H__
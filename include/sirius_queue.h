@@ -6,6 +6,11 @@
  * @date 2024-09-12
  * 
  * @brief 队列接口
+ * 
+ * @details
+ * 带锁队列的等待策略可在运行时修改，参考 sirius_config.h：
+ *  que.spin: 休眠前不持锁轮询队列的时长（pause 指令数），0 表示直接休眠
+ *  que.yield: 轮询之间让出 cpu，而不是自旋退避，每次让出计为 1
  */
 
 #ifndef __SIRIUS_QUEUE_H__
@@ -51,6 +56,12 @@ typedef struct {
 
     /* mechanism in the queue, refer `sirius_que_type_t` */
     sirius_que_type_t que_type;
+
+    /**
+     * if not NULL, the depth of the queue is exported as the metric
+     * `sirius_que_depth{que="<p_name>"}`, refer to sirius_metrics.h
+     */
+    const char *p_name;
 } sirius_que_cr_t;
 
 /**
@@ -0,0 +1,220 @@
+/**
+ * @name sirius_thread.h
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief 线程放置：亲和性、名称、栈大小、调度策略与拓扑
+ * 
+ * @details
+ * (1) sirius_thread_create: 按 `sirius_thread_attr_t` 创建线程，
+ *  亲和性与实时调度在线程运行前生效，名称与 nice 值在线程函数
+ *  执行前设置；全 0 的属性等同于 pthread 的默认属性
+ * 
+ * (2) sirius_cpuset_t: cpu 集合，可由 "0-3,8" 形式的列表解析
+ * 
+ * (3) sirius_thread_topo: 从 /sys/devices/system 读取拓扑，
+ *  给出每个 cpu 所属的物理核（SMT 兄弟）、共享末级缓存的组、
+ *  NUMA 节点与封装，只检测一次
+ * 
+ * (4) 库内部线程（日志管道、日志文件、并行归约）使用
+ *  `sirius_init_t` 中的 `thread` 属性，见 sirius_common.h
+ */
+
+#ifndef __SIRIUS_THREAD_H__
+#define __SIRIUS_THREAD_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "sirius_attributes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * cpu 集合可容纳的最大 cpu 编号（不含）
+ * CFLAGS += -DSIRIUS_THREAD_CPU_MAX=$(SIRIUS_THREAD_CPU_MAX)
+ */
+#ifndef SIRIUS_THREAD_CPU_MAX
+#define SIRIUS_THREAD_CPU_MAX 1024
+#endif // SIRIUS_THREAD_CPU_MAX
+
+/* the longest thread name the kernel keeps, without '\0' */
+#define SIRIUS_THREAD_NAME_MAX (15)
+
+/* cpu set */
+
+typedef struct {
+    unsigned long long bits[SIRIUS_THREAD_CPU_MAX / 64];
+} sirius_cpuset_t;
+
+static force_inline void
+sirius_cpuset_zero(sirius_cpuset_t *p_set)
+{
+    for (size_t i = 0; i < SIRIUS_THREAD_CPU_MAX / 64; i++)
+        p_set->bits[i] = 0;
+}
+
+static force_inline void
+sirius_cpuset_add(sirius_cpuset_t *p_set, unsigned int cpu)
+{
+    if (cpu < SIRIUS_THREAD_CPU_MAX)
+        p_set->bits[cpu / 64] |= 1ULL << (cpu % 64);
+}
+
+static force_inline void
+sirius_cpuset_del(sirius_cpuset_t *p_set, unsigned int cpu)
+{
+    if (cpu < SIRIUS_THREAD_CPU_MAX)
+        p_set->bits[cpu / 64] &= ~(1ULL << (cpu % 64));
+}
+
+static force_inline bool
+sirius_cpuset_has(const sirius_cpuset_t *p_set, unsigned int cpu)
+{
+    return cpu < SIRIUS_THREAD_CPU_MAX &&
+        (p_set->bits[cpu / 64] >> (cpu % 64)) & 1;
+}
+
+/**
+ * @return the number of cpus in the set
+ */
+static force_inline unsigned int
+sirius_cpuset_count(const sirius_cpuset_t *p_set)
+{
+    unsigned int n = 0;
+    for (size_t i = 0; i < SIRIUS_THREAD_CPU_MAX / 64; i++)
+        n += (unsigned int)__builtin_popcountll(p_set->bits[i]);
+    return n;
+}
+
+/**
+ * @brief parse a cpu list such as "0-3,8,10-11", the format of
+ *  sysfs and of `taskset -c`
+ * 
+ * @return 0 on success, error code if the list is malformed or
+ *  a cpu is not below `SIRIUS_THREAD_CPU_MAX`
+ */
+int
+sirius_cpuset_parse(const char *p_str, sirius_cpuset_t *p_set);
+
+/* threads */
+
+typedef enum {
+    /* inherited from the creating thread */
+    SIRIUS_THREAD_SCHED_INHERIT = 0,
+    /* SCHED_OTHER, `prio` is the nice value */
+    SIRIUS_THREAD_SCHED_OTHER,
+    /* SCHED_BATCH, `prio` is the nice value */
+    SIRIUS_THREAD_SCHED_BATCH,
+    /* SCHED_IDLE, `prio` is ignored */
+    SIRIUS_THREAD_SCHED_IDLE,
+    /* SCHED_FIFO, `prio` is the real-time priority, 1 to 99 */
+    SIRIUS_THREAD_SCHED_FIFO,
+    /* SCHED_RR, `prio` is the real-time priority, 1 to 99 */
+    SIRIUS_THREAD_SCHED_RR,
+
+    SIRIUS_THREAD_SCHED_MAX,
+} sirius_thread_sched_t;
+
+typedef struct {
+    /**
+     * thread name, truncated to `SIRIUS_THREAD_NAME_MAX`;
+     * NULL keeps the name of the process
+     */
+    const char *p_name;
+    /* cpus it may run on, an empty set inherits the creator's */
+    sirius_cpuset_t cpus;
+    /* stack size in bytes, 0 for the default */
+    size_t stack_size;
+    /* scheduling policy */
+    sirius_thread_sched_t sched;
+    /* priority, refer to `sirius_thread_sched_t` */
+    int prio;
+    /* the thread cannot be joined */
+    bool detached;
+} sirius_thread_attr_t;
+
+/**
+ * @brief create a thread
+ * 
+ * @param[out] p_id: thread id, may be NULL for a detached thread
+ * @param[in] p_attr: attributes, NULL for the defaults
+ * @param[in] p_fn: thread function
+ * @param[in] p_arg: argument of `p_fn`
+ * 
+ * @note the real-time policies need CAP_SYS_NICE or an RLIMIT_RTPRIO,
+ *  a negative nice value CAP_SYS_NICE or an RLIMIT_NICE
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_thread_create(pthread_t *p_id, const sirius_thread_attr_t *p_attr,
+    void *(*p_fn)(void *), void *p_arg);
+
+/**
+ * @brief apply the attributes to the calling thread,
+ *  `stack_size` and `detached` are ignored
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_thread_apply(const sirius_thread_attr_t *p_attr);
+
+/* topology */
+
+/* grouping of the cpus */
+typedef enum {
+    /* SMT siblings sharing a physical core */
+    SIRIUS_TOPO_CORE = 0,
+    /* cpus sharing the last level cache */
+    SIRIUS_TOPO_LLC,
+    /* NUMA node */
+    SIRIUS_TOPO_NODE,
+    /* physical package (socket) */
+    SIRIUS_TOPO_PKG,
+
+    SIRIUS_TOPO_MAX,
+} sirius_topo_level_t;
+
+typedef struct {
+    /* online cpus */
+    sirius_cpuset_t online;
+    unsigned int cpu_nr;
+    /**
+     * number of groups at every level, the groups are numbered
+     * from 0 in the order of their lowest cpu
+     */
+    unsigned int nr[SIRIUS_TOPO_MAX];
+    /* group of every cpu at every level, -1 if it is offline */
+    short group[SIRIUS_THREAD_CPU_MAX][SIRIUS_TOPO_MAX];
+} sirius_topo_t;
+
+/**
+ * @return the topology, detected on first use
+ */
+const sirius_topo_t *
+sirius_thread_topo();
+
+/**
+ * @brief the cpus of a group
+ * 
+ * @param[in] level: grouping
+ * @param[in] group: group number, below `nr[level]`
+ * @param[out] p_set: the cpus
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_thread_topo_cpus(sirius_topo_level_t level, unsigned int group,
+    sirius_cpuset_t *p_set);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIRIUS_THREAD_H__
@@ -0,0 +1,181 @@
+/**
+ * @name sirius_time.h
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief 低开销时钟
+ * 
+ * @details
+ * (1) sirius_time_ns: 单调时钟，纳秒。cpu 有不变的 tsc（invariant tsc）
+ *  且内核以 tsc 为时钟源时，读取 tsc 并按校准结果换算，不进入 vDSO；
+ *  否则使用 clock_gettime(CLOCK_MONOTONIC)
+ * 
+ * (2) sirius_time_cycles / sirius_time_cyc2ns: 读取周期计数器，
+ *  测量结束后再换算为纳秒，适合测量很短的区间
+ * 
+ * (3) sirius_time_coarse_ns: 粗粒度单调时钟，精度为一个时钟节拍，
+ *  适合超时、限速等不需要高精度的场合
+ * 
+ * (4) 校准不阻塞初始化：`sirius_init` 只记录起点（cpu 报告 tsc 频率时
+ *  直接使用），`SIRIUS_TIME_CAL_MS` 毫秒后第一次调用 sirius_time_ns
+ *  时完成校准，此前读取 clock_gettime；
+ *  sirius_time_mult / _hz / _tsc 需要结果时等待校准完成
+ * 
+ * (5) tsc 不跟随 ntp 对 CLOCK_MONOTONIC 的调整，
+ *  与内核共用的截止时间（如条件变量超时）应直接使用 clock_gettime
+ */
+
+#ifndef __SIRIUS_TIME_H__
+#define __SIRIUS_TIME_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sirius_attributes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 校准的最短时长（毫秒），越长换算误差越小
+ * CFLAGS += -DSIRIUS_TIME_CAL_MS=$(SIRIUS_TIME_CAL_MS)
+ */
+#ifndef SIRIUS_TIME_CAL_MS
+#define SIRIUS_TIME_CAL_MS 10
+#endif // SIRIUS_TIME_CAL_MS
+
+/**
+ * @brief calibration of the cycle counter
+ * 
+ * @note do not write it, it is published once by the calibration
+ */
+typedef struct {
+    /* ns per cycle << 32, 0 until calibrated */
+    uint64_t mult;
+    /* the cycle counter at `ns0` of CLOCK_MONOTONIC */
+    uint64_t tsc0;
+    uint64_t ns0;
+    /* cycles per second */
+    uint64_t hz;
+    /* `sirius_time_ns` reads the cycle counter */
+    int tsc;
+} sirius_time_cal_t;
+
+extern sirius_time_cal_t sirius_time_cal;
+
+/**
+ * @brief start the calibration of the cycle counter without waiting,
+ *  called by `sirius_init`
+ * 
+ * @note repeated calls keep the first start
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_time_init();
+
+/**
+ * @brief `sirius_time_ns` when the cycle counter is not used,
+ *  calibrates first if needed
+ */
+uint64_t
+sirius_time_ns_slow();
+
+/**
+ * @brief `mult` of `sirius_time_cal`, waits for the calibration
+ *  if needed
+ */
+uint64_t
+sirius_time_mult();
+
+/**
+ * @return CLOCK_MONOTONIC_COARSE in ns
+ */
+uint64_t
+sirius_time_coarse_ns();
+
+/**
+ * @return whether `sirius_time_ns` reads the cycle counter
+ */
+bool
+sirius_time_tsc();
+
+/**
+ * @return the frequency of `sirius_time_cycles`, unit: Hz
+ */
+uint64_t
+sirius_time_hz();
+
+#if defined(__x86_64__)
+
+/**
+ * @brief the cycle counter, not ordered with the surrounding loads
+ *  and stores; `sirius_time_cyc2ns` converts a difference
+ */
+static force_inline uint64_t
+sirius_time_cycles()
+{
+    return __builtin_ia32_rdtsc();
+}
+
+/**
+ * @brief cycles to ns
+ */
+static force_inline uint64_t
+sirius_time_cyc2ns(uint64_t cyc)
+{
+    uint64_t mult = __atomic_load_n(&(sirius_time_cal.mult),
+        __ATOMIC_ACQUIRE);
+    if (unlikely(0 == mult)) mult = sirius_time_mult();
+    return (uint64_t)(((unsigned __int128)cyc * mult) >> 32);
+}
+
+/**
+ * @return CLOCK_MONOTONIC in ns, within the calibration error
+ *  when the cycle counter is read
+ */
+static force_inline uint64_t
+sirius_time_ns()
+{
+    if (likely(__atomic_load_n(&(sirius_time_cal.tsc),
+            __ATOMIC_ACQUIRE))) {
+        /* another cpu may be a few cycles behind `tsc0` */
+        int64_t d = (int64_t)(__builtin_ia32_rdtsc() -
+            sirius_time_cal.tsc0);
+        return sirius_time_cal.ns0 +
+            (uint64_t)(((__int128)d * sirius_time_cal.mult) >> 32);
+    }
+    return sirius_time_ns_slow();
+}
+
+#else
+
+static force_inline uint64_t
+sirius_time_ns()
+{
+    return sirius_time_ns_slow();
+}
+
+/* without a cycle counter, a cycle is a ns */
+static force_inline uint64_t
+sirius_time_cycles()
+{
+    return sirius_time_ns_slow();
+}
+
+static force_inline uint64_t
+sirius_time_cyc2ns(uint64_t cyc)
+{
+    return cyc;
+}
+
+#endif // __x86_64__
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIRIUS_TIME_H__
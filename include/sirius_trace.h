@@ -0,0 +1,173 @@
+/**
+ * @name sirius_trace.h
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief 区间追踪，输出 Chrome / Perfetto 可读的 JSON
+ * 
+ * @details
+ * (1) 记录区间：
+ *  SIRIUS_TRACE_SCOPE("name") 记录到所在作用域结束
+ *  SIRIUS_TRACE_BEGIN("name") ... SIRIUS_TRACE_END("name")
+ *  带参数的版本 SIRIUS_TRACE_SCOPE_ARG / SIRIUS_TRACE_BEGIN_ARG
+ *  名称须为字符串常量，输出时才读取
+ * 
+ * (2) 事件写入各线程自己的缓冲区，不加锁；缓冲区满后丢弃，
+ *  停止时给出丢弃的数量
+ * 
+ * (3) 开始与停止： echo trace start > log_pipe
+ *  echo trace stop [path] > log_pipe
+ *  停止后写出 JSON 文件，默认为当前目录下的 sirius_trace_[pid].json，
+ *  在 chrome://tracing 或 ui.perfetto.dev 中打开
+ * 
+ * (4) 未开启时每个追踪点只有一次可预测的分支；
+ *  SIRIUS_TRACE_COMPILE 为 0 时追踪点不参与编译
+ */
+
+#ifndef __SIRIUS_TRACE_H__
+#define __SIRIUS_TRACE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sirius_attributes.h"
+#include "sirius_time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 追踪点是否参与编译
+ * CFLAGS += -DSIRIUS_TRACE_COMPILE=$(SIRIUS_TRACE_COMPILE)
+ */
+#ifndef SIRIUS_TRACE_COMPILE
+#define SIRIUS_TRACE_COMPILE 1
+#endif // SIRIUS_TRACE_COMPILE
+
+/**
+ * 每个线程缓冲区可容纳的事件数，开启追踪后第一次记录时申请
+ * CFLAGS += -DSIRIUS_TRACE_BUF_EVENTS=$(SIRIUS_TRACE_BUF_EVENTS)
+ */
+#ifndef SIRIUS_TRACE_BUF_EVENTS
+#define SIRIUS_TRACE_BUF_EVENTS 16384
+#endif // SIRIUS_TRACE_BUF_EVENTS
+
+/**
+ * @brief non-zero while tracing
+ * 
+ * @note do not write it, use `sirius_trace_start` and `sirius_trace_stop`
+ */
+extern int sirius_trace_on;
+
+static force_inline bool
+sirius_trace_enabled()
+{
+    return __atomic_load_n(&sirius_trace_on, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief start tracing, the events of a previous session are dropped
+ * 
+ * @return 0 on success, error code if it is already on
+ */
+int
+sirius_trace_start();
+
+/**
+ * @brief stop tracing and write the events
+ * 
+ * @param[in] p_path: JSON trace file, NULL for sirius_trace_[pid].json
+ *  in the working directory
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_trace_stop(const char *p_path);
+
+/* the slow paths of the trace points, called only while tracing */
+
+void
+sirius_trace_begin(const char *p_name, bool has_arg, long long arg);
+
+void
+sirius_trace_end(const char *p_name);
+
+typedef struct {
+    const char *p_name;
+    /* `sirius_time_cycles` at the start, 0 if tracing was off */
+    uint64_t start;
+    long long arg;
+    bool has_arg;
+} sirius_trace_scope_t;
+
+void
+sirius_trace_complete(const sirius_trace_scope_t *p_scope);
+
+static force_inline void
+sirius_trace_scope_end(const sirius_trace_scope_t *p_scope)
+{
+    if (unlikely(p_scope->start)) sirius_trace_complete(p_scope);
+}
+
+#define I_TRACE_CAT2(a, b) a##b
+#define I_TRACE_CAT(a, b) I_TRACE_CAT2(a, b)
+
+#if SIRIUS_TRACE_COMPILE && defined(scope_cleanup)
+#define I_TRACE_SCOPE(name, has, val) \
+    sirius_trace_scope_t I_TRACE_CAT(i_trace_scope_, __COUNTER__) \
+        scope_cleanup(sirius_trace_scope_end) = { \
+        (name), \
+        unlikely(sirius_trace_enabled()) ? sirius_time_cycles() : 0, \
+        (val), (has), \
+    }
+#else
+#define I_TRACE_SCOPE(name, has, val) \
+    do {} while (0)
+#endif
+
+#if SIRIUS_TRACE_COMPILE
+#define I_TRACE_BEGIN(name, has, val) \
+    do { \
+        if (unlikely(sirius_trace_enabled())) \
+            sirius_trace_begin((name), (has), (val)); \
+    } while (0)
+#define I_TRACE_END(name) \
+    do { \
+        if (unlikely(sirius_trace_enabled())) \
+            sirius_trace_end(name); \
+    } while (0)
+#else
+#define I_TRACE_BEGIN(name, has, val) \
+    do {} while (0)
+#define I_TRACE_END(name) \
+    do {} while (0)
+#endif
+
+/**
+ * @brief a span up to the end of the enclosing scope
+ * 
+ * @note a declaration, so not the body of an unbraced if
+ */
+#define SIRIUS_TRACE_SCOPE(name) \
+    I_TRACE_SCOPE(name, false, 0)
+#define SIRIUS_TRACE_SCOPE_ARG(name, arg) \
+    I_TRACE_SCOPE(name, true, (long long)(arg))
+
+/**
+ * @brief a span between two points of the same thread
+ */
+#define SIRIUS_TRACE_BEGIN(name) \
+    I_TRACE_BEGIN(name, false, 0)
+#define SIRIUS_TRACE_BEGIN_ARG(name, arg) \
+    I_TRACE_BEGIN(name, true, (long long)(arg))
+#define SIRIUS_TRACE_END(name) \
+    I_TRACE_END(name)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIRIUS_TRACE_H__
@@ -0,0 +1,176 @@
+/**
+ * @name sirius_window.h
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief 滑动窗口统计
+ * 
+ * @details
+ * (1) 窗口按个数（最近 elem_nr 个样本）或按时间（最近 span 时间内的样本）划分，
+ *  存储在创建时一次性分配，按时间的窗口最多也只保留 elem_nr 个样本
+ * 
+ * (2) 最小、最大值由单调队列维护，和、平均值由补偿求和维护，
+ *  每次更新均摊 O(1)；分位数在查询时用快速选择计算，O(n)
+ * 
+ * (3) sirius_win_push_batch 一次写入一组样本，
+ *  sirius_win_sliding_max / sirius_win_sliding_min 对整个数组计算
+ *  每个位置的窗口极值，与窗口长度无关，每个元素约 3 次比较
+ * 
+ * (4) 不加锁，由调用者保证单线程使用；样本不能为 NaN
+ */
+
+#ifndef __SIRIUS_WINDOW_H__
+#define __SIRIUS_WINDOW_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void* sirius_win_handle;
+
+typedef enum {
+    /* the latest `elem_nr` samples, default */
+    SIRIUS_WIN_TYPE_COUNT = 0,
+
+    /* samples whose timestamp lies within `span` of the latest one */
+    SIRIUS_WIN_TYPE_TIME = 1,
+
+    SIRIUS_WIN_TYPE_MAX,
+} sirius_win_type_t;
+
+typedef struct {
+    /* refer `sirius_win_type_t` */
+    sirius_win_type_t win_type;
+
+    /* capacity of the window */
+    size_t elem_nr;
+
+    /**
+     * length of a time window, in the unit of the timestamps;
+     * a sample is dropped once `ts + span <= now`
+     */
+    uint64_t span;
+} sirius_win_cr_t;
+
+typedef struct {
+    size_t count;
+    double min;
+    double max;
+    double sum;
+    double avg;
+} sirius_win_res_t;
+
+/**
+ * @brief create a window,
+ *  the resulting handle must be deleted using `sirius_win_del`
+ * 
+ * @param[in] p_cr: creation parameters
+ * @param[out] p_handle: window handle
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_win_cr(const sirius_win_cr_t *p_cr, sirius_win_handle *p_handle);
+
+int
+sirius_win_del(sirius_win_handle handle);
+
+/**
+ * @brief drop all the samples
+ */
+int
+sirius_win_reset(sirius_win_handle handle);
+
+/**
+ * @brief add a sample
+ * 
+ * @param[in] handle: window handle
+ * @param[in] ts: timestamp, ignored by a count window;
+ *  must not decrease in a time window
+ * @param[in] x: sample
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_win_push(sirius_win_handle handle, uint64_t ts, double x);
+
+/**
+ * @brief add `n` samples in order
+ * 
+ * @param[in] p_ts: timestamps, may be NULL for a count window
+ * @param[in] p_x: samples
+ * 
+ * @note samples that would be pushed out by the batch itself
+ *  are skipped, the rest go through the same path as
+ *  `sirius_win_push`, one at a time
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_win_push_batch(sirius_win_handle handle,
+    const uint64_t *p_ts, const double *p_x, size_t n);
+
+/**
+ * @brief drop the samples of a time window that have expired at `now`,
+ *  without adding a new one
+ */
+int
+sirius_win_expire(sirius_win_handle handle, uint64_t now);
+
+/**
+ * @brief count, min, max, sum and average of the window;
+ *  min and max are NAN, sum and average 0 if it is empty
+ * 
+ * @note sum and average follow IEEE for the samples in the window
+ *  only: an inf or NaN stops counting once it has left the window
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_win_get(sirius_win_handle handle, sirius_win_res_t *p_res);
+
+/**
+ * @brief the `q`th percentile of the window, nearest rank
+ * 
+ * @param[in] q: [0, 100]
+ * @param[out] p_val: the percentile
+ * 
+ * @return 0 on success, `SIRIUS_ERR_INVALID_PARAMETER` if the window
+ *  is empty, error code otherwise
+ */
+int
+sirius_win_percentile(sirius_win_handle handle, double q, double *p_val);
+
+/**
+ * @brief the maximum of each trailing window of an array,
+ *  p_out[i] = max(p_in[i - w + 1], ..., p_in[i]), the first `w - 1`
+ *  windows are shorter
+ * 
+ * @param[in] p_in: samples
+ * @param[out] p_out: results, `n` elements, must not overlap `p_in`
+ * @param[in] n: number of samples
+ * @param[in] w: window length
+ * 
+ * @return 0 on success, error code otherwise
+ */
+int
+sirius_win_sliding_max(const double *p_in, double *p_out,
+    size_t n, size_t w);
+
+/**
+ * @brief the minimum of each trailing window, refer `sirius_win_sliding_max`
+ */
+int
+sirius_win_sliding_min(const double *p_in, double *p_out,
+    size_t n, size_t w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SIRIUS_WINDOW_H__
@@ -1,8 +1,12 @@
 #include "sirius_common.h"
 #include "sirius_errno.h"
 #include "sirius_macro.h"
+#include "sirius_cpu.h"
+#include "sirius_time.h"
+#include "sirius_trace.h"
 
 #include "./internal/sirius_internal_log.h"
+#include "./internal/sirius_internal_thread.h"
 
 static char sirius_version[16];
 char *
@@ -24,6 +28,9 @@ sirius_deinit()
     if (!(is_init)) return;
 
     SIRIUS_INFO("deinitialization\n");
+    /* keep what has been traced */
+    if (sirius_trace_enabled()) (void)sirius_trace_stop(NULL);
+    sirius_metrics_deinit();
     sirius_log_deinit();
 
     is_init = false;
@@ -37,9 +44,18 @@ sirius_init(sirius_init_t *p_init)
         return SIRIUS_OK;
     }
 
+    /* before the log creates its threads */
+    sirius_thread_internal_set(&(p_init->thread));
+
     sirius_log_cr_t cr = {0};
     cr.log_lv = p_init->log_lv;
     cr.p_pipe = p_init->p_pipe;
+    cr.time_prec = p_init->log_time_prec;
+    cr.dup_suppress = p_init->log_dup_suppress;
+    cr.sink = p_init->log_sink;
+    cr.p_file = &(p_init->log_file);
+    cr.p_shm = &(p_init->log_shm);
+    cr.p_rec = &(p_init->log_recorder);
     if (sirius_log_init(&cr)) return SIRIUS_ERR;
 
     is_init = true;
@@ -47,5 +63,11 @@ sirius_init(sirius_init_t *p_init)
     SIRIUS_INFO("initialization\n");
     SIRIUS_INFO("sirius version: %s\n",
         sirius_get_version());
+    sirius_cpu_init();
+    sirius_time_init();
+    int ret = sirius_metrics_init(&(p_init->metrics));
+    if (ret) {
+        SIRIUS_WARN("sirius_metrics_init: [%d]\n", ret);
+    }
     return SIRIUS_OK;
 }
@@ -0,0 +1,340 @@
+#include "sirius_errno.h"
+#include "sirius_config.h"
+#include "sirius_lock.h"
+
+#include "./internal/sirius_internal_sys.h"
+
+#include <sched.h>
+#include <stdint.h>
+
+/**
+ * every update copies the current snapshot, changes the copy and
+ * publishes it with a pointer swap, then waits for a grace period
+ * before freeing the old one.
+ * 
+ * a reader announces itself by storing the global epoch into a
+ * slot of its own before loading the pointer. after the swap, the
+ * writer advances the epoch and waits until no slot holds an older
+ * one: a reader that could still see the old snapshot has left.
+ * 
+ * threads beyond `I_CFG_READER_MAX` share a counter instead of a
+ * slot, the writer then waits until it drops to zero.
+ */
+
+/* number of reader slots */
+#define I_CFG_READER_MAX    (128)
+
+/* the slot of a thread has not been claimed yet */
+#define I_CFG_SLOT_NONE     (-1)
+/* no free slot, the thread uses the shared counter */
+#define I_CFG_SLOT_SHARED   (-2)
+
+typedef struct {
+    /* epoch the reader entered with, 0 outside a read section */
+    atomic_ullong epoch;
+    atomic_bool used;
+} __attribute__((aligned(64))) i_cfg_reader_t;
+
+typedef struct {
+    char name[SIRIUS_CFG_NAME_SIZE];
+    long long min;
+    long long max;
+    int (*p_check)(long long val);
+    void (*p_notify)(long long val);
+} i_cfg_key_t;
+
+typedef struct {
+    /* current snapshot */
+    _Atomic(sirius_cfg_snap_t *) p_snap;
+    /* advanced by the writer after every swap */
+    atomic_ullong epoch;
+    /* readers without a slot */
+    atomic_uint shared_nr;
+
+    i_cfg_reader_t readers[I_CFG_READER_MAX];
+
+    /* number of published entries in `keys` */
+    atomic_uint key_nr;
+    i_cfg_key_t keys[SIRIUS_CFG_KEY_MAX];
+
+    /* serializes the writers */
+    pthread_mutex_t mutex;
+} i_cfg_t;
+
+/* the first snapshot is never freed */
+static sirius_cfg_snap_t g_snap_init = {0};
+
+static i_cfg_t g_c = {
+    .p_snap = &g_snap_init,
+    .epoch = 1,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+long long sirius_cfg_val[SIRIUS_CFG_KEY_MAX] = {0};
+
+typedef struct {
+    int slot;
+    /* nesting depth of the read sections */
+    unsigned int depth;
+    const sirius_cfg_snap_t *p_held;
+} i_cfg_tls_t;
+
+static __thread i_cfg_tls_t i_cfg_tls = {
+    .slot = I_CFG_SLOT_NONE,
+};
+
+static pthread_key_t g_tls_key;
+static pthread_once_t g_tls_once = PTHREAD_ONCE_INIT;
+
+static void
+i_cfg_slot_free(void *p_val)
+{
+    int slot = (int)(intptr_t)p_val - 1;
+    atomic_store_explicit(&(g_c.readers[slot].epoch), 0,
+        memory_order_relaxed);
+    atomic_store_explicit(&(g_c.readers[slot].used), false,
+        memory_order_release);
+}
+
+static void
+i_cfg_tls_key_cr()
+{
+    (void)pthread_key_create(&g_tls_key, i_cfg_slot_free);
+}
+
+static int
+i_cfg_slot_claim()
+{
+    (void)pthread_once(&g_tls_once, i_cfg_tls_key_cr);
+
+    for (int i = 0; i < I_CFG_READER_MAX; i++) {
+        bool used = false;
+        if (!(atomic_load_explicit(&(g_c.readers[i].used),
+                memory_order_relaxed)) &&
+            atomic_compare_exchange_strong(
+                &(g_c.readers[i].used), &used, true)) {
+            /* the key releases the slot when the thread exits */
+            (void)pthread_setspecific(g_tls_key, (void *)(intptr_t)(i + 1));
+            return i;
+        }
+    }
+
+    return I_CFG_SLOT_SHARED;
+}
+
+const sirius_cfg_snap_t *
+sirius_cfg_snap_acquire()
+{
+    i_cfg_tls_t *p_t = &i_cfg_tls;
+    if (p_t->depth++) return p_t->p_held;
+
+    if (unlikely(I_CFG_SLOT_NONE == p_t->slot)) {
+        p_t->slot = i_cfg_slot_claim();
+    }
+
+    if (likely(p_t->slot >= 0)) {
+        atomic_store_explicit(&(g_c.readers[p_t->slot].epoch),
+            atomic_load_explicit(&(g_c.epoch), memory_order_relaxed),
+            memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+    } else {
+        atomic_fetch_add_explicit(&(g_c.shared_nr), 1,
+            memory_order_seq_cst);
+    }
+
+    p_t->p_held = atomic_load_explicit(&(g_c.p_snap),
+        memory_order_acquire);
+    return p_t->p_held;
+}
+
+void
+sirius_cfg_snap_release()
+{
+    i_cfg_tls_t *p_t = &i_cfg_tls;
+    if (unlikely(0 == p_t->depth) || --(p_t->depth)) return;
+
+    p_t->p_held = NULL;
+    if (likely(p_t->slot >= 0)) {
+        atomic_store_explicit(&(g_c.readers[p_t->slot].epoch), 0,
+            memory_order_release);
+    } else {
+        atomic_fetch_sub_explicit(&(g_c.shared_nr), 1,
+            memory_order_release);
+    }
+}
+
+/**
+ * @brief wait until the readers that may hold the previous
+ *  snapshot have left
+ */
+static void
+i_cfg_synchronize()
+{
+    unsigned long long epoch = atomic_fetch_add_explicit(
+        &(g_c.epoch), 1, memory_order_seq_cst) + 1;
+
+    for (int i = 0; i < I_CFG_READER_MAX; i++) {
+        unsigned int n = 1;
+        while (true) {
+            unsigned long long e = atomic_load_explicit(
+                &(g_c.readers[i].epoch), memory_order_seq_cst);
+            if (0 == e || e >= epoch) break;
+            if (sirius_backoff(&n)) (void)sched_yield();
+        }
+    }
+
+    unsigned int n = 1;
+    while (atomic_load_explicit(&(g_c.shared_nr),
+            memory_order_seq_cst)) {
+        if (sirius_backoff(&n)) (void)sched_yield();
+    }
+}
+
+/**
+ * @brief publish a copy of the current snapshot with one key changed
+ * 
+ * @note called with the writer lock held
+ */
+static int
+i_cfg_publish(int id, long long val, unsigned int nr)
+{
+    sirius_cfg_snap_t *p_old = atomic_load_explicit(&(g_c.p_snap),
+        memory_order_relaxed);
+    sirius_cfg_snap_t *p_new =
+        (sirius_cfg_snap_t *)malloc(sizeof(sirius_cfg_snap_t));
+    if (!(p_new)) return SIRIUS_ERR_MEMORY_ALLOC;
+
+    memcpy(p_new, p_old, sizeof(sirius_cfg_snap_t));
+    p_new->vals[id] = val;
+    p_new->nr = nr;
+    p_new->version++;
+
+    atomic_store_explicit(&(g_c.p_snap), p_new, memory_order_seq_cst);
+    __atomic_store_n(&(sirius_cfg_val[id]), val, __ATOMIC_RELAXED);
+
+    i_cfg_synchronize();
+    if (&g_snap_init != p_old) free(p_old);
+
+    return SIRIUS_OK;
+}
+
+/**
+ * @brief the grace period of a publish would wait for the
+ *  read section of the calling thread itself
+ */
+static inline bool
+i_cfg_in_read()
+{
+    return 0 != i_cfg_tls.depth;
+}
+
+int
+sirius_cfg_register(const sirius_cfg_attr_t *p_attr)
+{
+    if (!(p_attr) || !(p_attr->p_name)) {
+        return SIRIUS_ERR_NULL_POINTER;
+    }
+    if (unlikely(i_cfg_in_read())) return SIRIUS_ERR_RESOURCE_REQUEST;
+    if (strlen(p_attr->p_name) >= SIRIUS_CFG_NAME_SIZE ||
+        p_attr->min > p_attr->max ||
+        p_attr->def < p_attr->min ||
+        p_attr->def > p_attr->max) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&(g_c.mutex));
+
+    int id = sirius_cfg_find(p_attr->p_name);
+    if (id >= 0) goto label_unlock;
+
+    unsigned int nr = atomic_load_explicit(&(g_c.key_nr),
+        memory_order_relaxed);
+    if (SIRIUS_CFG_KEY_MAX == nr) {
+        id = SIRIUS_ERR_CACHE_OVERFLOW;
+        goto label_unlock;
+    }
+
+    i_cfg_key_t *p_k = &(g_c.keys[nr]);
+    strncpy(p_k->name, p_attr->p_name, SIRIUS_CFG_NAME_SIZE - 1);
+    p_k->min = p_attr->min;
+    p_k->max = p_attr->max;
+    p_k->p_check = p_attr->p_check;
+    p_k->p_notify = p_attr->p_notify;
+
+    id = i_cfg_publish((int)nr, p_attr->def, nr + 1);
+    if (id) goto label_unlock;
+
+    /* publish the entry */
+    atomic_store_explicit(&(g_c.key_nr), nr + 1, memory_order_release);
+    id = (int)nr;
+
+label_unlock:
+    pthread_mutex_unlock(&(g_c.mutex));
+    return id;
+}
+
+int
+sirius_cfg_find(const char *p_name)
+{
+    if (!(p_name)) return SIRIUS_ERR_NULL_POINTER;
+
+    unsigned int nr = atomic_load_explicit(&(g_c.key_nr),
+        memory_order_acquire);
+    for (unsigned int i = 0; i < nr; i++) {
+        if (!(strcmp(g_c.keys[i].name, p_name))) return (int)i;
+    }
+    return SIRIUS_ERR_INVALID_PARAMETER;
+}
+
+const char *
+sirius_cfg_name(int id)
+{
+    if (id < 0 || (unsigned int)id >= atomic_load_explicit(
+            &(g_c.key_nr), memory_order_acquire)) {
+        return NULL;
+    }
+    return g_c.keys[id].name;
+}
+
+int
+sirius_cfg_set(int id, long long val)
+{
+    int ret;
+    if (unlikely(i_cfg_in_read())) return SIRIUS_ERR_RESOURCE_REQUEST;
+
+    pthread_mutex_lock(&(g_c.mutex));
+
+    unsigned int nr = atomic_load_explicit(&(g_c.key_nr),
+        memory_order_relaxed);
+    if (id < 0 || (unsigned int)id >= nr) {
+        ret = SIRIUS_ERR_INVALID_ENTRY;
+        goto label_unlock;
+    }
+
+    i_cfg_key_t *p_k = &(g_c.keys[id]);
+    if (val < p_k->min || val > p_k->max) {
+        ret = SIRIUS_ERR_INVALID_PARAMETER;
+        goto label_unlock;
+    }
+    if (p_k->p_check) {
+        ret = p_k->p_check(val);
+        if (ret) goto label_unlock;
+    }
+
+    ret = i_cfg_publish(id, val, nr);
+    if (ret) goto label_unlock;
+
+    if (p_k->p_notify) p_k->p_notify(val);
+
+label_unlock:
+    pthread_mutex_unlock(&(g_c.mutex));
+    return ret;
+}
+
+int
+sirius_cfg_set_name(const char *p_name, long long val)
+{
+    int id = sirius_cfg_find(p_name);
+    if (id < 0) return id;
+    return sirius_cfg_set(id, val);
+}
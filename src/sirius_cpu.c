@@ -0,0 +1,262 @@
+#include "sirius_cpu.h"
+#include "sirius_errno.h"
+#include "sirius_log.h"
+
+#include "./internal/sirius_internal_sys.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define I_CPU_X86
+#endif
+
+/**
+ * the features are detected on the first query and cached in
+ * `g_feat`, with `I_CPU_DETECTED` set so that a cpu without any of
+ * them is not detected again. two threads racing on the first query
+ * store the same value. nothing here calls into libc, an ifunc
+ * resolver may run before it is relocated.
+ *
+ * the caches come from sysfs, which is what the kernel exposes for
+ * any vendor; the deterministic cache parameters of cpuid (leaf 4 on
+ * intel, 0x8000001d on amd) fill in what sysfs lacks, e.g. inside a
+ * container without /sys.
+ */
+
+#define I_CPU_DETECTED      (1U << 31)
+
+#define I_CPU_SYSFS         "/sys/devices/system/cpu/cpu0/cache"
+/* cache descriptors looked at, sysfs index or cpuid subleaf */
+#define I_CPU_CACHE_MAX     (16)
+
+static _Atomic unsigned int g_feat = 0;
+
+static sirius_cpu_cache_t g_cache = {0};
+static pthread_once_t g_cache_once = PTHREAD_ONCE_INIT;
+
+static const char *g_feat_name[SIRIUS_CPU_FEAT_NR] = {
+    "sse2", "sse4.2", "popcnt", "avx", "avx2", "fma",
+    "bmi1", "bmi2", "avx512f", "avx512bw", "avx512dq", "avx512vl",
+};
+
+#ifdef I_CPU_X86
+static unsigned long long
+i_cpu_xgetbv()
+{
+    unsigned int lo, hi;
+    __asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+}
+#endif // I_CPU_X86
+
+static unsigned int
+i_cpu_detect()
+{
+    unsigned int feat = 0;
+
+#ifdef I_CPU_X86
+    unsigned int a, b, c, d;
+    if (!(__get_cpuid(1, &a, &b, &c, &d))) return feat;
+
+    if (d & bit_SSE2) feat |= SIRIUS_CPU_SSE2;
+    if (c & bit_SSE4_2) feat |= SIRIUS_CPU_SSE42;
+    if (c & bit_POPCNT) feat |= SIRIUS_CPU_POPCNT;
+
+    /* the ymm / zmm registers are usable only if the os saves them */
+    unsigned long long xcr0 = (c & bit_OSXSAVE) ? i_cpu_xgetbv() : 0;
+    bool ymm = 0x6 == (xcr0 & 0x6);
+    bool zmm = 0xe6 == (xcr0 & 0xe6);
+    if (ymm && (c & bit_AVX)) feat |= SIRIUS_CPU_AVX;
+    if (ymm && (c & bit_FMA)) feat |= SIRIUS_CPU_FMA;
+
+    if (!(__get_cpuid_count(7, 0, &a, &b, &c, &d))) return feat;
+
+    if (b & bit_BMI) feat |= SIRIUS_CPU_BMI1;
+    if (b & bit_BMI2) feat |= SIRIUS_CPU_BMI2;
+    if (ymm && (b & bit_AVX2)) feat |= SIRIUS_CPU_AVX2;
+    if (zmm) {
+        if (b & bit_AVX512F) feat |= SIRIUS_CPU_AVX512F;
+        if (b & bit_AVX512BW) feat |= SIRIUS_CPU_AVX512BW;
+        if (b & bit_AVX512DQ) feat |= SIRIUS_CPU_AVX512DQ;
+        if (b & bit_AVX512VL) feat |= SIRIUS_CPU_AVX512VL;
+    }
+#endif // I_CPU_X86
+
+    return feat;
+}
+
+unsigned int
+sirius_cpu_features()
+{
+    unsigned int feat = atomic_load_explicit(&g_feat, memory_order_relaxed);
+    if (unlikely(!(feat & I_CPU_DETECTED))) {
+        feat = i_cpu_detect() | I_CPU_DETECTED;
+        atomic_store_explicit(&g_feat, feat, memory_order_relaxed);
+    }
+    return feat & ~I_CPU_DETECTED;
+}
+
+const char *
+sirius_cpu_feat_name(sirius_cpu_feat_t feat)
+{
+    for (int i = 0; i < SIRIUS_CPU_FEAT_NR; i++) {
+        if ((unsigned int)feat == 1U << i) return g_feat_name[i];
+    }
+    return NULL;
+}
+
+sirius_cpu_fn_t
+sirius_cpu_select(const sirius_cpu_impl_t *p_impl, size_t nr)
+{
+    if (!(p_impl)) return NULL;
+
+    unsigned int feat = sirius_cpu_features();
+    for (size_t i = 0; i < nr; i++) {
+        if (p_impl[i].need == (feat & p_impl[i].need)) {
+            return p_impl[i].p_fn;
+        }
+    }
+    return NULL;
+}
+
+/* caches */
+
+static void
+i_cpu_cache_set(sirius_cpu_cache_t *p_c, unsigned int level, bool data,
+    size_t size, unsigned int line)
+{
+    size_t *p_size = NULL;
+    if (1 == level && data) {
+        p_size = &(p_c->l1d);
+    } else if (2 == level) {
+        p_size = &(p_c->l2);
+    } else if (3 == level) {
+        p_size = &(p_c->l3);
+    }
+    if (p_size && 0 == *p_size) *p_size = size;
+    if (1 == level && data && 0 == p_c->line) p_c->line = line;
+}
+
+/* reads an attribute of a sysfs cache index, returns the length */
+static int
+i_cpu_sysfs_read(int index, const char *p_attr, char *p_buf, size_t size)
+{
+    char path[128];
+    snprintf(path, sizeof(path), I_CPU_SYSFS "/index%d/%s", index, p_attr);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd) return -1;
+    ssize_t len = read(fd, p_buf, size - 1);
+    close(fd);
+    if (len <= 0) return -1;
+
+    p_buf[len] = '\0';
+    return (int)len;
+}
+
+static void
+i_cpu_cache_sysfs(sirius_cpu_cache_t *p_c)
+{
+    char buf[32];
+
+    for (int i = 0; i < I_CPU_CACHE_MAX; i++) {
+        if (i_cpu_sysfs_read(i, "level", buf, sizeof(buf)) < 0) break;
+        unsigned int level = (unsigned int)strtoul(buf, NULL, 10);
+
+        if (i_cpu_sysfs_read(i, "type", buf, sizeof(buf)) < 0) continue;
+        /* "Data", "Instruction" or "Unified" */
+        bool data = 'I' != buf[0];
+
+        if (i_cpu_sysfs_read(i, "size", buf, sizeof(buf)) < 0) continue;
+        char *p_end = NULL;
+        size_t size = strtoull(buf, &p_end, 10);
+        if ('K' == *p_end) size <<= 10;
+        if ('M' == *p_end) size <<= 20;
+
+        unsigned int line = 0;
+        if (i_cpu_sysfs_read(i, "coherency_line_size",
+            buf, sizeof(buf)) > 0) {
+            line = (unsigned int)strtoul(buf, NULL, 10);
+        }
+
+        i_cpu_cache_set(p_c, level, data, size, line);
+    }
+}
+
+static void
+i_cpu_cache_cpuid(sirius_cpu_cache_t *p_c)
+{
+#ifdef I_CPU_X86
+    unsigned int a, b, c, d;
+    unsigned int leaf = 4;
+
+    /* amd reports the same layout in another leaf */
+    __get_cpuid(0, &a, &b, &c, &d);
+    if (0x68747541 == b) {
+        if (__get_cpuid_max(0x80000000, NULL) < 0x8000001d) return;
+        leaf = 0x8000001d;
+    } else if (a < 4) {
+        return;
+    }
+
+    for (unsigned int i = 0; i < I_CPU_CACHE_MAX; i++) {
+        __cpuid_count(leaf, i, a, b, c, d);
+        /* 0: no more caches, 1: data, 2: instruction, 3: unified */
+        unsigned int type = a & 0x1f;
+        if (0 == type) break;
+
+        unsigned int level = (a >> 5) & 0x7;
+        unsigned int line = (b & 0xfff) + 1;
+        size_t ways = ((b >> 22) & 0x3ff) + 1;
+        size_t parts = ((b >> 12) & 0x3ff) + 1;
+        size_t sets = (size_t)c + 1;
+
+        i_cpu_cache_set(p_c, level, 2 != type,
+            ways * parts * line * sets, line);
+    }
+#endif // I_CPU_X86
+}
+
+static void
+i_cpu_cache_detect()
+{
+    i_cpu_cache_sysfs(&g_cache);
+    i_cpu_cache_cpuid(&g_cache);
+
+    if (0 == g_cache.line) {
+        long line = -1;
+#ifdef _SC_LEVEL1_DCACHE_LINESIZE
+        line = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+#endif
+        g_cache.line = line > 0 ? (unsigned int)line : 64;
+    }
+}
+
+const sirius_cpu_cache_t *
+sirius_cpu_cache()
+{
+    pthread_once(&g_cache_once, i_cpu_cache_detect);
+    return &g_cache;
+}
+
+int
+sirius_cpu_init()
+{
+    const sirius_cpu_cache_t *p_c = sirius_cpu_cache();
+    unsigned int feat = sirius_cpu_features();
+
+    char buf[160];
+    size_t len = 0;
+    buf[0] = '\0';
+    for (int i = 0; i < SIRIUS_CPU_FEAT_NR; i++) {
+        if (!(feat & (1U << i))) continue;
+        int r = snprintf(buf + len, sizeof(buf) - len, " %s",
+            g_feat_name[i]);
+        if (r < 0 || (size_t)r >= sizeof(buf) - len) break;
+        len += (size_t)r;
+    }
+
+    SIRIUS_INFO("cpu features:%s\n", len ? buf : " none");
+    SIRIUS_INFO("cpu caches: line %u, l1d %zu, l2 %zu, l3 %zu\n",
+        p_c->line, p_c->l1d, p_c->l2, p_c->l3);
+    return SIRIUS_OK;
+}
@@ -0,0 +1,988 @@
+#include "sirius_hashmap.h"
+#include "sirius_errno.h"
+#include "sirius_lock.h"
+
+#include "./internal/sirius_internal_sys.h"
+#include "./internal/sirius_internal_math.h"
+
+/**
+ * a table of `cap` slots, a power of 2, has one control byte per
+ * slot: `I_HMAP_EMPTY`, `I_HMAP_DELETED`, or the low 7 bits of the
+ * hash (h2) of a full slot. the rest of the hash (h1) picks the first
+ * slot to look at. a lookup loads the `width` control bytes from there
+ * as a group, compares all of them with h2 at once and checks the
+ * keys of the matches only; it stops at a group that has an empty
+ * slot, otherwise it moves on by 1, 2, 3... groups, a sequence that
+ * visits every group once since `cap` is a power of 2.
+ *
+ * the first `width` control bytes are mirrored after the last one,
+ * so a group starting near the end is a single unaligned load.
+ *
+ * an erased slot becomes empty again if no group that covers it can
+ * have been full: there is an empty slot within `width` before and
+ * after it. otherwise it is marked deleted, which a lookup skips and
+ * an insertion reuses. the table grows once the empty slots would
+ * fall below 1/8, or is rebuilt at the same size if most of that is
+ * deletion marks.
+ *
+ * the group width is 16 control bytes with sse2, 32 with avx2, and 8
+ * bytes of a 64-bit word elsewhere; for the word, a match is the top
+ * bit of the byte, so the mask is shifted by 3 to get an index.
+ */
+
+#define I_HMAP_EMPTY        ((int8_t)-128)
+#define I_HMAP_DELETED      ((int8_t)-2)
+
+/* the widest group, the size of the mirrored tail */
+#define I_HMAP_GROUP_MAX    (32)
+
+#define I_HMAP_H1(hash)     ((hash) >> 7)
+#define I_HMAP_H2(hash)     ((int8_t)((hash) & 0x7f))
+
+typedef struct {
+    uint64_t key;
+    size_t value;
+} i_hmap_slot_int_t;
+
+typedef struct {
+    uint64_t hash;
+    size_t len;
+    void *p_key;
+    size_t value;
+} i_hmap_slot_bytes_t;
+
+typedef struct {
+    int8_t *p_ctrl;
+    void *p_slots;
+    size_t cap;
+    size_t size;
+    /* empty slots that may still be filled before a rebuild */
+    size_t growth;
+} i_hmap_tab_t;
+
+typedef struct {
+    sirius_rwlock_t lock;
+    i_hmap_tab_t tab;
+} __attribute__((aligned(64))) i_hmap_stripe_t;
+
+typedef struct {
+    sirius_hashmap_key_t key_type;
+    size_t slot_size;
+    sirius_hashmap_hash_t p_hash;
+    uint64_t seed;
+
+    /* the stripes are locked */
+    bool locked;
+    unsigned int stripe_nr;
+    /* 64 - log2(stripe_nr), the top bits of the hash pick the stripe */
+    unsigned int stripe_shift;
+    i_hmap_stripe_t *p_stripes;
+} i_hmap_t;
+
+typedef struct {
+    const char *p_isa;
+    size_t width;
+    size_t (*find_int)(const i_hmap_tab_t *p_t, uint64_t key,
+        uint64_t hash);
+    size_t (*find_bytes)(const i_hmap_tab_t *p_t, const void *p_key,
+        size_t len, uint64_t hash);
+    /* first empty or deleted slot of the probe sequence */
+    size_t (*find_free)(const i_hmap_tab_t *p_t, uint64_t hash);
+    bool (*never_full)(const i_hmap_tab_t *p_t, size_t idx);
+    /* first full slot from `pos`, `cap` if none */
+    size_t (*next_full)(const i_hmap_tab_t *p_t, size_t pos);
+} i_hmap_ops_t;
+
+static i_hmap_ops_t g_ops = {0};
+
+/* hash */
+
+#define I_HMAP_P0   (0xa0761d6478bd642fULL)
+#define I_HMAP_P1   (0xe7037ed1a0b428dbULL)
+#define I_HMAP_P2   (0x8ebc6af09c88c6e3ULL)
+
+/* multiply and fold */
+static inline uint64_t
+i_hmap_mum(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = (unsigned __int128)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+    uint64_t lo = a * b;
+    uint64_t hi = (a >> 32) * (b >> 32) + ((a * (b >> 32)) >> 32);
+    return lo ^ hi;
+#endif
+}
+
+static inline uint64_t
+i_hmap_r8(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t
+i_hmap_r4(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t
+sirius_hashmap_hash(const void *p_key, size_t len, uint64_t seed)
+{
+    const uint8_t *p = (const uint8_t *)p_key;
+    uint64_t a, b;
+
+    seed ^= i_hmap_mum(seed ^ I_HMAP_P0, I_HMAP_P1);
+    if (len <= 16) {
+        if (len >= 4) {
+            size_t mid = (len >> 3) << 2;
+            a = (i_hmap_r4(p) << 32) | i_hmap_r4(p + mid);
+            b = (i_hmap_r4(p + len - 4) << 32) | i_hmap_r4(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) |
+                p[len - 1];
+            b = 0;
+        } else {
+            a = 0;
+            b = 0;
+        }
+    } else {
+        size_t i = len;
+        while (i > 16) {
+            seed = i_hmap_mum(i_hmap_r8(p) ^ I_HMAP_P1,
+                i_hmap_r8(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        /* the last 16 bytes, overlapping the previous block */
+        a = i_hmap_r8(p + i - 16);
+        b = i_hmap_r8(p + i - 8);
+    }
+    return i_hmap_mum(I_HMAP_P1 ^ len,
+        i_hmap_mum(a ^ I_HMAP_P1, b ^ seed) ^ I_HMAP_P2);
+}
+
+static inline uint64_t
+i_hmap_hash_int(const i_hmap_t *p_m, uint64_t key)
+{
+    if (p_m->p_hash) return p_m->p_hash(&key, sizeof(key), p_m->seed);
+
+    /* the finalizer of murmur3 */
+    key ^= p_m->seed;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+static inline uint64_t
+i_hmap_hash_bytes(const i_hmap_t *p_m, const void *p_key, size_t len)
+{
+    return (p_m->p_hash ? p_m->p_hash : sirius_hashmap_hash)(p_key, len,
+        p_m->seed);
+}
+
+/* group matching */
+
+#define I_HMAP_LSB  (0x0101010101010101ULL)
+#define I_HMAP_MSB  (0x8080808080808080ULL)
+
+static inline uint64_t
+i_hmap_word(const int8_t *p)
+{
+    uint64_t g;
+    memcpy(&g, p, sizeof(g));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    g = __builtin_bswap64(g);
+#endif
+    return g;
+}
+
+/* may report a byte above a true match, the keys are compared anyway */
+static inline uint64_t
+i_hmap_match_scalar(const int8_t *p, int8_t h2)
+{
+    uint64_t x = i_hmap_word(p) ^ (I_HMAP_LSB * (uint8_t)h2);
+    return (x - I_HMAP_LSB) & ~x & I_HMAP_MSB;
+}
+
+static inline uint64_t
+i_hmap_empty_scalar(const int8_t *p)
+{
+    /* the top bit set and bit 1 clear: -128 but not -2 */
+    uint64_t g = i_hmap_word(p);
+    return g & ~(g << 6) & I_HMAP_MSB;
+}
+
+static inline uint64_t
+i_hmap_free_scalar(const int8_t *p)
+{
+    return i_hmap_word(p) & I_HMAP_MSB;
+}
+
+static inline uint64_t
+i_hmap_full_scalar(const int8_t *p)
+{
+    return ~i_hmap_word(p) & I_HMAP_MSB;
+}
+
+#ifdef I_MATH_X86
+
+#define I_HMAP_SSE2 __attribute__((target("sse2")))
+
+I_HMAP_SSE2 static inline uint64_t
+i_hmap_match_sse2(const int8_t *p, int8_t h2)
+{
+    __m128i g = _mm_loadu_si128((const __m128i *)p);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(h2)));
+}
+
+I_HMAP_SSE2 static inline uint64_t
+i_hmap_empty_sse2(const int8_t *p)
+{
+    return i_hmap_match_sse2(p, I_HMAP_EMPTY);
+}
+
+I_HMAP_SSE2 static inline uint64_t
+i_hmap_free_sse2(const int8_t *p)
+{
+    return (uint32_t)_mm_movemask_epi8(
+        _mm_loadu_si128((const __m128i *)p));
+}
+
+I_HMAP_SSE2 static inline uint64_t
+i_hmap_full_sse2(const int8_t *p)
+{
+    return ~i_hmap_free_sse2(p) & 0xffff;
+}
+
+#define I_HMAP_AVX2 __attribute__((target("avx2")))
+
+I_HMAP_AVX2 static inline uint64_t
+i_hmap_match_avx2(const int8_t *p, int8_t h2)
+{
+    __m256i g = _mm256_loadu_si256((const __m256i *)p);
+    return (uint32_t)_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(g, _mm256_set1_epi8(h2)));
+}
+
+I_HMAP_AVX2 static inline uint64_t
+i_hmap_empty_avx2(const int8_t *p)
+{
+    return i_hmap_match_avx2(p, I_HMAP_EMPTY);
+}
+
+I_HMAP_AVX2 static inline uint64_t
+i_hmap_free_avx2(const int8_t *p)
+{
+    return (uint32_t)_mm256_movemask_epi8(
+        _mm256_loadu_si256((const __m256i *)p));
+}
+
+I_HMAP_AVX2 static inline uint64_t
+i_hmap_full_avx2(const int8_t *p)
+{
+    return ~i_hmap_free_avx2(p) & 0xffffffffULL;
+}
+
+#endif // I_MATH_X86
+
+/**
+ * @param isa: suffix of the group functions
+ * @param W: group width, in slots
+ * @param SHIFT: log2 of the mask bits per slot
+ */
+#define I_HMAP_PROBE(isa, attr, W, SHIFT) \
+attr static size_t \
+i_hmap_find_int_##isa(const i_hmap_tab_t *p_t, uint64_t key, \
+    uint64_t hash) \
+{ \
+    const i_hmap_slot_int_t *p_s = (const i_hmap_slot_int_t *)p_t->p_slots; \
+    size_t mask = p_t->cap - 1; \
+    size_t pos = I_HMAP_H1(hash) & mask; \
+    for (size_t step = W; ; step += W) { \
+        uint64_t m = i_hmap_match_##isa(p_t->p_ctrl + pos, I_HMAP_H2(hash)); \
+        for (; m; m &= m - 1) { \
+            size_t i = (pos + (__builtin_ctzll(m) >> SHIFT)) & mask; \
+            if (likely(p_s[i].key == key)) return i; \
+        } \
+        if (likely(i_hmap_empty_##isa(p_t->p_ctrl + pos))) return SIZE_MAX; \
+        pos = (pos + step) & mask; \
+    } \
+} \
+attr static size_t \
+i_hmap_find_bytes_##isa(const i_hmap_tab_t *p_t, const void *p_key, \
+    size_t len, uint64_t hash) \
+{ \
+    const i_hmap_slot_bytes_t *p_s = \
+        (const i_hmap_slot_bytes_t *)p_t->p_slots; \
+    size_t mask = p_t->cap - 1; \
+    size_t pos = I_HMAP_H1(hash) & mask; \
+    for (size_t step = W; ; step += W) { \
+        uint64_t m = i_hmap_match_##isa(p_t->p_ctrl + pos, I_HMAP_H2(hash)); \
+        for (; m; m &= m - 1) { \
+            size_t i = (pos + (__builtin_ctzll(m) >> SHIFT)) & mask; \
+            if (likely(p_s[i].hash == hash && p_s[i].len == len && \
+                0 == memcmp(p_s[i].p_key, p_key, len))) { \
+                return i; \
+            } \
+        } \
+        if (likely(i_hmap_empty_##isa(p_t->p_ctrl + pos))) return SIZE_MAX; \
+        pos = (pos + step) & mask; \
+    } \
+} \
+attr static size_t \
+i_hmap_find_free_##isa(const i_hmap_tab_t *p_t, uint64_t hash) \
+{ \
+    size_t mask = p_t->cap - 1; \
+    size_t pos = I_HMAP_H1(hash) & mask; \
+    for (size_t step = W; ; step += W) { \
+        uint64_t m = i_hmap_free_##isa(p_t->p_ctrl + pos); \
+        if (likely(m)) { \
+            return (pos + (__builtin_ctzll(m) >> SHIFT)) & mask; \
+        } \
+        pos = (pos + step) & mask; \
+    } \
+} \
+attr static bool \
+i_hmap_never_full_##isa(const i_hmap_tab_t *p_t, size_t idx) \
+{ \
+    size_t mask = p_t->cap - 1; \
+    uint64_t before = i_hmap_empty_##isa(p_t->p_ctrl + ((idx - W) & mask)); \
+    uint64_t after = i_hmap_empty_##isa(p_t->p_ctrl + idx); \
+    if (!(before) || !(after)) return false; \
+    /** \
+     * the run of non-empty slots ending right before `idx` and the \
+     * one starting at it; shorter than a group together, no probe \
+     * ever saw a full group across `idx` \
+     */ \
+    size_t lead = (size_t)(__builtin_clzll(before) - \
+        (64 - (W << SHIFT))) >> SHIFT; \
+    size_t trail = (size_t)__builtin_ctzll(after) >> SHIFT; \
+    return lead + trail < W; \
+} \
+attr static size_t \
+i_hmap_next_full_##isa(const i_hmap_tab_t *p_t, size_t pos) \
+{ \
+    for (; pos < p_t->cap; pos += W) { \
+        uint64_t m = i_hmap_full_##isa(p_t->p_ctrl + pos); \
+        if (m) { \
+            size_t i = pos + (__builtin_ctzll(m) >> SHIFT); \
+            return i < p_t->cap ? i : p_t->cap; \
+        } \
+    } \
+    return p_t->cap; \
+}
+
+I_HMAP_PROBE(scalar, , 8, 3)
+#ifdef I_MATH_X86
+I_HMAP_PROBE(sse2, I_HMAP_SSE2, 16, 0)
+I_HMAP_PROBE(avx2, I_HMAP_AVX2, 32, 0)
+#endif // I_MATH_X86
+
+#define I_HMAP_SET(isa, W) \
+    g_ops.p_isa = #isa; \
+    g_ops.width = W; \
+    g_ops.find_int = i_hmap_find_int_##isa; \
+    g_ops.find_bytes = i_hmap_find_bytes_##isa; \
+    g_ops.find_free = i_hmap_find_free_##isa; \
+    g_ops.never_full = i_hmap_never_full_##isa; \
+    g_ops.next_full = i_hmap_next_full_##isa;
+
+#define I_HMAP_SET_FN(isa, W) \
+static void \
+i_hmap_set_##isa() \
+{ \
+    I_HMAP_SET(isa, W) \
+}
+
+I_HMAP_SET_FN(scalar, 8)
+#ifdef I_MATH_X86
+I_HMAP_SET_FN(sse2, 16)
+I_HMAP_SET_FN(avx2, 32)
+#endif // I_MATH_X86
+
+/* 64-byte groups are not worth it, avx512 uses the avx2 probing */
+static const sirius_cpu_impl_t i_hmap_impl[] = {
+#ifdef I_MATH_X86
+    {SIRIUS_CPU_AVX2, (sirius_cpu_fn_t)i_hmap_set_avx2},
+    {SIRIUS_CPU_SSE2, (sirius_cpu_fn_t)i_hmap_set_sse2},
+#endif // I_MATH_X86
+    {0, (sirius_cpu_fn_t)i_hmap_set_scalar},
+};
+
+__attribute__((constructor)) static void
+i_hmap_dispatch()
+{
+    ((void (*)())sirius_math_internal_select(i_hmap_impl,
+        sizeof(i_hmap_impl) / sizeof(i_hmap_impl[0])))();
+}
+
+const char *
+sirius_hashmap_isa()
+{
+    return g_ops.p_isa;
+}
+
+/* table */
+
+static inline void
+i_hmap_set_ctrl(i_hmap_tab_t *p_t, size_t i, int8_t c)
+{
+    p_t->p_ctrl[i] = c;
+    if (i < g_ops.width) p_t->p_ctrl[p_t->cap + i] = c;
+}
+
+static inline size_t
+i_hmap_growth(size_t cap)
+{
+    return cap - cap / 8;
+}
+
+/**
+ * @return the smallest capacity holding `n` elements, 0 on overflow
+ */
+static size_t
+i_hmap_cap_for(size_t n)
+{
+    size_t cap = g_ops.width;
+    while (i_hmap_growth(cap) < n) {
+        if (cap > SIZE_MAX / 4) return 0;
+        cap <<= 1;
+    }
+    return cap;
+}
+
+static int
+i_hmap_tab_init(i_hmap_tab_t *p_t, size_t cap, size_t slot_size)
+{
+    size_t ctrl_size = (cap + I_HMAP_GROUP_MAX + 63) & ~(size_t)63;
+    if (cap > (SIZE_MAX - ctrl_size) / slot_size) {
+        return SIRIUS_ERR_MEMORY_ALLOC;
+    }
+    size_t size = (ctrl_size + cap * slot_size + 63) & ~(size_t)63;
+    int8_t *p = (int8_t *)aligned_alloc(64, size);
+    if (!(p)) return SIRIUS_ERR_MEMORY_ALLOC;
+
+    memset(p, I_HMAP_EMPTY, ctrl_size);
+    p_t->p_ctrl = p;
+    p_t->p_slots = p + ctrl_size;
+    p_t->cap = cap;
+    p_t->size = 0;
+    p_t->growth = i_hmap_growth(cap);
+    return SIRIUS_OK;
+}
+
+static void
+i_hmap_keys_free(const i_hmap_t *p_m, i_hmap_tab_t *p_t)
+{
+    if (SIRIUS_HASHMAP_KEY_BYTES != p_m->key_type) return;
+
+    i_hmap_slot_bytes_t *p_s = (i_hmap_slot_bytes_t *)p_t->p_slots;
+    for (size_t i = g_ops.next_full(p_t, 0); i < p_t->cap;
+        i = g_ops.next_full(p_t, i + 1)) {
+        free(p_s[i].p_key);
+    }
+}
+
+/**
+ * @brief move the elements into a table of `cap` slots
+ */
+static int
+i_hmap_resize(const i_hmap_t *p_m, i_hmap_tab_t *p_t, size_t cap)
+{
+    i_hmap_tab_t t;
+    int ret = i_hmap_tab_init(&t, cap, p_m->slot_size);
+    if (ret) return ret;
+
+    const char *p_old = (const char *)p_t->p_slots;
+    char *p_new = (char *)t.p_slots;
+    for (size_t i = g_ops.next_full(p_t, 0); i < p_t->cap;
+        i = g_ops.next_full(p_t, i + 1)) {
+        const char *p_slot = p_old + i * p_m->slot_size;
+        uint64_t hash = SIRIUS_HASHMAP_KEY_INT == p_m->key_type ?
+            i_hmap_hash_int(p_m, ((const i_hmap_slot_int_t *)p_slot)->key) :
+            ((const i_hmap_slot_bytes_t *)p_slot)->hash;
+
+        size_t j = g_ops.find_free(&t, hash);
+        i_hmap_set_ctrl(&t, j, I_HMAP_H2(hash));
+        memcpy(p_new + j * p_m->slot_size, p_slot, p_m->slot_size);
+    }
+    t.size = p_t->size;
+    t.growth -= p_t->size;
+
+    free(p_t->p_ctrl);
+    *p_t = t;
+    return SIRIUS_OK;
+}
+
+/**
+ * @brief claim the slot for a new element of `hash`,
+ *  growing the table if needed
+ *
+ * @return the slot, SIZE_MAX if the table cannot grow
+ */
+static size_t
+i_hmap_claim(const i_hmap_t *p_m, i_hmap_tab_t *p_t, uint64_t hash)
+{
+    size_t i = g_ops.find_free(p_t, hash);
+    if (unlikely(0 == p_t->growth && I_HMAP_DELETED != p_t->p_ctrl[i])) {
+        /* mostly deletion marks, rebuilding is enough */
+        size_t cap = p_t->size * 16 <= p_t->cap * 7 ?
+            p_t->cap : p_t->cap * 2;
+        if (i_hmap_resize(p_m, p_t, cap)) return SIZE_MAX;
+        i = g_ops.find_free(p_t, hash);
+    }
+
+    if (I_HMAP_EMPTY == p_t->p_ctrl[i]) p_t->growth--;
+    i_hmap_set_ctrl(p_t, i, I_HMAP_H2(hash));
+    p_t->size++;
+    return i;
+}
+
+static void
+i_hmap_release(i_hmap_tab_t *p_t, size_t i)
+{
+    if (g_ops.never_full(p_t, i)) {
+        i_hmap_set_ctrl(p_t, i, I_HMAP_EMPTY);
+        p_t->growth++;
+    } else {
+        i_hmap_set_ctrl(p_t, i, I_HMAP_DELETED);
+    }
+    p_t->size--;
+}
+
+/* stripes */
+
+static inline i_hmap_stripe_t *
+i_hmap_stripe(const i_hmap_t *p_m, uint64_t hash)
+{
+    return p_m->stripe_nr > 1 ?
+        &(p_m->p_stripes[hash >> p_m->stripe_shift]) : p_m->p_stripes;
+}
+
+static inline void
+i_hmap_rdlock(const i_hmap_t *p_m, i_hmap_stripe_t *p_s)
+{
+    if (p_m->locked) sirius_rwlock_rdlock(&(p_s->lock));
+}
+
+static inline void
+i_hmap_rdunlock(const i_hmap_t *p_m, i_hmap_stripe_t *p_s)
+{
+    if (p_m->locked) sirius_rwlock_rdunlock(&(p_s->lock));
+}
+
+static inline void
+i_hmap_wrlock(const i_hmap_t *p_m, i_hmap_stripe_t *p_s)
+{
+    if (p_m->locked) sirius_rwlock_wrlock(&(p_s->lock));
+}
+
+static inline void
+i_hmap_wrunlock(const i_hmap_t *p_m, i_hmap_stripe_t *p_s)
+{
+    if (p_m->locked) sirius_rwlock_wrunlock(&(p_s->lock));
+}
+
+/* map */
+
+int
+sirius_hashmap_cr(const sirius_hashmap_cr_t *p_cr,
+    sirius_hashmap_handle *p_handle)
+{
+    if (!(p_cr) || !(p_handle)) return SIRIUS_ERR_NULL_POINTER;
+    if (p_cr->key_type < 0 || p_cr->key_type >= SIRIUS_HASHMAP_KEY_MAX ||
+        p_cr->stripes > SIRIUS_HASHMAP_STRIPE_MAX) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    i_hmap_t *p_m = (i_hmap_t *)calloc(1, sizeof(i_hmap_t));
+    if (!(p_m)) return SIRIUS_ERR_MEMORY_ALLOC;
+    p_m->key_type = p_cr->key_type;
+    p_m->slot_size = SIRIUS_HASHMAP_KEY_INT == p_cr->key_type ?
+        sizeof(i_hmap_slot_int_t) : sizeof(i_hmap_slot_bytes_t);
+    p_m->p_hash = p_cr->p_hash;
+    p_m->seed = p_cr->seed;
+    p_m->locked = p_cr->stripes > 0;
+    p_m->stripe_nr = 1;
+    p_m->stripe_shift = 64;
+    while (p_m->stripe_nr < p_cr->stripes) {
+        p_m->stripe_nr <<= 1;
+        p_m->stripe_shift--;
+    }
+
+    p_m->p_stripes = (i_hmap_stripe_t *)aligned_alloc(64,
+        sizeof(i_hmap_stripe_t) * p_m->stripe_nr);
+    if (!(p_m->p_stripes)) {
+        free(p_m);
+        return SIRIUS_ERR_MEMORY_ALLOC;
+    }
+
+    /* the capacity is shared evenly */
+    size_t cap = i_hmap_cap_for(
+        (p_cr->capacity + p_m->stripe_nr - 1) / p_m->stripe_nr);
+    int ret = cap ? SIRIUS_OK : SIRIUS_ERR_INVALID_PARAMETER;
+    unsigned int s = 0;
+    for (; !(ret) && s < p_m->stripe_nr; s++) {
+        sirius_rwlock_init(&(p_m->p_stripes[s].lock));
+        ret = i_hmap_tab_init(&(p_m->p_stripes[s].tab), cap, p_m->slot_size);
+    }
+    if (ret) {
+        for (unsigned int i = 0; i + 1 < s; i++) {
+            free(p_m->p_stripes[i].tab.p_ctrl);
+        }
+        free(p_m->p_stripes);
+        free(p_m);
+        return ret;
+    }
+
+    *p_handle = (sirius_hashmap_handle)p_m;
+    return SIRIUS_OK;
+}
+
+int
+sirius_hashmap_del(sirius_hashmap_handle handle)
+{
+    if (!(handle)) return SIRIUS_ERR_NULL_POINTER;
+
+    i_hmap_t *p_m = (i_hmap_t *)handle;
+    for (unsigned int s = 0; s < p_m->stripe_nr; s++) {
+        i_hmap_keys_free(p_m, &(p_m->p_stripes[s].tab));
+        free(p_m->p_stripes[s].tab.p_ctrl);
+    }
+    free(p_m->p_stripes);
+    free(p_m);
+    return SIRIUS_OK;
+}
+
+#define I_HMAP_CHECK(handle, type) \
+    if (unlikely(!(handle))) return SIRIUS_ERR_NULL_POINTER; \
+    if (unlikely((type) != ((i_hmap_t *)(handle))->key_type)) { \
+        return SIRIUS_ERR_INVALID_PARAMETER; \
+    }
+
+int
+sirius_hashmap_put_int(sirius_hashmap_handle handle, uint64_t key,
+    size_t value)
+{
+    I_HMAP_CHECK(handle, SIRIUS_HASHMAP_KEY_INT);
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    uint64_t hash = i_hmap_hash_int(p_m, key);
+    i_hmap_stripe_t *p_s = i_hmap_stripe(p_m, hash);
+
+    int ret = SIRIUS_OK;
+    i_hmap_wrlock(p_m, p_s);
+    i_hmap_tab_t *p_t = &(p_s->tab);
+    size_t i = g_ops.find_int(p_t, key, hash);
+    if (SIZE_MAX == i) i = i_hmap_claim(p_m, p_t, hash);
+    if (likely(SIZE_MAX != i)) {
+        i_hmap_slot_int_t *p_slot = (i_hmap_slot_int_t *)p_t->p_slots + i;
+        p_slot->key = key;
+        p_slot->value = value;
+    } else {
+        ret = SIRIUS_ERR_MEMORY_ALLOC;
+    }
+    i_hmap_wrunlock(p_m, p_s);
+    return ret;
+}
+
+int
+sirius_hashmap_get_int(sirius_hashmap_handle handle, uint64_t key,
+    size_t *p_value)
+{
+    I_HMAP_CHECK(handle, SIRIUS_HASHMAP_KEY_INT);
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    uint64_t hash = i_hmap_hash_int(p_m, key);
+    i_hmap_stripe_t *p_s = i_hmap_stripe(p_m, hash);
+
+    int ret = SIRIUS_ERR_NOT_FOUND;
+    i_hmap_rdlock(p_m, p_s);
+    size_t i = g_ops.find_int(&(p_s->tab), key, hash);
+    if (SIZE_MAX != i) {
+        if (p_value) {
+            *p_value = ((const i_hmap_slot_int_t *)p_s->tab.p_slots)[i].value;
+        }
+        ret = SIRIUS_OK;
+    }
+    i_hmap_rdunlock(p_m, p_s);
+    return ret;
+}
+
+int
+sirius_hashmap_erase_int(sirius_hashmap_handle handle, uint64_t key)
+{
+    I_HMAP_CHECK(handle, SIRIUS_HASHMAP_KEY_INT);
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    uint64_t hash = i_hmap_hash_int(p_m, key);
+    i_hmap_stripe_t *p_s = i_hmap_stripe(p_m, hash);
+
+    int ret = SIRIUS_ERR_NOT_FOUND;
+    i_hmap_wrlock(p_m, p_s);
+    size_t i = g_ops.find_int(&(p_s->tab), key, hash);
+    if (SIZE_MAX != i) {
+        i_hmap_release(&(p_s->tab), i);
+        ret = SIRIUS_OK;
+    }
+    i_hmap_wrunlock(p_m, p_s);
+    return ret;
+}
+
+int
+sirius_hashmap_put(sirius_hashmap_handle handle, const void *p_key,
+    size_t len, size_t value)
+{
+    I_HMAP_CHECK(handle, SIRIUS_HASHMAP_KEY_BYTES);
+    if (!(p_key) && len) return SIRIUS_ERR_NULL_POINTER;
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    uint64_t hash = i_hmap_hash_bytes(p_m, p_key, len);
+    i_hmap_stripe_t *p_s = i_hmap_stripe(p_m, hash);
+
+    int ret = SIRIUS_OK;
+    i_hmap_wrlock(p_m, p_s);
+    i_hmap_tab_t *p_t = &(p_s->tab);
+    i_hmap_slot_bytes_t *p_slots = (i_hmap_slot_bytes_t *)p_t->p_slots;
+    size_t i = g_ops.find_bytes(p_t, p_key, len, hash);
+    if (SIZE_MAX != i) {
+        p_slots[i].value = value;
+        goto label_unlock;
+    }
+
+    /* the copy is made first, a failure leaves the map unchanged */
+    void *p_copy = malloc(len ? len : 1);
+    if (!(p_copy)) {
+        ret = SIRIUS_ERR_MEMORY_ALLOC;
+        goto label_unlock;
+    }
+    if (len) memcpy(p_copy, p_key, len);
+
+    i = i_hmap_claim(p_m, p_t, hash);
+    if (unlikely(SIZE_MAX == i)) {
+        free(p_copy);
+        ret = SIRIUS_ERR_MEMORY_ALLOC;
+        goto label_unlock;
+    }
+    p_slots = (i_hmap_slot_bytes_t *)p_t->p_slots;
+    p_slots[i].hash = hash;
+    p_slots[i].len = len;
+    p_slots[i].p_key = p_copy;
+    p_slots[i].value = value;
+
+label_unlock:
+    i_hmap_wrunlock(p_m, p_s);
+    return ret;
+}
+
+int
+sirius_hashmap_get(sirius_hashmap_handle handle, const void *p_key,
+    size_t len, size_t *p_value)
+{
+    I_HMAP_CHECK(handle, SIRIUS_HASHMAP_KEY_BYTES);
+    if (!(p_key) && len) return SIRIUS_ERR_NULL_POINTER;
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    uint64_t hash = i_hmap_hash_bytes(p_m, p_key, len);
+    i_hmap_stripe_t *p_s = i_hmap_stripe(p_m, hash);
+
+    int ret = SIRIUS_ERR_NOT_FOUND;
+    i_hmap_rdlock(p_m, p_s);
+    size_t i = g_ops.find_bytes(&(p_s->tab), p_key, len, hash);
+    if (SIZE_MAX != i) {
+        if (p_value) {
+            *p_value =
+                ((const i_hmap_slot_bytes_t *)p_s->tab.p_slots)[i].value;
+        }
+        ret = SIRIUS_OK;
+    }
+    i_hmap_rdunlock(p_m, p_s);
+    return ret;
+}
+
+int
+sirius_hashmap_erase(sirius_hashmap_handle handle, const void *p_key,
+    size_t len)
+{
+    I_HMAP_CHECK(handle, SIRIUS_HASHMAP_KEY_BYTES);
+    if (!(p_key) && len) return SIRIUS_ERR_NULL_POINTER;
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    uint64_t hash = i_hmap_hash_bytes(p_m, p_key, len);
+    i_hmap_stripe_t *p_s = i_hmap_stripe(p_m, hash);
+
+    int ret = SIRIUS_ERR_NOT_FOUND;
+    i_hmap_wrlock(p_m, p_s);
+    size_t i = g_ops.find_bytes(&(p_s->tab), p_key, len, hash);
+    if (SIZE_MAX != i) {
+        free(((i_hmap_slot_bytes_t *)p_s->tab.p_slots)[i].p_key);
+        i_hmap_release(&(p_s->tab), i);
+        ret = SIRIUS_OK;
+    }
+    i_hmap_wrunlock(p_m, p_s);
+    return ret;
+}
+
+size_t
+sirius_hashmap_size(sirius_hashmap_handle handle)
+{
+    if (!(handle)) return 0;
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    size_t n = 0;
+    for (unsigned int s = 0; s < p_m->stripe_nr; s++) {
+        i_hmap_stripe_t *p_s = &(p_m->p_stripes[s]);
+        i_hmap_rdlock(p_m, p_s);
+        n += p_s->tab.size;
+        i_hmap_rdunlock(p_m, p_s);
+    }
+    return n;
+}
+
+size_t
+sirius_hashmap_capacity(sirius_hashmap_handle handle)
+{
+    if (!(handle)) return 0;
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    size_t n = 0;
+    for (unsigned int s = 0; s < p_m->stripe_nr; s++) {
+        i_hmap_stripe_t *p_s = &(p_m->p_stripes[s]);
+        i_hmap_rdlock(p_m, p_s);
+        n += p_s->tab.size + p_s->tab.growth;
+        i_hmap_rdunlock(p_m, p_s);
+    }
+    return n;
+}
+
+/**
+ * @param shrink: `n` may be below the current capacity
+ */
+static int
+i_hmap_rebuild(sirius_hashmap_handle handle, size_t n, bool shrink)
+{
+    if (!(handle)) return SIRIUS_ERR_NULL_POINTER;
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    size_t per = (n + p_m->stripe_nr - 1) / p_m->stripe_nr;
+    int ret = SIRIUS_OK;
+    for (unsigned int s = 0; !(ret) && s < p_m->stripe_nr; s++) {
+        i_hmap_stripe_t *p_s = &(p_m->p_stripes[s]);
+        i_hmap_wrlock(p_m, p_s);
+        i_hmap_tab_t *p_t = &(p_s->tab);
+        size_t cap = i_hmap_cap_for(per > p_t->size ? per : p_t->size);
+        if (!(cap)) {
+            ret = SIRIUS_ERR_INVALID_PARAMETER;
+        } else if (shrink || cap > p_t->cap) {
+            ret = i_hmap_resize(p_m, p_t, cap);
+        }
+        i_hmap_wrunlock(p_m, p_s);
+    }
+    return ret;
+}
+
+int
+sirius_hashmap_reserve(sirius_hashmap_handle handle, size_t n)
+{
+    return i_hmap_rebuild(handle, n, false);
+}
+
+int
+sirius_hashmap_rehash(sirius_hashmap_handle handle, size_t n)
+{
+    return i_hmap_rebuild(handle, n, true);
+}
+
+int
+sirius_hashmap_clear(sirius_hashmap_handle handle)
+{
+    if (!(handle)) return SIRIUS_ERR_NULL_POINTER;
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    for (unsigned int s = 0; s < p_m->stripe_nr; s++) {
+        i_hmap_stripe_t *p_s = &(p_m->p_stripes[s]);
+        i_hmap_wrlock(p_m, p_s);
+        i_hmap_tab_t *p_t = &(p_s->tab);
+        i_hmap_keys_free(p_m, p_t);
+        memset(p_t->p_ctrl, I_HMAP_EMPTY, p_t->cap + I_HMAP_GROUP_MAX);
+        p_t->size = 0;
+        p_t->growth = i_hmap_growth(p_t->cap);
+        i_hmap_wrunlock(p_m, p_s);
+    }
+    return SIRIUS_OK;
+}
+
+static inline void
+i_hmap_entry(const i_hmap_t *p_m, const i_hmap_tab_t *p_t, size_t i,
+    sirius_hashmap_entry_t *p_ent)
+{
+    if (SIRIUS_HASHMAP_KEY_INT == p_m->key_type) {
+        i_hmap_slot_int_t *p_slot = (i_hmap_slot_int_t *)p_t->p_slots + i;
+        p_ent->key = p_slot->key;
+        p_ent->p_key = NULL;
+        p_ent->len = 0;
+        p_ent->p_value = &(p_slot->value);
+    } else {
+        i_hmap_slot_bytes_t *p_slot = (i_hmap_slot_bytes_t *)p_t->p_slots + i;
+        p_ent->key = 0;
+        p_ent->p_key = p_slot->p_key;
+        p_ent->len = p_slot->len;
+        p_ent->p_value = &(p_slot->value);
+    }
+}
+
+bool
+sirius_hashmap_next(sirius_hashmap_handle handle,
+    sirius_hashmap_iter_t *p_it, sirius_hashmap_entry_t *p_ent)
+{
+    if (!(handle) || !(p_it) || !(p_ent)) return false;
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    for (; p_it->stripe < p_m->stripe_nr; p_it->stripe++, p_it->pos = 0) {
+        const i_hmap_tab_t *p_t = &(p_m->p_stripes[p_it->stripe].tab);
+        size_t i = g_ops.next_full(p_t, p_it->pos);
+        if (i < p_t->cap) {
+            i_hmap_entry(p_m, p_t, i, p_ent);
+            p_it->pos = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+int
+sirius_hashmap_foreach(sirius_hashmap_handle handle,
+    int (*p_fn)(const sirius_hashmap_entry_t *p_ent, void *p_arg),
+    void *p_arg)
+{
+    if (!(handle) || !(p_fn)) return SIRIUS_ERR_NULL_POINTER;
+
+    const i_hmap_t *p_m = (const i_hmap_t *)handle;
+    for (unsigned int s = 0; s < p_m->stripe_nr; s++) {
+        i_hmap_stripe_t *p_s = &(p_m->p_stripes[s]);
+        /* `p_fn` may write the values, `get` reads them under rdlock */
+        i_hmap_wrlock(p_m, p_s);
+        const i_hmap_tab_t *p_t = &(p_s->tab);
+        for (size_t i = g_ops.next_full(p_t, 0); i < p_t->cap;
+            i = g_ops.next_full(p_t, i + 1)) {
+            sirius_hashmap_entry_t ent;
+            i_hmap_entry(p_m, p_t, i, &ent);
+            int ret = p_fn(&ent, p_arg);
+            if (ret) {
+                i_hmap_wrunlock(p_m, p_s);
+                return ret;
+            }
+        }
+        i_hmap_wrunlock(p_m, p_s);
+    }
+    return SIRIUS_OK;
+}
@@ -0,0 +1,204 @@
+#include "sirius_lock.h"
+
+#include "./internal/sirius_internal_sys.h"
+
+#include <sched.h>
+#include <linux/futex.h>
+
+/**
+ * the fast paths are inlined in `sirius_lock.h`, only the
+ * contended paths live here.
+ * 
+ * a waiter first spins with exponential backoff, a holder that
+ * isn't preempted usually releases the lock within that time;
+ * then it sleeps on a futex (mutex, rwlock) or yields the cpu
+ * (ticket lock, seqlock writer), so a preempted holder no longer
+ * costs a whole core.
+ */
+
+/* the largest backoff step before sleeping, 1 + 2 + ... + 128 pauses */
+#define I_LOCK_SPIN_MAX     (128)
+
+/* backoff rounds of a ticket waiter before yielding the cpu */
+#define I_LOCK_YIELD_NR     (16)
+
+static inline long
+i_lock_futex(unsigned int *p_addr, int op, unsigned int val)
+{
+    return syscall(SYS_futex, p_addr, op, val, NULL, NULL, 0);
+}
+
+/**
+ * @return true once the caller should stop spinning
+ */
+static inline bool
+i_lock_spin(unsigned int *p_n)
+{
+    if (*p_n > I_LOCK_SPIN_MAX) return true;
+    (void)sirius_backoff(p_n);
+    return false;
+}
+
+void
+sirius_mtx_lock_slow(sirius_mtx_t *p_mtx)
+{
+    unsigned int n = 1;
+    unsigned int c;
+
+    do {
+        c = __atomic_load_n(&(p_mtx->state), __ATOMIC_RELAXED);
+        if (0 == c) {
+            if (__atomic_compare_exchange_n(&(p_mtx->state), &c, 1,
+                    false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                return;
+            }
+        } else if (2 == c) {
+            /* others are already sleeping */
+            break;
+        }
+    } while (!(i_lock_spin(&n)));
+
+    /* 2 tells the holder to wake a sleeper up on unlock */
+    c = __atomic_exchange_n(&(p_mtx->state), 2, __ATOMIC_ACQUIRE);
+    while (0 != c) {
+        (void)i_lock_futex(&(p_mtx->state), FUTEX_WAIT_PRIVATE, 2);
+        c = __atomic_exchange_n(&(p_mtx->state), 2, __ATOMIC_ACQUIRE);
+    }
+}
+
+void
+sirius_mtx_unlock_slow(sirius_mtx_t *p_mtx)
+{
+    __atomic_store_n(&(p_mtx->state), 0, __ATOMIC_RELEASE);
+    (void)i_lock_futex(&(p_mtx->state), FUTEX_WAKE_PRIVATE, 1);
+}
+
+void
+sirius_ticket_lock_slow(sirius_ticket_t *p_tk, unsigned int ticket)
+{
+    unsigned int rounds = 0;
+    unsigned int owner;
+
+    while (ticket != (owner = __atomic_load_n(&(p_tk->owner),
+            __ATOMIC_ACQUIRE))) {
+        /* backoff proportional to the position in the queue */
+        unsigned int n = (ticket - owner) * 8;
+        if (n > SIRIUS_BACKOFF_MAX) n = SIRIUS_BACKOFF_MAX;
+        for (unsigned int i = 0; i < n; i++) {
+            sirius_cpu_relax();
+        }
+
+        if (++rounds >= I_LOCK_YIELD_NR) {
+            (void)sched_yield();
+        }
+    }
+}
+
+/**
+ * sleep while `state` still equals `s`
+ */
+static void
+i_lock_rw_wait(sirius_rwlock_t *p_rw, unsigned int s)
+{
+    __atomic_add_fetch(&(p_rw->waiters), 1, __ATOMIC_SEQ_CST);
+    if (s == __atomic_load_n(&(p_rw->state), __ATOMIC_SEQ_CST)) {
+        (void)i_lock_futex(&(p_rw->state), FUTEX_WAIT_PRIVATE, s);
+    }
+    __atomic_sub_fetch(&(p_rw->waiters), 1, __ATOMIC_RELAXED);
+}
+
+void
+sirius_rwlock_wake(sirius_rwlock_t *p_rw)
+{
+    if (__atomic_load_n(&(p_rw->waiters), __ATOMIC_SEQ_CST)) {
+        (void)i_lock_futex(&(p_rw->state), FUTEX_WAKE_PRIVATE, INT_MAX);
+    }
+}
+
+void
+sirius_rwlock_rdlock_slow(sirius_rwlock_t *p_rw)
+{
+    unsigned int n = 1;
+
+    while (true) {
+        unsigned int s = __atomic_load_n(&(p_rw->state), __ATOMIC_RELAXED);
+        if (!(s & (SIRIUS_RWLOCK_WRITER | SIRIUS_RWLOCK_WAIT))) {
+            if (__atomic_compare_exchange_n(&(p_rw->state), &s, s + 1,
+                    false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                return;
+            }
+            continue;
+        }
+
+        if (i_lock_spin(&n)) {
+            i_lock_rw_wait(p_rw, s);
+        }
+    }
+}
+
+void
+sirius_rwlock_wrlock_slow(sirius_rwlock_t *p_rw)
+{
+    unsigned int n = 1;
+
+    __atomic_add_fetch(&(p_rw->writers), 1, __ATOMIC_SEQ_CST);
+    while (true) {
+        unsigned int s = __atomic_load_n(&(p_rw->state), __ATOMIC_RELAXED);
+
+        /* neither readers nor a writer, a pending `WAIT` is kept */
+        if (!(s & ~SIRIUS_RWLOCK_WAIT)) {
+            if (__atomic_compare_exchange_n(&(p_rw->state), &s,
+                    s | SIRIUS_RWLOCK_WRITER, false,
+                    __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                break;
+            }
+            continue;
+        }
+
+        /* hold new readers back */
+        if (!(s & SIRIUS_RWLOCK_WAIT)) {
+            if (!(__atomic_compare_exchange_n(&(p_rw->state), &s,
+                    s | SIRIUS_RWLOCK_WAIT, false,
+                    __ATOMIC_RELAXED, __ATOMIC_RELAXED))) {
+                continue;
+            }
+            s |= SIRIUS_RWLOCK_WAIT;
+        }
+
+        if (i_lock_spin(&n)) {
+            i_lock_rw_wait(p_rw, s);
+        }
+    }
+
+    /*
+     * the last waiting writer lets the readers back in; one that
+     * arrived in between saw `WAIT` set and may be asleep on it,
+     * the wake makes it set the bit again
+     */
+    if (0 == __atomic_sub_fetch(&(p_rw->writers), 1, __ATOMIC_SEQ_CST) &&
+        (__atomic_fetch_and(&(p_rw->state), ~SIRIUS_RWLOCK_WAIT,
+            __ATOMIC_SEQ_CST) & SIRIUS_RWLOCK_WAIT)) {
+        sirius_rwlock_wake(p_rw);
+    }
+}
+
+void
+sirius_seqlock_wrlock_slow(sirius_seqlock_t *p_sl)
+{
+    unsigned int rounds = 0;
+    unsigned int n = 1;
+
+    while (true) {
+        unsigned int seq = __atomic_load_n(&(p_sl->seq), __ATOMIC_RELAXED);
+        if (!(seq & 1) &&
+            __atomic_compare_exchange_n(&(p_sl->seq), &seq, seq + 1,
+                false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            return;
+        }
+
+        if (sirius_backoff(&n) && ++rounds >= I_LOCK_YIELD_NR) {
+            (void)sched_yield();
+        }
+    }
+}
@@ -1,9 +1,18 @@
 #include "sirius_errno.h"
 #include "sirius_log.h"
 #include "sirius_attributes.h"
+#include "sirius_lock.h"
+#include "sirius_config.h"
+#include "sirius_time.h"
+#include "sirius_trace.h"
+#include "sirius_metrics.h"
 
 #include "./internal/sirius_internal_log.h"
 #include "./internal/sirius_internal_file.h"
+#include "./internal/sirius_internal_thread.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 /**
  * cache size for reading the contents
@@ -15,66 +24,45 @@
 #define I_LOG_FIFO_PATH_SIZE    (256)
 
 /**
- * the thread reading the pipeline file is blocked,
- * and the specific blocking location is located in
- * the read function.
- * 
- * the pipeline file will be opened and closed repeatedly,
- * and if you don't, the thread reading the pipeline file
- * will be extremely cpu intensive.
- * 
- * because in addition to opening the pipeline file,
- * you can set it to block, once data is written to the
- * pipeline file, it will become unblocked, in this case,
- * you can only close the pipeline file and open it again.
- * 
- * another way is to add appropriate sleep to the thread,
- * but I don't use that here, because I don't think it's
- * necessary to keep doing ineffective loops
- * 
- * so, when I need to quit the thread reading the pipeline
- * file, the appropriate command needs to be sent to allow
- * the blocking read function to continue and terminate the
- * thread
+ * the control thread waits on an epoll set made of the pipeline
+ * file and an eventfd.
+ *
+ * the pipeline file is opened once with `O_RDWR`, the thread
+ * itself then holds a write end, so the file never reports EOF
+ * when a writer such as `echo` closes it and it doesn't need to
+ * be reopened after every command.
+ *
+ * the eventfd is only used to wake the thread up when it has
+ * to quit, so deinitialization is a write and a join.
  */
 
-/* thread termination command */
-#define I_LOG_CMD_THD_EXIT      "echo " LOG_CMD_LV " 0 > "
-
-/* the length of the thread termination command */
-#define I_LOG_CMD_THD_EXIT_SIZE (I_LOG_FIFO_PATH_SIZE << 1)
-
-typedef enum {
-    /* invalid state */
-    I_LOG_THD_STATE_INVALID = 0,
-
-    /* thread exiting */
-    I_LOG_THD_STATE_EXITING,
-    /* thread exited */
-    I_LOG_THD_STATE_EXITED,
-    /* thread is running */
-    I_LOG_THD_STATE_RUNNING,
-
-    I_LOG_THD_STATE_MAX,
-} i_log_thd_state_t;
-
 typedef struct {
     /* thread id */
     pthread_t id;
 
-    /* thread state */
-    i_log_thd_state_t state;
+    /* the pipeline file */
+    int fifo_fd;
+    /* wakes the thread up to quit */
+    int event_fd;
+    /* epoll instance */
+    int epoll_fd;
 
-    /* buffer of the single-read pipe */
+    /* buffer of the pipe, holds an incomplete line between reads */
     char pipe_buf[I_LOG_FIFO_BUR_SIZE];
+    /* number of bytes in `pipe_buf` */
+    size_t pipe_len;
 
     /* path of the pipe */
     char pipe_path[I_LOG_FIFO_PATH_SIZE];
-
-    /* buffer of the system call to stop the thread */
-    char exit_cmd[I_LOG_CMD_THD_EXIT_SIZE];
 } i_log_thd_t;
 
+/* records per level, bytes, duplicates and rate limited */
+#define I_LOG_METRIC_REC    (0)
+#define I_LOG_METRIC_BYTES  (SIRIUS_LOG_LV_MAX - SIRIUS_LOG_LV_DEFAULT)
+#define I_LOG_METRIC_DUP    (I_LOG_METRIC_BYTES + 1)
+#define I_LOG_METRIC_RL     (I_LOG_METRIC_BYTES + 2)
+#define I_LOG_METRIC_NR     (I_LOG_METRIC_BYTES + 3)
+
 typedef struct {
     /* module init flag */
     bool is_init;
@@ -82,64 +70,66 @@ typedef struct {
     /* thread config */
     i_log_thd_t *p_thd;
 
-    /* log level */
-    sirius_log_lv_t log_lv;
-
-#ifndef __STDC_NO_ATOMICS__
-    /* atomic lock */
-    atomic_flag atomic_lock;
-#endif
+    /* the file sink is initialized */
+    bool file_init;
+    /* the shared-memory sink is initialized */
+    bool shm_init;
+    /* current sink, refer to `sirius_log_sink_t` */
+    atomic_int sink;
+
+    /* drop identical repeated records */
+    bool dup_suppress;
+
+    /* the flight recorder is initialized */
+    bool rec_init;
+
+    /**
+     * records written per level, bytes written and records dropped,
+     * sharded counters of the registry, refer to
+     * `i_log_metrics_register`
+     */
+    sirius_metric_handle metrics[I_LOG_METRIC_NR];
+
+    /**
+     * serializes the writes to the terminal, a thread preempted
+     * while holding it puts the others to sleep instead of
+     * keeping them spinning
+     */
+    sirius_mtx_t lock;
 } i_log_t;
 
 static i_log_t g_h = {0};
 
-#ifndef __STDC_NO_ATOMICS__
-#define i_log_atomic_set() \
-while (atomic_flag_test_and_set(&(g_h.atomic_lock)))
-#define i_log_atomic_clear() \
-atomic_flag_clear(&(g_h.atomic_lock))
-#else
-#define i_log_atomic_set() \
-do {} while (0)
-#define i_log_atomic_clear() \
-do {} while (0)
-#endif // __STDC_NO_ATOMICS__
-
-static char tm_buf[9] = {0};
-static inline char*
-i_log_current_time()
-{
-    time_t raw_tm;
-    time(&raw_tm);
-    struct tm *p_tm_info = localtime(&raw_tm);
-
-    /* Note that writes to the cache are unlocked */
-    strftime(
-        tm_buf, sizeof(tm_buf), "%H:%M:%S", p_tm_info);
-    return tm_buf;
-}
-
-#define I_LOG_PRNT(color, stream, type, fmt, ...) \
-    do { \
-        i_log_atomic_set(); \
-        fprintf(stream, \
-            color "[%s " #type " %s (%s|%d)] " \
-            fmt, i_log_current_time(), \
-            SIRIUS_FILE, __FUNCTION__, __LINE__, \
-            ##__VA_ARGS__); \
-        fprintf(stream, LOG_NONE); \
-        i_log_atomic_clear(); \
-    } while (0)
-
-#define I_LOG_INFO(fmt, ...) \
-    I_LOG_PRNT(LOG_GREEN, \
-        stdout, info, fmt, ##__VA_ARGS__)
-#define I_LOG_WARN(fmt, ...) \
-    I_LOG_PRNT(LOG_YELLOW, \
-        stderr, warn, fmt, ##__VA_ARGS__)
-#define I_LOG_ERROR(fmt, ...) \
-    I_LOG_PRNT(LOG_RED, \
-        stderr, error, fmt, ##__VA_ARGS__)
+#define i_log_lock() \
+sirius_mtx_lock(&(g_h.lock))
+#define i_log_unlock() \
+sirius_mtx_unlock(&(g_h.lock))
+
+void
+sirius_log_diag(const char *p_color,
+    FILE *stream,
+    const char *p_type,
+    const char *p_file,
+    const char *p_func,
+    int line,
+    const char *p_fmt, ...)
+{
+    char tm_buf[SIRIUS_LOG_CLOCK_BUF_SIZE];
+    (void)sirius_log_clock_fmt(tm_buf);
+
+    va_list args;
+    va_start(args, p_fmt);
+
+    i_log_lock();
+    fprintf(stream, "%s[%s %s %s (%s|%d)] ",
+        p_color, tm_buf,
+        p_type, p_file, p_func, line);
+    vfprintf(stream, p_fmt, args);
+    fprintf(stream, LOG_NONE);
+    i_log_unlock();
+
+    va_end(args);
+}
 
 static inline int
 i_log_fifo_rm(const char *p_pipe)
@@ -154,15 +144,29 @@ i_log_fifo_rm(const char *p_pipe)
         cmd); \
     return SIRIUS_ERR_INVALID_PARAMETER;
 
+/**
+ * loglevel [lv]
+ * loglevel [module] [lv]
+ */
 static int
 i_log_pipe_cmd_log_lv(char **pp_cmd)
 {
     if (pp_cmd[0]) {
-        if ((SIRIUS_LOG_LV_0 <= atoi(pp_cmd[0])) &&
-            (SIRIUS_LOG_LV_MAX > atoi(pp_cmd[0]))) {
-            g_h.log_lv = atoi(pp_cmd[0]);
+        const char *p_mod = NULL;
+        const char *p_lv = pp_cmd[0];
+        if (pp_cmd[1]) {
+            p_mod = pp_cmd[0];
+            p_lv = pp_cmd[1];
+        }
+
+        if ((SIRIUS_LOG_LV_0 <= atoi(p_lv)) &&
+            (SIRIUS_LOG_LV_MAX > atoi(p_lv))) {
+            if (sirius_log_lv_set(p_mod, atoi(p_lv))) {
+                I_LOG_WARN("failed to set the level of [%s]\n",
+                    p_mod);
+            }
         } else {
-            I_LOG_CMD_ERROR(pp_cmd[0]);
+            I_LOG_CMD_ERROR(p_lv);
         }
     } else {
         I_LOG_WARN("incomplete command\n");
@@ -171,6 +175,221 @@ i_log_pipe_cmd_log_lv(char **pp_cmd)
     return SIRIUS_OK;
 }
 
+static const char *i_log_sink_name[SIRIUS_LOG_SINK_MAX] = {
+    [SIRIUS_LOG_SINK_DEFAULT]   = "default",
+    [SIRIUS_LOG_SINK_STDOUT]    = "stdout",
+    [SIRIUS_LOG_SINK_FILE]      = "file",
+    [SIRIUS_LOG_SINK_SHM]       = "shm",
+};
+
+static const char *i_log_lv_tag[SIRIUS_LOG_LV_MAX] = {
+    "off", "prnt", "error", "warn", "info", "debg",
+};
+
+static void
+i_log_pipe_cmd_stats()
+{
+    I_LOG_INFO("sink: %s\n", i_log_sink_name[
+        atomic_load_explicit(&(g_h.sink), memory_order_relaxed)]);
+    for (int i = SIRIUS_LOG_LV_DEFAULT; i < SIRIUS_LOG_LV_MAX; i++) {
+        I_LOG_INFO("records [%s]: %.0f\n", i_log_lv_tag[i],
+            sirius_metrics_value(g_h.metrics[
+                I_LOG_METRIC_REC + i - SIRIUS_LOG_LV_DEFAULT]));
+    }
+    I_LOG_INFO("bytes: %.0f\n",
+        sirius_metrics_value(g_h.metrics[I_LOG_METRIC_BYTES]));
+    I_LOG_INFO("duplicates dropped: %.0f\n",
+        sirius_metrics_value(g_h.metrics[I_LOG_METRIC_DUP]));
+    I_LOG_INFO("rate limited: %.0f\n",
+        sirius_metrics_value(g_h.metrics[I_LOG_METRIC_RL]));
+
+    if (g_h.file_init) {
+        sirius_log_file_stats();
+    }
+    if (g_h.shm_init) {
+        sirius_log_shm_stats();
+    }
+}
+
+/**
+ * the sink is the configuration key "log.sink", `g_h.sink` caches
+ * it for the output path
+ */
+#define I_LOG_SINK_KEY  "log.sink"
+
+static int g_sink_id = -1;
+
+/**
+ * @return 0 on success, error code if the sink is not configured
+ */
+static int
+i_log_sink_check(long long val)
+{
+    switch (val) {
+        case SIRIUS_LOG_SINK_STDOUT:
+            break;
+        case SIRIUS_LOG_SINK_FILE:
+            if (!(g_h.file_init)) return SIRIUS_ERR_NOT_INIT;
+            break;
+        case SIRIUS_LOG_SINK_SHM:
+            if (!(g_h.shm_init)) return SIRIUS_ERR_NOT_INIT;
+            break;
+        default:
+            return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    return SIRIUS_OK;
+}
+
+static void
+i_log_sink_notify(long long val)
+{
+    atomic_store_explicit(&(g_h.sink), (int)val, memory_order_relaxed);
+}
+
+/**
+ * @return 0 on success, error code if the sink is not configured
+ */
+static int
+i_log_sink_set(sirius_log_sink_t sink)
+{
+    if (g_sink_id < 0) {
+        sirius_cfg_attr_t attr = {
+            .p_name = I_LOG_SINK_KEY,
+            .def = SIRIUS_LOG_SINK_STDOUT,
+            .min = SIRIUS_LOG_SINK_STDOUT,
+            .max = SIRIUS_LOG_SINK_MAX - 1,
+            .p_check = i_log_sink_check,
+            .p_notify = i_log_sink_notify,
+        };
+        int id = sirius_cfg_register(&attr);
+        if (id < 0) return id;
+        g_sink_id = id;
+    }
+
+    return sirius_cfg_set(g_sink_id, sink);
+}
+
+/**
+ * logsink [stdout | file | shm]
+ */
+static int
+i_log_pipe_cmd_sink(char **pp_cmd)
+{
+    if (!(pp_cmd[0])) {
+        I_LOG_WARN("incomplete command\n");
+        return SIRIUS_OK;
+    }
+
+    for (int i = SIRIUS_LOG_SINK_STDOUT; i < SIRIUS_LOG_SINK_MAX; i++) {
+        if (!(strcmp(i_log_sink_name[i], pp_cmd[0]))) {
+            if (i_log_sink_set(i)) {
+                I_LOG_WARN("the sink [%s] is not configured\n",
+                    pp_cmd[0]);
+            }
+            return SIRIUS_OK;
+        }
+    }
+
+    I_LOG_CMD_ERROR(pp_cmd[0]);
+}
+
+/**
+ * config
+ * config [key] [value]
+ */
+static int
+i_log_pipe_cmd_cfg(char **pp_cmd)
+{
+    if (!(pp_cmd[0])) {
+        const sirius_cfg_snap_t *p_snap = sirius_cfg_snap_acquire();
+        I_LOG_INFO("config version: %llu\n", p_snap->version);
+        for (unsigned int i = 0; i < p_snap->nr; i++) {
+            I_LOG_INFO("%s = %lld\n",
+                sirius_cfg_name(i), p_snap->vals[i]);
+        }
+        sirius_cfg_snap_release();
+        return SIRIUS_OK;
+    }
+
+    if (!(pp_cmd[1])) {
+        I_LOG_WARN("incomplete command\n");
+        return SIRIUS_OK;
+    }
+
+    char *p_end = NULL;
+    long long val = strtoll(pp_cmd[1], &p_end, 0);
+    if (p_end == pp_cmd[1] || *p_end) {
+        I_LOG_CMD_ERROR(pp_cmd[1]);
+    }
+
+    int ret = sirius_cfg_set_name(pp_cmd[0], val);
+    if (ret) {
+        I_LOG_WARN("failed to set [%s] to %lld: [%d]\n",
+            pp_cmd[0], val, ret);
+    }
+    return SIRIUS_OK;
+}
+
+/**
+ * trace
+ * trace start
+ * trace stop [path]
+ */
+static int
+i_log_pipe_cmd_trace(char **pp_cmd)
+{
+    if (!(pp_cmd[0])) {
+        I_LOG_INFO("tracing: %s\n",
+            sirius_trace_enabled() ? "on" : "off");
+        return SIRIUS_OK;
+    }
+
+    if (!(strcmp("start", pp_cmd[0]))) {
+        (void)sirius_trace_start();
+        return SIRIUS_OK;
+    }
+    if (!(strcmp("stop", pp_cmd[0]))) {
+        (void)sirius_trace_stop(pp_cmd[1]);
+        return SIRIUS_OK;
+    }
+
+    I_LOG_CMD_ERROR(pp_cmd[0]);
+}
+
+/**
+ * metrics
+ * metrics [path]
+ */
+static int
+i_log_pipe_cmd_metrics(char **pp_cmd)
+{
+    if (pp_cmd[0]) {
+        if (sirius_metrics_dump(pp_cmd[0])) {
+            I_LOG_WARN("failed to write the metrics to [%s]\n", pp_cmd[0]);
+        }
+        return SIRIUS_OK;
+    }
+
+    char *p_buf = NULL;
+    size_t size = 0;
+    FILE *p_f = open_memstream(&p_buf, &size);
+    if (!(p_f)) {
+        I_LOG_WARN("open_memstream: %s\n", strerror(errno));
+        return SIRIUS_OK;
+    }
+    (void)sirius_metrics_write(p_f);
+    fclose(p_f);
+
+    char *p_tmp = NULL;
+    for (char *p_line = strtok_r(p_buf, "\n", &p_tmp); p_line;
+        p_line = strtok_r(NULL, "\n", &p_tmp)) {
+        I_LOG_INFO("%s\n", p_line);
+    }
+    free(p_buf);
+    return SIRIUS_OK;
+}
+
 static int
 i_log_pipe_cmd_deal(char **pp_cmd)
 {
@@ -182,6 +401,41 @@ i_log_pipe_cmd_deal(char **pp_cmd)
             if (ret) {
                 return ret;
             }
+        } else if (!(strcmp(LOG_CMD_REOPEN, pp_cmd[0]))) {
+            if (g_h.file_init) {
+                sirius_log_file_reopen();
+            } else {
+                I_LOG_WARN("the file sink is not configured\n");
+            }
+        } else if (!(strcmp(LOG_CMD_FLUSH, pp_cmd[0]))) {
+            if (g_h.file_init) {
+                sirius_log_file_flush();
+            }
+        } else if (!(strcmp(LOG_CMD_DUMP, pp_cmd[0]))) {
+            if (!(g_h.rec_init)) {
+                I_LOG_WARN("the flight recorder is not enabled\n");
+            } else if (sirius_log_rec_dump(pp_cmd[1])) {
+                I_LOG_WARN("failed to dump the flight recorder\n");
+            }
+        } else if (!(strcmp(LOG_CMD_STATS, pp_cmd[0]))) {
+            i_log_pipe_cmd_stats();
+        } else if (!(strcmp(LOG_CMD_SINK, pp_cmd[0]))) {
+            ret = i_log_pipe_cmd_sink(pp_cmd + 1);
+            if (ret) {
+                return ret;
+            }
+        } else if (!(strcmp(LOG_CMD_CFG, pp_cmd[0]))) {
+            ret = i_log_pipe_cmd_cfg(pp_cmd + 1);
+            if (ret) {
+                return ret;
+            }
+        } else if (!(strcmp(LOG_CMD_TRACE, pp_cmd[0]))) {
+            ret = i_log_pipe_cmd_trace(pp_cmd + 1);
+            if (ret) {
+                return ret;
+            }
+        } else if (!(strcmp(LOG_CMD_METRICS, pp_cmd[0]))) {
+            (void)i_log_pipe_cmd_metrics(pp_cmd + 1);
         } else {
             I_LOG_CMD_ERROR(pp_cmd[0]);
         }
@@ -193,21 +447,21 @@ i_log_pipe_cmd_deal(char **pp_cmd)
 /* 单次间隔命令数量 */
 #define I_LOG_FIFO_CMD_MAX (32)
 
+/**
+ * @param p_buf: a single line without the trailing '\n'
+ */
 static void
 i_log_pipe_cmd_parse(char *p_buf)
 {
-    /* replace the '\n' at the end with the '\0' */
-    p_buf[strlen(p_buf) - 1] = '\0';
-
     unsigned int i = 0;
     char *p_tmp = NULL;
     char *p_cmd[I_LOG_FIFO_CMD_MAX] = {NULL};
-    p_cmd[i] = strtok_r(p_buf, " ", &p_tmp);
+    p_cmd[i] = strtok_r(p_buf, " \t\r", &p_tmp);
     while (p_cmd[i]) {
         i++;
 
         if (I_LOG_FIFO_CMD_MAX == i) {
-            if (strtok_r(NULL, " ", &p_tmp)) {
+            if (strtok_r(NULL, " \t\r", &p_tmp)) {
                 I_LOG_WARN(
                     "the number of commands exceeded\n");
                 return;
@@ -215,118 +469,118 @@ i_log_pipe_cmd_parse(char *p_buf)
             break;
         }
 
-        p_cmd[i] = strtok_r(NULL, " ", &p_tmp);
+        p_cmd[i] = strtok_r(NULL, " \t\r", &p_tmp);
     }
 
     (void)i_log_pipe_cmd_deal(p_cmd);
 }
 
-static int
-i_log_pipe_thd(void *args)
+/**
+ * @return false if the pipeline file is broken
+ */
+static bool
+i_log_pipe_read(i_log_thd_t *p_th)
 {
-    int fd;
-    const char *p_pipe = (const char *)args;
-    i_log_thd_t *p_th = g_h.p_thd;
-
-    p_th->state = I_LOG_THD_STATE_RUNNING;
     while (true) {
-        fd = open(p_pipe, O_RDONLY);
-        if (-1 == fd) {
-            I_LOG_ERROR("open [%s]\n", p_pipe);
-            perror(NULL);
-            p_th->state = I_LOG_THD_STATE_EXITED;
-            return errno;
+        ssize_t bytes = read(p_th->fifo_fd,
+            p_th->pipe_buf + p_th->pipe_len,
+            I_LOG_FIFO_BUR_SIZE - 1 - p_th->pipe_len);
+        if (bytes < 0) {
+            if (EINTR == errno) continue;
+            if (EAGAIN == errno) return true;
+            I_LOG_ERROR("read [%s]: %s\n",
+                p_th->pipe_path, strerror(errno));
+            return false;
         }
+        if (0 == bytes) return true;
 
-        memset(p_th->pipe_buf, 0, I_LOG_FIFO_BUR_SIZE);
-        ssize_t bytes = read(fd, p_th->pipe_buf,
-            I_LOG_FIFO_BUR_SIZE);
-        if (bytes <= 0) {
-            if (I_LOG_THD_STATE_EXITING == p_th->state) {
-                goto label_thd_exit;
-            }
-            goto label_file_close;
+        p_th->pipe_len += (size_t)bytes;
+        p_th->pipe_buf[p_th->pipe_len] = '\0';
+
+        char *p_line = p_th->pipe_buf;
+        char *p_end;
+        while ((p_end = strchr(p_line, '\n'))) {
+            *p_end = '\0';
+            i_log_pipe_cmd_parse(p_line);
+            p_line = p_end + 1;
         }
 
-        if (I_LOG_THD_STATE_EXITING == p_th->state) {
-            goto label_thd_exit;
+        size_t rest = p_th->pipe_len - (size_t)(p_line - p_th->pipe_buf);
+        if (I_LOG_FIFO_BUR_SIZE - 1 == rest) {
+            I_LOG_WARN("command too long, discarded\n");
+            rest = 0;
         }
+        memmove(p_th->pipe_buf, p_line, rest);
+        p_th->pipe_len = rest;
+    }
+}
+
+static void *
+i_log_pipe_thd(void *args)
+{
+    i_log_thd_t *p_th = (i_log_thd_t *)args;
+    struct epoll_event evs[2];
 
-        p_th->pipe_buf[I_LOG_FIFO_BUR_SIZE - 1] = '\0';
-        i_log_pipe_cmd_parse(p_th->pipe_buf);
+    while (true) {
+        int nr = epoll_wait(p_th->epoll_fd, evs, 2, -1);
+        if (nr < 0) {
+            if (EINTR == errno) continue;
+            I_LOG_ERROR("epoll_wait: %s\n", strerror(errno));
+            break;
+        }
 
-label_file_close:
-        close(fd);
+        for (int i = 0; i < nr; i++) {
+            if (evs[i].data.fd == p_th->event_fd) {
+                return NULL;
+            }
+            if (!(i_log_pipe_read(p_th))) {
+                return NULL;
+            }
+        }
     }
 
-label_thd_exit:
-    close(fd);
-    p_th->state = I_LOG_THD_STATE_EXITED;
+    return NULL;
+}
 
-    return SIRIUS_OK;
+static void
+i_log_pipe_close(i_log_thd_t *p_th)
+{
+    if (-1 != p_th->epoll_fd) close(p_th->epoll_fd);
+    if (-1 != p_th->event_fd) close(p_th->event_fd);
+    if (-1 != p_th->fifo_fd) close(p_th->fifo_fd);
+    p_th->epoll_fd = -1;
+    p_th->event_fd = -1;
+    p_th->fifo_fd = -1;
 }
 
 static void
 i_log_pipe_destory()
 {
     i_log_thd_t *p_th = g_h.p_thd;
+    if (!(p_th)) return;
 
-    if (I_LOG_THD_STATE_EXITED != p_th->state) {
-        p_th->state = I_LOG_THD_STATE_EXITING;
-
-#define THD_JDG(count) \
-    for (unsigned int i = 0; i < count; i++) { \
-        usleep(50 * 1000); \
-        if (I_LOG_THD_STATE_EXITED == \
-            p_th->state) { \
-            goto label_thread_join; \
-        } \
-    }
-
-        THD_JDG(20);
-
-        memset(p_th->exit_cmd, 0, I_LOG_CMD_THD_EXIT_SIZE);
-        strncpy(p_th->exit_cmd, I_LOG_CMD_THD_EXIT,
-            I_LOG_CMD_THD_EXIT_SIZE - 1);
-
-        size_t stop_cmd_len = strlen(p_th->exit_cmd);
-        size_t copy_len = I_LOG_CMD_THD_EXIT_SIZE - stop_cmd_len;
-        if (0 < copy_len) {
-            memmove(p_th->exit_cmd + stop_cmd_len,
-                p_th->pipe_path, copy_len);
-        }
-
-        if ('\0' !=
-            p_th->exit_cmd[I_LOG_CMD_THD_EXIT_SIZE - 1]) {
-            p_th->exit_cmd[I_LOG_CMD_THD_EXIT_SIZE - 1] =
-                '\0';
-            goto label_thd_cancel;
-        }
-        system(p_th->exit_cmd);
-        THD_JDG(10);
-
-label_thd_cancel:
-        I_LOG_WARN("thread[%lu] cancel\n", p_th->id);
-        pthread_cancel(p_th->id);
-        usleep(500 * 1000);
+    uint64_t val = 1;
+    if (sizeof(val) != write(p_th->event_fd, &val, sizeof(val))) {
+        I_LOG_ERROR("write eventfd: %s\n", strerror(errno));
     }
 
-label_thread_join:
     if (pthread_join(p_th->id, NULL)) {
         I_LOG_ERROR("pthread_join\n");
     }
 
+    i_log_pipe_close(p_th);
     i_log_fifo_rm(p_th->pipe_path);
-
-#ifdef THD_JDG
-#undef THD_JDG
-#endif
 }
 
 static int
-i_log_pipe_create(const char *p_pipe)
+i_log_pipe_create(i_log_thd_t *p_th)
 {
     int ret;
+    struct epoll_event ev;
+
+    p_th->fifo_fd = -1;
+    p_th->event_fd = -1;
+    p_th->epoll_fd = -1;
 
     mode_t mode =
         S_IRUSR |
@@ -335,26 +589,504 @@ i_log_pipe_create(const char *p_pipe)
         S_IWGRP |
         S_IROTH |
         S_IWOTH;
-    internal_file_mkfifo(ret, p_pipe, mode);
+    internal_file_mkfifo(ret, p_th->pipe_path, mode);
     if (ret) return ret;
 
-    ret = pthread_create(&(g_h.p_thd->id), NULL,
-        (void *)i_log_pipe_thd, (void *)p_pipe);
+    p_th->fifo_fd = open(p_th->pipe_path,
+        O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    p_th->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    p_th->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (-1 == p_th->fifo_fd ||
+        -1 == p_th->event_fd ||
+        -1 == p_th->epoll_fd) {
+        I_LOG_ERROR("open [%s]: %s\n",
+            p_th->pipe_path, strerror(errno));
+        ret = SIRIUS_ERR_RESOURCE_REQUEST;
+        goto label_close;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = p_th->fifo_fd;
+    if (epoll_ctl(p_th->epoll_fd, EPOLL_CTL_ADD, p_th->fifo_fd, &ev)) {
+        I_LOG_ERROR("epoll_ctl: %s\n", strerror(errno));
+        ret = SIRIUS_ERR_RESOURCE_REQUEST;
+        goto label_close;
+    }
+    ev.data.fd = p_th->event_fd;
+    if (epoll_ctl(p_th->epoll_fd, EPOLL_CTL_ADD, p_th->event_fd, &ev)) {
+        I_LOG_ERROR("epoll_ctl: %s\n", strerror(errno));
+        ret = SIRIUS_ERR_RESOURCE_REQUEST;
+        goto label_close;
+    }
+
+    ret = sirius_thread_internal_create(&(p_th->id), "sirius-pipe", false,
+        i_log_pipe_thd, (void *)p_th);
     if (ret) {
-        I_LOG_ERROR("pthread_create: [%d]\n", ret);
-        perror(NULL);
-        i_log_fifo_rm(p_pipe);
+        I_LOG_ERROR("sirius_thread_internal_create: [%d]\n", ret);
+        goto label_close;
     }
 
+    return SIRIUS_OK;
+
+label_close:
+    i_log_pipe_close(p_th);
+    i_log_fifo_rm(p_th->pipe_path);
     return ret;
 }
 
 static inline void
 i_log_param_init(const sirius_log_cr_t *p_cr)
 {
-    i_log_atomic_clear();
-    g_h.log_lv = p_cr->log_lv;
+    sirius_log_clock_init(p_cr->time_prec);
+    g_h.dup_suppress = p_cr->dup_suppress;
     g_h.is_init = true;
+    sirius_log_lv_init(p_cr->log_lv);
+    if (g_h.rec_init) {
+        sirius_log_lv_rec_set(p_cr->p_rec->log_lv);
+    }
+}
+
+/* output stream and tag of each level */
+static const struct {
+    int fd;
+    const char *p_tag;
+} i_log_lv_attr[SIRIUS_LOG_LV_MAX] = {
+    [SIRIUS_LOG_LV_0]       = {-1, NULL},
+    [SIRIUS_LOG_LV_DEFAULT] = {STDOUT_FILENO, "prnt"},
+    [SIRIUS_LOG_LV_ERROR]   = {STDERR_FILENO, "error"},
+    [SIRIUS_LOG_LV_WARN]    = {STDERR_FILENO, "warn"},
+    [SIRIUS_LOG_LV_INFO]    = {STDOUT_FILENO, "info"},
+    [SIRIUS_LOG_LV_DEBG]    = {STDOUT_FILENO, "debg"},
+};
+
+static inline int
+i_log_header(char *p_buf, size_t size,
+    sirius_log_lv_t log_lv,
+    const char *p_color,
+    const char *p_mod,
+    const char *p_file,
+    const char *p_func,
+    int line)
+{
+    char tm_buf[SIRIUS_LOG_CLOCK_BUF_SIZE];
+    (void)sirius_log_clock_fmt(tm_buf);
+
+    int n = snprintf(p_buf, size,
+        "%s[%s %s %s %d %s (%s|%d)] ",
+        p_color, tm_buf, i_log_lv_attr[log_lv].p_tag,
+        p_mod, (int)sirius_log_tid(),
+        p_file, p_func, line);
+    return n < (int)size ? n : (int)size - 1;
+}
+
+/**
+ * a record is handed to the sinks as segments: the header, the
+ * payload, an optional newline and, on a terminal, the colour
+ * reset, so a large payload is never copied into a fixed buffer.
+ */
+
+/* header, payload, newline, colour reset */
+#define I_LOG_IOV_NR    (4)
+
+static void
+i_log_writev_all(int fd, struct iovec *p_iov, int iov_nr)
+{
+    while (iov_nr > 0) {
+        ssize_t n = writev(fd, p_iov, iov_nr);
+        if (n < 0) {
+            if (EINTR == errno) continue;
+            return;
+        }
+
+        /* partial write, skip the segments already written */
+        while (iov_nr > 0 && (size_t)n >= p_iov->iov_len) {
+            n -= p_iov->iov_len;
+            p_iov++;
+            iov_nr--;
+        }
+        if (iov_nr > 0) {
+            p_iov->iov_base = (char *)p_iov->iov_base + n;
+            p_iov->iov_len -= n;
+        }
+    }
+}
+
+/**
+ * @brief add to a counter of the records, one relaxed add on the
+ *  shard of the thread; a counter that failed to register is skipped
+ */
+static inline void
+i_log_count(int idx, unsigned long long n)
+{
+    sirius_metric_handle h = g_h.metrics[idx];
+    if (likely(h)) sirius_metrics_counter_add(h, n);
+}
+
+/**
+ * @param p_iov: segments of the record, with room for
+ *  `I_LOG_IOV_NR` entries
+ * 
+ * @return the number of bytes written
+ */
+static int
+i_log_output(sirius_log_lv_t log_lv,
+    struct iovec *p_iov, int iov_nr)
+{
+    SIRIUS_TRACE_SCOPE_ARG("sirius_log_write", log_lv);
+
+    i_log_count(I_LOG_METRIC_REC + log_lv - SIRIUS_LOG_LV_DEFAULT, 1);
+
+    size_t len;
+    switch (atomic_load_explicit(&(g_h.sink), memory_order_relaxed)) {
+        case SIRIUS_LOG_SINK_FILE:
+            (void)sirius_log_file_write(p_iov, iov_nr);
+            len = sirius_log_iov_len(p_iov, iov_nr);
+            break;
+        case SIRIUS_LOG_SINK_SHM:
+            (void)sirius_log_shm_write(log_lv, p_iov, iov_nr);
+            len = sirius_log_iov_len(p_iov, iov_nr);
+            break;
+        default:
+            p_iov[iov_nr].iov_base = (void *)LOG_NONE;
+            p_iov[iov_nr].iov_len = sizeof(LOG_NONE) - 1;
+            iov_nr++;
+            len = sirius_log_iov_len(p_iov, iov_nr);
+
+            SIRIUS_TRACE_BEGIN("sirius_log_lock");
+            i_log_lock();
+            SIRIUS_TRACE_END("sirius_log_lock");
+            i_log_writev_all(i_log_lv_attr[log_lv].fd, p_iov, iov_nr);
+            i_log_unlock();
+            break;
+    }
+
+    i_log_count(I_LOG_METRIC_BYTES, len);
+    return len > INT_MAX ? INT_MAX : (int)len;
+}
+
+/**
+ * duplicate suppression is done per thread, so it needs no lock:
+ * a record equal to the previous one of the same thread is
+ * dropped, and a summary is printed when a different record
+ * arrives or `I_LOG_DUP_INTERVAL` seconds have passed. the summary
+ * carries the call site of the repeated record. a thread that
+ * exits with dropped repetitions prints it from the destructor
+ * of `g_dup_key`, and `sirius_log_deinit` prints the one of the
+ * calling thread.
+ */
+
+/* summary interval of a repeated record, unit: s */
+#define I_LOG_DUP_INTERVAL  (1)
+
+typedef struct {
+    /* hash of the previous payload */
+    unsigned long long hash;
+    /* call site of the previous record */
+    const char *p_color;
+    const char *p_mod;
+    const char *p_file;
+    const char *p_func;
+    int line;
+    sirius_log_lv_t log_lv;
+    /* number of dropped repetitions */
+    unsigned int count;
+    /* the moment the previous record was printed */
+    time_t last;
+    /* `g_dup_key` is set for the thread */
+    bool keyed;
+} i_log_dup_t;
+
+static __thread i_log_dup_t i_log_dup = {0};
+
+static pthread_key_t g_dup_key;
+static pthread_once_t g_dup_once = PTHREAD_ONCE_INIT;
+
+static inline unsigned long long
+i_log_dup_hash(const char *p_buf, int n)
+{
+    /* FNV-1a */
+    unsigned long long h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < n; i++) {
+        h ^= (unsigned char)p_buf[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void
+i_log_dup_summary(i_log_dup_t *p_d)
+{
+    char buf[LOG_PRNT_BUF_SIZE_MIN << 1];
+    int n = i_log_header(buf, sizeof(buf), p_d->log_lv,
+        p_d->p_color, p_d->p_mod, p_d->p_file, p_d->p_func, p_d->line);
+    n += snprintf(buf + n, sizeof(buf) - n,
+        "last message repeated %u times\n", p_d->count);
+    if (n >= (int)sizeof(buf)) {
+        n = sizeof(buf) - 1;
+    }
+
+    struct iovec iov[I_LOG_IOV_NR] = {
+        {.iov_base = buf, .iov_len = (size_t)n},
+    };
+    (void)i_log_output(p_d->log_lv, iov, 1);
+    p_d->count = 0;
+}
+
+static void
+i_log_dup_flush(void *p_arg)
+{
+    i_log_dup_t *p_d = (i_log_dup_t *)p_arg;
+    if (p_d->count && g_h.is_init) {
+        i_log_dup_summary(p_d);
+    }
+}
+
+static void
+i_log_dup_key_cr()
+{
+    (void)pthread_key_create(&g_dup_key, i_log_dup_flush);
+}
+
+/* the first dropped repetition of the thread arms the exit flush */
+static void
+i_log_dup_arm(i_log_dup_t *p_d)
+{
+    (void)pthread_once(&g_dup_once, i_log_dup_key_cr);
+    (void)pthread_setspecific(g_dup_key, p_d);
+    p_d->keyed = true;
+}
+
+/**
+ * @return true if the record is dropped
+ */
+static bool
+i_log_dup_check(sirius_log_lv_t log_lv,
+    const char *p_color,
+    const char *p_mod,
+    const char *p_file,
+    const char *p_func,
+    int line,
+    const char *p_payload, size_t n)
+{
+    i_log_dup_t *p_d = &i_log_dup;
+    unsigned long long hash = i_log_dup_hash(p_payload, n);
+    time_t now = (time_t)(sirius_time_coarse_ns() / 1000000000ULL);
+
+    if (hash == p_d->hash &&
+        line == p_d->line &&
+        p_file == p_d->p_file) {
+        if (now - p_d->last < I_LOG_DUP_INTERVAL) {
+            if (unlikely(!(p_d->keyed))) i_log_dup_arm(p_d);
+            p_d->count++;
+            return true;
+        }
+        p_d->last = now;
+        if (p_d->count) {
+            p_d->count++;
+            i_log_dup_summary(p_d);
+            return true;
+        }
+        return false;
+    }
+
+    if (p_d->count) {
+        i_log_dup_summary(p_d);
+    }
+
+    p_d->hash = hash;
+    p_d->p_color = p_color;
+    p_d->p_mod = p_mod;
+    p_d->p_file = p_file;
+    p_d->p_func = p_func;
+    p_d->line = line;
+    p_d->log_lv = log_lv;
+    p_d->last = now;
+    return false;
+}
+
+/**
+ * payloads that don't fit into the stack buffer of
+ * `sirius_log_print` are formatted into a buffer of the thread,
+ * which grows on demand up to `LOG_PRNT_LEN_MAX`.
+ */
+
+/* a larger thread buffer is released after the record */
+#define I_LOG_TLS_BUF_KEEP  (256 * 1024)
+
+typedef struct {
+    char *p_data;
+    size_t cap;
+} i_log_tls_buf_t;
+
+static __thread i_log_tls_buf_t i_log_tls_buf = {0};
+
+static pthread_key_t g_tls_key;
+static pthread_once_t g_tls_once = PTHREAD_ONCE_INIT;
+
+static void
+i_log_tls_buf_free(void *p_data)
+{
+    free(p_data);
+}
+
+static void
+i_log_tls_key_cr()
+{
+    (void)pthread_key_create(&g_tls_key, i_log_tls_buf_free);
+}
+
+static char *
+i_log_tls_buf_get(size_t size)
+{
+    i_log_tls_buf_t *p_b = &i_log_tls_buf;
+    if (p_b->cap >= size) return p_b->p_data;
+
+    size_t cap = p_b->cap ? p_b->cap : LOG_PRNT_BUF_SIZE;
+    while (cap < size) cap <<= 1;
+
+    char *p_data = (char *)realloc(p_b->p_data, cap);
+    if (!(p_data)) return NULL;
+
+    /* the key frees the buffer when the thread exits */
+    (void)pthread_once(&g_tls_once, i_log_tls_key_cr);
+    (void)pthread_setspecific(g_tls_key, p_data);
+    p_b->p_data = p_data;
+    p_b->cap = cap;
+    return p_data;
+}
+
+static void
+i_log_tls_buf_trim()
+{
+    i_log_tls_buf_t *p_b = &i_log_tls_buf;
+    if (p_b->cap <= I_LOG_TLS_BUF_KEEP) return;
+
+    free(p_b->p_data);
+    (void)pthread_setspecific(g_tls_key, NULL);
+    p_b->p_data = NULL;
+    p_b->cap = 0;
+}
+
+/**
+ * @return whether the level goes to the sink (`*p_out`)
+ *  or to the flight recorder (`*p_rec`)
+ */
+static inline bool
+i_log_check(sirius_log_lv_t log_lv, sirius_log_mod_t *p_mod,
+    bool *p_out, bool *p_rec)
+{
+    if (unlikely(!(g_h.is_init))) return false;
+    if (unlikely((SIRIUS_LOG_LV_0 >= (int)log_lv) ||
+        (SIRIUS_LOG_LV_MAX <= log_lv))) {
+        if (SIRIUS_LOG_LV_0 != log_lv) {
+            I_LOG_WARN("invalid log level: %d\n", log_lv);
+        }
+        return false;
+    }
+
+    *p_out = sirius_log_lv_mod_get(p_mod) >= log_lv;
+    *p_rec = g_h.rec_init && sirius_log_lv_rec_get() >= log_lv;
+    return *p_out || *p_rec;
+}
+
+/**
+ * @param p_iov: the header, including the colour, and the payload
+ * @param color_len: length of the colour at the head of the header
+ */
+static int
+i_log_commit(sirius_log_lv_t log_lv,
+    const char *p_color,
+    const char *p_mod,
+    const char *p_file,
+    const char *p_func,
+    int line,
+    bool out, bool rec,
+    struct iovec *p_iov, int iov_nr,
+    size_t color_len)
+{
+    if (rec) {
+        struct iovec iov[I_LOG_IOV_NR];
+        memcpy(iov, p_iov, sizeof(struct iovec) * iov_nr);
+        iov[0].iov_base = (char *)iov[0].iov_base + color_len;
+        iov[0].iov_len -= color_len;
+        sirius_log_rec_write(iov, iov_nr);
+    }
+    if (!(out)) return 0;
+
+    if (g_h.dup_suppress &&
+        i_log_dup_check(log_lv, p_color, p_mod,
+            p_file, p_func, line,
+            (const char *)p_iov[1].iov_base, p_iov[1].iov_len)) {
+        i_log_count(I_LOG_METRIC_DUP, 1);
+        return 0;
+    }
+
+    return i_log_output(log_lv, p_iov, iov_nr);
+}
+
+/* colour codes are only meaningful on a terminal */
+static inline const char *
+i_log_color(const char *p_color)
+{
+    return SIRIUS_LOG_SINK_STDOUT == atomic_load_explicit(
+        &(g_h.sink), memory_order_relaxed) ? p_color : "";
+}
+
+static int
+i_log_vprint(sirius_log_lv_t log_lv,
+    const char *p_color,
+    sirius_log_mod_t *p_mod,
+    const char *p_file,
+    const char *p_func,
+    int line,
+    const char *p_fmt, va_list args)
+{
+    bool out, rec;
+    if (!(i_log_check(log_lv, p_mod, &out, &rec))) return 0;
+
+    char buf[LOG_PRNT_BUF_SIZE];
+    p_color = i_log_color(p_color);
+
+    int hdr_len = i_log_header(buf, sizeof(buf), log_lv,
+        p_color, p_mod->p_name, p_file, p_func, line);
+    char *p_payload = buf + hdr_len;
+    size_t room = sizeof(buf) - hdr_len;
+
+    va_list args_cp;
+    va_copy(args_cp, args);
+    int n = vsnprintf(p_payload, room, p_fmt, args);
+
+    bool large = false;
+    if (unlikely(n < 0)) {
+        n = 0;
+    } else if (unlikely((size_t)n >= room)) {
+        /* format again into the thread buffer */
+        size_t size = (size_t)n + 1;
+        if (size > LOG_PRNT_LEN_MAX) size = LOG_PRNT_LEN_MAX;
+
+        char *p_large = i_log_tls_buf_get(size);
+        if (p_large) {
+            n = vsnprintf(p_large, size, p_fmt, args_cp);
+            if (n >= (int)size) n = size - 1;
+            p_payload = p_large;
+            large = true;
+        } else {
+            n = room - 1;
+        }
+    }
+    va_end(args_cp);
+
+    struct iovec iov[I_LOG_IOV_NR] = {
+        {.iov_base = buf, .iov_len = (size_t)hdr_len},
+        {.iov_base = p_payload, .iov_len = (size_t)n},
+    };
+    int ret = i_log_commit(log_lv, p_color, p_mod->p_name,
+        p_file, p_func, line, out, rec,
+        iov, 2, strlen(p_color));
+
+    if (unlikely(large)) i_log_tls_buf_trim();
+    return ret;
 }
 
 int
@@ -366,63 +1098,137 @@ sirius_log_print(sirius_log_lv_t log_lv,
     int line,
     const char *p_fmt, ...)
 {
-    if (unlikely(!(g_h.is_init))) return 0;
-    if (g_h.log_lv < log_lv) return 0;
+    /* no call site to keep the key in, it is looked up every time */
+    sirius_log_mod_t mod = SIRIUS_LOG_MOD_INIT(p_mod);
 
-    char buf[LOG_PRNT_BUF_SIZE];
-    int n = 0;
-    time_t raw_tm;
-    struct tm *p_tm_info;
+    va_list args;
+    va_start(args, p_fmt);
+    int ret = i_log_vprint(log_lv, p_color, &mod,
+        p_file, p_func, line, p_fmt, args);
+    va_end(args);
+    return ret;
+}
+
+int
+sirius_log_print_mod(sirius_log_lv_t log_lv,
+    const char *p_color,
+    sirius_log_mod_t *p_mod,
+    const char *p_file,
+    const char *p_func,
+    int line,
+    const char *p_fmt, ...)
+{
+    if (!(p_mod)) return SIRIUS_ERR_NULL_POINTER;
 
     va_list args;
     va_start(args, p_fmt);
+    int ret = i_log_vprint(log_lv, p_color, p_mod,
+        p_file, p_func, line, p_fmt, args);
+    va_end(args);
+    return ret;
+}
 
-#define i_log_prnt(fd, type) \
-    time(&raw_tm); \
-    p_tm_info = localtime(&raw_tm); \
-    n = snprintf(buf, sizeof(buf), \
-        "%s[%02d:%02d:%02d " #type " %s %lu " \
-        "%s (%s|%d)] ", \
-            p_color, \
-            p_tm_info->tm_hour, \
-            p_tm_info->tm_min, \
-            p_tm_info->tm_sec, \
-            p_mod, syscall(__NR_gettid), \
-            p_file, p_func, line); \
-    n += vsnprintf( \
-        buf + n, sizeof(buf) - n, p_fmt, args); \
-    n += snprintf(buf + n, sizeof(buf) - n, LOG_NONE); \
-    i_log_atomic_set(); \
-    write(fd, buf, n + 1); \
-    i_log_atomic_clear();
-
-    switch (log_lv) {
-        case SIRIUS_LOG_LV_0:
-            return 0;
-        case SIRIUS_LOG_LV_DEFAULT:
-            i_log_prnt(STDOUT_FILENO, prnt)
-            break;
-        case SIRIUS_LOG_LV_ERROR:
-            i_log_prnt(STDERR_FILENO, error)
-            break;
-        case SIRIUS_LOG_LV_WARN:
-            i_log_prnt(STDERR_FILENO, warn)
-            break;
-        case SIRIUS_LOG_LV_INFO:
-            i_log_prnt(STDOUT_FILENO, info)
-            break;
-        case SIRIUS_LOG_LV_DEBG:
-            i_log_prnt(STDOUT_FILENO, debg)
-            break;
-        default:
-            I_LOG_WARN("invalid log level: %d\n", log_lv);
-            return 0;
+int
+sirius_log_bytes_mod(sirius_log_lv_t log_lv,
+    const char *p_color,
+    sirius_log_mod_t *p_mod,
+    const char *p_file,
+    const char *p_func,
+    int line,
+    const void *p_data,
+    size_t len)
+{
+    if (!(p_mod) || (!(p_data) && len)) return SIRIUS_ERR_NULL_POINTER;
+
+    bool out, rec;
+    if (!(i_log_check(log_lv, p_mod, &out, &rec))) return 0;
+
+    char buf[LOG_PRNT_BUF_SIZE_MIN << 1];
+    p_color = i_log_color(p_color);
+
+    int hdr_len = i_log_header(buf, sizeof(buf), log_lv,
+        p_color, p_mod->p_name, p_file, p_func, line);
+
+    struct iovec iov[I_LOG_IOV_NR] = {
+        {.iov_base = buf, .iov_len = (size_t)hdr_len},
+        {.iov_base = (void *)p_data, .iov_len = len},
+    };
+    int iov_nr = 2;
+
+    /* every record ends with a newline */
+    if (0 == len || '\n' != ((const char *)p_data)[len - 1]) {
+        iov[iov_nr].iov_base = (void *)"\n";
+        iov[iov_nr].iov_len = 1;
+        iov_nr++;
     }
 
-    va_end(args);
+    return i_log_commit(log_lv, p_color, p_mod->p_name,
+        p_file, p_func, line, out, rec,
+        iov, iov_nr, strlen(p_color));
+}
 
-#undef i_log_prnt
-    return n;
+int
+sirius_log_bytes(sirius_log_lv_t log_lv,
+    const char *p_color,
+    const char *p_mod,
+    const char *p_file,
+    const char *p_func,
+    int line,
+    const void *p_data,
+    size_t len)
+{
+    sirius_log_mod_t mod = SIRIUS_LOG_MOD_INIT(p_mod);
+    return sirius_log_bytes_mod(log_lv, p_color, &mod,
+        p_file, p_func, line, p_data, len);
+}
+
+void
+sirius_log_ratelimit_drop()
+{
+    i_log_count(I_LOG_METRIC_RL, 1);
+}
+
+static void
+i_log_metrics_unregister()
+{
+    for (int i = 0; i < I_LOG_METRIC_NR; i++) {
+        if (g_h.metrics[i]) {
+            (void)sirius_metrics_unregister(g_h.metrics[i]);
+            g_h.metrics[i] = NULL;
+        }
+    }
+}
+
+/* a metric that cannot be registered is left out */
+static void
+i_log_metrics_register()
+{
+    char labels[32];
+    sirius_metric_attr_t attr = {
+        .type = SIRIUS_METRIC_COUNTER,
+        .p_name = "sirius_log_records_total",
+        .p_help = "Log records written, per level.",
+        .p_labels = labels,
+    };
+
+    for (int i = SIRIUS_LOG_LV_DEFAULT; i < SIRIUS_LOG_LV_MAX; i++) {
+        snprintf(labels, sizeof(labels), "level=\"%s\"", i_log_lv_tag[i]);
+        (void)sirius_metrics_register(&attr, &(g_h.metrics[
+            I_LOG_METRIC_REC + i - SIRIUS_LOG_LV_DEFAULT]));
+    }
+
+    attr.p_name = "sirius_log_bytes_total";
+    attr.p_help = "Bytes of log records written.";
+    attr.p_labels = NULL;
+    (void)sirius_metrics_register(&attr, &(g_h.metrics[I_LOG_METRIC_BYTES]));
+
+    attr.p_name = "sirius_log_dropped_total";
+    attr.p_help = "Log records dropped before the output.";
+    attr.p_labels = "reason=\"duplicate\"";
+    (void)sirius_metrics_register(&attr, &(g_h.metrics[I_LOG_METRIC_DUP]));
+
+    attr.p_labels = "reason=\"ratelimit\"";
+    (void)sirius_metrics_register(&attr, &(g_h.metrics[I_LOG_METRIC_RL]));
 }
 
 void
@@ -432,13 +1238,31 @@ sirius_log_deinit()
         return;
     }
 
-    i_log_pipe_destory();
+    i_log_dup_flush(&i_log_dup);
+    i_log_metrics_unregister();
+    sirius_log_lv_deinit();
 
     if (g_h.p_thd) {
+        i_log_pipe_destory();
         free(g_h.p_thd);
         g_h.p_thd = NULL;
     }
 
+    if (g_h.rec_init) {
+        g_h.rec_init = false;
+        sirius_log_rec_deinit();
+    }
+
+    (void)i_log_sink_set(SIRIUS_LOG_SINK_STDOUT);
+    if (g_h.shm_init) {
+        g_h.shm_init = false;
+        sirius_log_shm_deinit();
+    }
+    if (g_h.file_init) {
+        g_h.file_init = false;
+        sirius_log_file_deinit();
+    }
+
     memset(&g_h, 0, sizeof(i_log_t));
 }
 
@@ -455,23 +1279,90 @@ sirius_log_init(const sirius_log_cr_t *p_cr)
         return SIRIUS_ERR_INVALID_ENTRY;
     }
 
-    g_h.p_thd = (i_log_thd_t *)calloc(
-        1, sizeof(i_log_thd_t));
-    if (!(g_h.p_thd)) {
-        I_LOG_ERROR("calloc\n");
-        return SIRIUS_ERR_MEMORY_ALLOC;
+    int ret;
+    if (p_cr->p_file && p_cr->p_file->p_path) {
+        ret = sirius_log_file_init(p_cr->p_file);
+        if (ret) {
+            I_LOG_ERROR(
+                "sirius_log_file_init: [%d]\n", ret);
+            return ret;
+        }
+        g_h.file_init = true;
     }
 
-    strncpy(g_h.p_thd->pipe_path, p_cr->p_pipe,
-        I_LOG_FIFO_PATH_SIZE - 1);
-    int ret = i_log_pipe_create(g_h.p_thd->pipe_path);
+    if (p_cr->p_shm && p_cr->p_shm->enable) {
+        ret = sirius_log_shm_init(p_cr->p_shm);
+        if (ret) {
+            I_LOG_ERROR(
+                "sirius_log_shm_init: [%d]\n", ret);
+            goto label_file_deinit;
+        }
+        g_h.shm_init = true;
+    }
+
+    sirius_log_sink_t sink = p_cr->sink;
+    if (SIRIUS_LOG_SINK_DEFAULT == sink) {
+        sink = g_h.shm_init ? SIRIUS_LOG_SINK_SHM :
+            g_h.file_init ? SIRIUS_LOG_SINK_FILE :
+            SIRIUS_LOG_SINK_STDOUT;
+    }
+    ret = i_log_sink_set(sink);
     if (ret) {
-        I_LOG_ERROR(
-            "i_log_pipe_create: [%d]\n", ret);
-        return ret;
+        I_LOG_ERROR("the sink [%d] is not configured\n", sink);
+        goto label_file_deinit;
     }
 
+    if (p_cr->p_rec && p_cr->p_rec->size) {
+        ret = sirius_log_rec_init(p_cr->p_rec);
+        if (ret) {
+            I_LOG_ERROR(
+                "sirius_log_rec_init: [%d]\n", ret);
+            goto label_file_deinit;
+        }
+        g_h.rec_init = true;
+    }
+
+    /* the control channel is disabled without a pipe path */
+    if (p_cr->p_pipe && p_cr->p_pipe[0]) {
+        g_h.p_thd = (i_log_thd_t *)calloc(
+            1, sizeof(i_log_thd_t));
+        if (!(g_h.p_thd)) {
+            I_LOG_ERROR("calloc\n");
+            ret = SIRIUS_ERR_MEMORY_ALLOC;
+            goto label_file_deinit;
+        }
+
+        strncpy(g_h.p_thd->pipe_path, p_cr->p_pipe,
+            I_LOG_FIFO_PATH_SIZE - 1);
+        ret = i_log_pipe_create(g_h.p_thd);
+        if (ret) {
+            I_LOG_ERROR(
+                "i_log_pipe_create: [%d]\n", ret);
+            free(g_h.p_thd);
+            g_h.p_thd = NULL;
+            goto label_file_deinit;
+        }
+    }
+
+    /* the counters exist before the first record is let through */
+    i_log_metrics_register();
     i_log_param_init(p_cr);
 
     return SIRIUS_OK;
+
+label_file_deinit:
+    (void)i_log_sink_set(SIRIUS_LOG_SINK_STDOUT);
+    if (g_h.rec_init) {
+        g_h.rec_init = false;
+        sirius_log_rec_deinit();
+    }
+    if (g_h.shm_init) {
+        g_h.shm_init = false;
+        sirius_log_shm_deinit();
+    }
+    if (g_h.file_init) {
+        g_h.file_init = false;
+        sirius_log_file_deinit();
+    }
+    return ret;
 }
@@ -0,0 +1,159 @@
+#include "sirius_errno.h"
+#include "sirius_log.h"
+#include "sirius_attributes.h"
+
+#include "./internal/sirius_internal_log.h"
+
+/**
+ * `localtime` takes the timezone lock of glibc and may stat
+ * `/etc/localtime`, so the "HH:MM:SS" part of the header is
+ * formatted once per second and shared by all threads.
+ *
+ * the cache is protected by a sequence counter: the thread that
+ * sees a new second claims the refresh by making the counter odd,
+ * readers never wait, they copy the string and retry only if the
+ * counter changed in the meantime.
+ */
+
+/* "HH:MM:SS" */
+#define I_LOG_CLOCK_SEC_LEN (8)
+
+typedef struct {
+    /* odd while the cache is being refreshed */
+    atomic_uint seq;
+    /* the second `str` was formatted for */
+    atomic_llong sec;
+    char str[I_LOG_CLOCK_SEC_LEN + 1];
+} i_log_clock_t;
+
+static i_log_clock_t g_c = {
+    .sec = -1,
+};
+
+static atomic_int g_prec = SIRIUS_LOG_TIME_PREC_SEC;
+
+static __thread pid_t i_log_tid = 0;
+
+static void
+i_log_clock_atfork_child()
+{
+    /* the only thread of the child inherited the parent's id */
+    i_log_tid = 0;
+}
+
+static pthread_once_t i_log_clock_once = PTHREAD_ONCE_INIT;
+
+static void
+i_log_clock_once_init()
+{
+    (void)pthread_atfork(NULL, NULL, i_log_clock_atfork_child);
+}
+
+pid_t
+sirius_log_tid()
+{
+    if (unlikely(0 == i_log_tid)) {
+        i_log_tid = (pid_t)syscall(__NR_gettid);
+    }
+    return i_log_tid;
+}
+
+static inline void
+i_log_clock_sec_fmt(time_t sec, char *p_buf)
+{
+    struct tm tm_info;
+    localtime_r(&sec, &tm_info);
+    (void)strftime(p_buf,
+        I_LOG_CLOCK_SEC_LEN + 1, "%H:%M:%S", &tm_info);
+}
+
+static void
+i_log_clock_sec_get(time_t sec, char *p_buf)
+{
+    unsigned int seq;
+
+    while (true) {
+        seq = atomic_load_explicit(&(g_c.seq), memory_order_acquire);
+        if (likely(!(seq & 1) &&
+            sec == atomic_load_explicit(
+                &(g_c.sec), memory_order_relaxed))) {
+            memcpy(p_buf, g_c.str, I_LOG_CLOCK_SEC_LEN);
+            atomic_thread_fence(memory_order_acquire);
+            if (likely(seq == atomic_load_explicit(
+                    &(g_c.seq), memory_order_relaxed))) {
+                return;
+            }
+            continue;
+        }
+
+        if (!(seq & 1) &&
+            atomic_compare_exchange_strong_explicit(
+                &(g_c.seq), &seq, seq + 1,
+                memory_order_acquire, memory_order_relaxed)) {
+            i_log_clock_sec_fmt(sec, g_c.str);
+            atomic_store_explicit(&(g_c.sec), sec,
+                memory_order_relaxed);
+            atomic_store_explicit(&(g_c.seq), seq + 2,
+                memory_order_release);
+            memcpy(p_buf, g_c.str, I_LOG_CLOCK_SEC_LEN);
+            return;
+        }
+
+        /**
+         * another thread is refreshing the cache,
+         * do not wait for it
+         */
+        char tmp[I_LOG_CLOCK_SEC_LEN + 1];
+        i_log_clock_sec_fmt(sec, tmp);
+        memcpy(p_buf, tmp, I_LOG_CLOCK_SEC_LEN);
+        return;
+    }
+}
+
+int
+sirius_log_clock_fmt(char *p_buf)
+{
+    struct timespec ts;
+    int prec = atomic_load_explicit(&g_prec, memory_order_relaxed);
+
+    /**
+     * both clocks are read from the vDSO without a syscall; the
+     * coarse one only advances once per tick (1 to 4 ms), so it
+     * is used when nothing below the second is printed
+     */
+    if (SIRIUS_LOG_TIME_PREC_SEC == prec) {
+        clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    } else {
+        clock_gettime(CLOCK_REALTIME, &ts);
+    }
+
+    i_log_clock_sec_get(ts.tv_sec, p_buf);
+
+    int n = I_LOG_CLOCK_SEC_LEN;
+    switch (prec) {
+        case SIRIUS_LOG_TIME_PREC_MS:
+            n += snprintf(p_buf + n, SIRIUS_LOG_CLOCK_BUF_SIZE - n,
+                ".%03ld", ts.tv_nsec / 1000000);
+            break;
+        case SIRIUS_LOG_TIME_PREC_US:
+            n += snprintf(p_buf + n, SIRIUS_LOG_CLOCK_BUF_SIZE - n,
+                ".%06ld", ts.tv_nsec / 1000);
+            break;
+        default:
+            p_buf[n] = '\0';
+            break;
+    }
+
+    return n;
+}
+
+void
+sirius_log_clock_init(sirius_log_time_prec_t prec)
+{
+    (void)pthread_once(&i_log_clock_once, i_log_clock_once_init);
+
+    if (prec >= SIRIUS_LOG_TIME_PREC_MAX) {
+        prec = SIRIUS_LOG_TIME_PREC_SEC;
+    }
+    atomic_store_explicit(&g_prec, prec, memory_order_relaxed);
+}
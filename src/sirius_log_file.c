@@ -0,0 +1,615 @@
+#include "sirius_errno.h"
+#include "sirius_log.h"
+#include "sirius_attributes.h"
+
+#include "./internal/sirius_internal_log.h"
+#include "./internal/sirius_internal_thread.h"
+
+#include <signal.h>
+#include <stdint.h>
+
+/* default size of the user-space write buffer */
+#define I_LOG_FILE_BUF_SIZE_DEF     (64 * 1024)
+/* the write buffer can hold at least one full record */
+#define I_LOG_FILE_BUF_SIZE_MIN     (LOG_PRNT_BUF_SIZE)
+
+/* default buffer flush interval, unit: ms */
+#define I_LOG_FILE_FLUSH_MS_DEF     (200)
+
+/* delay before opening the file again after a failed open, unit: ms */
+#define I_LOG_FILE_RETRY_MS         (1000)
+
+/* segments of a record written by one `writev` */
+#define I_LOG_FILE_IOV_NR           (8)
+
+/* the file path length of the log file */
+#define I_LOG_FILE_PATH_SIZE        (256)
+/* path length of a rotated file, `path.N` */
+#define I_LOG_FILE_ROTATE_PATH_SIZE (I_LOG_FILE_PATH_SIZE + 16)
+
+/**
+ * the records are collected in `p_active`, once it is full it
+ * is swapped with `p_spare` and the background thread writes
+ * `p_spare` out, so a logging thread only does a memcpy unless
+ * both buffers are full.
+ *
+ * rotation and reopen are also done by the background thread:
+ * the rename and open happen without the lock, and only the
+ * final fd swap is done while holding it. if the open fails the
+ * records keep going to the previous fd, which may be `path.1`
+ * by then, and the open is retried every `I_LOG_FILE_RETRY_MS`;
+ * no rotation is started until it succeeds.
+ *
+ * a record larger than a buffer is written by its own thread with
+ * one `writev`, outside the lock: it waits for the pending records
+ * to be written out and takes `direct`, which keeps the background
+ * thread away from the file until it is done. the records logged
+ * meanwhile are collected in `p_active` and follow it in the file.
+ */
+
+typedef struct {
+    char *p_data;
+    size_t len;
+} i_log_file_buf_t;
+
+typedef struct {
+    /* log file path */
+    char path[I_LOG_FILE_PATH_SIZE];
+
+    /* current file descriptor */
+    int fd;
+    /* bytes already handed to the current file */
+    size_t size;
+
+    /* buffer capacity */
+    size_t cap;
+    /* buffer being filled by the logging threads */
+    i_log_file_buf_t active;
+    /* buffer being written by the background thread */
+    i_log_file_buf_t spare;
+    /* `spare` is being written out */
+    bool flushing;
+    /* a record larger than a buffer is being written out */
+    bool direct;
+
+    unsigned int flush_ms;
+    size_t rotate_size;
+    unsigned int rotate_sec;
+    unsigned int retention;
+    /* the moment of the next time-based rotation */
+    time_t rotate_next;
+    /* CLOCK_MONOTONIC ms of the next open after a failed one, 0 if none */
+    uint64_t retry_at;
+
+    /* rotation requested by a logging thread */
+    bool rotate_pending;
+    /* reopen requested by the pipe command */
+    bool reopen_pending;
+
+    bool sighup_reopen;
+    struct sigaction sighup_old;
+
+    /* number of write-outs of the buffer */
+    unsigned long long flush_nr;
+    /* number of rotations */
+    unsigned long long rotate_nr;
+    /* number of times a logging thread waited for the buffer */
+    unsigned long long wait_nr;
+    /* number of failed opens */
+    unsigned long long open_fail_nr;
+
+    bool exit;
+    pthread_t id;
+    pthread_mutex_t mutex;
+    /* wakes up the background thread */
+    pthread_cond_t cond_work;
+    /* `spare` or a direct record has been written out */
+    pthread_cond_t cond_free;
+} i_log_file_t;
+
+static i_log_file_t *g_f = NULL;
+
+/* set by the SIGHUP handler, polled by the background thread */
+static volatile sig_atomic_t i_log_file_sighup = 0;
+
+static void
+i_log_file_sighup_handler(int sig)
+{
+    (void)sig;
+    i_log_file_sighup = 1;
+}
+
+static int
+i_log_file_open(const char *p_path, size_t *p_size)
+{
+    int fd = open(p_path,
+        O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (-1 == fd) {
+        I_LOG_ERROR("open [%s]: %s\n",
+            p_path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    *p_size = fstat(fd, &st) ? 0 : (size_t)st.st_size;
+    return fd;
+}
+
+static void
+i_log_file_write_all(int fd, const char *p_buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, p_buf, len);
+        if (n < 0) {
+            if (EINTR == errno) continue;
+            I_LOG_ERROR("write: %s\n", strerror(errno));
+            return;
+        }
+        p_buf += n;
+        len -= (size_t)n;
+    }
+}
+
+static void
+i_log_file_writev_all(int fd, struct iovec *p_iov, int iov_nr)
+{
+    while (iov_nr > 0) {
+        ssize_t n = writev(fd, p_iov, iov_nr);
+        if (n < 0) {
+            if (EINTR == errno) continue;
+            I_LOG_ERROR("writev: %s\n", strerror(errno));
+            return;
+        }
+
+        /* partial write, skip the segments already written */
+        while (iov_nr > 0 && (size_t)n >= p_iov->iov_len) {
+            n -= p_iov->iov_len;
+            p_iov++;
+            iov_nr--;
+        }
+        if (iov_nr > 0) {
+            p_iov->iov_base = (char *)p_iov->iov_base + n;
+            p_iov->iov_len -= n;
+        }
+    }
+}
+
+/* `path.(N-1)` -> `path.N`, ..., `path` -> `path.1` */
+static void
+i_log_file_rename_chain(i_log_file_t *p_f)
+{
+    char src[I_LOG_FILE_ROTATE_PATH_SIZE];
+    char dst[I_LOG_FILE_ROTATE_PATH_SIZE];
+
+    if (0 == p_f->retention) {
+        (void)unlink(p_f->path);
+        return;
+    }
+
+    snprintf(dst, sizeof(dst), "%s.%u",
+        p_f->path, p_f->retention);
+    (void)unlink(dst);
+
+    for (unsigned int i = p_f->retention; i > 1; i--) {
+        snprintf(src, sizeof(src), "%s.%u", p_f->path, i - 1);
+        snprintf(dst, sizeof(dst), "%s.%u", p_f->path, i);
+        if (rename(src, dst) && ENOENT != errno) {
+            I_LOG_WARN("rename [%s]: %s\n",
+                src, strerror(errno));
+        }
+    }
+
+    snprintf(dst, sizeof(dst), "%s.1", p_f->path);
+    if (rename(p_f->path, dst) && ENOENT != errno) {
+        I_LOG_WARN("rename [%s]: %s\n",
+            p_f->path, strerror(errno));
+    }
+}
+
+static inline uint64_t
+i_log_file_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static inline time_t
+i_log_file_rotate_next(unsigned int rotate_sec)
+{
+    time_t now = time(NULL);
+    return (now / rotate_sec + 1) * rotate_sec;
+}
+
+/**
+ * @note called by the background thread with the lock held,
+ *  the lock is released while renaming and opening
+ */
+static void
+i_log_file_switch(i_log_file_t *p_f, bool rotate)
+{
+    p_f->rotate_pending = false;
+    p_f->reopen_pending = false;
+    pthread_mutex_unlock(&(p_f->mutex));
+
+    if (rotate) i_log_file_rename_chain(p_f);
+
+    size_t size = 0;
+    int fd = i_log_file_open(p_f->path, &size);
+
+    pthread_mutex_lock(&(p_f->mutex));
+    /* a direct record still writes to the old fd */
+    while (p_f->direct) {
+        pthread_cond_wait(&(p_f->cond_free), &(p_f->mutex));
+    }
+    if (rotate) p_f->rotate_nr++;
+    if (-1 == fd) {
+        /* keep the current fd, the rename is not repeated */
+        p_f->open_fail_nr++;
+        p_f->retry_at = i_log_file_ms() + I_LOG_FILE_RETRY_MS;
+        return;
+    }
+
+    int old_fd = p_f->fd;
+    p_f->fd = fd;
+    p_f->retry_at = 0;
+    /* the pending records go to the new file */
+    p_f->size = size + p_f->active.len;
+    if (p_f->rotate_sec) {
+        p_f->rotate_next = i_log_file_rotate_next(p_f->rotate_sec);
+    }
+
+    pthread_mutex_unlock(&(p_f->mutex));
+    close(old_fd);
+    pthread_mutex_lock(&(p_f->mutex));
+}
+
+/**
+ * @note called with the lock held and `flushing` set
+ */
+static void
+i_log_file_flush_spare(i_log_file_t *p_f)
+{
+    int fd = p_f->fd;
+    pthread_mutex_unlock(&(p_f->mutex));
+
+    i_log_file_write_all(fd, p_f->spare.p_data, p_f->spare.len);
+
+    pthread_mutex_lock(&(p_f->mutex));
+    p_f->spare.len = 0;
+    p_f->flushing = false;
+    p_f->flush_nr++;
+    pthread_cond_broadcast(&(p_f->cond_free));
+}
+
+static inline void
+i_log_file_swap(i_log_file_t *p_f)
+{
+    i_log_file_buf_t tmp = p_f->spare;
+    p_f->spare = p_f->active;
+    p_f->active = tmp;
+    p_f->flushing = true;
+}
+
+static void *
+i_log_file_thd(void *args)
+{
+    i_log_file_t *p_f = (i_log_file_t *)args;
+    struct timespec ts;
+
+    pthread_mutex_lock(&(p_f->mutex));
+    while (true) {
+        if (!(p_f->flushing) &&
+            !(p_f->rotate_pending) &&
+            !(p_f->reopen_pending) &&
+            !(p_f->exit)) {
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            ts.tv_sec += p_f->flush_ms / 1000;
+            ts.tv_nsec += (p_f->flush_ms % 1000) * 1000000;
+            if (ts.tv_nsec >= 1000000000) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000;
+            }
+            (void)pthread_cond_timedwait(
+                &(p_f->cond_work), &(p_f->mutex), &ts);
+        }
+
+        /* the file belongs to a direct record until it is written */
+        while (p_f->direct) {
+            pthread_cond_wait(&(p_f->cond_free), &(p_f->mutex));
+        }
+
+        /* interval flush */
+        if (!(p_f->flushing) && p_f->active.len > 0) {
+            i_log_file_swap(p_f);
+        }
+        if (p_f->flushing) {
+            i_log_file_flush_spare(p_f);
+        }
+
+        if (p_f->exit) break;
+
+        if (i_log_file_sighup) {
+            i_log_file_sighup = 0;
+            p_f->reopen_pending = true;
+        }
+
+        if (p_f->retry_at) {
+            /* a requested reopen does not wait for the deadline */
+            if (p_f->reopen_pending || i_log_file_ms() >= p_f->retry_at) {
+                i_log_file_switch(p_f, false);
+            }
+        } else if (p_f->rotate_pending ||
+            (p_f->rotate_sec && time(NULL) >= p_f->rotate_next)) {
+            i_log_file_switch(p_f, true);
+        } else if (p_f->reopen_pending) {
+            i_log_file_switch(p_f, false);
+        }
+    }
+
+    /* records written after the last flush */
+    if (p_f->active.len > 0) {
+        i_log_file_swap(p_f);
+        i_log_file_flush_spare(p_f);
+    }
+    pthread_mutex_unlock(&(p_f->mutex));
+
+    return NULL;
+}
+
+/**
+ * @note called with the lock held and `direct` set, the lock is
+ *  released while writing
+ */
+static void
+i_log_file_write_direct(i_log_file_t *p_f,
+    const struct iovec *p_iov, int iov_nr)
+{
+    int fd = p_f->fd;
+    pthread_mutex_unlock(&(p_f->mutex));
+
+    struct iovec iov[I_LOG_FILE_IOV_NR];
+    while (iov_nr > 0) {
+        int n = iov_nr < I_LOG_FILE_IOV_NR ? iov_nr : I_LOG_FILE_IOV_NR;
+        memcpy(iov, p_iov, sizeof(struct iovec) * n);
+        i_log_file_writev_all(fd, iov, n);
+        p_iov += n;
+        iov_nr -= n;
+    }
+
+    pthread_mutex_lock(&(p_f->mutex));
+    p_f->direct = false;
+    pthread_cond_broadcast(&(p_f->cond_free));
+}
+
+int
+sirius_log_file_write(const struct iovec *p_iov, int iov_nr)
+{
+    i_log_file_t *p_f = g_f;
+    if (unlikely(!(p_f))) return SIRIUS_ERR_NOT_INIT;
+
+    size_t len = sirius_log_iov_len(p_iov, iov_nr);
+
+    pthread_mutex_lock(&(p_f->mutex));
+
+    if (unlikely(len > p_f->cap)) {
+        /**
+         * the record never fits into a buffer, it is written
+         * after the pending records and before the next ones,
+         * so the order in the file is kept
+         */
+        while (p_f->direct || p_f->flushing || p_f->active.len > 0) {
+            if (!(p_f->direct) && !(p_f->flushing)) {
+                i_log_file_swap(p_f);
+                pthread_cond_signal(&(p_f->cond_work));
+            } else {
+                p_f->wait_nr++;
+                pthread_cond_wait(&(p_f->cond_free), &(p_f->mutex));
+            }
+        }
+        p_f->direct = true;
+        i_log_file_write_direct(p_f, p_iov, iov_nr);
+    } else {
+        while (p_f->active.len + len > p_f->cap) {
+            if (!(p_f->flushing)) {
+                i_log_file_swap(p_f);
+                pthread_cond_signal(&(p_f->cond_work));
+            } else {
+                p_f->wait_nr++;
+                pthread_cond_wait(&(p_f->cond_free), &(p_f->mutex));
+            }
+        }
+
+        p_f->active.len += sirius_log_iov_gather(
+            p_f->active.p_data + p_f->active.len, len,
+            p_iov, iov_nr);
+    }
+    p_f->size += len;
+
+    if (p_f->rotate_size &&
+        p_f->size >= p_f->rotate_size &&
+        !(p_f->rotate_pending) &&
+        !(p_f->retry_at)) {
+        p_f->rotate_pending = true;
+        pthread_cond_signal(&(p_f->cond_work));
+    }
+
+    pthread_mutex_unlock(&(p_f->mutex));
+    return SIRIUS_OK;
+}
+
+void
+sirius_log_file_reopen()
+{
+    i_log_file_t *p_f = g_f;
+    if (!(p_f)) return;
+
+    pthread_mutex_lock(&(p_f->mutex));
+    p_f->reopen_pending = true;
+    pthread_cond_signal(&(p_f->cond_work));
+    pthread_mutex_unlock(&(p_f->mutex));
+}
+
+void
+sirius_log_file_flush()
+{
+    i_log_file_t *p_f = g_f;
+    if (!(p_f)) return;
+
+    /* the background thread writes the buffer out on every wakeup */
+    pthread_mutex_lock(&(p_f->mutex));
+    pthread_cond_signal(&(p_f->cond_work));
+    pthread_mutex_unlock(&(p_f->mutex));
+}
+
+void
+sirius_log_file_stats()
+{
+    i_log_file_t *p_f = g_f;
+    if (!(p_f)) return;
+
+    pthread_mutex_lock(&(p_f->mutex));
+    size_t size = p_f->size;
+    size_t pending = p_f->active.len + p_f->spare.len;
+    unsigned long long flush_nr = p_f->flush_nr;
+    unsigned long long rotate_nr = p_f->rotate_nr;
+    unsigned long long wait_nr = p_f->wait_nr;
+    unsigned long long open_fail_nr = p_f->open_fail_nr;
+    pthread_mutex_unlock(&(p_f->mutex));
+
+    I_LOG_INFO("file [%s]: size %zu, pending %zu\n",
+        p_f->path, size, pending);
+    I_LOG_INFO("file flushes: %llu, rotations: %llu, "
+        "buffer waits: %llu, failed opens: %llu\n",
+        flush_nr, rotate_nr, wait_nr, open_fail_nr);
+}
+
+static void
+i_log_file_free(i_log_file_t *p_f)
+{
+    if (-1 != p_f->fd) close(p_f->fd);
+    free(p_f->active.p_data);
+    free(p_f->spare.p_data);
+    free(p_f);
+}
+
+void
+sirius_log_file_deinit()
+{
+    i_log_file_t *p_f = g_f;
+    if (!(p_f)) return;
+
+    pthread_mutex_lock(&(p_f->mutex));
+    p_f->exit = true;
+    pthread_cond_signal(&(p_f->cond_work));
+    pthread_mutex_unlock(&(p_f->mutex));
+
+    if (pthread_join(p_f->id, NULL)) {
+        I_LOG_ERROR("pthread_join\n");
+    }
+    g_f = NULL;
+
+    if (p_f->sighup_reopen) {
+        (void)sigaction(SIGHUP, &(p_f->sighup_old), NULL);
+    }
+
+    pthread_cond_destroy(&(p_f->cond_free));
+    pthread_cond_destroy(&(p_f->cond_work));
+    pthread_mutex_destroy(&(p_f->mutex));
+    i_log_file_free(p_f);
+}
+
+int
+sirius_log_file_init(const sirius_log_file_t *p_cr)
+{
+    if (g_f) {
+        return SIRIUS_ERR_INIT_REPEATED;
+    }
+
+    if (!(p_cr) || !(p_cr->p_path)) {
+        I_LOG_ERROR("null pointer\n");
+        return SIRIUS_ERR_INVALID_ENTRY;
+    }
+
+    if (strlen(p_cr->p_path) >= I_LOG_FILE_PATH_SIZE) {
+        I_LOG_ERROR("path too long: [%s]\n", p_cr->p_path);
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    i_log_file_t *p_f = (i_log_file_t *)calloc(
+        1, sizeof(i_log_file_t));
+    if (!(p_f)) {
+        I_LOG_ERROR("calloc\n");
+        return SIRIUS_ERR_MEMORY_ALLOC;
+    }
+
+    strncpy(p_f->path, p_cr->p_path, I_LOG_FILE_PATH_SIZE - 1);
+    p_f->cap = p_cr->buf_size ?
+        p_cr->buf_size : I_LOG_FILE_BUF_SIZE_DEF;
+    if (p_f->cap < I_LOG_FILE_BUF_SIZE_MIN) {
+        p_f->cap = I_LOG_FILE_BUF_SIZE_MIN;
+    }
+    p_f->flush_ms = p_cr->flush_ms ?
+        p_cr->flush_ms : I_LOG_FILE_FLUSH_MS_DEF;
+    p_f->rotate_size = p_cr->rotate_size;
+    p_f->rotate_sec = p_cr->rotate_sec;
+    p_f->retention = p_cr->retention;
+    if (p_f->rotate_sec) {
+        p_f->rotate_next = i_log_file_rotate_next(p_f->rotate_sec);
+    }
+
+    p_f->active.p_data = (char *)malloc(p_f->cap);
+    p_f->spare.p_data = (char *)malloc(p_f->cap);
+    p_f->fd = -1;
+    if (!(p_f->active.p_data) || !(p_f->spare.p_data)) {
+        I_LOG_ERROR("malloc\n");
+        i_log_file_free(p_f);
+        return SIRIUS_ERR_MEMORY_ALLOC;
+    }
+
+    p_f->fd = i_log_file_open(p_f->path, &(p_f->size));
+    if (-1 == p_f->fd) {
+        i_log_file_free(p_f);
+        return SIRIUS_ERR_RESOURCE_REQUEST;
+    }
+
+    /* the flush interval does not jump with the wall clock */
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&(p_f->mutex), NULL);
+    pthread_cond_init(&(p_f->cond_work), &attr);
+    pthread_cond_init(&(p_f->cond_free), &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (p_cr->sighup_reopen) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = i_log_file_sighup_handler;
+        sigemptyset(&(sa.sa_mask));
+        sa.sa_flags = SA_RESTART;
+        if (sigaction(SIGHUP, &sa, &(p_f->sighup_old))) {
+            I_LOG_WARN("sigaction: %s\n", strerror(errno));
+        } else {
+            p_f->sighup_reopen = true;
+        }
+    }
+
+    int ret = sirius_thread_internal_create(&(p_f->id), "sirius-logfile",
+        false, i_log_file_thd, (void *)p_f);
+    if (ret) {
+        I_LOG_ERROR("sirius_thread_internal_create: [%d]\n", ret);
+        if (p_f->sighup_reopen) {
+            (void)sigaction(SIGHUP, &(p_f->sighup_old), NULL);
+        }
+        pthread_cond_destroy(&(p_f->cond_free));
+        pthread_cond_destroy(&(p_f->cond_work));
+        pthread_mutex_destroy(&(p_f->mutex));
+        i_log_file_free(p_f);
+        return SIRIUS_ERR_RESOURCE_REQUEST;
+    }
+
+    g_f = p_f;
+    return SIRIUS_OK;
+}
@@ -0,0 +1,289 @@
+#include "sirius_errno.h"
+#include "sirius_log.h"
+#include "sirius_attributes.h"
+#include "sirius_config.h"
+
+#include "./internal/sirius_internal_log.h"
+
+/**
+ * the levels are configuration keys (`sirius_config.h`):
+ * "log.lv" for the modules without an override, "log.lv.rec" for
+ * the flight recorder and "log.lv.<module>" for each override,
+ * so they can also be changed with `echo config ...`.
+ *
+ * (1) `sirius_log_lv_threshold` is the highest level that any
+ *  module may print, the call-site macros compare against it
+ *  with a relaxed load, so a disabled call costs one load and
+ *  one branch. it is recomputed whenever a level key changes.
+ *
+ * (2) the module table maps a module name to its key, it is
+ *  only consulted by `sirius_log_print` once the threshold check
+ *  has passed. entries are appended by a single writer and never
+ *  removed until deinitialization.
+ *
+ * (3) each call site keeps the key it resolved together with the
+ *  table generation (`sirius_log_mod_t`), the table is searched
+ *  again only after an entry was added or the table was cleared.
+ */
+
+/* maximum number of modules with their own level */
+#define I_LOG_LV_MOD_MAX        (32)
+/* maximum length of a module name */
+#define I_LOG_LV_MOD_NAME_SIZE  (64)
+
+/* key names */
+#define I_LOG_LV_KEY            "log.lv"
+#define I_LOG_LV_KEY_REC        "log.lv.rec"
+#define I_LOG_LV_KEY_MOD        "log.lv."
+
+typedef struct {
+    char name[I_LOG_LV_MOD_NAME_SIZE];
+    /* configuration key */
+    int id;
+} i_log_lv_mod_t;
+
+typedef struct {
+    /* key of the modules without an override */
+    int id;
+
+    /* key of the level recorded by the flight recorder */
+    int rec_id;
+
+    /* number of published entries in `mods` */
+    atomic_uint mod_nr;
+    i_log_lv_mod_t mods[I_LOG_LV_MOD_MAX];
+    /* bumped after the table changes, never 0 */
+    atomic_uint gen;
+
+    /* serializes the writers */
+    pthread_mutex_t mutex;
+} i_log_lv_t;
+
+static i_log_lv_t g_l = {
+    .id = -1,
+    .rec_id = -1,
+    .gen = 1,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+int sirius_log_lv_threshold = SIRIUS_LOG_LV_0;
+
+/**
+ * @note called by the configuration writer
+ */
+static void
+i_log_lv_threshold_update(long long val)
+{
+    (void)val;
+
+    int thr = (int)sirius_cfg_get(g_l.id);
+    int rec_lv = (int)sirius_cfg_get(g_l.rec_id);
+    thr = rec_lv > thr ? rec_lv : thr;
+    unsigned int nr = atomic_load_explicit(
+        &(g_l.mod_nr), memory_order_acquire);
+
+    for (unsigned int i = 0; i < nr; i++) {
+        int lv = (int)sirius_cfg_get(g_l.mods[i].id);
+        thr = lv > thr ? lv : thr;
+    }
+
+    __atomic_store_n(&sirius_log_lv_threshold, thr, __ATOMIC_RELAXED);
+}
+
+static int
+i_log_lv_key(const char *p_name)
+{
+    sirius_cfg_attr_t attr = {
+        .p_name = p_name,
+        .def = SIRIUS_LOG_LV_0,
+        .min = SIRIUS_LOG_LV_0,
+        .max = SIRIUS_LOG_LV_MAX - 1,
+        .p_notify = i_log_lv_threshold_update,
+    };
+    return sirius_cfg_register(&attr);
+}
+
+/**
+ * @note called with the writer lock held
+ */
+static int
+i_log_lv_keys()
+{
+    if (g_l.id < 0) {
+        int id = i_log_lv_key(I_LOG_LV_KEY);
+        if (id < 0) return id;
+        g_l.id = id;
+    }
+    if (g_l.rec_id < 0) {
+        int id = i_log_lv_key(I_LOG_LV_KEY_REC);
+        if (id < 0) return id;
+        g_l.rec_id = id;
+    }
+    return SIRIUS_OK;
+}
+
+/**
+ * @return the level key of a module, the default one
+ *  if it has no override
+ */
+static int
+i_log_lv_find(const char *p_mod)
+{
+    unsigned int nr = atomic_load_explicit(
+        &(g_l.mod_nr), memory_order_acquire);
+
+    if (p_mod) {
+        for (unsigned int i = 0; i < nr; i++) {
+            if (!(strcmp(g_l.mods[i].name, p_mod))) {
+                return g_l.mods[i].id;
+            }
+        }
+    }
+    return g_l.id;
+}
+
+static inline void
+i_log_lv_gen_bump()
+{
+    unsigned int gen = atomic_load_explicit(&(g_l.gen),
+        memory_order_relaxed) + 1;
+    atomic_store_explicit(&(g_l.gen), gen ? gen : 1, memory_order_release);
+}
+
+sirius_log_lv_t
+sirius_log_lv_get(const char *p_mod)
+{
+    int id = i_log_lv_find(p_mod);
+    if (unlikely(id < 0)) return SIRIUS_LOG_LV_0;
+    return (sirius_log_lv_t)sirius_cfg_get(id);
+}
+
+sirius_log_lv_t
+sirius_log_lv_mod_get(sirius_log_mod_t *p_mod)
+{
+    /* loaded before the search, a change during it is seen next time */
+    unsigned int gen = atomic_load_explicit(&(g_l.gen),
+        memory_order_acquire);
+    unsigned long long key = __atomic_load_n(&(p_mod->key),
+        __ATOMIC_RELAXED);
+
+    if (unlikely((unsigned int)(key >> 32) != gen)) {
+        int id = i_log_lv_find(p_mod->p_name);
+        if (unlikely(id < 0)) return SIRIUS_LOG_LV_0;
+        key = ((unsigned long long)gen << 32) | (unsigned int)(id + 1);
+        __atomic_store_n(&(p_mod->key), key, __ATOMIC_RELAXED);
+    }
+
+    return (sirius_log_lv_t)sirius_cfg_get((int)(unsigned int)key - 1);
+}
+
+int
+sirius_log_lv_set(const char *p_mod, sirius_log_lv_t log_lv)
+{
+    if ((SIRIUS_LOG_LV_0 > (int)log_lv) ||
+        (SIRIUS_LOG_LV_MAX <= log_lv)) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    int id;
+    pthread_mutex_lock(&(g_l.mutex));
+
+    int ret = i_log_lv_keys();
+    if (ret) goto label_unlock;
+
+    if (!(p_mod)) {
+        id = g_l.id;
+        goto label_update;
+    }
+
+    unsigned int nr = atomic_load_explicit(
+        &(g_l.mod_nr), memory_order_relaxed);
+    for (unsigned int i = 0; i < nr; i++) {
+        if (!(strcmp(g_l.mods[i].name, p_mod))) {
+            id = g_l.mods[i].id;
+            goto label_update;
+        }
+    }
+
+    if (I_LOG_LV_MOD_MAX == nr) {
+        ret = SIRIUS_ERR_CACHE_OVERFLOW;
+        goto label_unlock;
+    }
+    if (strlen(p_mod) >= I_LOG_LV_MOD_NAME_SIZE) {
+        ret = SIRIUS_ERR_INVALID_PARAMETER;
+        goto label_unlock;
+    }
+
+    char key[SIRIUS_CFG_NAME_SIZE];
+    snprintf(key, sizeof(key), I_LOG_LV_KEY_MOD "%s", p_mod);
+    id = i_log_lv_key(key);
+    if (id < 0) {
+        ret = id;
+        goto label_unlock;
+    }
+
+    i_log_lv_mod_t *p_m = &(g_l.mods[nr]);
+    strncpy(p_m->name, p_mod, I_LOG_LV_MOD_NAME_SIZE - 1);
+    p_m->id = id;
+    /* publish the entry, the level is set below */
+    atomic_store_explicit(&(g_l.mod_nr), nr + 1, memory_order_release);
+    i_log_lv_gen_bump();
+
+label_update:
+    ret = sirius_cfg_set(id, log_lv);
+label_unlock:
+    pthread_mutex_unlock(&(g_l.mutex));
+    return ret;
+}
+
+void
+sirius_log_lv_rec_set(sirius_log_lv_t log_lv)
+{
+    if ((SIRIUS_LOG_LV_0 > (int)log_lv) ||
+        (SIRIUS_LOG_LV_MAX <= log_lv)) {
+        log_lv = SIRIUS_LOG_LV_0;
+    }
+
+    pthread_mutex_lock(&(g_l.mutex));
+    if (!(i_log_lv_keys())) {
+        (void)sirius_cfg_set(g_l.rec_id, log_lv);
+    }
+    pthread_mutex_unlock(&(g_l.mutex));
+}
+
+sirius_log_lv_t
+sirius_log_lv_rec_get()
+{
+    if (unlikely(g_l.rec_id < 0)) return SIRIUS_LOG_LV_0;
+    return (sirius_log_lv_t)sirius_cfg_get(g_l.rec_id);
+}
+
+void
+sirius_log_lv_deinit()
+{
+    pthread_mutex_lock(&(g_l.mutex));
+    /* the keys stay registered, they are reused on the next init */
+    unsigned int nr = atomic_load_explicit(
+        &(g_l.mod_nr), memory_order_relaxed);
+    atomic_store_explicit(&(g_l.mod_nr), 0, memory_order_release);
+    i_log_lv_gen_bump();
+    for (unsigned int i = 0; i < nr; i++) {
+        (void)sirius_cfg_set(g_l.mods[i].id, SIRIUS_LOG_LV_0);
+    }
+    memset(g_l.mods, 0, sizeof(g_l.mods));
+    if (g_l.id >= 0) (void)sirius_cfg_set(g_l.id, SIRIUS_LOG_LV_0);
+    if (g_l.rec_id >= 0) (void)sirius_cfg_set(g_l.rec_id, SIRIUS_LOG_LV_0);
+    __atomic_store_n(&sirius_log_lv_threshold,
+        SIRIUS_LOG_LV_0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&(g_l.mutex));
+}
+
+void
+sirius_log_lv_init(sirius_log_lv_t log_lv)
+{
+    if ((SIRIUS_LOG_LV_0 > (int)log_lv) ||
+        (SIRIUS_LOG_LV_MAX <= log_lv)) {
+        log_lv = SIRIUS_LOG_LV_DEFAULT;
+    }
+    (void)sirius_log_lv_set(NULL, log_lv);
+}
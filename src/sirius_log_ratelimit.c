@@ -0,0 +1,53 @@
+#include "sirius_errno.h"
+#include "sirius_log.h"
+#include "sirius_attributes.h"
+#include "sirius_time.h"
+
+#include "./internal/sirius_internal_log.h"
+
+/**
+ * the token bucket is kept as a single "theoretical arrival time"
+ * (GCRA): every record pushes it forward by `interval / burst`,
+ * and a record is allowed while it stays within `interval` of
+ * the current time. the state is one 64-bit word, so an allowed
+ * record costs one load and one CAS, a limited record one load,
+ * the increment of the call site's `missed` and one relaxed add on
+ * the thread's shard of the dropped counter.
+ * 
+ * the time is `sirius_time_ns`: the coarse clock ticks every 1-4 ms,
+ * a step of `interval / burst` below that would be rounded to a tick.
+ */
+
+int
+sirius_log_ratelimit(sirius_log_rl_t *p_rl,
+    unsigned int interval_ms, unsigned int burst)
+{
+    if (unlikely(0 == interval_ms || 0 == burst)) return 0;
+
+    unsigned long long interval =
+        (unsigned long long)interval_ms * 1000000ULL;
+    unsigned long long step = interval / burst;
+    unsigned long long now = sirius_time_ns();
+    unsigned long long tat =
+        __atomic_load_n(&(p_rl->tat), __ATOMIC_RELAXED);
+
+    while (true) {
+        unsigned long long base = tat > now ? tat : now;
+        if (unlikely(base + step - now > interval)) {
+            __atomic_fetch_add(&(p_rl->missed), 1, __ATOMIC_RELAXED);
+            sirius_log_ratelimit_drop();
+            return -1;
+        }
+
+        if (likely(__atomic_compare_exchange_n(&(p_rl->tat),
+                &tat, base + step, false,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED))) {
+            break;
+        }
+    }
+
+    if (likely(0 == __atomic_load_n(&(p_rl->missed), __ATOMIC_RELAXED))) {
+        return 0;
+    }
+    return (int)__atomic_exchange_n(&(p_rl->missed), 0, __ATOMIC_RELAXED);
+}
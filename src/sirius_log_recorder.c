@@ -0,0 +1,375 @@
+#include "sirius_errno.h"
+#include "sirius_log.h"
+#include "sirius_attributes.h"
+#include "sirius_time.h"
+
+#include "./internal/sirius_internal_log.h"
+#include "./internal/sirius_internal_log_rec.h"
+
+#include <signal.h>
+#include <sys/mman.h>
+
+/**
+ * the flight recorder keeps the most recent records in a ring of
+ * fixed-size slots, split into slices, the layout is described in
+ * `sirius_internal_log_rec.h`. a thread picks a slice on its first
+ * record and from then on a record is a fetch-add on the slice
+ * position, a CAS claiming the slot, a memcpy with a cycle stamp
+ * and a release store of the slot sequence; no lock is taken and
+ * no cache line is shared with the other slices.
+ *
+ * when the ring lives in a file mapped with `MAP_SHARED`, the
+ * records are in the page cache and survive a crash of the
+ * process even without a dump. the ring of the previous run is
+ * renamed to `<path>.1` at initialization, `sirius_logrec` reads
+ * either file.
+ *
+ * the dump collects the published slots into an index allocated
+ * at initialization, heapsorts it by stamp and writes the
+ * records with `write`, so it can be called from a signal handler.
+ * one dump runs at a time.
+ */
+
+/* default and limits of the slot size */
+#define I_LOG_REC_SLOT_SIZE_DEF (1024)
+#define I_LOG_REC_SLOT_SIZE_MIN (64)
+#define I_LOG_REC_SLOT_SIZE_MAX (65536)
+/* default number of slices */
+#define I_LOG_REC_SLICE_NR_DEF  (8)
+/* minimum number of slots of a slice */
+#define I_LOG_REC_SLICE_MIN     (16)
+
+typedef struct {
+    i_log_rec_hdr_t *p_hdr;
+    size_t map_size;
+
+    /* number of slices */
+    unsigned int slice_nr;
+    /* slots per slice */
+    unsigned int slot_nr;
+    /* room for a record */
+    size_t cap;
+
+    /* round robin of the slice assignment */
+    atomic_uint slice_next;
+
+    /* index and copy buffer of the dump, taken with `dumping` */
+    atomic_flag dumping;
+    i_log_rec_ent_t *p_ent;
+    char *p_buf;
+
+    /* dump path, stderr when empty */
+    char dump_path[256];
+
+    bool crash_dump;
+    struct sigaction sigsegv_old;
+    struct sigaction sigabrt_old;
+    struct sigaction sigbus_old;
+} i_log_rec_t;
+
+static i_log_rec_t *g_r = NULL;
+
+/* changes on every initialization, invalidates the cached slices */
+static atomic_uint g_gen = 0;
+
+static __thread struct {
+    unsigned int gen;
+    unsigned int slice;
+} i_log_rec_tls = {0};
+
+void
+sirius_log_rec_write(const struct iovec *p_iov, int iov_nr)
+{
+    i_log_rec_t *p_r = g_r;
+    if (unlikely(!(p_r))) return;
+
+    unsigned int gen = atomic_load_explicit(&g_gen, memory_order_relaxed);
+    if (unlikely(i_log_rec_tls.gen != gen)) {
+        i_log_rec_tls.slice = atomic_fetch_add_explicit(
+            &(p_r->slice_next), 1, memory_order_relaxed) %
+            p_r->slice_nr;
+        i_log_rec_tls.gen = gen;
+    }
+
+    i_log_rec_hdr_t *p_hdr = p_r->p_hdr;
+    unsigned int s = i_log_rec_tls.slice;
+    unsigned long long pos = atomic_fetch_add_explicit(
+        &(p_hdr->slices[s].pos), 1, memory_order_relaxed);
+    i_log_rec_slot_t *p_slot = i_log_rec_slot(p_hdr,
+        (size_t)s * p_r->slot_nr + pos % p_r->slot_nr);
+
+    /* another writer is in the slot, two copies would tear it */
+    unsigned long long cur = atomic_load_explicit(&(p_slot->seq),
+        memory_order_relaxed);
+    if (unlikely((cur & I_LOG_REC_BUSY) ||
+        !(atomic_compare_exchange_strong_explicit(&(p_slot->seq),
+            &cur, I_LOG_REC_BUSY,
+            memory_order_relaxed, memory_order_relaxed)))) {
+        atomic_fetch_add_explicit(&(p_hdr->busy_nr), 1,
+            memory_order_relaxed);
+        return;
+    }
+    atomic_thread_fence(memory_order_release);
+
+    if (unlikely(sirius_log_iov_len(p_iov, iov_nr) > p_r->cap)) {
+        atomic_fetch_add_explicit(&(p_hdr->trunc_nr), 1,
+            memory_order_relaxed);
+    }
+
+    p_slot->stamp = sirius_time_cycles();
+    size_t len = sirius_log_iov_gather(p_slot->data, p_r->cap,
+        p_iov, iov_nr);
+    p_slot->len = (uint32_t)len;
+    atomic_store_explicit(&(p_slot->seq), I_LOG_REC_SEQ(pos),
+        memory_order_release);
+}
+
+/**
+ * @note async-signal-safe
+ */
+static int
+i_log_rec_dump(i_log_rec_t *p_r, const char *p_path)
+{
+    if (atomic_flag_test_and_set_explicit(
+            &(p_r->dumping), memory_order_acquire)) {
+        return SIRIUS_ERR_RESOURCE_REQUEST;
+    }
+
+    int fd = STDERR_FILENO;
+    if (p_path && p_path[0]) {
+        fd = open(p_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+            S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (-1 == fd) {
+            atomic_flag_clear_explicit(&(p_r->dumping),
+                memory_order_release);
+            return SIRIUS_ERR_RESOURCE_REQUEST;
+        }
+    }
+
+    static const char head[] = "---- sirius flight recorder ----\n";
+    (void)!write(fd, head, sizeof(head) - 1);
+
+    size_t n = i_log_rec_collect(p_r->p_hdr, p_r->p_ent);
+    i_log_rec_sort(p_r->p_ent, n);
+    (void)i_log_rec_emit(p_r->p_hdr, fd, p_r->p_ent, n, p_r->p_buf);
+
+    if (STDERR_FILENO != fd) close(fd);
+    atomic_flag_clear_explicit(&(p_r->dumping), memory_order_release);
+    return SIRIUS_OK;
+}
+
+int
+sirius_log_rec_dump(const char *p_path)
+{
+    i_log_rec_t *p_r = g_r;
+    if (!(p_r)) return SIRIUS_ERR_NOT_INIT;
+
+    return i_log_rec_dump(p_r, p_path ? p_path : p_r->dump_path);
+}
+
+static void
+i_log_rec_crash_handler(int sig)
+{
+    i_log_rec_t *p_r = g_r;
+    if (p_r) {
+        (void)i_log_rec_dump(p_r, p_r->dump_path);
+
+        /* let the previous disposition handle the signal */
+        switch (sig) {
+            case SIGSEGV:
+                sigaction(SIGSEGV, &(p_r->sigsegv_old), NULL);
+                break;
+            case SIGABRT:
+                sigaction(SIGABRT, &(p_r->sigabrt_old), NULL);
+                break;
+            case SIGBUS:
+                sigaction(SIGBUS, &(p_r->sigbus_old), NULL);
+                break;
+            default:
+                signal(sig, SIG_DFL);
+                break;
+        }
+    } else {
+        signal(sig, SIG_DFL);
+    }
+
+    raise(sig);
+}
+
+static void
+i_log_rec_signal_install(i_log_rec_t *p_r)
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = i_log_rec_crash_handler;
+    sigemptyset(&(sa.sa_mask));
+    sa.sa_flags = SA_RESETHAND | SA_NODEFER;
+
+    if (sigaction(SIGSEGV, &sa, &(p_r->sigsegv_old)) ||
+        sigaction(SIGABRT, &sa, &(p_r->sigabrt_old)) ||
+        sigaction(SIGBUS, &sa, &(p_r->sigbus_old))) {
+        I_LOG_WARN("sigaction: %s\n", strerror(errno));
+        return;
+    }
+    p_r->crash_dump = true;
+}
+
+static void
+i_log_rec_signal_restore(i_log_rec_t *p_r)
+{
+    if (!(p_r->crash_dump)) return;
+
+    (void)sigaction(SIGSEGV, &(p_r->sigsegv_old), NULL);
+    (void)sigaction(SIGABRT, &(p_r->sigabrt_old), NULL);
+    (void)sigaction(SIGBUS, &(p_r->sigbus_old), NULL);
+    p_r->crash_dump = false;
+}
+
+void
+sirius_log_rec_deinit()
+{
+    i_log_rec_t *p_r = g_r;
+    if (!(p_r)) return;
+
+    i_log_rec_signal_restore(p_r);
+    g_r = NULL;
+    atomic_fetch_add_explicit(&g_gen, 1, memory_order_relaxed);
+
+    /**
+     * a thread that already loaded `g_r` may still be writing,
+     * the mapping is left to the caller's quiescence like the
+     * other sinks of the log module
+     */
+    munmap(p_r->p_hdr, p_r->map_size);
+    free(p_r->p_ent);
+    free(p_r->p_buf);
+    free(p_r);
+}
+
+/**
+ * @brief map the ring backed by `p_path`, the ring of the previous
+ *  run is kept as `<path>.1`
+ */
+static void *
+i_log_rec_map_file(const char *p_path, size_t size)
+{
+    char old[PATH_MAX];
+    if ((size_t)snprintf(old, sizeof(old), "%s.1", p_path) >= sizeof(old)) {
+        I_LOG_ERROR("path too long [%s]\n", p_path);
+        return MAP_FAILED;
+    }
+    if (rename(p_path, old) && ENOENT != errno) {
+        I_LOG_WARN("rename [%s]: %s\n", p_path, strerror(errno));
+    }
+
+    int fd = open(p_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (-1 == fd) {
+        I_LOG_ERROR("open [%s]: %s\n", p_path, strerror(errno));
+        return MAP_FAILED;
+    }
+
+    void *p_map = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size)) {
+        I_LOG_ERROR("ftruncate [%s]: %s\n", p_path, strerror(errno));
+    } else {
+        p_map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+        if (MAP_FAILED == p_map) {
+            I_LOG_ERROR("mmap: %s\n", strerror(errno));
+        }
+    }
+    close(fd);
+    return p_map;
+}
+
+int
+sirius_log_rec_init(const sirius_log_recorder_t *p_cr)
+{
+    if (g_r) return SIRIUS_ERR_INIT_REPEATED;
+    if (!(p_cr) || 0 == p_cr->size) return SIRIUS_ERR_INVALID_ENTRY;
+
+    i_log_rec_t *p_r = (i_log_rec_t *)calloc(1, sizeof(i_log_rec_t));
+    if (!(p_r)) {
+        I_LOG_ERROR("calloc\n");
+        return SIRIUS_ERR_MEMORY_ALLOC;
+    }
+    atomic_flag_clear(&(p_r->dumping));
+    int ret = SIRIUS_ERR_RESOURCE_REQUEST;
+
+    p_r->slice_nr = p_cr->slice_nr ?
+        p_cr->slice_nr : I_LOG_REC_SLICE_NR_DEF;
+    if (p_r->slice_nr > I_LOG_REC_SLICE_NR_MAX) {
+        p_r->slice_nr = I_LOG_REC_SLICE_NR_MAX;
+    }
+
+    size_t slot_size = p_cr->slot_size ?
+        p_cr->slot_size : I_LOG_REC_SLOT_SIZE_DEF;
+    if (slot_size < I_LOG_REC_SLOT_SIZE_MIN) {
+        slot_size = I_LOG_REC_SLOT_SIZE_MIN;
+    } else if (slot_size > I_LOG_REC_SLOT_SIZE_MAX) {
+        slot_size = I_LOG_REC_SLOT_SIZE_MAX;
+    }
+    /* keep the slot sequences aligned */
+    slot_size = (slot_size + 7) & ~(size_t)7;
+    p_r->cap = slot_size - sizeof(i_log_rec_slot_t);
+
+    size_t slot_total = p_cr->size / slot_size;
+    p_r->slot_nr = slot_total / p_r->slice_nr;
+    if (p_r->slot_nr < I_LOG_REC_SLICE_MIN) {
+        p_r->slot_nr = I_LOG_REC_SLICE_MIN;
+    }
+    slot_total = (size_t)p_r->slot_nr * p_r->slice_nr;
+    p_r->map_size = sizeof(i_log_rec_hdr_t) + slot_total * slot_size;
+
+    p_r->p_ent = (i_log_rec_ent_t *)malloc(
+        slot_total * sizeof(i_log_rec_ent_t));
+    p_r->p_buf = (char *)malloc(slot_size);
+    if (!(p_r->p_ent) || !(p_r->p_buf)) {
+        I_LOG_ERROR("malloc\n");
+        ret = SIRIUS_ERR_MEMORY_ALLOC;
+        goto label_free;
+    }
+
+    void *p_map = MAP_FAILED;
+    if (p_cr->p_path && p_cr->p_path[0]) {
+        p_map = i_log_rec_map_file(p_cr->p_path, p_r->map_size);
+    } else {
+        p_map = mmap(NULL, p_r->map_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == p_map) {
+            I_LOG_ERROR("mmap: %s\n", strerror(errno));
+        }
+    }
+    if (MAP_FAILED == p_map) goto label_free;
+
+    /* the mapping is zero-filled, every slot is empty */
+    p_r->p_hdr = (i_log_rec_hdr_t *)p_map;
+    p_r->p_hdr->version = I_LOG_REC_VERSION;
+    p_r->p_hdr->slot_size = (uint32_t)slot_size;
+    p_r->p_hdr->slice_nr = p_r->slice_nr;
+    p_r->p_hdr->slot_nr = p_r->slot_nr;
+    /* readers check the magic last */
+    atomic_thread_fence(memory_order_release);
+    p_r->p_hdr->magic = I_LOG_REC_MAGIC;
+
+    if (p_cr->p_dump) {
+        strncpy(p_r->dump_path, p_cr->p_dump,
+            sizeof(p_r->dump_path) - 1);
+    }
+
+    atomic_fetch_add_explicit(&g_gen, 1, memory_order_relaxed);
+    g_r = p_r;
+
+    if (p_cr->crash_dump) {
+        i_log_rec_signal_install(p_r);
+    }
+
+    return SIRIUS_OK;
+
+label_free:
+    free(p_r->p_ent);
+    free(p_r->p_buf);
+    free(p_r);
+    return ret;
+}
@@ -0,0 +1,184 @@
+#include "sirius_errno.h"
+#include "sirius_log.h"
+#include "sirius_attributes.h"
+
+#include "./internal/sirius_internal_log.h"
+#include "./internal/sirius_internal_log_shm.h"
+
+/* default size of the ring */
+#define I_LOG_SHM_SIZE_DEF      (4 * 1024 * 1024)
+/* default size of a slot */
+#define I_LOG_SHM_SLOT_DEF      (512)
+/* minimum size of a slot */
+#define I_LOG_SHM_SLOT_MIN      (128)
+/* the object name length */
+#define I_LOG_SHM_NAME_SIZE     (256)
+
+typedef struct {
+    i_log_shm_hdr_t *p_hdr;
+    size_t map_size;
+    char name[I_LOG_SHM_NAME_SIZE];
+    /* identity of the object, the name may be taken over later */
+    dev_t dev;
+    ino_t ino;
+} i_log_shm_t;
+
+static i_log_shm_t *g_s = NULL;
+
+int
+sirius_log_shm_write(sirius_log_lv_t log_lv,
+    const struct iovec *p_iov, int iov_nr)
+{
+    i_log_shm_t *p_s = g_s;
+    if (unlikely(!(p_s))) return SIRIUS_ERR_NOT_INIT;
+
+    i_log_shm_hdr_t *p_hdr = p_s->p_hdr;
+    unsigned long long pos = atomic_fetch_add_explicit(
+        &(p_hdr->head), 1, memory_order_relaxed);
+    i_log_shm_slot_t *p_slot = i_log_shm_slot(p_hdr, pos);
+
+    size_t cap = p_hdr->slot_size - sizeof(i_log_shm_slot_t);
+    if (unlikely(sirius_log_iov_len(p_iov, iov_nr) > cap)) {
+        atomic_fetch_add_explicit(&(p_hdr->trunc_nr), 1,
+            memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&(p_slot->seq), 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    size_t len = sirius_log_iov_gather(p_slot->data, cap,
+        p_iov, iov_nr);
+    p_slot->len = (uint32_t)len;
+    p_slot->lv = (uint32_t)log_lv;
+    atomic_store_explicit(&(p_slot->seq), pos + 1,
+        memory_order_release);
+
+    if (unlikely(atomic_load_explicit(
+            &(p_hdr->waiters), memory_order_seq_cst))) {
+        atomic_fetch_add_explicit(&(p_hdr->notify), 1,
+            memory_order_seq_cst);
+        (void)i_log_shm_futex(&(p_hdr->notify),
+            FUTEX_WAKE, INT_MAX, NULL);
+    }
+
+    return SIRIUS_OK;
+}
+
+void
+sirius_log_shm_stats()
+{
+    i_log_shm_t *p_s = g_s;
+    if (!(p_s)) return;
+
+    I_LOG_INFO("shm [%s]: slots %u x %u, written %llu, "
+        "truncated %llu\n",
+        p_s->name, p_s->p_hdr->slot_nr, p_s->p_hdr->slot_size,
+        atomic_load_explicit(&(p_s->p_hdr->head),
+            memory_order_relaxed),
+        atomic_load_explicit(&(p_s->p_hdr->trunc_nr),
+            memory_order_relaxed));
+}
+
+void
+sirius_log_shm_deinit()
+{
+    i_log_shm_t *p_s = g_s;
+    if (!(p_s)) return;
+
+    g_s = NULL;
+    munmap(p_s->p_hdr, p_s->map_size);
+
+    /**
+     * readers that still map the object keep their view; the name is
+     * left alone if another writer has created its own object since
+     */
+    struct stat st;
+    int fd = shm_open(p_s->name, O_RDONLY, 0);
+    if (-1 != fd) {
+        if (0 == fstat(fd, &st) &&
+            st.st_dev == p_s->dev && st.st_ino == p_s->ino) {
+            (void)shm_unlink(p_s->name);
+        }
+        close(fd);
+    }
+    free(p_s);
+}
+
+int
+sirius_log_shm_init(const sirius_log_shm_t *p_cr)
+{
+    if (g_s) return SIRIUS_ERR_INIT_REPEATED;
+    if (!(p_cr)) return SIRIUS_ERR_INVALID_ENTRY;
+
+    i_log_shm_t *p_s = (i_log_shm_t *)calloc(1, sizeof(i_log_shm_t));
+    if (!(p_s)) {
+        I_LOG_ERROR("calloc\n");
+        return SIRIUS_ERR_MEMORY_ALLOC;
+    }
+
+    strncpy(p_s->name,
+        (p_cr->p_name && p_cr->p_name[0]) ?
+            p_cr->p_name : I_LOG_SHM_NAME_DEF,
+        I_LOG_SHM_NAME_SIZE - 1);
+
+    size_t slot_size = p_cr->slot_size ?
+        p_cr->slot_size : I_LOG_SHM_SLOT_DEF;
+    if (slot_size < I_LOG_SHM_SLOT_MIN) {
+        slot_size = I_LOG_SHM_SLOT_MIN;
+    }
+    /* keep the slot sequence aligned */
+    slot_size = (slot_size + 7) & ~(size_t)7;
+
+    size_t size = p_cr->size ? p_cr->size : I_LOG_SHM_SIZE_DEF;
+    size_t slot_nr = size / slot_size;
+    if (slot_nr < 2) slot_nr = 2;
+    p_s->map_size = sizeof(i_log_shm_hdr_t) + slot_nr * slot_size;
+
+    /**
+     * never truncate an object in use: a reader still mapping it would
+     * fault and two writers would share one ring. the old object is
+     * unlinked, those mapping it keep it until they unmap, and a new
+     * one is created under the name
+     */
+    (void)shm_unlink(p_s->name);
+    int fd = shm_open(p_s->name, O_RDWR | O_CREAT | O_EXCL,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (-1 == fd) {
+        I_LOG_ERROR("shm_open [%s]: %s\n",
+            p_s->name, strerror(errno));
+        free(p_s);
+        return SIRIUS_ERR_RESOURCE_REQUEST;
+    }
+
+    struct stat st = {0};
+    void *p_map = MAP_FAILED;
+    if (fstat(fd, &st)) {
+        I_LOG_ERROR("fstat [%s]: %s\n",
+            p_s->name, strerror(errno));
+    } else if (ftruncate(fd, p_s->map_size)) {
+        I_LOG_ERROR("ftruncate [%s]: %s\n",
+            p_s->name, strerror(errno));
+    } else {
+        p_map = mmap(NULL, p_s->map_size,
+            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    p_s->dev = st.st_dev;
+    p_s->ino = st.st_ino;
+    if (MAP_FAILED == p_map) {
+        I_LOG_ERROR("mmap [%s]: %s\n", p_s->name, strerror(errno));
+        (void)shm_unlink(p_s->name);
+        free(p_s);
+        return SIRIUS_ERR_RESOURCE_REQUEST;
+    }
+
+    p_s->p_hdr = (i_log_shm_hdr_t *)p_map;
+    p_s->p_hdr->version = I_LOG_SHM_VERSION;
+    p_s->p_hdr->slot_size = (uint32_t)slot_size;
+    p_s->p_hdr->slot_nr = (uint32_t)slot_nr;
+    /* readers check the magic last */
+    atomic_thread_fence(memory_order_release);
+    p_s->p_hdr->magic = I_LOG_SHM_MAGIC;
+
+    g_s = p_s;
+    return SIRIUS_OK;
+}
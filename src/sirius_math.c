@@ -40,7 +40,7 @@ sirius_math_max_dbl(unsigned int args_num, ...)
     va_list args;
     va_start(args, args_num);
 
-    double max_val = DBL_MIN;
+    double max_val = -INFINITY;
     for (unsigned int i = 0; i < args_num; i++) {
         double arg = va_arg(args, double);
         max_val = arg > max_val ? arg : max_val;
@@ -56,7 +56,7 @@ sirius_math_min_dbl(unsigned int args_num, ...)
     va_list args;
     va_start(args, args_num);
 
-    double min_val = DBL_MAX;
+    double min_val = INFINITY;
     for (unsigned int i = 0; i < args_num; i++) {
         double arg = va_arg(args, double);
         min_val = arg < min_val ? arg : min_val;
@@ -0,0 +1,757 @@
+#include "sirius_math.h"
+#include "sirius_errno.h"
+#include "sirius_attributes.h"
+#include "sirius_cpu.h"
+
+#include "./internal/sirius_internal_math.h"
+
+/**
+ * every kernel keeps 4 independent accumulators, so the loop is
+ * bound by the loads rather than by the latency of min/max, and
+ * reduces them to a scalar at the end. the tail is done by the
+ * scalar loop.
+ *
+ * the instruction set is chosen once at load time from sirius_cpu:
+ * avx512 (F + BW), avx2, sse2 or the scalar loop. the kernels are
+ * compiled with `target` attributes, so the library itself needs
+ * no extra compiler flags.
+ *
+ * operations missing from an instruction set are emulated:
+ * sse2 has no signed 8-bit, unsigned 16-bit nor 32-bit min/max,
+ * avx2 has no 64-bit min/max; sse2 has no 64-bit compare at all,
+ * so the 64-bit kernels fall back to the scalar loop there.
+ *
+ * the same vectors serve the shared kernels of the top-k selection:
+ * `above` / `below` look for the first element beating a threshold,
+ * 4 vectors at a time, and `network` is a bitonic sorting network.
+ * its compare-exchanges between vectors are plain min/max, those
+ * inside a vector permute the 32-bit lanes and blend the results;
+ * 8-bit and 16-bit elements use the scalar network.
+ */
+
+#define I_MATH_SMAX(a, b) ((a) > (b) ? (a) : (b))
+#define I_MATH_SMIN(a, b) ((a) < (b) ? (a) : (b))
+
+/* kernel table */
+
+#define I_MATH_FIELD(name, T, lo, hi) \
+    T (*max_##name)(const T *p_arr, size_t n); \
+    T (*min_##name)(const T *p_arr, size_t n); \
+    void (*minmax_##name)(const T *p_arr, size_t n, \
+        T *p_min, T *p_max); \
+    size_t (*above_##name)(const T *p_arr, size_t n, T thr); \
+    size_t (*below_##name)(const T *p_arr, size_t n, T thr); \
+    void (*network_##name)(T *p_arr, size_t nr);
+
+typedef struct {
+    const char *p_isa;
+    I_MATH_TYPES(I_MATH_FIELD)
+} i_math_kernel_t;
+
+static i_math_kernel_t g_m = {0};
+
+/* scalar */
+
+#define I_MATH_SCALAR(name, T, lo, hi) \
+static T \
+i_math_max_##name##_scalar(const T *p_arr, size_t n) \
+{ \
+    T r = p_arr[0]; \
+    for (size_t i = 1; i < n; i++) r = I_MATH_SMAX(r, p_arr[i]); \
+    return r; \
+} \
+static T \
+i_math_min_##name##_scalar(const T *p_arr, size_t n) \
+{ \
+    T r = p_arr[0]; \
+    for (size_t i = 1; i < n; i++) r = I_MATH_SMIN(r, p_arr[i]); \
+    return r; \
+} \
+static void \
+i_math_minmax_##name##_scalar(const T *p_arr, size_t n, \
+    T *p_min, T *p_max) \
+{ \
+    T mn = p_arr[0]; \
+    T mx = p_arr[0]; \
+    for (size_t i = 1; i < n; i++) { \
+        mn = I_MATH_SMIN(mn, p_arr[i]); \
+        mx = I_MATH_SMAX(mx, p_arr[i]); \
+    } \
+    *p_min = mn; \
+    *p_max = mx; \
+} \
+static size_t \
+i_math_above_##name##_scalar(const T *p_arr, size_t n, T thr) \
+{ \
+    for (size_t i = 0; i < n; i++) { \
+        if (p_arr[i] > thr) return i; \
+    } \
+    return n; \
+} \
+static size_t \
+i_math_below_##name##_scalar(const T *p_arr, size_t n, T thr) \
+{ \
+    for (size_t i = 0; i < n; i++) { \
+        if (p_arr[i] < thr) return i; \
+    } \
+    return n; \
+} \
+static void \
+i_math_network_##name##_scalar(T *p_arr, size_t nr) \
+{ \
+    for (size_t k = 2; k <= nr; k <<= 1) { \
+        for (size_t j = k >> 1; j > 0; j >>= 1) { \
+            for (size_t i = 0; i < nr; i++) { \
+                size_t l = i ^ j; \
+                if (l < i) continue; \
+                /* a tie keeps both elements, -0.0 and 0.0 included */ \
+                T mn = I_MATH_SMIN(p_arr[i], p_arr[l]); \
+                T mx = I_MATH_SMAX(p_arr[l], p_arr[i]); \
+                p_arr[i] = (i & k) ? mx : mn; \
+                p_arr[l] = (i & k) ? mn : mx; \
+            } \
+        } \
+    } \
+}
+
+I_MATH_TYPES(I_MATH_SCALAR)
+
+/**
+ * @param isa: suffix of the kernels
+ * @param attr: target attribute
+ * @param V: vector type
+ * @param LANES: elements per vector
+ * @param LOAD: unaligned load
+ * @param STORE: unaligned store
+ * @param VMAX: vector max
+ * @param VMIN: vector min
+ * 
+ * `I_MATH_LEAVE_<isa>` runs once the vectors are stored, `vzeroupper`
+ * for avx: the library may be built without optimization, and gcc
+ * only inserts it by itself when optimizing
+ * 
+ * `I_MATH_VI_<isa>` is the integer vector of the same width, the
+ * `i_<isa>_diff`, `i_<isa>_perm32` and `i_<isa>_sel32` helpers work
+ * on its bits whatever the element type
+ */
+#define I_MATH_KERNEL(isa, attr, name, T, V, LANES, \
+    LOAD, STORE, VMAX, VMIN) \
+static attr T \
+i_math_max_##name##_##isa(const T *p_arr, size_t n) \
+{ \
+    if (n < 4 * LANES) return i_math_max_##name##_scalar(p_arr, n); \
+    V v0 = LOAD(p_arr); \
+    V v1 = LOAD(p_arr + LANES); \
+    V v2 = LOAD(p_arr + 2 * LANES); \
+    V v3 = LOAD(p_arr + 3 * LANES); \
+    size_t i = 4 * LANES; \
+    for (; i + 4 * LANES <= n; i += 4 * LANES) { \
+        v0 = VMAX(v0, LOAD(p_arr + i)); \
+        v1 = VMAX(v1, LOAD(p_arr + i + LANES)); \
+        v2 = VMAX(v2, LOAD(p_arr + i + 2 * LANES)); \
+        v3 = VMAX(v3, LOAD(p_arr + i + 3 * LANES)); \
+    } \
+    v0 = VMAX(VMAX(v0, v1), VMAX(v2, v3)); \
+    T lanes[LANES]; \
+    STORE(lanes, v0); \
+    I_MATH_LEAVE_##isa; \
+    T r = lanes[0]; \
+    for (size_t k = 1; k < LANES; k++) r = I_MATH_SMAX(r, lanes[k]); \
+    for (; i < n; i++) r = I_MATH_SMAX(r, p_arr[i]); \
+    return r; \
+} \
+static attr T \
+i_math_min_##name##_##isa(const T *p_arr, size_t n) \
+{ \
+    if (n < 4 * LANES) return i_math_min_##name##_scalar(p_arr, n); \
+    V v0 = LOAD(p_arr); \
+    V v1 = LOAD(p_arr + LANES); \
+    V v2 = LOAD(p_arr + 2 * LANES); \
+    V v3 = LOAD(p_arr + 3 * LANES); \
+    size_t i = 4 * LANES; \
+    for (; i + 4 * LANES <= n; i += 4 * LANES) { \
+        v0 = VMIN(v0, LOAD(p_arr + i)); \
+        v1 = VMIN(v1, LOAD(p_arr + i + LANES)); \
+        v2 = VMIN(v2, LOAD(p_arr + i + 2 * LANES)); \
+        v3 = VMIN(v3, LOAD(p_arr + i + 3 * LANES)); \
+    } \
+    v0 = VMIN(VMIN(v0, v1), VMIN(v2, v3)); \
+    T lanes[LANES]; \
+    STORE(lanes, v0); \
+    I_MATH_LEAVE_##isa; \
+    T r = lanes[0]; \
+    for (size_t k = 1; k < LANES; k++) r = I_MATH_SMIN(r, lanes[k]); \
+    for (; i < n; i++) r = I_MATH_SMIN(r, p_arr[i]); \
+    return r; \
+} \
+static attr void \
+i_math_minmax_##name##_##isa(const T *p_arr, size_t n, \
+    T *p_min, T *p_max) \
+{ \
+    if (n < 2 * LANES) { \
+        i_math_minmax_##name##_scalar(p_arr, n, p_min, p_max); \
+        return; \
+    } \
+    V mn0 = LOAD(p_arr); \
+    V mn1 = LOAD(p_arr + LANES); \
+    V mx0 = mn0; \
+    V mx1 = mn1; \
+    size_t i = 2 * LANES; \
+    for (; i + 2 * LANES <= n; i += 2 * LANES) { \
+        V a = LOAD(p_arr + i); \
+        V b = LOAD(p_arr + i + LANES); \
+        mn0 = VMIN(mn0, a); \
+        mx0 = VMAX(mx0, a); \
+        mn1 = VMIN(mn1, b); \
+        mx1 = VMAX(mx1, b); \
+    } \
+    T lo[LANES], hi[LANES]; \
+    STORE(lo, VMIN(mn0, mn1)); \
+    STORE(hi, VMAX(mx0, mx1)); \
+    I_MATH_LEAVE_##isa; \
+    T mn = lo[0]; \
+    T mx = hi[0]; \
+    for (size_t k = 1; k < LANES; k++) { \
+        mn = I_MATH_SMIN(mn, lo[k]); \
+        mx = I_MATH_SMAX(mx, hi[k]); \
+    } \
+    for (; i < n; i++) { \
+        mn = I_MATH_SMIN(mn, p_arr[i]); \
+        mx = I_MATH_SMAX(mx, p_arr[i]); \
+    } \
+    *p_min = mn; \
+    *p_max = mx; \
+} \
+static attr size_t \
+i_math_above_##name##_##isa(const T *p_arr, size_t n, T thr) \
+{ \
+    T tv[LANES]; \
+    for (size_t k = 0; k < LANES; k++) tv[k] = thr; \
+    V t = LOAD(tv); \
+    size_t i = 0; \
+    for (; i + 4 * LANES <= n; i += 4 * LANES) { \
+        V m = VMAX(VMAX(LOAD(p_arr + i), LOAD(p_arr + i + LANES)), \
+            VMAX(LOAD(p_arr + i + 2 * LANES), \
+                LOAD(p_arr + i + 3 * LANES))); \
+        /* max(m, t) is `t` bit for bit unless a lane beats it */ \
+        if (i_##isa##_diff((I_MATH_VI_##isa)VMAX(m, t), \
+            (I_MATH_VI_##isa)t)) break; \
+    } \
+    I_MATH_LEAVE_##isa; \
+    for (; i < n; i++) { \
+        if (p_arr[i] > thr) return i; \
+    } \
+    return n; \
+} \
+static attr size_t \
+i_math_below_##name##_##isa(const T *p_arr, size_t n, T thr) \
+{ \
+    T tv[LANES]; \
+    for (size_t k = 0; k < LANES; k++) tv[k] = thr; \
+    V t = LOAD(tv); \
+    size_t i = 0; \
+    for (; i + 4 * LANES <= n; i += 4 * LANES) { \
+        V m = VMIN(VMIN(LOAD(p_arr + i), LOAD(p_arr + i + LANES)), \
+            VMIN(LOAD(p_arr + i + 2 * LANES), \
+                LOAD(p_arr + i + 3 * LANES))); \
+        if (i_##isa##_diff((I_MATH_VI_##isa)VMIN(m, t), \
+            (I_MATH_VI_##isa)t)) break; \
+    } \
+    I_MATH_LEAVE_##isa; \
+    for (; i < n; i++) { \
+        if (p_arr[i] < thr) return i; \
+    } \
+    return n; \
+} \
+static attr void \
+i_math_network_##name##_##isa(T *p_arr, size_t nr) \
+{ \
+    if (sizeof(T) < 4 || nr < LANES) { \
+        i_math_network_##name##_scalar(p_arr, nr); \
+        return; \
+    } \
+    /* 32-bit lanes per element */ \
+    const int s = sizeof(T) / 4; \
+    for (size_t k = 2; k <= nr; k <<= 1) { \
+        size_t j = k >> 1; \
+        /* partners in different vectors */ \
+        for (; j >= LANES; j >>= 1) { \
+            for (size_t i = 0; i < nr; i += LANES) { \
+                if (i & j) continue; \
+                V a = LOAD(p_arr + i); \
+                V b = LOAD(p_arr + i + j); \
+                V lo = VMIN(a, b); \
+                V hi = VMAX(b, a); \
+                STORE(p_arr + i, (i & k) ? hi : lo); \
+                STORE(p_arr + i + j, (i & k) ? lo : hi); \
+            } \
+        } \
+        /* partners in the same vector */ \
+        for (; j > 0; j >>= 1) { \
+            for (size_t i = 0; i < nr; i += LANES) { \
+                V v = LOAD(p_arr + i); \
+                V w = (V)i_##isa##_perm32((I_MATH_VI_##isa)v, j * s); \
+                V lo = VMIN(v, w); \
+                V hi = VMAX(v, w); \
+                STORE(p_arr + i, (V)i_##isa##_sel32( \
+                    (I_MATH_VI_##isa)lo, (I_MATH_VI_##isa)hi, \
+                    j * s, k * s, i * s)); \
+            } \
+        } \
+    } \
+    I_MATH_LEAVE_##isa; \
+}
+
+/* a kernel that is the scalar loop under another name */
+#define I_MATH_KERNEL_SCALAR(isa, name, T) \
+static T \
+i_math_max_##name##_##isa(const T *p_arr, size_t n) \
+{ \
+    return i_math_max_##name##_scalar(p_arr, n); \
+} \
+static T \
+i_math_min_##name##_##isa(const T *p_arr, size_t n) \
+{ \
+    return i_math_min_##name##_scalar(p_arr, n); \
+} \
+static void \
+i_math_minmax_##name##_##isa(const T *p_arr, size_t n, \
+    T *p_min, T *p_max) \
+{ \
+    i_math_minmax_##name##_scalar(p_arr, n, p_min, p_max); \
+} \
+static size_t \
+i_math_above_##name##_##isa(const T *p_arr, size_t n, T thr) \
+{ \
+    return i_math_above_##name##_scalar(p_arr, n, thr); \
+} \
+static size_t \
+i_math_below_##name##_##isa(const T *p_arr, size_t n, T thr) \
+{ \
+    return i_math_below_##name##_scalar(p_arr, n, thr); \
+} \
+static void \
+i_math_network_##name##_##isa(T *p_arr, size_t nr) \
+{ \
+    i_math_network_##name##_scalar(p_arr, nr); \
+}
+
+#ifdef I_MATH_X86
+
+/* sse2 */
+
+#define I_SSE2 __attribute__((target("sse2")))
+#define I_MATH_LEAVE_sse2   ((void)0)
+#define I_MATH_VI_sse2      __m128i
+
+#define I_SSE2_LD(p)        _mm_loadu_si128((const __m128i *)(p))
+#define I_SSE2_ST(p, v)     _mm_storeu_si128((__m128i *)(p), v)
+
+/* flip the sign bit, maps between signed and unsigned order */
+#define I_SSE2_FLIP(bits) \
+static I_SSE2 inline __m128i \
+i_sse2_flip##bits(__m128i v) \
+{ \
+    return _mm_xor_si128(v, _mm_set1_epi##bits( \
+        (int##bits##_t)(1ULL << (bits - 1)))); \
+}
+
+I_SSE2_FLIP(8)
+I_SSE2_FLIP(16)
+I_SSE2_FLIP(32)
+
+static I_SSE2 inline __m128i
+i_sse2_max_epi8(__m128i a, __m128i b)
+{
+    return i_sse2_flip8(_mm_max_epu8(i_sse2_flip8(a), i_sse2_flip8(b)));
+}
+
+static I_SSE2 inline __m128i
+i_sse2_min_epi8(__m128i a, __m128i b)
+{
+    return i_sse2_flip8(_mm_min_epu8(i_sse2_flip8(a), i_sse2_flip8(b)));
+}
+
+static I_SSE2 inline __m128i
+i_sse2_max_epu16(__m128i a, __m128i b)
+{
+    return i_sse2_flip16(_mm_max_epi16(i_sse2_flip16(a), i_sse2_flip16(b)));
+}
+
+static I_SSE2 inline __m128i
+i_sse2_min_epu16(__m128i a, __m128i b)
+{
+    return i_sse2_flip16(_mm_min_epi16(i_sse2_flip16(a), i_sse2_flip16(b)));
+}
+
+/* `m` ? a : b */
+static I_SSE2 inline __m128i
+i_sse2_select(__m128i m, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+/* any byte differs */
+static I_SSE2 inline int
+i_sse2_diff(__m128i a, __m128i b)
+{
+    return 0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+}
+
+/* swap the 32-bit lanes whose index differs in bit `j`, 1 or 2 */
+static I_SSE2 inline __m128i
+i_sse2_perm32(__m128i v, int j)
+{
+    return 1 == j ? _mm_shuffle_epi32(v, 0xB1) : _mm_shuffle_epi32(v, 0x4E);
+}
+
+/* lane `e` takes `hi` where bits `j` and `k` of `base + e` differ */
+static I_SSE2 inline __m128i
+i_sse2_sel32(__m128i lo, __m128i hi, int j, int k, int base)
+{
+    const __m128i z = _mm_setzero_si128();
+    __m128i e = _mm_add_epi32(_mm_setr_epi32(0, 1, 2, 3),
+        _mm_set1_epi32(base));
+    __m128i m = _mm_xor_si128(
+        _mm_cmpeq_epi32(_mm_and_si128(e, _mm_set1_epi32(j)), z),
+        _mm_cmpeq_epi32(_mm_and_si128(e, _mm_set1_epi32(k)), z));
+    return i_sse2_select(m, hi, lo);
+}
+
+static I_SSE2 inline __m128i
+i_sse2_max_epi32(__m128i a, __m128i b)
+{
+    return i_sse2_select(_mm_cmpgt_epi32(a, b), a, b);
+}
+
+static I_SSE2 inline __m128i
+i_sse2_min_epi32(__m128i a, __m128i b)
+{
+    return i_sse2_select(_mm_cmpgt_epi32(a, b), b, a);
+}
+
+static I_SSE2 inline __m128i
+i_sse2_max_epu32(__m128i a, __m128i b)
+{
+    return i_sse2_select(
+        _mm_cmpgt_epi32(i_sse2_flip32(a), i_sse2_flip32(b)), a, b);
+}
+
+static I_SSE2 inline __m128i
+i_sse2_min_epu32(__m128i a, __m128i b)
+{
+    return i_sse2_select(
+        _mm_cmpgt_epi32(i_sse2_flip32(a), i_sse2_flip32(b)), b, a);
+}
+
+I_MATH_KERNEL(sse2, I_SSE2, i8, int8_t, __m128i, 16,
+    I_SSE2_LD, I_SSE2_ST, i_sse2_max_epi8, i_sse2_min_epi8)
+I_MATH_KERNEL(sse2, I_SSE2, i16, int16_t, __m128i, 8,
+    I_SSE2_LD, I_SSE2_ST, _mm_max_epi16, _mm_min_epi16)
+I_MATH_KERNEL(sse2, I_SSE2, i32, int32_t, __m128i, 4,
+    I_SSE2_LD, I_SSE2_ST, i_sse2_max_epi32, i_sse2_min_epi32)
+I_MATH_KERNEL_SCALAR(sse2, i64, int64_t)
+I_MATH_KERNEL(sse2, I_SSE2, u8, uint8_t, __m128i, 16,
+    I_SSE2_LD, I_SSE2_ST, _mm_max_epu8, _mm_min_epu8)
+I_MATH_KERNEL(sse2, I_SSE2, u16, uint16_t, __m128i, 8,
+    I_SSE2_LD, I_SSE2_ST, i_sse2_max_epu16, i_sse2_min_epu16)
+I_MATH_KERNEL(sse2, I_SSE2, u32, uint32_t, __m128i, 4,
+    I_SSE2_LD, I_SSE2_ST, i_sse2_max_epu32, i_sse2_min_epu32)
+I_MATH_KERNEL_SCALAR(sse2, u64, uint64_t)
+I_MATH_KERNEL(sse2, I_SSE2, f32, float, __m128, 4,
+    _mm_loadu_ps, _mm_storeu_ps, _mm_max_ps, _mm_min_ps)
+I_MATH_KERNEL(sse2, I_SSE2, f64, double, __m128d, 2,
+    _mm_loadu_pd, _mm_storeu_pd, _mm_max_pd, _mm_min_pd)
+
+/* avx2 */
+
+#define I_AVX2 __attribute__((target("avx2")))
+#define I_MATH_LEAVE_avx2   _mm256_zeroupper()
+#define I_MATH_VI_avx2      __m256i
+
+#define I_AVX2_LD(p)        _mm256_loadu_si256((const __m256i *)(p))
+#define I_AVX2_ST(p, v)     _mm256_storeu_si256((__m256i *)(p), v)
+
+static I_AVX2 inline int
+i_avx2_diff(__m256i a, __m256i b)
+{
+    return -1 != _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+}
+
+static I_AVX2 inline __m256i
+i_avx2_perm32(__m256i v, int j)
+{
+    __m256i idx = _mm256_xor_si256(
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(j));
+    return _mm256_permutevar8x32_epi32(v, idx);
+}
+
+static I_AVX2 inline __m256i
+i_avx2_sel32(__m256i lo, __m256i hi, int j, int k, int base)
+{
+    const __m256i z = _mm256_setzero_si256();
+    __m256i e = _mm256_add_epi32(
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(base));
+    __m256i m = _mm256_xor_si256(
+        _mm256_cmpeq_epi32(_mm256_and_si256(e, _mm256_set1_epi32(j)), z),
+        _mm256_cmpeq_epi32(_mm256_and_si256(e, _mm256_set1_epi32(k)), z));
+    return _mm256_blendv_epi8(lo, hi, m);
+}
+
+static I_AVX2 inline __m256i
+i_avx2_max_epi64(__m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+}
+
+static I_AVX2 inline __m256i
+i_avx2_min_epi64(__m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+static I_AVX2 inline __m256i
+i_avx2_gt_epu64(__m256i a, __m256i b)
+{
+    const __m256i s = _mm256_set1_epi64x((long long)(1ULL << 63));
+    return _mm256_cmpgt_epi64(_mm256_xor_si256(a, s),
+        _mm256_xor_si256(b, s));
+}
+
+static I_AVX2 inline __m256i
+i_avx2_max_epu64(__m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(b, a, i_avx2_gt_epu64(a, b));
+}
+
+static I_AVX2 inline __m256i
+i_avx2_min_epu64(__m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(a, b, i_avx2_gt_epu64(a, b));
+}
+
+I_MATH_KERNEL(avx2, I_AVX2, i8, int8_t, __m256i, 32,
+    I_AVX2_LD, I_AVX2_ST, _mm256_max_epi8, _mm256_min_epi8)
+I_MATH_KERNEL(avx2, I_AVX2, i16, int16_t, __m256i, 16,
+    I_AVX2_LD, I_AVX2_ST, _mm256_max_epi16, _mm256_min_epi16)
+I_MATH_KERNEL(avx2, I_AVX2, i32, int32_t, __m256i, 8,
+    I_AVX2_LD, I_AVX2_ST, _mm256_max_epi32, _mm256_min_epi32)
+I_MATH_KERNEL(avx2, I_AVX2, i64, int64_t, __m256i, 4,
+    I_AVX2_LD, I_AVX2_ST, i_avx2_max_epi64, i_avx2_min_epi64)
+I_MATH_KERNEL(avx2, I_AVX2, u8, uint8_t, __m256i, 32,
+    I_AVX2_LD, I_AVX2_ST, _mm256_max_epu8, _mm256_min_epu8)
+I_MATH_KERNEL(avx2, I_AVX2, u16, uint16_t, __m256i, 16,
+    I_AVX2_LD, I_AVX2_ST, _mm256_max_epu16, _mm256_min_epu16)
+I_MATH_KERNEL(avx2, I_AVX2, u32, uint32_t, __m256i, 8,
+    I_AVX2_LD, I_AVX2_ST, _mm256_max_epu32, _mm256_min_epu32)
+I_MATH_KERNEL(avx2, I_AVX2, u64, uint64_t, __m256i, 4,
+    I_AVX2_LD, I_AVX2_ST, i_avx2_max_epu64, i_avx2_min_epu64)
+I_MATH_KERNEL(avx2, I_AVX2, f32, float, __m256, 8,
+    _mm256_loadu_ps, _mm256_storeu_ps, _mm256_max_ps, _mm256_min_ps)
+I_MATH_KERNEL(avx2, I_AVX2, f64, double, __m256d, 4,
+    _mm256_loadu_pd, _mm256_storeu_pd, _mm256_max_pd, _mm256_min_pd)
+
+/* avx512 */
+
+#define I_AVX512 __attribute__((target("avx512f,avx512bw")))
+#define I_MATH_LEAVE_avx512 _mm256_zeroupper()
+#define I_MATH_VI_avx512    __m512i
+
+#define I_AVX512_LD(p)      _mm512_loadu_si512((const void *)(p))
+#define I_AVX512_ST(p, v)   _mm512_storeu_si512((void *)(p), v)
+
+#define I_AVX512_IOTA \
+    _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, \
+        8, 9, 10, 11, 12, 13, 14, 15)
+
+static I_AVX512 inline int
+i_avx512_diff(__m512i a, __m512i b)
+{
+    return 0 != _mm512_cmpneq_epi32_mask(a, b);
+}
+
+static I_AVX512 inline __m512i
+i_avx512_perm32(__m512i v, int j)
+{
+    __m512i idx = _mm512_xor_si512(I_AVX512_IOTA, _mm512_set1_epi32(j));
+    return _mm512_permutexvar_epi32(idx, v);
+}
+
+static I_AVX512 inline __m512i
+i_avx512_sel32(__m512i lo, __m512i hi, int j, int k, int base)
+{
+    __m512i e = _mm512_add_epi32(I_AVX512_IOTA, _mm512_set1_epi32(base));
+    __mmask16 m = _mm512_test_epi32_mask(e, _mm512_set1_epi32(j)) ^
+        _mm512_test_epi32_mask(e, _mm512_set1_epi32(k));
+    return _mm512_mask_blend_epi32(m, lo, hi);
+}
+
+I_MATH_KERNEL(avx512, I_AVX512, i8, int8_t, __m512i, 64,
+    I_AVX512_LD, I_AVX512_ST, _mm512_max_epi8, _mm512_min_epi8)
+I_MATH_KERNEL(avx512, I_AVX512, i16, int16_t, __m512i, 32,
+    I_AVX512_LD, I_AVX512_ST, _mm512_max_epi16, _mm512_min_epi16)
+I_MATH_KERNEL(avx512, I_AVX512, i32, int32_t, __m512i, 16,
+    I_AVX512_LD, I_AVX512_ST, _mm512_max_epi32, _mm512_min_epi32)
+I_MATH_KERNEL(avx512, I_AVX512, i64, int64_t, __m512i, 8,
+    I_AVX512_LD, I_AVX512_ST, _mm512_max_epi64, _mm512_min_epi64)
+I_MATH_KERNEL(avx512, I_AVX512, u8, uint8_t, __m512i, 64,
+    I_AVX512_LD, I_AVX512_ST, _mm512_max_epu8, _mm512_min_epu8)
+I_MATH_KERNEL(avx512, I_AVX512, u16, uint16_t, __m512i, 32,
+    I_AVX512_LD, I_AVX512_ST, _mm512_max_epu16, _mm512_min_epu16)
+I_MATH_KERNEL(avx512, I_AVX512, u32, uint32_t, __m512i, 16,
+    I_AVX512_LD, I_AVX512_ST, _mm512_max_epu32, _mm512_min_epu32)
+I_MATH_KERNEL(avx512, I_AVX512, u64, uint64_t, __m512i, 8,
+    I_AVX512_LD, I_AVX512_ST, _mm512_max_epu64, _mm512_min_epu64)
+I_MATH_KERNEL(avx512, I_AVX512, f32, float, __m512, 16,
+    _mm512_loadu_ps, _mm512_storeu_ps, _mm512_max_ps, _mm512_min_ps)
+I_MATH_KERNEL(avx512, I_AVX512, f64, double, __m512d, 8,
+    _mm512_loadu_pd, _mm512_storeu_pd, _mm512_max_pd, _mm512_min_pd)
+
+#endif // I_MATH_X86
+
+/* dispatch */
+
+#define I_MATH_SET_scalar(name, T, lo, hi) \
+    g_m.max_##name = i_math_max_##name##_scalar; \
+    g_m.min_##name = i_math_min_##name##_scalar; \
+    g_m.minmax_##name = i_math_minmax_##name##_scalar; \
+    g_m.above_##name = i_math_above_##name##_scalar; \
+    g_m.below_##name = i_math_below_##name##_scalar; \
+    g_m.network_##name = i_math_network_##name##_scalar;
+#define I_MATH_SET_sse2(name, T, lo, hi) \
+    g_m.max_##name = i_math_max_##name##_sse2; \
+    g_m.min_##name = i_math_min_##name##_sse2; \
+    g_m.minmax_##name = i_math_minmax_##name##_sse2; \
+    g_m.above_##name = i_math_above_##name##_sse2; \
+    g_m.below_##name = i_math_below_##name##_sse2; \
+    g_m.network_##name = i_math_network_##name##_sse2;
+#define I_MATH_SET_avx2(name, T, lo, hi) \
+    g_m.max_##name = i_math_max_##name##_avx2; \
+    g_m.min_##name = i_math_min_##name##_avx2; \
+    g_m.minmax_##name = i_math_minmax_##name##_avx2; \
+    g_m.above_##name = i_math_above_##name##_avx2; \
+    g_m.below_##name = i_math_below_##name##_avx2; \
+    g_m.network_##name = i_math_network_##name##_avx2;
+#define I_MATH_SET_avx512(name, T, lo, hi) \
+    g_m.max_##name = i_math_max_##name##_avx512; \
+    g_m.min_##name = i_math_min_##name##_avx512; \
+    g_m.minmax_##name = i_math_minmax_##name##_avx512; \
+    g_m.above_##name = i_math_above_##name##_avx512; \
+    g_m.below_##name = i_math_below_##name##_avx512; \
+    g_m.network_##name = i_math_network_##name##_avx512;
+
+/* features of each level of `SIRIUS_MATH_ISA_ENV` */
+static const struct {
+    const char *p_name;
+    unsigned int allow;
+} i_math_isa_env[] = {
+    {"scalar", 0},
+    {"sse2", SIRIUS_CPU_SSE2},
+    {"avx2", ~(unsigned int)(SIRIUS_CPU_AVX512F | SIRIUS_CPU_AVX512BW |
+        SIRIUS_CPU_AVX512DQ | SIRIUS_CPU_AVX512VL)},
+    {"avx512", ~0U},
+};
+
+sirius_cpu_fn_t
+sirius_math_internal_select(const sirius_cpu_impl_t *p_impl, size_t nr)
+{
+    if (!(p_impl)) return NULL;
+
+    unsigned int allow = ~0U;
+    const char *p_env = getenv(SIRIUS_MATH_ISA_ENV);
+    for (size_t i = 0; p_env &&
+            i < sizeof(i_math_isa_env) / sizeof(i_math_isa_env[0]); i++) {
+        if (0 == strcmp(p_env, i_math_isa_env[i].p_name)) {
+            allow = i_math_isa_env[i].allow;
+            break;
+        }
+    }
+
+    size_t skip = 0;
+    while (skip < nr && (p_impl[skip].need & ~allow)) skip++;
+    return sirius_cpu_select(p_impl + skip, nr - skip);
+}
+
+#define I_MATH_SET_FN(isa) \
+static void \
+i_math_set_##isa() \
+{ \
+    I_MATH_TYPES(I_MATH_SET_##isa) \
+    g_m.p_isa = #isa; \
+}
+
+I_MATH_SET_FN(scalar)
+#ifdef I_MATH_X86
+I_MATH_SET_FN(sse2)
+I_MATH_SET_FN(avx2)
+I_MATH_SET_FN(avx512)
+#endif // I_MATH_X86
+
+static const sirius_cpu_impl_t i_math_impl[] = {
+#ifdef I_MATH_X86
+    {SIRIUS_CPU_AVX512F | SIRIUS_CPU_AVX512BW,
+        (sirius_cpu_fn_t)i_math_set_avx512},
+    {SIRIUS_CPU_AVX2, (sirius_cpu_fn_t)i_math_set_avx2},
+    {SIRIUS_CPU_SSE2, (sirius_cpu_fn_t)i_math_set_sse2},
+#endif // I_MATH_X86
+    {0, (sirius_cpu_fn_t)i_math_set_scalar},
+};
+
+__attribute__((constructor)) static void
+i_math_dispatch()
+{
+    ((void (*)())sirius_math_internal_select(i_math_impl,
+        sizeof(i_math_impl) / sizeof(i_math_impl[0])))();
+}
+
+const char *
+sirius_math_isa()
+{
+    return g_m.p_isa;
+}
+
+#define I_MATH_API(name, T, lo, hi) \
+T \
+sirius_math_max_##name(const T *p_arr, size_t n) \
+{ \
+    if (unlikely(!(p_arr) || 0 == n)) return lo; \
+    return g_m.max_##name(p_arr, n); \
+} \
+T \
+sirius_math_min_##name(const T *p_arr, size_t n) \
+{ \
+    if (unlikely(!(p_arr) || 0 == n)) return hi; \
+    return g_m.min_##name(p_arr, n); \
+} \
+int \
+sirius_math_minmax_##name(const T *p_arr, size_t n, \
+    T *p_min, T *p_max) \
+{ \
+    if (!(p_arr) || !(p_min) || !(p_max)) { \
+        return SIRIUS_ERR_NULL_POINTER; \
+    } \
+    if (0 == n) return SIRIUS_ERR_INVALID_PARAMETER; \
+    g_m.minmax_##name(p_arr, n, p_min, p_max); \
+    return SIRIUS_OK; \
+}
+
+I_MATH_TYPES(I_MATH_API)
+
+#define I_MATH_SHARED_API(name, T, lo, hi) \
+size_t \
+sirius_math_above_##name(const T *p_arr, size_t n, T thr) \
+{ \
+    return g_m.above_##name(p_arr, n, thr); \
+} \
+size_t \
+sirius_math_below_##name(const T *p_arr, size_t n, T thr) \
+{ \
+    return g_m.below_##name(p_arr, n, thr); \
+} \
+void \
+sirius_math_network_##name(T *p_arr, size_t nr) \
+{ \
+    g_m.network_##name(p_arr, nr); \
+}
+
+I_MATH_TYPES(I_MATH_SHARED_API)
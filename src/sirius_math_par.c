@@ -0,0 +1,392 @@
+#include "sirius_math.h"
+#include "sirius_errno.h"
+#include "sirius_config.h"
+
+#include "./internal/sirius_internal_sys.h"
+#include "./internal/sirius_internal_thread.h"
+
+#include <signal.h>
+
+/**
+ * the worker team is started by the first `_par` call and lives
+ * as long as the process. a job is a function called once per
+ * chunk; the workers and the caller claim chunks from a shared
+ * counter, and each chunk writes its own slot of the partial
+ * results, so which thread reduces a chunk changes nothing.
+ * 
+ * only the workers taking part are woken, each sleeps on a
+ * condition of its own; the caller waits until all of them have
+ * left the job, only then the job description may be replaced.
+ * 
+ * configuration keys:
+ * "math.par.min": arrays below this size (bytes) are reduced by the
+ *  caller alone
+ * "math.par.threads": the most threads taking part, 0 for all
+ */
+#define I_PAR_MIN_KEY       "math.par.min"
+#define I_PAR_THREADS_KEY   "math.par.threads"
+
+/* default of "math.par.min" */
+#define I_PAR_MIN_DEF       (4 * 1024 * 1024)
+
+typedef void (*i_par_fn_t)(void *p_ctx, size_t idx);
+
+typedef struct {
+    /* one job at a time */
+    pthread_mutex_t busy;
+
+    pthread_mutex_t mutex;
+    /* one per worker */
+    pthread_cond_t cond_work[SIRIUS_MATH_PAR_THREAD_MAX];
+    pthread_cond_t cond_done;
+
+    /* bumped for every job */
+    unsigned long long gen;
+    /* workers taking part that are done with the current job */
+    unsigned int acked;
+    unsigned int worker_nr;
+    /* the team does not survive a fork */
+    pid_t pid;
+
+    i_par_fn_t p_fn;
+    void *p_ctx;
+    size_t chunk_nr;
+    /* workers with a smaller index take part */
+    unsigned int active;
+    atomic_size_t next;
+} i_par_t;
+
+static i_par_t g_p = {
+    .busy = PTHREAD_MUTEX_INITIALIZER,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond_done = PTHREAD_COND_INITIALIZER,
+};
+
+static pthread_once_t g_par_once = PTHREAD_ONCE_INIT;
+
+static int g_min_id = -1;
+static int g_threads_id = -1;
+
+static void
+i_par_run(i_par_fn_t p_fn, void *p_ctx, size_t chunk_nr)
+{
+    size_t i;
+    while ((i = atomic_fetch_add_explicit(&(g_p.next), 1,
+            memory_order_relaxed)) < chunk_nr) {
+        p_fn(p_ctx, i);
+    }
+}
+
+static void *
+i_par_worker(void *p_arg)
+{
+    unsigned int id = (unsigned int)(uintptr_t)p_arg;
+    unsigned long long seen = 0;
+
+    pthread_mutex_lock(&(g_p.mutex));
+    while (true) {
+        /* the jobs this worker sits out are skipped */
+        while (seen == g_p.gen || id >= g_p.active) {
+            pthread_cond_wait(&(g_p.cond_work[id]), &(g_p.mutex));
+        }
+        seen = g_p.gen;
+        i_par_fn_t p_fn = g_p.p_fn;
+        void *p_ctx = g_p.p_ctx;
+        size_t chunk_nr = g_p.chunk_nr;
+        pthread_mutex_unlock(&(g_p.mutex));
+
+        i_par_run(p_fn, p_ctx, chunk_nr);
+
+        pthread_mutex_lock(&(g_p.mutex));
+        if (++(g_p.acked) == g_p.active) {
+            pthread_cond_signal(&(g_p.cond_done));
+        }
+    }
+
+    return NULL;
+}
+
+static void
+i_par_init()
+{
+    sirius_cfg_attr_t attr = {
+        .p_name = I_PAR_MIN_KEY,
+        .def = I_PAR_MIN_DEF,
+        .min = 0,
+        .max = LLONG_MAX,
+    };
+    g_min_id = sirius_cfg_register(&attr);
+
+    attr.p_name = I_PAR_THREADS_KEY;
+    attr.def = 0;
+    attr.max = SIRIUS_MATH_PAR_THREAD_MAX;
+    g_threads_id = sirius_cfg_register(&attr);
+
+    long cpu_nr = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpu_nr < 1) cpu_nr = 1;
+    if (cpu_nr > SIRIUS_MATH_PAR_THREAD_MAX) {
+        cpu_nr = SIRIUS_MATH_PAR_THREAD_MAX;
+    }
+
+    for (long i = 0; i < cpu_nr - 1; i++) {
+        pthread_cond_init(&(g_p.cond_work[i]), NULL);
+    }
+
+    /* signals go to the application threads, never to the workers */
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+
+    unsigned int nr = 0;
+    for (; nr < (unsigned int)cpu_nr - 1; nr++) {
+        char name[32];
+        snprintf(name, sizeof(name), "sirius-par%u", nr);
+        if (sirius_thread_internal_create(NULL, name, true, i_par_worker,
+                (void *)(uintptr_t)nr)) {
+            break;
+        }
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    pthread_mutex_lock(&(g_p.mutex));
+    g_p.worker_nr = nr;
+    g_p.pid = getpid();
+    pthread_mutex_unlock(&(g_p.mutex));
+}
+
+/**
+ * @return true if an array of `size` bytes is worth the team
+ */
+static inline bool
+i_par_worth(size_t size)
+{
+    /* a single chunk never starts the team */
+    if (size <= SIRIUS_MATH_PAR_CHUNK) return false;
+
+    (void)pthread_once(&g_par_once, i_par_init);
+    long long min = g_min_id < 0 ? I_PAR_MIN_DEF : sirius_cfg_get(g_min_id);
+    return (long long)size >= min;
+}
+
+/**
+ * @brief call `p_fn` for every chunk, on the team if it is free
+ */
+static void
+i_par_exec(i_par_fn_t p_fn, void *p_ctx, size_t chunk_nr)
+{
+    unsigned int thread_nr = g_p.worker_nr + 1;
+    long long limit = g_threads_id < 0 ? 0 : sirius_cfg_get(g_threads_id);
+    if (limit > 0 && limit < thread_nr) thread_nr = (unsigned int)limit;
+
+    if (thread_nr < 2 || chunk_nr < 2 || getpid() != g_p.pid ||
+        pthread_mutex_trylock(&(g_p.busy))) {
+        for (size_t i = 0; i < chunk_nr; i++) p_fn(p_ctx, i);
+        return;
+    }
+
+    atomic_store_explicit(&(g_p.next), 0, memory_order_relaxed);
+
+    pthread_mutex_lock(&(g_p.mutex));
+    g_p.p_fn = p_fn;
+    g_p.p_ctx = p_ctx;
+    g_p.chunk_nr = chunk_nr;
+    g_p.active = thread_nr - 1;
+    g_p.acked = 0;
+    g_p.gen++;
+    for (unsigned int i = 0; i < g_p.active; i++) {
+        pthread_cond_signal(&(g_p.cond_work[i]));
+    }
+    pthread_mutex_unlock(&(g_p.mutex));
+
+    i_par_run(p_fn, p_ctx, chunk_nr);
+
+    /* the partial results are visible once the workers acked */
+    pthread_mutex_lock(&(g_p.mutex));
+    while (g_p.acked < g_p.active) {
+        pthread_cond_wait(&(g_p.cond_done), &(g_p.mutex));
+    }
+    pthread_mutex_unlock(&(g_p.mutex));
+
+    pthread_mutex_unlock(&(g_p.busy));
+}
+
+typedef struct {
+    const void *p_arr;
+    size_t n;
+    /* elements per chunk */
+    size_t chunk;
+    void *p_part;
+} i_par_ctx_t;
+
+static inline size_t
+i_par_chunk_len(const i_par_ctx_t *p_c, size_t idx)
+{
+    size_t beg = idx * p_c->chunk;
+    return p_c->n - beg < p_c->chunk ? p_c->n - beg : p_c->chunk;
+}
+
+/* min and max */
+
+#define I_PAR_TYPES(X) \
+    X(i8,  int8_t) \
+    X(i16, int16_t) \
+    X(i32, int32_t) \
+    X(i64, int64_t) \
+    X(u8,  uint8_t) \
+    X(u16, uint16_t) \
+    X(u32, uint32_t) \
+    X(u64, uint64_t) \
+    X(f32, float) \
+    X(f64, double)
+
+#define I_PAR_EXTREME(op, name, T) \
+static void \
+i_par_##op##_##name(void *p_ctx, size_t idx) \
+{ \
+    i_par_ctx_t *p_c = (i_par_ctx_t *)p_ctx; \
+    ((T *)p_c->p_part)[idx] = sirius_math_##op##_##name( \
+        (const T *)p_c->p_arr + idx * p_c->chunk, \
+        i_par_chunk_len(p_c, idx)); \
+} \
+T \
+sirius_math_##op##_##name##_par(const T *p_arr, size_t n) \
+{ \
+    if (!(p_arr) || !(i_par_worth(n * sizeof(T)))) { \
+        return sirius_math_##op##_##name(p_arr, n); \
+    } \
+    i_par_ctx_t ctx = { \
+        .p_arr = p_arr, \
+        .n = n, \
+        .chunk = SIRIUS_MATH_PAR_CHUNK / sizeof(T), \
+    }; \
+    size_t chunk_nr = (n + ctx.chunk - 1) / ctx.chunk; \
+    ctx.p_part = malloc(chunk_nr * sizeof(T)); \
+    if (!(ctx.p_part)) return sirius_math_##op##_##name(p_arr, n); \
+ \
+    i_par_exec(i_par_##op##_##name, &ctx, chunk_nr); \
+    T r = sirius_math_##op##_##name((const T *)ctx.p_part, chunk_nr); \
+    free(ctx.p_part); \
+    return r; \
+}
+
+#define I_PAR_MAX(name, T) I_PAR_EXTREME(max, name, T)
+#define I_PAR_MIN(name, T) I_PAR_EXTREME(min, name, T)
+
+I_PAR_TYPES(I_PAR_MAX)
+I_PAR_TYPES(I_PAR_MIN)
+
+/* the minima of the chunks, then the maxima */
+#define I_PAR_MINMAX(name, T) \
+static void \
+i_par_minmax_##name(void *p_ctx, size_t idx) \
+{ \
+    i_par_ctx_t *p_c = (i_par_ctx_t *)p_ctx; \
+    size_t chunk_nr = (p_c->n + p_c->chunk - 1) / p_c->chunk; \
+    T *p_part = (T *)p_c->p_part; \
+    (void)sirius_math_minmax_##name( \
+        (const T *)p_c->p_arr + idx * p_c->chunk, \
+        i_par_chunk_len(p_c, idx), \
+        p_part + idx, p_part + chunk_nr + idx); \
+} \
+int \
+sirius_math_minmax_##name##_par(const T *p_arr, size_t n, \
+    T *p_min, T *p_max) \
+{ \
+    if (!(p_arr) || !(p_min) || !(p_max) || \
+        !(i_par_worth(n * sizeof(T)))) { \
+        return sirius_math_minmax_##name(p_arr, n, p_min, p_max); \
+    } \
+    i_par_ctx_t ctx = { \
+        .p_arr = p_arr, \
+        .n = n, \
+        .chunk = SIRIUS_MATH_PAR_CHUNK / sizeof(T), \
+    }; \
+    size_t chunk_nr = (n + ctx.chunk - 1) / ctx.chunk; \
+    ctx.p_part = malloc(2 * chunk_nr * sizeof(T)); \
+    if (!(ctx.p_part)) { \
+        return sirius_math_minmax_##name(p_arr, n, p_min, p_max); \
+    } \
+ \
+    i_par_exec(i_par_minmax_##name, &ctx, chunk_nr); \
+    const T *p_part = (const T *)ctx.p_part; \
+    *p_min = sirius_math_min_##name(p_part, chunk_nr); \
+    *p_max = sirius_math_max_##name(p_part + chunk_nr, chunk_nr); \
+    free(ctx.p_part); \
+    return SIRIUS_OK; \
+}
+
+I_PAR_TYPES(I_PAR_MINMAX)
+
+/* sum */
+
+/**
+ * the partial sums are combined like a binary counter, partial `i`
+ * merges with the pending ones while bit 0, 1, ... of `i` is set.
+ * the tree depends only on the number of chunks, so the chunks can
+ * also be fed one by one without storing them.
+ */
+#define I_PAR_SUM(name, T) \
+typedef struct { \
+    T stack[64]; \
+    unsigned int top; \
+    size_t nr; \
+} i_par_tree_##name##_t; \
+static inline void \
+i_par_tree_##name##_add(i_par_tree_##name##_t *p_t, T x) \
+{ \
+    for (size_t k = p_t->nr++; k & 1; k >>= 1) { \
+        x = p_t->stack[--(p_t->top)] + x; \
+    } \
+    p_t->stack[(p_t->top)++] = x; \
+} \
+static inline T \
+i_par_tree_##name##_sum(const i_par_tree_##name##_t *p_t) \
+{ \
+    if (0 == p_t->top) return 0; \
+    T s = p_t->stack[p_t->top - 1]; \
+    for (unsigned int i = p_t->top - 1; i > 0; i--) { \
+        s = p_t->stack[i - 1] + s; \
+    } \
+    return s; \
+} \
+static void \
+i_par_sum_##name(void *p_ctx, size_t idx) \
+{ \
+    i_par_ctx_t *p_c = (i_par_ctx_t *)p_ctx; \
+    ((T *)p_c->p_part)[idx] = sirius_math_sum_##name( \
+        (const T *)p_c->p_arr + idx * p_c->chunk, \
+        i_par_chunk_len(p_c, idx), SIRIUS_MATH_ACC_FAST); \
+} \
+T \
+sirius_math_sum_##name##_par(const T *p_arr, size_t n) \
+{ \
+    if (!(p_arr) || 0 == n) return 0; \
+ \
+    i_par_ctx_t ctx = { \
+        .p_arr = p_arr, \
+        .n = n, \
+        .chunk = SIRIUS_MATH_PAR_CHUNK / sizeof(T), \
+    }; \
+    size_t chunk_nr = (n + ctx.chunk - 1) / ctx.chunk; \
+    i_par_tree_##name##_t tree = {0}; \
+ \
+    if (i_par_worth(n * sizeof(T)) && \
+        (ctx.p_part = malloc(chunk_nr * sizeof(T)))) { \
+        i_par_exec(i_par_sum_##name, &ctx, chunk_nr); \
+        for (size_t i = 0; i < chunk_nr; i++) { \
+            i_par_tree_##name##_add(&tree, ((T *)ctx.p_part)[i]); \
+        } \
+        free(ctx.p_part); \
+    } else { \
+        for (size_t i = 0; i < chunk_nr; i++) { \
+            i_par_tree_##name##_add(&tree, sirius_math_sum_##name( \
+                p_arr + i * ctx.chunk, i_par_chunk_len(&ctx, i), \
+                SIRIUS_MATH_ACC_FAST)); \
+        } \
+    } \
+    return i_par_tree_##name##_sum(&tree); \
+}
+
+I_PAR_SUM(f32, float)
+I_PAR_SUM(f64, double)
@@ -0,0 +1,346 @@
+#include "sirius_math.h"
+#include "sirius_attributes.h"
+
+#include "./internal/sirius_internal_math.h"
+
+/**
+ * fast mode: blocks of `I_SUM_BLOCK` elements are summed in 4 vector
+ * accumulators, the block sums are combined pairwise; the error grows
+ * with log2(n / I_SUM_BLOCK) instead of n.
+ * 
+ * compensated mode: Kahan summation in every lane, 2 accumulator
+ * pairs to hide the latency; the lanes and the tail are then folded
+ * with Neumaier's variant in double precision. the error does not
+ * depend on n.
+ * 
+ * the dot products are the same with x[i] * y[i] as the elements;
+ * no fma is used, the rounding of each product is kept.
+ */
+
+/* elements summed by a block kernel */
+#define I_SUM_BLOCK         (256)
+
+typedef struct {
+    float (*sum_blk_f32)(const float *p_x, size_t n);
+    double (*sum_blk_f64)(const double *p_x, size_t n);
+    float (*dot_blk_f32)(const float *p_x, const float *p_y, size_t n);
+    double (*dot_blk_f64)(const double *p_x, const double *p_y, size_t n);
+
+    double (*sum_comp_f32)(const float *p_x, size_t n);
+    double (*sum_comp_f64)(const double *p_x, size_t n);
+    double (*dot_comp_f32)(const float *p_x, const float *p_y, size_t n);
+    double (*dot_comp_f64)(const double *p_x, const double *p_y, size_t n);
+} i_sum_kernel_t;
+
+static i_sum_kernel_t g_s = {0};
+
+typedef struct {
+    double sum;
+    double comp;
+} i_sum_neumaier_t;
+
+static inline void
+i_sum_neumaier_add(i_sum_neumaier_t *p_n, double x)
+{
+    double t = p_n->sum + x;
+    if (fabs(p_n->sum) >= fabs(x)) {
+        p_n->comp += (p_n->sum - t) + x;
+    } else {
+        p_n->comp += (x - t) + p_n->sum;
+    }
+    p_n->sum = t;
+}
+
+/**
+ * @param LOAD2: element `i`, `LOAD` for a sum, a product for a dot
+ * @param SCALAR2: the same for a single element
+ * @param LEAVE: run once the vectors are stored, `vzeroupper` for
+ *  avx, the library may be built without optimization and gcc
+ *  only inserts it by itself when optimizing
+ */
+#define I_SUM_KERNEL(isa, attr, name, op, T, V, LANES, ZERO, \
+    LOAD2, SCALAR2, STORE, ADD, SUB, LEAVE, PARAMS) \
+static attr T \
+i_##op##_blk_##name##_##isa PARAMS \
+{ \
+    V a0 = ZERO, a1 = ZERO, a2 = ZERO, a3 = ZERO; \
+    size_t i = 0; \
+    for (; i + 4 * LANES <= n; i += 4 * LANES) { \
+        a0 = ADD(a0, LOAD2(i)); \
+        a1 = ADD(a1, LOAD2(i + LANES)); \
+        a2 = ADD(a2, LOAD2(i + 2 * LANES)); \
+        a3 = ADD(a3, LOAD2(i + 3 * LANES)); \
+    } \
+    for (; i + LANES <= n; i += LANES) a0 = ADD(a0, LOAD2(i)); \
+    a0 = ADD(ADD(a0, a1), ADD(a2, a3)); \
+ \
+    T lanes[LANES]; \
+    STORE(lanes, a0); \
+    LEAVE; \
+    T s = 0; \
+    for (size_t k = 0; k < LANES; k++) s += lanes[k]; \
+    for (; i < n; i++) s += SCALAR2(i); \
+    return s; \
+} \
+static attr double \
+i_##op##_comp_##name##_##isa PARAMS \
+{ \
+    V s0 = ZERO, c0 = ZERO, s1 = ZERO, c1 = ZERO; \
+    size_t i = 0; \
+    for (; i + 2 * LANES <= n; i += 2 * LANES) { \
+        V y0 = SUB(LOAD2(i), c0); \
+        V y1 = SUB(LOAD2(i + LANES), c1); \
+        V t0 = ADD(s0, y0); \
+        V t1 = ADD(s1, y1); \
+        c0 = SUB(SUB(t0, s0), y0); \
+        c1 = SUB(SUB(t1, s1), y1); \
+        s0 = t0; \
+        s1 = t1; \
+    } \
+ \
+    i_sum_neumaier_t acc = {0, 0}; \
+    T lanes[4][LANES]; \
+    STORE(lanes[0], s0); \
+    STORE(lanes[1], s1); \
+    STORE(lanes[2], c0); \
+    STORE(lanes[3], c1); \
+    LEAVE; \
+    for (size_t k = 0; k < LANES; k++) { \
+        i_sum_neumaier_add(&acc, lanes[0][k]); \
+        i_sum_neumaier_add(&acc, lanes[1][k]); \
+        i_sum_neumaier_add(&acc, -lanes[2][k]); \
+        i_sum_neumaier_add(&acc, -lanes[3][k]); \
+    } \
+    for (; i < n; i++) i_sum_neumaier_add(&acc, (double)SCALAR2(i)); \
+    return acc.sum + acc.comp; \
+}
+
+#define I_SUM_PARAMS(T)     (const T *p_x, size_t n)
+#define I_DOT_PARAMS(T)     (const T *p_x, const T *p_y, size_t n)
+
+#define I_SUM_ELEM(i)       (p_x[i])
+#define I_DOT_ELEM(i)       (p_x[i] * p_y[i])
+
+/* scalar, a "vector" of one element */
+
+#define I_S_ZERO            (0)
+#define I_S_STORE(p, v)     (*(p) = (v))
+#define I_S_ADD(a, b)       ((a) + (b))
+#define I_S_SUB(a, b)       ((a) - (b))
+#define I_S_LEAVE           ((void)0)
+
+#define I_SUM_SCALAR(name, T) \
+    I_SUM_KERNEL(scalar, , name, sum, T, T, 1, I_S_ZERO, \
+        I_SUM_ELEM, I_SUM_ELEM, I_S_STORE, I_S_ADD, I_S_SUB, \
+        I_S_LEAVE, I_SUM_PARAMS(T)) \
+    I_SUM_KERNEL(scalar, , name, dot, T, T, 1, I_S_ZERO, \
+        I_DOT_ELEM, I_DOT_ELEM, I_S_STORE, I_S_ADD, I_S_SUB, \
+        I_S_LEAVE, I_DOT_PARAMS(T))
+
+I_SUM_SCALAR(f32, float)
+I_SUM_SCALAR(f64, double)
+
+#ifdef I_MATH_X86
+
+/**
+ * @param sfx: intrinsic suffix, ps or pd
+ * @param pfx: intrinsic prefix, _mm, _mm256 or _mm512
+ */
+#define I_SUM_SIMD(isa, attr, name, T, V, LANES, pfx, sfx) \
+    I_SUM_KERNEL(isa, attr, name, sum, T, V, LANES, \
+        pfx##_setzero_##sfx(), \
+        I_SUM_LD_##name##_##isa, I_SUM_ELEM, pfx##_storeu_##sfx, \
+        pfx##_add_##sfx, pfx##_sub_##sfx, I_SUM_LEAVE_##isa, \
+        I_SUM_PARAMS(T)) \
+    I_SUM_KERNEL(isa, attr, name, dot, T, V, LANES, \
+        pfx##_setzero_##sfx(), \
+        I_DOT_LD_##name##_##isa, I_DOT_ELEM, pfx##_storeu_##sfx, \
+        pfx##_add_##sfx, pfx##_sub_##sfx, I_SUM_LEAVE_##isa, \
+        I_DOT_PARAMS(T))
+
+#define I_SUM_LD_f32_sse2(i)    _mm_loadu_ps(p_x + (i))
+#define I_SUM_LD_f64_sse2(i)    _mm_loadu_pd(p_x + (i))
+#define I_DOT_LD_f32_sse2(i) \
+    _mm_mul_ps(_mm_loadu_ps(p_x + (i)), _mm_loadu_ps(p_y + (i)))
+#define I_DOT_LD_f64_sse2(i) \
+    _mm_mul_pd(_mm_loadu_pd(p_x + (i)), _mm_loadu_pd(p_y + (i)))
+
+#define I_SUM_LD_f32_avx2(i)    _mm256_loadu_ps(p_x + (i))
+#define I_SUM_LD_f64_avx2(i)    _mm256_loadu_pd(p_x + (i))
+#define I_DOT_LD_f32_avx2(i) \
+    _mm256_mul_ps(_mm256_loadu_ps(p_x + (i)), _mm256_loadu_ps(p_y + (i)))
+#define I_DOT_LD_f64_avx2(i) \
+    _mm256_mul_pd(_mm256_loadu_pd(p_x + (i)), _mm256_loadu_pd(p_y + (i)))
+
+#define I_SUM_LD_f32_avx512(i)  _mm512_loadu_ps(p_x + (i))
+#define I_SUM_LD_f64_avx512(i)  _mm512_loadu_pd(p_x + (i))
+#define I_DOT_LD_f32_avx512(i) \
+    _mm512_mul_ps(_mm512_loadu_ps(p_x + (i)), _mm512_loadu_ps(p_y + (i)))
+#define I_DOT_LD_f64_avx512(i) \
+    _mm512_mul_pd(_mm512_loadu_pd(p_x + (i)), _mm512_loadu_pd(p_y + (i)))
+
+#define I_SUM_LEAVE_sse2        ((void)0)
+#define I_SUM_LEAVE_avx2        _mm256_zeroupper()
+#define I_SUM_LEAVE_avx512      _mm256_zeroupper()
+
+#define I_SSE2      __attribute__((target("sse2")))
+#define I_AVX2      __attribute__((target("avx2")))
+#define I_AVX512    __attribute__((target("avx512f")))
+
+I_SUM_SIMD(sse2, I_SSE2, f32, float, __m128, 4, _mm, ps)
+I_SUM_SIMD(sse2, I_SSE2, f64, double, __m128d, 2, _mm, pd)
+I_SUM_SIMD(avx2, I_AVX2, f32, float, __m256, 8, _mm256, ps)
+I_SUM_SIMD(avx2, I_AVX2, f64, double, __m256d, 4, _mm256, pd)
+I_SUM_SIMD(avx512, I_AVX512, f32, float, __m512, 16, _mm512, ps)
+I_SUM_SIMD(avx512, I_AVX512, f64, double, __m512d, 8, _mm512, pd)
+
+#endif // I_MATH_X86
+
+#define I_SUM_SET(isa) \
+    do { \
+        g_s.sum_blk_f32 = i_sum_blk_f32_##isa; \
+        g_s.sum_blk_f64 = i_sum_blk_f64_##isa; \
+        g_s.dot_blk_f32 = i_dot_blk_f32_##isa; \
+        g_s.dot_blk_f64 = i_dot_blk_f64_##isa; \
+        g_s.sum_comp_f32 = i_sum_comp_f32_##isa; \
+        g_s.sum_comp_f64 = i_sum_comp_f64_##isa; \
+        g_s.dot_comp_f32 = i_dot_comp_f32_##isa; \
+        g_s.dot_comp_f64 = i_dot_comp_f64_##isa; \
+    } while (0)
+
+#define I_SUM_SET_FN(isa) \
+static void \
+i_sum_set_##isa() \
+{ \
+    I_SUM_SET(isa); \
+}
+
+I_SUM_SET_FN(scalar)
+#ifdef I_MATH_X86
+I_SUM_SET_FN(sse2)
+I_SUM_SET_FN(avx2)
+I_SUM_SET_FN(avx512)
+#endif // I_MATH_X86
+
+static const sirius_cpu_impl_t i_sum_impl[] = {
+#ifdef I_MATH_X86
+    {SIRIUS_CPU_AVX512F, (sirius_cpu_fn_t)i_sum_set_avx512},
+    {SIRIUS_CPU_AVX2, (sirius_cpu_fn_t)i_sum_set_avx2},
+    {SIRIUS_CPU_SSE2, (sirius_cpu_fn_t)i_sum_set_sse2},
+#endif // I_MATH_X86
+    {0, (sirius_cpu_fn_t)i_sum_set_scalar},
+};
+
+__attribute__((constructor)) static void
+i_sum_dispatch()
+{
+    ((void (*)())sirius_math_internal_select(i_sum_impl,
+        sizeof(i_sum_impl) / sizeof(i_sum_impl[0])))();
+}
+
+#define I_SUM_PAIRWISE(name, T) \
+static T \
+i_sum_pairwise_##name(const T *p_x, size_t n) \
+{ \
+    if (n <= I_SUM_BLOCK) return g_s.sum_blk_##name(p_x, n); \
+    /* split at a multiple of the block, the blocks stay aligned */ \
+    size_t half = (n / 2 + I_SUM_BLOCK - 1) / I_SUM_BLOCK * I_SUM_BLOCK; \
+    return i_sum_pairwise_##name(p_x, half) + \
+        i_sum_pairwise_##name(p_x + half, n - half); \
+} \
+static T \
+i_dot_pairwise_##name(const T *p_x, const T *p_y, size_t n) \
+{ \
+    if (n <= I_SUM_BLOCK) return g_s.dot_blk_##name(p_x, p_y, n); \
+    size_t half = (n / 2 + I_SUM_BLOCK - 1) / I_SUM_BLOCK * I_SUM_BLOCK; \
+    return i_dot_pairwise_##name(p_x, p_y, half) + \
+        i_dot_pairwise_##name(p_x + half, p_y + half, n - half); \
+}
+
+I_SUM_PAIRWISE(f32, float)
+I_SUM_PAIRWISE(f64, double)
+
+/**
+ * an inf or an overflow turns the compensation into inf - inf, the
+ * compensated result is then NaN; the plain pairwise sum is the
+ * IEEE one in that case
+ */
+#define I_SUM_API(name, T, MIN, EPS) \
+static double \
+i_sum_##name(const T *p_x, size_t n, sirius_math_acc_t acc) \
+{ \
+    if (SIRIUS_MATH_ACC_COMP == acc) { \
+        double s = g_s.sum_comp_##name(p_x, n); \
+        if (isfinite(s)) return s; \
+    } \
+    return i_sum_pairwise_##name(p_x, n); \
+} \
+static double \
+i_dot_##name(const T *p_x, const T *p_y, size_t n, sirius_math_acc_t acc) \
+{ \
+    if (SIRIUS_MATH_ACC_COMP == acc) { \
+        double s = g_s.dot_comp_##name(p_x, p_y, n); \
+        if (isfinite(s)) return s; \
+    } \
+    return i_dot_pairwise_##name(p_x, p_y, n); \
+} \
+/** \
+ * as the blas nrm2: the elements are divided by the largest \
+ * magnitude, the squares are then at most 1 \
+ */ \
+static T \
+i_l2norm_scaled_##name(const T *p_arr, size_t n, sirius_math_acc_t acc) \
+{ \
+    T amax = 0; \
+    for (size_t i = 0; i < n; i++) { \
+        T a = (T)fabs(p_arr[i]); \
+        if (a > amax) amax = a; \
+    } \
+    if (0 == amax || isinf(amax)) return amax; \
+ \
+    T tmp[I_SUM_BLOCK]; \
+    double ssq = 0; \
+    for (size_t i = 0; i < n; i += I_SUM_BLOCK) { \
+        size_t k = n - i < I_SUM_BLOCK ? n - i : I_SUM_BLOCK; \
+        for (size_t j = 0; j < k; j++) tmp[j] = p_arr[i + j] / amax; \
+        ssq += i_dot_##name(tmp, tmp, k, acc); \
+    } \
+    return (T)((double)amax * sqrt(ssq)); \
+} \
+T \
+sirius_math_sum_##name(const T *p_arr, size_t n, sirius_math_acc_t acc) \
+{ \
+    if (!(p_arr) || 0 == n) return 0; \
+    return (T)i_sum_##name(p_arr, n, acc); \
+} \
+T \
+sirius_math_dot_##name(const T *p_x, const T *p_y, size_t n, \
+    sirius_math_acc_t acc) \
+{ \
+    if (!(p_x) || !(p_y) || 0 == n) return 0; \
+    return (T)i_dot_##name(p_x, p_y, n, acc); \
+} \
+T \
+sirius_math_l2norm_##name(const T *p_arr, size_t n, sirius_math_acc_t acc) \
+{ \
+    if (!(p_arr) || 0 == n) return 0; \
+    double d = i_dot_##name(p_arr, p_arr, n, acc); \
+    if (isnan(d)) return (T)d; \
+    /* the squares overflowed, or underflowed and lost their bits */ \
+    if (isinf(d) || d < (double)MIN / (double)EPS) { \
+        return i_l2norm_scaled_##name(p_arr, n, acc); \
+    } \
+    return (T)sqrt(d); \
+} \
+T \
+sirius_math_mean_##name(const T *p_arr, size_t n, sirius_math_acc_t acc) \
+{ \
+    if (!(p_arr) || 0 == n) return NAN; \
+    if (SIRIUS_MATH_ACC_COMP == acc) { \
+        return (T)(i_sum_##name(p_arr, n, acc) / (double)n); \
+    } \
+    return (T)(i_sum_pairwise_##name(p_arr, n) / (T)n); \
+}
+
+I_SUM_API(f32, float, FLT_MIN, FLT_EPSILON)
+I_SUM_API(f64, double, DBL_MIN, DBL_EPSILON)
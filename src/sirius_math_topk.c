@@ -0,0 +1,219 @@
+#include "sirius_math.h"
+#include "sirius_errno.h"
+
+#include "./internal/sirius_internal_math.h"
+
+/**
+ * top-k: the first k elements are the candidates and the worst of
+ * them is the threshold. the rest of the array is scanned with
+ * `sirius_math_above_*` (`below` for the smallest), which skips the
+ * vectors that cannot beat the threshold; an element that beats it
+ * is appended to the candidates. once the buffer is full a partition
+ * keeps the best k and the threshold rises to the k-th of them, so
+ * with k << n nearly the whole array goes through the vector scan.
+ *
+ * a candidate is (value, index) and is ordered by value, then by
+ * index: ties go to the lower index, like a stable sort would do.
+ */
+
+/* candidates appended between two partitions, at least */
+#define I_TOPK_SLACK        (16)
+/* ranges this short are sorted by insertion */
+#define I_TOPK_INSERTION    (16)
+
+#define I_TOPK_ELEM(name, T, lo, hi) \
+typedef struct { \
+    T v; \
+    size_t i; \
+} i_topk_##name##_t;
+
+I_MATH_TYPES(I_TOPK_ELEM)
+
+/* `a` goes before `b` */
+#define I_TOPK_BEFORE_lg(a, b) \
+    ((a).v > (b).v || ((a).v == (b).v && (a).i < (b).i))
+#define I_TOPK_BEFORE_sm(a, b) \
+    ((a).v < (b).v || ((a).v == (b).v && (a).i < (b).i))
+
+/* value `a` beats value `b` */
+#define I_TOPK_BEATS_lg(a, b)   ((a) > (b))
+#define I_TOPK_BEATS_sm(a, b)   ((a) < (b))
+
+#define I_TOPK_SKIP_lg(name)    sirius_math_above_##name
+#define I_TOPK_SKIP_sm(name)    sirius_math_below_##name
+
+#define I_TOPK_SWAP(T, a, b) \
+    do { \
+        T t_ = (a); \
+        (a) = (b); \
+        (b) = t_; \
+    } while (0)
+
+/**
+ * @param dir: lg for the largest, sm for the smallest
+ */
+#define I_TOPK_ORDER(name, T, dir) \
+/* partition p[lo, hi] around a median of 3, returns where it lands */ \
+static size_t \
+i_topk_part_##name##_##dir(i_topk_##name##_t *p, size_t lo, size_t hi) \
+{ \
+    size_t mid = lo + (hi - lo) / 2; \
+    if (I_TOPK_BEFORE_##dir(p[mid], p[lo])) \
+        I_TOPK_SWAP(i_topk_##name##_t, p[mid], p[lo]); \
+    if (I_TOPK_BEFORE_##dir(p[hi], p[lo])) \
+        I_TOPK_SWAP(i_topk_##name##_t, p[hi], p[lo]); \
+    if (I_TOPK_BEFORE_##dir(p[hi], p[mid])) \
+        I_TOPK_SWAP(i_topk_##name##_t, p[hi], p[mid]); \
+    I_TOPK_SWAP(i_topk_##name##_t, p[mid], p[hi]); \
+ \
+    size_t s = lo; \
+    for (size_t i = lo; i < hi; i++) { \
+        if (I_TOPK_BEFORE_##dir(p[i], p[hi])) { \
+            I_TOPK_SWAP(i_topk_##name##_t, p[i], p[s]); \
+            s++; \
+        } \
+    } \
+    I_TOPK_SWAP(i_topk_##name##_t, p[s], p[hi]); \
+    return s; \
+} \
+static void \
+i_topk_insert_##name##_##dir(i_topk_##name##_t *p, size_t nr) \
+{ \
+    for (size_t i = 1; i < nr; i++) { \
+        i_topk_##name##_t x = p[i]; \
+        size_t j = i; \
+        for (; j > 0 && I_TOPK_BEFORE_##dir(x, p[j - 1]); j--) { \
+            p[j] = p[j - 1]; \
+        } \
+        p[j] = x; \
+    } \
+} \
+/* the first `k` in order to p[0, k), p[k - 1] the k-th, 0 < k <= nr */ \
+static void \
+i_topk_select_##name##_##dir(i_topk_##name##_t *p, size_t nr, size_t k) \
+{ \
+    size_t lo = 0; \
+    size_t hi = nr - 1; \
+    while (hi - lo + 1 > I_TOPK_INSERTION) { \
+        size_t s = i_topk_part_##name##_##dir(p, lo, hi); \
+        if (s == k - 1) return; \
+        if (s < k - 1) { \
+            lo = s + 1; \
+        } else { \
+            hi = s - 1; \
+        } \
+    } \
+    i_topk_insert_##name##_##dir(p + lo, hi - lo + 1); \
+} \
+static void \
+i_topk_sort_##name##_##dir(i_topk_##name##_t *p, size_t nr) \
+{ \
+    while (nr > I_TOPK_INSERTION) { \
+        size_t s = i_topk_part_##name##_##dir(p, 0, nr - 1); \
+        /* recurse into the shorter side */ \
+        if (s < nr - 1 - s) { \
+            i_topk_sort_##name##_##dir(p, s); \
+            p += s + 1; \
+            nr -= s + 1; \
+        } else { \
+            i_topk_sort_##name##_##dir(p + s + 1, nr - s - 1); \
+            nr = s; \
+        } \
+    } \
+    i_topk_insert_##name##_##dir(p, nr); \
+} \
+/* the best `k` in order to p_buf[0, k), `cap` > k unless it is `n` */ \
+static void \
+i_topk_run_##name##_##dir(const T *p_arr, size_t n, size_t k, \
+    i_topk_##name##_t *p_buf, size_t cap) \
+{ \
+    T thr = p_arr[0]; \
+    for (size_t i = 0; i < k; i++) { \
+        p_buf[i].v = p_arr[i]; \
+        p_buf[i].i = i; \
+        if (I_TOPK_BEATS_##dir(thr, p_arr[i])) thr = p_arr[i]; \
+    } \
+ \
+    size_t nr = k; \
+    size_t i = k; \
+    while (i < n) { \
+        i += I_TOPK_SKIP_##dir(name)(p_arr + i, n - i, thr); \
+        if (i == n) break; \
+        p_buf[nr].v = p_arr[i]; \
+        p_buf[nr].i = i; \
+        nr++; \
+        i++; \
+        if (nr == cap) { \
+            i_topk_select_##name##_##dir(p_buf, nr, k); \
+            nr = k; \
+            thr = p_buf[k - 1].v; \
+        } \
+    } \
+ \
+    i_topk_select_##name##_##dir(p_buf, nr, k); \
+    i_topk_sort_##name##_##dir(p_buf, k); \
+}
+
+#define I_TOPK_LG(name, T, lo, hi) I_TOPK_ORDER(name, T, lg)
+#define I_TOPK_SM(name, T, lo, hi) I_TOPK_ORDER(name, T, sm)
+
+I_MATH_TYPES(I_TOPK_LG)
+I_MATH_TYPES(I_TOPK_SM)
+
+#define I_TOPK_API(name, T, lo, hi) \
+int \
+sirius_math_topk_##name(const T *p_arr, size_t n, size_t k, \
+    sirius_math_topk_t order, T *p_val, size_t *p_idx) \
+{ \
+    if (!(p_arr) || (!(p_val) && !(p_idx))) { \
+        return SIRIUS_ERR_NULL_POINTER; \
+    } \
+    if (k > n || (SIRIUS_MATH_TOPK_LARGEST != order && \
+        SIRIUS_MATH_TOPK_SMALLEST != order)) { \
+        return SIRIUS_ERR_INVALID_PARAMETER; \
+    } \
+    if (0 == k) return SIRIUS_OK; \
+ \
+    size_t cap = k + (k > I_TOPK_SLACK ? k : I_TOPK_SLACK); \
+    cap = cap < n ? cap : n; \
+    i_topk_##name##_t *p_buf = \
+        (i_topk_##name##_t *)malloc(cap * sizeof(i_topk_##name##_t)); \
+    if (!(p_buf)) return SIRIUS_ERR_MEMORY_ALLOC; \
+ \
+    if (SIRIUS_MATH_TOPK_LARGEST == order) { \
+        i_topk_run_##name##_lg(p_arr, n, k, p_buf, cap); \
+    } else { \
+        i_topk_run_##name##_sm(p_arr, n, k, p_buf, cap); \
+    } \
+    for (size_t i = 0; i < k; i++) { \
+        if (p_val) p_val[i] = p_buf[i].v; \
+        if (p_idx) p_idx[i] = p_buf[i].i; \
+    } \
+ \
+    free(p_buf); \
+    return SIRIUS_OK; \
+} \
+int \
+sirius_math_sort_##name(T *p_arr, size_t n) \
+{ \
+    if (!(p_arr)) return SIRIUS_ERR_NULL_POINTER; \
+    if (n > SIRIUS_MATH_SORT_MAX) return SIRIUS_ERR_INVALID_PARAMETER; \
+    if (n < 2) return SIRIUS_OK; \
+ \
+    size_t nr = 2; \
+    while (nr < n) nr <<= 1; \
+    if (nr == n) { \
+        sirius_math_network_##name(p_arr, nr); \
+        return SIRIUS_OK; \
+    } \
+ \
+    /* the padding sorts behind every element */ \
+    T buf[SIRIUS_MATH_SORT_MAX]; \
+    memcpy(buf, p_arr, n * sizeof(T)); \
+    for (size_t i = n; i < nr; i++) buf[i] = hi; \
+    sirius_math_network_##name(buf, nr); \
+    memcpy(p_arr, buf, n * sizeof(T)); \
+    return SIRIUS_OK; \
+}
+
+I_MATH_TYPES(I_TOPK_API)
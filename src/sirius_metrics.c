@@ -0,0 +1,584 @@
+#include "sirius_metrics.h"
+#include "sirius_errno.h"
+#include "sirius_log.h"
+#include "sirius_lock.h"
+
+#include "./internal/sirius_internal_sys.h"
+#include "./internal/sirius_internal_thread.h"
+
+#include <ctype.h>
+
+/**
+ * the registry is an array of metrics under a lock, taken only to
+ * register, unregister and export. recording never takes it:
+ *
+ * a counter is an array of cache-line sized cells, a thread adds to
+ * the cell it was assigned on its first record with a relaxed atomic
+ * add; threads beyond `SIRIUS_METRICS_SHARD_NR` share cells, which
+ * stays correct since every update is an atomic read-modify-write.
+ *
+ * a gauge is a single double, stored as its bits; `add` is a
+ * compare-and-swap loop.
+ *
+ * the export sorts the metrics by name, so that all the series of a
+ * name follow their HELP and TYPE lines as the text format requires.
+ */
+
+/* quantiles of the exported summaries */
+static const double i_metrics_q[] = {50, 90, 99, 99.9};
+static const char *i_metrics_q_name[] = {"0.5", "0.9", "0.99", "0.999"};
+#define I_METRICS_Q_NR  (sizeof(i_metrics_q) / sizeof(i_metrics_q[0]))
+
+/* default interval of the periodic export, unit: ms */
+#define I_METRICS_INTERVAL_DEF  (10000)
+
+typedef struct {
+    atomic_ullong v;
+    char pad[64 - sizeof(atomic_ullong)];
+} i_metrics_cell_t;
+
+typedef struct {
+    sirius_metric_type_t type;
+    char *p_name;
+    char *p_help;
+    /* "" without labels */
+    char *p_labels;
+    double (*p_fn)(void *p_arg);
+    void *p_arg;
+    /* registration order, ties of the sort */
+    unsigned long long seq;
+
+    union {
+        i_metrics_cell_t *p_cells;
+        /* bits of a double */
+        atomic_ullong gauge;
+        sirius_hist_handle hist;
+    };
+} i_metric_t;
+
+typedef struct {
+    sirius_mtx_t lock;
+    i_metric_t **pp_m;
+    size_t nr;
+    size_t cap;
+    unsigned long long seq;
+} i_metrics_t;
+
+static i_metrics_t g_m = {
+    .lock = SIRIUS_MTX_INITIALIZER,
+};
+
+/* cell of the calling thread plus 1, 0 if not assigned yet */
+static __thread unsigned int i_metrics_tid = 0;
+
+static atomic_uint g_metrics_tid_next = 0;
+
+static inline unsigned int
+i_metrics_cell_id()
+{
+    if (unlikely(0 == i_metrics_tid)) {
+        i_metrics_tid = atomic_fetch_add_explicit(&g_metrics_tid_next, 1,
+            memory_order_relaxed) % SIRIUS_METRICS_SHARD_NR + 1;
+    }
+    return i_metrics_tid - 1;
+}
+
+static inline double
+i_metrics_bits2d(unsigned long long bits)
+{
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static inline unsigned long long
+i_metrics_d2bits(double v)
+{
+    unsigned long long bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static bool
+i_metrics_name_valid(const char *p_name)
+{
+    if (!(p_name) || !(isalpha((unsigned char)p_name[0]) ||
+        '_' == p_name[0] || ':' == p_name[0])) {
+        return false;
+    }
+    for (const char *p = p_name + 1; *p; p++) {
+        if (!(isalnum((unsigned char)*p) || '_' == *p || ':' == *p)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* the labels go between braces on a single line */
+static bool
+i_metrics_labels_valid(const char *p_labels)
+{
+    return !(strpbrk(p_labels, "{}\n"));
+}
+
+static void
+i_metric_free(i_metric_t *p_m)
+{
+    if (!(p_m)) return;
+    if (!(p_m->p_fn)) {
+        if (SIRIUS_METRIC_COUNTER == p_m->type) {
+            free(p_m->p_cells);
+        } else if (SIRIUS_METRIC_HIST == p_m->type && p_m->hist) {
+            (void)sirius_hist_del(p_m->hist);
+        }
+    }
+    free(p_m->p_name);
+    free(p_m->p_help);
+    free(p_m->p_labels);
+    free(p_m);
+}
+
+/**
+ * @note called with the registry locked
+ */
+static int
+i_metrics_check(const i_metric_t *p_new)
+{
+    for (size_t i = 0; i < g_m.nr; i++) {
+        const i_metric_t *p_m = g_m.pp_m[i];
+        if (strcmp(p_m->p_name, p_new->p_name)) continue;
+        if (p_m->type != p_new->type) {
+            SIRIUS_WARN("metric [%s] is registered with another type\n",
+                p_new->p_name);
+            return SIRIUS_ERR_INVALID_PARAMETER;
+        }
+        if (!(strcmp(p_m->p_labels, p_new->p_labels))) {
+            SIRIUS_WARN("metric [%s{%s}] is already registered\n",
+                p_new->p_name, p_new->p_labels);
+            return SIRIUS_ERR_INVALID_PARAMETER;
+        }
+    }
+    return SIRIUS_OK;
+}
+
+int
+sirius_metrics_register(const sirius_metric_attr_t *p_attr,
+    sirius_metric_handle *p_handle)
+{
+    if (!(p_attr) || !(p_handle)) return SIRIUS_ERR_NULL_POINTER;
+    if (p_attr->type < 0 || p_attr->type >= SIRIUS_METRIC_MAX ||
+        !(i_metrics_name_valid(p_attr->p_name)) ||
+        (p_attr->p_labels && !(i_metrics_labels_valid(p_attr->p_labels))) ||
+        (p_attr->p_fn && SIRIUS_METRIC_HIST == p_attr->type)) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    i_metric_t *p_m = (i_metric_t *)calloc(1, sizeof(i_metric_t));
+    if (!(p_m)) return SIRIUS_ERR_MEMORY_ALLOC;
+    p_m->type = p_attr->type;
+    p_m->p_fn = p_attr->p_fn;
+    p_m->p_arg = p_attr->p_arg;
+    p_m->p_name = strdup(p_attr->p_name);
+    p_m->p_help = p_attr->p_help ? strdup(p_attr->p_help) : NULL;
+    p_m->p_labels = strdup(p_attr->p_labels ? p_attr->p_labels : "");
+    if (!(p_m->p_name) || !(p_m->p_labels) ||
+        (p_attr->p_help && !(p_m->p_help))) {
+        i_metric_free(p_m);
+        return SIRIUS_ERR_MEMORY_ALLOC;
+    }
+
+    int ret = SIRIUS_OK;
+    if (!(p_m->p_fn)) {
+        switch (p_m->type) {
+            case SIRIUS_METRIC_COUNTER:
+                p_m->p_cells = (i_metrics_cell_t *)aligned_alloc(64,
+                    sizeof(i_metrics_cell_t) * SIRIUS_METRICS_SHARD_NR);
+                if (!(p_m->p_cells)) {
+                    ret = SIRIUS_ERR_MEMORY_ALLOC;
+                    break;
+                }
+                for (int i = 0; i < SIRIUS_METRICS_SHARD_NR; i++) {
+                    atomic_init(&(p_m->p_cells[i].v), 0);
+                }
+                break;
+            case SIRIUS_METRIC_GAUGE:
+                atomic_init(&(p_m->gauge), i_metrics_d2bits(0));
+                break;
+            default: {
+                sirius_hist_cr_t cr = {.sig_bits = p_attr->sig_bits};
+                ret = sirius_hist_cr(&cr, &(p_m->hist));
+                break;
+            }
+        }
+    }
+    if (ret) {
+        i_metric_free(p_m);
+        return ret;
+    }
+
+    sirius_mtx_lock(&(g_m.lock));
+    ret = i_metrics_check(p_m);
+    if (!(ret) && g_m.nr == g_m.cap) {
+        size_t cap = g_m.cap ? g_m.cap * 2 : 32;
+        i_metric_t **pp = (i_metric_t **)realloc(g_m.pp_m,
+            cap * sizeof(i_metric_t *));
+        if (pp) {
+            g_m.pp_m = pp;
+            g_m.cap = cap;
+        } else {
+            ret = SIRIUS_ERR_MEMORY_ALLOC;
+        }
+    }
+    if (!(ret)) {
+        p_m->seq = g_m.seq++;
+        g_m.pp_m[g_m.nr++] = p_m;
+    }
+    sirius_mtx_unlock(&(g_m.lock));
+
+    if (ret) {
+        i_metric_free(p_m);
+        return ret;
+    }
+    *p_handle = (sirius_metric_handle)p_m;
+    return SIRIUS_OK;
+}
+
+int
+sirius_metrics_unregister(sirius_metric_handle handle)
+{
+    if (!(handle)) return SIRIUS_ERR_NULL_POINTER;
+
+    i_metric_t *p_m = NULL;
+    sirius_mtx_lock(&(g_m.lock));
+    for (size_t i = 0; i < g_m.nr; i++) {
+        if (g_m.pp_m[i] == (i_metric_t *)handle) {
+            p_m = g_m.pp_m[i];
+            g_m.pp_m[i] = g_m.pp_m[--g_m.nr];
+            break;
+        }
+    }
+    sirius_mtx_unlock(&(g_m.lock));
+
+    if (!(p_m)) return SIRIUS_ERR_INVALID_PARAMETER;
+    i_metric_free(p_m);
+    return SIRIUS_OK;
+}
+
+void
+sirius_metrics_counter_add(sirius_metric_handle handle,
+    unsigned long long n)
+{
+    i_metric_t *p_m = (i_metric_t *)handle;
+    atomic_fetch_add_explicit(&(p_m->p_cells[i_metrics_cell_id()].v), n,
+        memory_order_relaxed);
+}
+
+void
+sirius_metrics_gauge_set(sirius_metric_handle handle, double v)
+{
+    i_metric_t *p_m = (i_metric_t *)handle;
+    atomic_store_explicit(&(p_m->gauge), i_metrics_d2bits(v),
+        memory_order_relaxed);
+}
+
+void
+sirius_metrics_gauge_add(sirius_metric_handle handle, double d)
+{
+    i_metric_t *p_m = (i_metric_t *)handle;
+    unsigned long long old = atomic_load_explicit(&(p_m->gauge),
+        memory_order_relaxed);
+    while (!(atomic_compare_exchange_weak_explicit(&(p_m->gauge), &old,
+        i_metrics_d2bits(i_metrics_bits2d(old) + d),
+        memory_order_relaxed, memory_order_relaxed))) {}
+}
+
+void
+sirius_metrics_hist_record(sirius_metric_handle handle, uint64_t v)
+{
+    sirius_hist_record(((i_metric_t *)handle)->hist, v);
+}
+
+static double
+i_metrics_value(const i_metric_t *p_m)
+{
+    if (p_m->p_fn) return p_m->p_fn(p_m->p_arg);
+
+    if (SIRIUS_METRIC_GAUGE == p_m->type) {
+        return i_metrics_bits2d(atomic_load_explicit(&(p_m->gauge),
+            memory_order_relaxed));
+    }
+    unsigned long long sum = 0;
+    for (int i = 0; i < SIRIUS_METRICS_SHARD_NR; i++) {
+        sum += atomic_load_explicit(&(p_m->p_cells[i].v),
+            memory_order_relaxed);
+    }
+    return (double)sum;
+}
+
+double
+sirius_metrics_value(sirius_metric_handle handle)
+{
+    if (!(handle)) return 0;
+    const i_metric_t *p_m = (const i_metric_t *)handle;
+    if (SIRIUS_METRIC_HIST == p_m->type) return 0;
+    return i_metrics_value(p_m);
+}
+
+sirius_hist_handle
+sirius_metrics_hist(sirius_metric_handle handle)
+{
+    if (!(handle)) return NULL;
+    const i_metric_t *p_m = (const i_metric_t *)handle;
+    return SIRIUS_METRIC_HIST == p_m->type ? p_m->hist : NULL;
+}
+
+/* export */
+
+static int
+i_metrics_cmp(const void *p_a, const void *p_b)
+{
+    const i_metric_t *p_ma = *(const i_metric_t * const *)p_a;
+    const i_metric_t *p_mb = *(const i_metric_t * const *)p_b;
+    int ret = strcmp(p_ma->p_name, p_mb->p_name);
+    if (ret) return ret;
+    return p_ma->seq < p_mb->seq ? -1 : 1;
+}
+
+static void
+i_metrics_write_double(FILE *p_f, double v)
+{
+    if (isnan(v)) {
+        fputs("NaN", p_f);
+    } else if (isinf(v)) {
+        fputs(v > 0 ? "+Inf" : "-Inf", p_f);
+    } else if (v == (double)(long long)v && fabs(v) < 1e15) {
+        fprintf(p_f, "%lld", (long long)v);
+    } else {
+        fprintf(p_f, "%.17g", v);
+    }
+}
+
+static void
+i_metrics_write_help(FILE *p_f, const i_metric_t *p_m)
+{
+    static const char *p_type[SIRIUS_METRIC_MAX] = {
+        [SIRIUS_METRIC_COUNTER] = "counter",
+        [SIRIUS_METRIC_GAUGE]   = "gauge",
+        [SIRIUS_METRIC_HIST]    = "summary",
+    };
+
+    if (p_m->p_help) {
+        fprintf(p_f, "# HELP %s ", p_m->p_name);
+        for (const char *p = p_m->p_help; *p; p++) {
+            if ('\\' == *p) {
+                fputs("\\\\", p_f);
+            } else if ('\n' == *p) {
+                fputs("\\n", p_f);
+            } else {
+                fputc(*p, p_f);
+            }
+        }
+        fputc('\n', p_f);
+    }
+    fprintf(p_f, "# TYPE %s %s\n", p_m->p_name, p_type[p_m->type]);
+}
+
+/**
+ * @param p_suffix: appended to the name
+ * @param p_extra: one more label, may be NULL
+ */
+static void
+i_metrics_write_series(FILE *p_f, const i_metric_t *p_m,
+    const char *p_suffix, const char *p_extra)
+{
+    fprintf(p_f, "%s%s", p_m->p_name, p_suffix);
+    if (p_m->p_labels[0] || p_extra) {
+        fprintf(p_f, "{%s%s%s}", p_m->p_labels,
+            p_m->p_labels[0] && p_extra ? "," : "",
+            p_extra ? p_extra : "");
+    }
+    fputc(' ', p_f);
+}
+
+static void
+i_metrics_write_summary(FILE *p_f, const i_metric_t *p_m)
+{
+    sirius_hist_res_t res = {0};
+    uint64_t val[I_METRICS_Q_NR] = {0};
+    if (sirius_hist_query(p_m->hist, &res, i_metrics_q, val,
+            I_METRICS_Q_NR)) {
+        return;
+    }
+
+    char extra[32];
+    for (size_t i = 0; i < I_METRICS_Q_NR; i++) {
+        snprintf(extra, sizeof(extra), "quantile=\"%s\"",
+            i_metrics_q_name[i]);
+        i_metrics_write_series(p_f, p_m, "", extra);
+        if (res.count) {
+            fprintf(p_f, "%llu\n", (unsigned long long)val[i]);
+        } else {
+            fputs("NaN\n", p_f);
+        }
+    }
+    i_metrics_write_series(p_f, p_m, "_sum", NULL);
+    i_metrics_write_double(p_f, res.mean * (double)res.count);
+    fputc('\n', p_f);
+    i_metrics_write_series(p_f, p_m, "_count", NULL);
+    fprintf(p_f, "%llu\n", res.count);
+}
+
+int
+sirius_metrics_write(FILE *p_f)
+{
+    if (!(p_f)) return SIRIUS_ERR_NULL_POINTER;
+
+    sirius_mtx_lock(&(g_m.lock));
+    /* the lock keeps the metrics alive while their callbacks run */
+    qsort(g_m.pp_m, g_m.nr, sizeof(i_metric_t *), i_metrics_cmp);
+
+    const char *p_prev = NULL;
+    for (size_t i = 0; i < g_m.nr; i++) {
+        const i_metric_t *p_m = g_m.pp_m[i];
+        if (!(p_prev) || strcmp(p_prev, p_m->p_name)) {
+            i_metrics_write_help(p_f, p_m);
+            p_prev = p_m->p_name;
+        }
+
+        if (SIRIUS_METRIC_HIST == p_m->type) {
+            i_metrics_write_summary(p_f, p_m);
+            continue;
+        }
+        i_metrics_write_series(p_f, p_m, "", NULL);
+        i_metrics_write_double(p_f, i_metrics_value(p_m));
+        fputc('\n', p_f);
+    }
+    sirius_mtx_unlock(&(g_m.lock));
+
+    return ferror(p_f) ? SIRIUS_ERR : SIRIUS_OK;
+}
+
+int
+sirius_metrics_dump(const char *p_path)
+{
+    if (!(p_path) || !(p_path[0])) return SIRIUS_ERR_NULL_POINTER;
+
+    char tmp[PATH_MAX];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", p_path) >= (int)sizeof(tmp)) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    FILE *p_f = fopen(tmp, "w");
+    if (!(p_f)) {
+        SIRIUS_WARN("fopen [%s]: %s\n", tmp, strerror(errno));
+        return SIRIUS_ERR_RESOURCE_REQUEST;
+    }
+    int ret = sirius_metrics_write(p_f);
+    if (fclose(p_f)) ret = SIRIUS_ERR;
+    if (!(ret) && rename(tmp, p_path)) {
+        SIRIUS_WARN("rename [%s]: %s\n", p_path, strerror(errno));
+        ret = SIRIUS_ERR;
+    }
+    if (ret) (void)unlink(tmp);
+    return ret;
+}
+
+/* periodic export */
+
+typedef struct {
+    pthread_t id;
+    bool run;
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+    unsigned int interval_ms;
+    char path[PATH_MAX];
+} i_metrics_exp_t;
+
+static i_metrics_exp_t *g_exp = NULL;
+
+static void *
+i_metrics_exp_thd(void *args)
+{
+    i_metrics_exp_t *p_e = (i_metrics_exp_t *)args;
+
+    pthread_mutex_lock(&(p_e->mtx));
+    while (p_e->run) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        uint64_t end = (uint64_t)ts.tv_sec * 1000000000ULL +
+            (uint64_t)ts.tv_nsec + (uint64_t)p_e->interval_ms * 1000000ULL;
+        ts.tv_sec = (time_t)(end / 1000000000ULL);
+        ts.tv_nsec = (long)(end % 1000000000ULL);
+
+        while (p_e->run &&
+            ETIMEDOUT != pthread_cond_timedwait(&(p_e->cond),
+                &(p_e->mtx), &ts)) {}
+        if (!(p_e->run)) break;
+
+        pthread_mutex_unlock(&(p_e->mtx));
+        (void)sirius_metrics_dump(p_e->path);
+        pthread_mutex_lock(&(p_e->mtx));
+    }
+    pthread_mutex_unlock(&(p_e->mtx));
+
+    return NULL;
+}
+
+int
+sirius_metrics_init(const sirius_metrics_export_t *p_exp)
+{
+    if (!(p_exp) || !(p_exp->p_path) || !(p_exp->p_path[0])) {
+        return SIRIUS_OK;
+    }
+    if (g_exp) return SIRIUS_ERR_INIT_REPEATED;
+    if (strlen(p_exp->p_path) + sizeof(".tmp") > PATH_MAX) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    i_metrics_exp_t *p_e = (i_metrics_exp_t *)calloc(1,
+        sizeof(i_metrics_exp_t));
+    if (!(p_e)) return SIRIUS_ERR_MEMORY_ALLOC;
+    strcpy(p_e->path, p_exp->p_path);
+    p_e->interval_ms = p_exp->interval_ms ?
+        p_exp->interval_ms : I_METRICS_INTERVAL_DEF;
+    p_e->run = true;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&(p_e->mtx), NULL);
+    pthread_cond_init(&(p_e->cond), &attr);
+    pthread_condattr_destroy(&attr);
+
+    int ret = sirius_thread_internal_create(&(p_e->id), "sirius-metrics",
+        false, i_metrics_exp_thd, p_e);
+    if (ret) {
+        pthread_cond_destroy(&(p_e->cond));
+        pthread_mutex_destroy(&(p_e->mtx));
+        free(p_e);
+        return ret;
+    }
+
+    g_exp = p_e;
+    return SIRIUS_OK;
+}
+
+void
+sirius_metrics_deinit()
+{
+    i_metrics_exp_t *p_e = g_exp;
+    if (!(p_e)) return;
+    g_exp = NULL;
+
+    pthread_mutex_lock(&(p_e->mtx));
+    p_e->run = false;
+    pthread_cond_signal(&(p_e->cond));
+    pthread_mutex_unlock(&(p_e->mtx));
+    pthread_join(p_e->id, NULL);
+
+    (void)sirius_metrics_dump(p_e->path);
+
+    pthread_cond_destroy(&(p_e->cond));
+    pthread_mutex_destroy(&(p_e->mtx));
+    free(p_e);
+}
@@ -1,9 +1,58 @@
 #include "sirius_queue.h"
 #include "sirius_log.h"
 #include "sirius_errno.h"
+#include "sirius_lock.h"
+#include "sirius_config.h"
+#include "sirius_trace.h"
+#include "sirius_metrics.h"
 
 #include "./internal/sirius_internal_sys.h"
 
+#include <sched.h>
+
+/**
+ * wait strategy of `SIRIUS_QUE_TYPE_MTX`, configuration keys:
+ * "que.spin": how long an empty (full) queue is polled without
+ *  the lock before sleeping on the condition variable, in `pause`
+ *  instructions with exponential backoff between the polls,
+ *  0 sleeps at once
+ * "que.yield": yield the cpu between the polls instead, each
+ *  yield counts as one
+ */
+#define I_QUE_SPIN_KEY      "que.spin"
+#define I_QUE_YIELD_KEY     "que.yield"
+
+/* upper limit of "que.spin" */
+#define I_QUE_SPIN_MAX      (1 << 20)
+
+static int g_spin_id = -1;
+static int g_yield_id = -1;
+static pthread_once_t g_cfg_once = PTHREAD_ONCE_INIT;
+
+static void
+i_que_cfg_init()
+{
+    sirius_cfg_attr_t attr = {
+        .p_name = I_QUE_SPIN_KEY,
+        .def = 0,
+        .min = 0,
+        .max = I_QUE_SPIN_MAX,
+    };
+    int spin_id = sirius_cfg_register(&attr);
+
+    attr.p_name = I_QUE_YIELD_KEY;
+    attr.max = 1;
+    int yield_id = sirius_cfg_register(&attr);
+
+    if (spin_id < 0 || yield_id < 0) {
+        SIRIUS_WARN("sirius_cfg_register: [%d] [%d]\n",
+            spin_id, yield_id);
+        return;
+    }
+    g_spin_id = spin_id;
+    g_yield_id = yield_id;
+}
+
 typedef struct {
     /* queue elements */
     size_t *elements;
@@ -30,8 +79,44 @@ typedef struct {
     pthread_cond_t cond_non_empty;
     /* condition variable for non-full queue */
     pthread_cond_t cond_non_full;
+
+    /* depth gauge, NULL if the queue is not named */
+    sirius_metric_handle metric;
 } i_queue_t;
 
+static double
+i_que_depth(void *p_arg)
+{
+    i_queue_t *q = (i_queue_t *)p_arg;
+    return (double)__atomic_load_n(&(q->elem_nr), __ATOMIC_RELAXED);
+}
+
+/* a queue whose depth cannot be exported still works */
+static void
+i_que_metric_register(i_queue_t *q, const char *p_name)
+{
+    char labels[128];
+    if (snprintf(labels, sizeof(labels), "que=\"%s\"", p_name) >=
+            (int)sizeof(labels) || strpbrk(p_name, "\"\\")) {
+        SIRIUS_WARN("queue name: [%s]\n", p_name);
+        return;
+    }
+
+    sirius_metric_attr_t attr = {
+        .type = SIRIUS_METRIC_GAUGE,
+        .p_name = "sirius_que_depth",
+        .p_help = "Elements in the queue.",
+        .p_labels = labels,
+        .p_fn = i_que_depth,
+        .p_arg = q,
+    };
+    int ret = sirius_metrics_register(&attr, &(q->metric));
+    if (ret) {
+        SIRIUS_WARN("sirius_metrics_register: [%d]\n", ret);
+        q->metric = NULL;
+    }
+}
+
 int
 sirius_que_cr(sirius_que_cr_t *p_cr,
     sirius_que_handle *p_handle)
@@ -41,6 +126,8 @@ sirius_que_cr(sirius_que_cr_t *p_cr,
         return SIRIUS_ERR_NULL_POINTER;
     }
 
+    (void)pthread_once(&g_cfg_once, i_que_cfg_init);
+
     i_queue_t *q = (i_queue_t *)calloc(1, sizeof(i_queue_t));
     if (!(q)) {
         SIRIUS_ERROR("calloc\n");
@@ -61,11 +148,18 @@ sirius_que_cr(sirius_que_cr_t *p_cr,
     }
 
     if (q->type == SIRIUS_QUE_TYPE_MTX) {
+        /* the timeouts do not jump with the wall clock */
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
         pthread_mutex_init(&(q->mutex), NULL);
-        pthread_cond_init(&(q->cond_non_empty), NULL);
-        pthread_cond_init(&(q->cond_non_full), NULL);
+        pthread_cond_init(&(q->cond_non_empty), &attr);
+        pthread_cond_init(&(q->cond_non_full), &attr);
+        pthread_condattr_destroy(&attr);
     }
 
+    if (p_cr->p_name) i_que_metric_register(q, p_cr->p_name);
+
     *p_handle = (sirius_que_handle)q;
     return SIRIUS_OK;
 }
@@ -79,6 +173,7 @@ sirius_que_del(sirius_que_handle handle)
     }
 
     i_queue_t *q = (i_queue_t *)handle;
+    if (q->metric) (void)sirius_metrics_unregister(q->metric);
     
     if (q->type == SIRIUS_QUE_TYPE_MTX) {
         pthread_cond_destroy(&(q->cond_non_full));
@@ -93,19 +188,68 @@ sirius_que_del(sirius_que_handle handle)
     return SIRIUS_OK;
 }
 
+/**
+ * @brief poll the queue without the lock before sleeping
+ * 
+ * @note called with the lock held
+ * 
+ * @return true if `elem_nr` no longer equals `wait_nr`
+ */
+static bool
+i_que_spin(i_queue_t *q, unsigned short wait_nr)
+{
+    if (g_spin_id < 0) return false;
+
+    const sirius_cfg_snap_t *p_snap = sirius_cfg_snap_acquire();
+    long long spin = p_snap->vals[g_spin_id];
+    bool yield = p_snap->vals[g_yield_id];
+    sirius_cfg_snap_release();
+    if (spin <= 0) return false;
+
+    pthread_mutex_unlock(&(q->mutex));
+    unsigned int n = 1;
+    for (long long spent = 0; spent < spin; ) {
+        if (__atomic_load_n(&(q->elem_nr), __ATOMIC_RELAXED) != wait_nr) {
+            break;
+        }
+        if (yield) {
+            (void)sched_yield();
+            spent++;
+        } else {
+            spent += n;
+            (void)sirius_backoff(&n);
+        }
+    }
+    pthread_mutex_lock(&(q->mutex));
+
+    return q->elem_nr != wait_nr;
+}
+
+/**
+ * @param p_span: name of the trace span of the wait
+ */
 static inline int
 i_que_wait(i_queue_t *q, unsigned int timeout,
-    pthread_cond_t *p_cond, unsigned short wait_nr)
+    pthread_cond_t *p_cond, unsigned short wait_nr, const char *p_span)
 {
     if (q->elem_nr != wait_nr) {
         return SIRIUS_OK;
     }
+    SIRIUS_TRACE_SCOPE_ARG(p_span, timeout);
 
+    if (timeout != SIRIUS_QUE_TIMEOUT_NONE &&
+        i_que_spin(q, wait_nr)) {
+        return SIRIUS_OK;
+    }
+
+    /* the deadline is on the clock of the condition, not the tsc */
     struct timespec ts;
     if (timeout != SIRIUS_QUE_TIMEOUT_NONE) {
-        clock_gettime(CLOCK_REALTIME, &ts);
-        ts.tv_sec += timeout / 1000;
-        ts.tv_nsec += (timeout % 1000) * 1000000;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        uint64_t end = (uint64_t)ts.tv_sec * 1000000000ULL +
+            (uint64_t)ts.tv_nsec + (uint64_t)timeout * 1000000ULL;
+        ts.tv_sec = (time_t)(end / 1000000000ULL);
+        ts.tv_nsec = (long)(end % 1000000000ULL);
     }
 
     int ret = SIRIUS_OK;
@@ -114,15 +258,23 @@ i_que_wait(i_queue_t *q, unsigned int timeout,
             ret = SIRIUS_ERR;
             break;
         case SIRIUS_QUE_TIMEOUT_INFINITE:
-            pthread_cond_wait(
-                p_cond, &(q->mutex));
+            /* recheck after every wakeup, it may be spurious */
+            while (q->elem_nr == wait_nr) {
+                pthread_cond_wait(
+                    p_cond, &(q->mutex));
+            }
+            break;
         default:
-            if (pthread_cond_timedwait(
-                    p_cond, &(q->mutex), &ts) == ETIMEDOUT) {
-                SIRIUS_DEBG("timeout\n");
-                ret = SIRIUS_ERR_TIMEOUT;
-                break;
+            while (q->elem_nr == wait_nr) {
+                if (pthread_cond_timedwait(
+                        p_cond, &(q->mutex), &ts) == ETIMEDOUT &&
+                    q->elem_nr == wait_nr) {
+                    SIRIUS_DEBG("timeout\n");
+                    ret = SIRIUS_ERR_TIMEOUT;
+                    break;
+                }
             }
+            break;
     }
 
     return ret;
@@ -174,7 +326,8 @@ sirius_que_get(sirius_que_handle handle,
     q->front = (q->front + 1) % q->capacity; \
     (q->elem_nr)--;
 #define W \
-    i_que_wait(q, timeout, &(q->cond_non_empty), 0)
+    i_que_wait(q, timeout, &(q->cond_non_empty), 0, \
+        "sirius_que_get.wait")
 
     I_QUE_VAR(ret, q->type, q->mutex, q->cond_non_full);
 #undef W
@@ -199,7 +352,8 @@ sirius_que_put(sirius_que_handle handle,
     q->rear = (q->rear + 1) % q->capacity; \
     (q->elem_nr)++;
 #define W \
-    i_que_wait(q, timeout, &(q->cond_non_full), q->capacity)
+    i_que_wait(q, timeout, &(q->cond_non_full), q->capacity, \
+        "sirius_que_put.wait")
 
     I_QUE_VAR(ret, q->type, q->mutex, q->cond_non_empty);
 #undef W
@@ -0,0 +1,428 @@
+#include "sirius_errno.h"
+#include "sirius_stats.h"
+
+#include "./internal/sirius_internal_sys.h"
+
+/* Welford */
+
+void
+sirius_stats_init(sirius_stats_t *p_s)
+{
+    p_s->n = 0;
+    p_s->mean = 0;
+    p_s->m2 = 0;
+    p_s->min = INFINITY;
+    p_s->max = -INFINITY;
+}
+
+void
+sirius_stats_merge(sirius_stats_t *p_dst, const sirius_stats_t *p_src)
+{
+    if (0 == p_src->n) return;
+    if (0 == p_dst->n) {
+        *p_dst = *p_src;
+        return;
+    }
+
+    /* Chan et al., parallel variance */
+    double na = (double)(p_dst->n);
+    double nb = (double)(p_src->n);
+    double n = na + nb;
+    double delta = p_src->mean - p_dst->mean;
+
+    p_dst->mean += delta * nb / n;
+    p_dst->m2 += p_src->m2 + delta * delta * na * nb / n;
+    p_dst->n += p_src->n;
+    if (p_src->min < p_dst->min) p_dst->min = p_src->min;
+    if (p_src->max > p_dst->max) p_dst->max = p_src->max;
+}
+
+double
+sirius_stats_var(const sirius_stats_t *p_s)
+{
+    if (p_s->n < 2) return 0;
+    return p_s->m2 / (double)(p_s->n - 1);
+}
+
+double
+sirius_stats_stddev(const sirius_stats_t *p_s)
+{
+    return sqrt(sirius_stats_var(p_s));
+}
+
+/* EWMA */
+
+int
+sirius_ewma_init(sirius_ewma_t *p_e, double alpha)
+{
+    if (!(p_e)) return SIRIUS_ERR_NULL_POINTER;
+    if (!(alpha > 0 && alpha <= 1)) return SIRIUS_ERR_INVALID_PARAMETER;
+
+    p_e->alpha = alpha;
+    p_e->val = 0;
+    p_e->init = false;
+    return SIRIUS_OK;
+}
+
+/* histogram */
+
+/**
+ * with p = sig_bits, S = 2^p and H = S / 2:
+ * values below S have a bucket each; above that, every power of two
+ * [2^m, 2^(m + 1)) is split into H buckets of width 2^(m - p + 1).
+ * 
+ * a thread records into its own shard with relaxed atomics only,
+ * a query sums the shards without stopping the recorders. threads
+ * beyond `SIRIUS_HIST_SHARD_MAX` share shards, which stays correct
+ * since every update is an atomic read-modify-write.
+ */
+
+typedef struct {
+    atomic_ullong count;
+    atomic_ullong sum;
+    atomic_ullong min;
+    atomic_ullong max;
+    atomic_ullong buckets[];
+} i_hist_shard_t;
+
+typedef struct {
+    unsigned int sig_bits;
+    unsigned int bucket_nr;
+
+    /* allocated on the first record of a thread, 0 at creation */
+    _Atomic(i_hist_shard_t *) p_shards[SIRIUS_HIST_SHARD_MAX];
+} i_hist_t;
+
+/* shard of the calling thread plus 1, 0 if not assigned yet */
+static __thread unsigned int i_hist_tid = 0;
+
+static atomic_uint g_hist_tid_next = 0;
+
+static inline unsigned int
+i_hist_shard_id()
+{
+    if (unlikely(0 == i_hist_tid)) {
+        i_hist_tid = atomic_fetch_add_explicit(&g_hist_tid_next, 1,
+            memory_order_relaxed) % SIRIUS_HIST_SHARD_MAX + 1;
+    }
+    return i_hist_tid - 1;
+}
+
+static inline unsigned int
+i_hist_index(const i_hist_t *p_h, uint64_t v)
+{
+    unsigned int p = p_h->sig_bits;
+    if (v < (1ULL << p)) return (unsigned int)v;
+
+    unsigned int shift = (63 - __builtin_clzll(v)) - p + 1;
+    unsigned int half = 1U << (p - 1);
+    return (1U << p) + (shift - 1) * half +
+        (unsigned int)(v >> shift) - half;
+}
+
+/**
+ * @return the highest value that falls into the bucket
+ */
+static inline uint64_t
+i_hist_value(const i_hist_t *p_h, unsigned int idx)
+{
+    unsigned int p = p_h->sig_bits;
+    if (idx < (1U << p)) return idx;
+
+    unsigned int half = 1U << (p - 1);
+    unsigned int k = idx - (1U << p);
+    unsigned int shift = k / half + 1;
+    uint64_t sub = k % half + half;
+    return (sub << shift) + ((1ULL << shift) - 1);
+}
+
+static void
+i_hist_shard_reset(const i_hist_t *p_h, i_hist_shard_t *p_s)
+{
+    for (unsigned int i = 0; i < p_h->bucket_nr; i++) {
+        atomic_store_explicit(&(p_s->buckets[i]), 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&(p_s->count), 0, memory_order_relaxed);
+    atomic_store_explicit(&(p_s->sum), 0, memory_order_relaxed);
+    atomic_store_explicit(&(p_s->min), UINT64_MAX, memory_order_relaxed);
+    atomic_store_explicit(&(p_s->max), 0, memory_order_relaxed);
+}
+
+static i_hist_shard_t *
+i_hist_shard_alloc(const i_hist_t *p_h)
+{
+    size_t size = sizeof(i_hist_shard_t) +
+        p_h->bucket_nr * sizeof(atomic_ullong);
+    /* whole cache lines, two shards never share one */
+    size = (size + 63) & ~(size_t)63;
+
+    i_hist_shard_t *p_s = (i_hist_shard_t *)aligned_alloc(64, size);
+    if (!(p_s)) return NULL;
+    i_hist_shard_reset(p_h, p_s);
+    return p_s;
+}
+
+/**
+ * @return the shard `id`, shard 0 if it can't be allocated
+ */
+static i_hist_shard_t *
+i_hist_shard_cr(i_hist_t *p_h, unsigned int id)
+{
+    i_hist_shard_t *p_new = i_hist_shard_alloc(p_h);
+    if (!(p_new)) {
+        return atomic_load_explicit(&(p_h->p_shards[0]),
+            memory_order_acquire);
+    }
+
+    /* threads sharing the id race to publish it */
+    i_hist_shard_t *p_cur = NULL;
+    if (atomic_compare_exchange_strong_explicit(&(p_h->p_shards[id]),
+            &p_cur, p_new, memory_order_acq_rel, memory_order_acquire)) {
+        return p_new;
+    }
+    free(p_new);
+    return p_cur;
+}
+
+static inline void
+i_hist_minmax(i_hist_shard_t *p_s, uint64_t mn, uint64_t mx)
+{
+    unsigned long long cur = atomic_load_explicit(&(p_s->min),
+        memory_order_relaxed);
+    while (mn < cur && !(atomic_compare_exchange_weak_explicit(
+            &(p_s->min), &cur, mn,
+            memory_order_relaxed, memory_order_relaxed))) {}
+
+    cur = atomic_load_explicit(&(p_s->max), memory_order_relaxed);
+    while (mx > cur && !(atomic_compare_exchange_weak_explicit(
+            &(p_s->max), &cur, mx,
+            memory_order_relaxed, memory_order_relaxed))) {}
+}
+
+/**
+ * @brief the sum saturates at UINT64_MAX instead of wrapping around,
+ *  a single `v * n` near 2^64 would otherwise turn the mean into noise
+ */
+static inline void
+i_hist_sum_add(atomic_ullong *p_sum, unsigned long long add)
+{
+    unsigned long long cur = atomic_load_explicit(p_sum,
+        memory_order_relaxed);
+    unsigned long long sum;
+    do {
+        sum = cur > ULLONG_MAX - add ? ULLONG_MAX : cur + add;
+    } while (!(atomic_compare_exchange_weak_explicit(p_sum, &cur, sum,
+        memory_order_relaxed, memory_order_relaxed)));
+}
+
+int
+sirius_hist_cr(const sirius_hist_cr_t *p_cr, sirius_hist_handle *p_handle)
+{
+    if (!(p_cr) || !(p_handle)) return SIRIUS_ERR_NULL_POINTER;
+    if (p_cr->sig_bits < SIRIUS_HIST_SIG_BITS_MIN ||
+        p_cr->sig_bits > SIRIUS_HIST_SIG_BITS_MAX) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    i_hist_t *p_h = (i_hist_t *)calloc(1, sizeof(i_hist_t));
+    if (!(p_h)) return SIRIUS_ERR_MEMORY_ALLOC;
+
+    unsigned int p = p_cr->sig_bits;
+    p_h->sig_bits = p;
+    p_h->bucket_nr = (1U << p) + (64 - p) * (1U << (p - 1));
+
+    /* shard 0 always exists, merges and failed allocations land there */
+    i_hist_shard_t *p_s = i_hist_shard_alloc(p_h);
+    if (!(p_s)) {
+        free(p_h);
+        return SIRIUS_ERR_MEMORY_ALLOC;
+    }
+    atomic_init(&(p_h->p_shards[0]), p_s);
+
+    *p_handle = (sirius_hist_handle)p_h;
+    return SIRIUS_OK;
+}
+
+int
+sirius_hist_del(sirius_hist_handle handle)
+{
+    if (!(handle)) return SIRIUS_ERR_NULL_POINTER;
+
+    i_hist_t *p_h = (i_hist_t *)handle;
+    for (int i = 0; i < SIRIUS_HIST_SHARD_MAX; i++) {
+        free(atomic_load_explicit(&(p_h->p_shards[i]),
+            memory_order_acquire));
+    }
+    free(p_h);
+    return SIRIUS_OK;
+}
+
+void
+sirius_hist_record_n(sirius_hist_handle handle, uint64_t v,
+    unsigned long long n)
+{
+    i_hist_t *p_h = (i_hist_t *)handle;
+    unsigned int id = i_hist_shard_id();
+
+    i_hist_shard_t *p_s = atomic_load_explicit(&(p_h->p_shards[id]),
+        memory_order_acquire);
+    if (unlikely(!(p_s))) p_s = i_hist_shard_cr(p_h, id);
+
+    atomic_fetch_add_explicit(&(p_s->buckets[i_hist_index(p_h, v)]), n,
+        memory_order_relaxed);
+    atomic_fetch_add_explicit(&(p_s->count), n, memory_order_relaxed);
+    unsigned long long add;
+    if (__builtin_mul_overflow(v, n, &add)) add = ULLONG_MAX;
+    i_hist_sum_add(&(p_s->sum), add);
+    i_hist_minmax(p_s, v, v);
+}
+
+/**
+ * @brief sum the shards of `p_h` into `p_buckets` and `p_tot`
+ */
+static void
+i_hist_collect(i_hist_t *p_h, unsigned long long *p_buckets,
+    i_hist_shard_t *p_tot)
+{
+    for (int i = 0; i < SIRIUS_HIST_SHARD_MAX; i++) {
+        i_hist_shard_t *p_s = atomic_load_explicit(
+            &(p_h->p_shards[i]), memory_order_acquire);
+        if (!(p_s)) continue;
+
+        for (unsigned int k = 0; k < p_h->bucket_nr; k++) {
+            p_buckets[k] += atomic_load_explicit(&(p_s->buckets[k]),
+                memory_order_relaxed);
+        }
+        atomic_fetch_add_explicit(&(p_tot->count),
+            atomic_load_explicit(&(p_s->count), memory_order_relaxed),
+            memory_order_relaxed);
+        i_hist_sum_add(&(p_tot->sum),
+            atomic_load_explicit(&(p_s->sum), memory_order_relaxed));
+        i_hist_minmax(p_tot,
+            atomic_load_explicit(&(p_s->min), memory_order_relaxed),
+            atomic_load_explicit(&(p_s->max), memory_order_relaxed));
+    }
+}
+
+int
+sirius_hist_merge(sirius_hist_handle dst, sirius_hist_handle src)
+{
+    if (!(dst) || !(src)) return SIRIUS_ERR_NULL_POINTER;
+
+    i_hist_t *p_dst = (i_hist_t *)dst;
+    i_hist_t *p_src = (i_hist_t *)src;
+    if (p_dst == p_src || p_dst->sig_bits != p_src->sig_bits) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    unsigned long long *p_buckets = (unsigned long long *)calloc(
+        p_src->bucket_nr, sizeof(unsigned long long));
+    if (!(p_buckets)) return SIRIUS_ERR_MEMORY_ALLOC;
+    i_hist_shard_t tot = {0};
+    atomic_init(&(tot.min), UINT64_MAX);
+    i_hist_collect(p_src, p_buckets, &tot);
+
+    i_hist_shard_t *p_s = atomic_load_explicit(&(p_dst->p_shards[0]),
+        memory_order_acquire);
+    for (unsigned int k = 0; k < p_dst->bucket_nr; k++) {
+        if (!(p_buckets[k])) continue;
+        atomic_fetch_add_explicit(&(p_s->buckets[k]), p_buckets[k],
+            memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&(p_s->count),
+        atomic_load_explicit(&(tot.count), memory_order_relaxed),
+        memory_order_relaxed);
+    i_hist_sum_add(&(p_s->sum),
+        atomic_load_explicit(&(tot.sum), memory_order_relaxed));
+    i_hist_minmax(p_s,
+        atomic_load_explicit(&(tot.min), memory_order_relaxed),
+        atomic_load_explicit(&(tot.max), memory_order_relaxed));
+
+    free(p_buckets);
+    return SIRIUS_OK;
+}
+
+int
+sirius_hist_query(sirius_hist_handle handle, sirius_hist_res_t *p_res,
+    const double *p_q, uint64_t *p_val, size_t q_nr)
+{
+    if (!(handle)) return SIRIUS_ERR_NULL_POINTER;
+    if (q_nr && (!(p_q) || !(p_val))) return SIRIUS_ERR_NULL_POINTER;
+    for (size_t i = 0; i < q_nr; i++) {
+        if (!(p_q[i] >= 0 && p_q[i] <= 100)) {
+            return SIRIUS_ERR_INVALID_PARAMETER;
+        }
+    }
+
+    i_hist_t *p_h = (i_hist_t *)handle;
+    unsigned long long *p_buckets = (unsigned long long *)calloc(
+        p_h->bucket_nr, sizeof(unsigned long long));
+    if (!(p_buckets)) return SIRIUS_ERR_MEMORY_ALLOC;
+    i_hist_shard_t tot = {0};
+    atomic_init(&(tot.min), UINT64_MAX);
+    i_hist_collect(p_h, p_buckets, &tot);
+
+    /**
+     * the bucket counts and the totals are read at different times,
+     * the percentiles rely on the buckets only
+     */
+    unsigned long long total = 0;
+    for (unsigned int k = 0; k < p_h->bucket_nr; k++) {
+        total += p_buckets[k];
+    }
+    uint64_t mn = atomic_load_explicit(&(tot.min), memory_order_relaxed);
+    uint64_t mx = atomic_load_explicit(&(tot.max), memory_order_relaxed);
+    unsigned long long count = atomic_load_explicit(&(tot.count),
+        memory_order_relaxed);
+
+    if (p_res) {
+        p_res->count = count;
+        p_res->min = count ? mn : 0;
+        p_res->max = mx;
+        p_res->mean = count ? (double)atomic_load_explicit(&(tot.sum),
+            memory_order_relaxed) / (double)count : 0;
+    }
+
+    for (size_t i = 0; i < q_nr; i++) {
+        p_val[i] = 0;
+        if (!(total)) continue;
+        if (0 == p_q[i]) {
+            p_val[i] = mn;
+            continue;
+        }
+
+        unsigned long long rank =
+            (unsigned long long)ceil(p_q[i] / 100 * (double)total);
+        if (rank < 1) rank = 1;
+        if (rank > total) rank = total;
+
+        unsigned long long acc = 0;
+        for (unsigned int k = 0; k < p_h->bucket_nr; k++) {
+            acc += p_buckets[k];
+            if (acc >= rank) {
+                uint64_t v = i_hist_value(p_h, k);
+                if (v > mx) v = mx;
+                if (v < mn) v = mn;
+                p_val[i] = v;
+                break;
+            }
+        }
+    }
+
+    free(p_buckets);
+    return SIRIUS_OK;
+}
+
+int
+sirius_hist_reset(sirius_hist_handle handle)
+{
+    if (!(handle)) return SIRIUS_ERR_NULL_POINTER;
+
+    i_hist_t *p_h = (i_hist_t *)handle;
+    for (int i = 0; i < SIRIUS_HIST_SHARD_MAX; i++) {
+        i_hist_shard_t *p_s = atomic_load_explicit(&(p_h->p_shards[i]),
+            memory_order_acquire);
+        if (p_s) i_hist_shard_reset(p_h, p_s);
+    }
+    return SIRIUS_OK;
+}
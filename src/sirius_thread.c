@@ -0,0 +1,533 @@
+/* pthread_setaffinity_np, pthread_setname_np, CPU_ALLOC */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "sirius_thread.h"
+#include "sirius_errno.h"
+#include "sirius_log.h"
+
+#include "./internal/sirius_internal_sys.h"
+#include "./internal/sirius_internal_log.h"
+#include "./internal/sirius_internal_thread.h"
+
+#include <sched.h>
+#include <sys/resource.h>
+
+/**
+ * the affinity and a real-time policy go into the pthread attributes,
+ * so they hold from the first instruction of the thread. the name
+ * and the nice value can only be set by the thread itself (the nice
+ * value is per thread on linux, `setpriority` on its tid): the thread
+ * starts in `i_thread_start`, sets them and reports to the creator,
+ * which waits, before it calls the user function. a thread that
+ * cannot apply them exits at once and the creation fails.
+ *
+ * the topology is read once from sysfs. every level keys a cpu by
+ * the lowest cpu of its group (the package by its id), the keys are
+ * then numbered in the order of the cpus.
+ */
+
+#define I_THREAD_SYSFS_CPU  "/sys/devices/system/cpu"
+#define I_THREAD_SYSFS_NODE "/sys/devices/system/node"
+/* cache descriptors looked at per cpu */
+#define I_THREAD_CACHE_MAX  (16)
+/* longest sysfs cpu list read */
+#define I_THREAD_LIST_SIZE  (4096)
+
+/* cpu set */
+
+int
+sirius_cpuset_parse(const char *p_str, sirius_cpuset_t *p_set)
+{
+    if (!(p_str) || !(p_set)) return SIRIUS_ERR_NULL_POINTER;
+
+    sirius_cpuset_zero(p_set);
+    const char *p = p_str;
+    while (true) {
+        while (' ' == *p || '\t' == *p) p++;
+        if ('\0' == *p || '\n' == *p) break;
+
+        char *p_end = NULL;
+        if (*p < '0' || *p > '9') return SIRIUS_ERR_INVALID_PARAMETER;
+        unsigned long lo = strtoul(p, &p_end, 10);
+        unsigned long hi = lo;
+        p = p_end;
+        if ('-' == *p) {
+            p++;
+            if (*p < '0' || *p > '9') return SIRIUS_ERR_INVALID_PARAMETER;
+            hi = strtoul(p, &p_end, 10);
+            p = p_end;
+        }
+        if (lo > hi || hi >= SIRIUS_THREAD_CPU_MAX) {
+            return SIRIUS_ERR_INVALID_PARAMETER;
+        }
+        for (unsigned long c = lo; c <= hi; c++) {
+            sirius_cpuset_add(p_set, (unsigned int)c);
+        }
+
+        while (' ' == *p || '\t' == *p) p++;
+        if (',' == *p) {
+            p++;
+        } else if ('\0' != *p && '\n' != *p) {
+            return SIRIUS_ERR_INVALID_PARAMETER;
+        }
+    }
+
+    return SIRIUS_OK;
+}
+
+/* threads */
+
+static const int g_policy[SIRIUS_THREAD_SCHED_MAX] = {
+    [SIRIUS_THREAD_SCHED_INHERIT] = -1,
+    [SIRIUS_THREAD_SCHED_OTHER] = SCHED_OTHER,
+    [SIRIUS_THREAD_SCHED_BATCH] = SCHED_BATCH,
+    [SIRIUS_THREAD_SCHED_IDLE] = SCHED_IDLE,
+    [SIRIUS_THREAD_SCHED_FIFO] = SCHED_FIFO,
+    [SIRIUS_THREAD_SCHED_RR] = SCHED_RR,
+};
+
+static inline bool
+i_thread_rt(sirius_thread_sched_t sched)
+{
+    return SIRIUS_THREAD_SCHED_FIFO == sched ||
+        SIRIUS_THREAD_SCHED_RR == sched;
+}
+
+static inline bool
+i_thread_nice(sirius_thread_sched_t sched)
+{
+    return SIRIUS_THREAD_SCHED_OTHER == sched ||
+        SIRIUS_THREAD_SCHED_BATCH == sched;
+}
+
+static int
+i_thread_attr_check(const sirius_thread_attr_t *p_attr)
+{
+    if (p_attr->sched >= SIRIUS_THREAD_SCHED_MAX) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+    if (i_thread_rt(p_attr->sched)) {
+        int policy = g_policy[p_attr->sched];
+        if (p_attr->prio < sched_get_priority_min(policy) ||
+            p_attr->prio > sched_get_priority_max(policy)) {
+            return SIRIUS_ERR_INVALID_PARAMETER;
+        }
+    }
+    if (i_thread_nice(p_attr->sched) &&
+        (p_attr->prio < -20 || p_attr->prio > 19)) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+    return SIRIUS_OK;
+}
+
+/* sized for `SIRIUS_THREAD_CPU_MAX`, which may exceed CPU_SETSIZE */
+static cpu_set_t *
+i_thread_cpuset(const sirius_cpuset_t *p_set, size_t *p_size)
+{
+    cpu_set_t *p_cs = CPU_ALLOC(SIRIUS_THREAD_CPU_MAX);
+    if (!(p_cs)) return NULL;
+
+    *p_size = CPU_ALLOC_SIZE(SIRIUS_THREAD_CPU_MAX);
+    CPU_ZERO_S(*p_size, p_cs);
+    for (unsigned int c = 0; c < SIRIUS_THREAD_CPU_MAX; c++) {
+        if (sirius_cpuset_has(p_set, c)) CPU_SET_S(c, *p_size, p_cs);
+    }
+    return p_cs;
+}
+
+/* the part of the attributes a thread applies to itself */
+static int
+i_thread_self(const char *p_name, sirius_thread_sched_t sched, int prio)
+{
+    if (p_name) {
+        char name[SIRIUS_THREAD_NAME_MAX + 1];
+        snprintf(name, sizeof(name), "%s", p_name);
+        int ret = pthread_setname_np(pthread_self(), name);
+        if (ret) return ret;
+    }
+    if (i_thread_nice(sched)) {
+        pid_t tid = (pid_t)syscall(__NR_gettid);
+        if (setpriority(PRIO_PROCESS, (id_t)tid, prio)) return errno;
+    }
+    return 0;
+}
+
+typedef struct {
+    void *(*p_fn)(void *);
+    void *p_arg;
+    const char *p_name;
+    sirius_thread_sched_t sched;
+    int prio;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool done;
+    int ret;
+} i_thread_start_t;
+
+static void *
+i_thread_start(void *p_arg)
+{
+    /* lives on the stack of the creator until `done` is set */
+    i_thread_start_t *p_s = (i_thread_start_t *)p_arg;
+    void *(*p_fn)(void *) = p_s->p_fn;
+    void *p_fn_arg = p_s->p_arg;
+
+    int ret = i_thread_self(p_s->p_name, p_s->sched, p_s->prio);
+
+    pthread_mutex_lock(&(p_s->mutex));
+    p_s->ret = ret;
+    p_s->done = true;
+    pthread_cond_signal(&(p_s->cond));
+    pthread_mutex_unlock(&(p_s->mutex));
+
+    if (ret) return NULL;
+    return p_fn(p_fn_arg);
+}
+
+static int
+i_thread_attr_init(pthread_attr_t *p_pa, const sirius_thread_attr_t *p_attr)
+{
+    int ret = 0;
+
+    if (p_attr->detached) {
+        ret = pthread_attr_setdetachstate(p_pa, PTHREAD_CREATE_DETACHED);
+        if (ret) return ret;
+    }
+
+    if (p_attr->stack_size) {
+        long page = sysconf(_SC_PAGESIZE);
+        size_t size = p_attr->stack_size;
+        if (page > 0) {
+            size = (size + (size_t)page - 1) & ~((size_t)page - 1);
+        }
+        ret = pthread_attr_setstacksize(p_pa, size);
+        if (ret) return ret;
+    }
+
+    if (sirius_cpuset_count(&(p_attr->cpus))) {
+        size_t size;
+        cpu_set_t *p_cs = i_thread_cpuset(&(p_attr->cpus), &size);
+        if (!(p_cs)) return ENOMEM;
+        ret = pthread_attr_setaffinity_np(p_pa, size, p_cs);
+        CPU_FREE(p_cs);
+        if (ret) return ret;
+    }
+
+    if (SIRIUS_THREAD_SCHED_INHERIT != p_attr->sched) {
+        struct sched_param sp = {
+            .sched_priority = i_thread_rt(p_attr->sched) ? p_attr->prio : 0,
+        };
+        ret = pthread_attr_setinheritsched(p_pa, PTHREAD_EXPLICIT_SCHED);
+        if (!(ret)) {
+            ret = pthread_attr_setschedpolicy(p_pa,
+                g_policy[p_attr->sched]);
+        }
+        if (!(ret)) ret = pthread_attr_setschedparam(p_pa, &sp);
+    }
+
+    return ret;
+}
+
+int
+sirius_thread_create(pthread_t *p_id, const sirius_thread_attr_t *p_attr,
+    void *(*p_fn)(void *), void *p_arg)
+{
+    static const sirius_thread_attr_t def = {0};
+    if (!(p_attr)) p_attr = &def;
+    if (!(p_fn) || (!(p_id) && !(p_attr->detached))) {
+        return SIRIUS_ERR_NULL_POINTER;
+    }
+    int ret = i_thread_attr_check(p_attr);
+    if (ret) return ret;
+
+    pthread_attr_t pa;
+    pthread_attr_init(&pa);
+    ret = i_thread_attr_init(&pa, p_attr);
+    if (ret) {
+        pthread_attr_destroy(&pa);
+        SIRIUS_WARN("thread attributes: %s\n", strerror(ret));
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    i_thread_start_t s = {
+        .p_fn = p_fn,
+        .p_arg = p_arg,
+        .p_name = p_attr->p_name,
+        .sched = p_attr->sched,
+        .prio = p_attr->prio,
+        .done = false,
+        .ret = 0,
+    };
+    pthread_mutex_init(&(s.mutex), NULL);
+    pthread_cond_init(&(s.cond), NULL);
+
+    pthread_t id;
+    ret = pthread_create(&id, &pa, i_thread_start, (void *)&s);
+    pthread_attr_destroy(&pa);
+    if (!(ret)) {
+        pthread_mutex_lock(&(s.mutex));
+        while (!(s.done)) {
+            pthread_cond_wait(&(s.cond), &(s.mutex));
+        }
+        pthread_mutex_unlock(&(s.mutex));
+        ret = s.ret;
+        if (ret && !(p_attr->detached)) (void)pthread_join(id, NULL);
+    }
+    pthread_cond_destroy(&(s.cond));
+    pthread_mutex_destroy(&(s.mutex));
+
+    if (ret) {
+        SIRIUS_WARN("thread [%s]: %s\n",
+            p_attr->p_name ? p_attr->p_name : "", strerror(ret));
+        return SIRIUS_ERR_RESOURCE_REQUEST;
+    }
+    if (p_id) *p_id = id;
+    return SIRIUS_OK;
+}
+
+int
+sirius_thread_apply(const sirius_thread_attr_t *p_attr)
+{
+    if (!(p_attr)) return SIRIUS_ERR_NULL_POINTER;
+    int ret = i_thread_attr_check(p_attr);
+    if (ret) return ret;
+
+    if (sirius_cpuset_count(&(p_attr->cpus))) {
+        size_t size;
+        cpu_set_t *p_cs = i_thread_cpuset(&(p_attr->cpus), &size);
+        if (!(p_cs)) return SIRIUS_ERR_MEMORY_ALLOC;
+        ret = pthread_setaffinity_np(pthread_self(), size, p_cs);
+        CPU_FREE(p_cs);
+        if (ret) goto label_err;
+    }
+
+    if (SIRIUS_THREAD_SCHED_INHERIT != p_attr->sched) {
+        struct sched_param sp = {
+            .sched_priority = i_thread_rt(p_attr->sched) ? p_attr->prio : 0,
+        };
+        ret = pthread_setschedparam(pthread_self(),
+            g_policy[p_attr->sched], &sp);
+        if (ret) goto label_err;
+    }
+
+    ret = i_thread_self(p_attr->p_name, p_attr->sched, p_attr->prio);
+    if (ret) goto label_err;
+    return SIRIUS_OK;
+
+label_err:
+    SIRIUS_WARN("thread attributes: %s\n", strerror(ret));
+    return SIRIUS_ERR_RESOURCE_REQUEST;
+}
+
+/* threads of the library */
+
+static sirius_thread_attr_t g_internal = {0};
+
+void
+sirius_thread_internal_set(const sirius_thread_attr_t *p_attr)
+{
+    if (p_attr) {
+        g_internal = *p_attr;
+    } else {
+        memset(&g_internal, 0, sizeof(g_internal));
+    }
+}
+
+int
+sirius_thread_internal_create(pthread_t *p_id, const char *p_name,
+    bool detached, void *(*p_fn)(void *), void *p_arg)
+{
+    sirius_thread_attr_t attr = g_internal;
+    attr.p_name = p_name;
+    attr.detached = detached;
+    if (SIRIUS_OK == sirius_thread_create(p_id, &attr, p_fn, p_arg)) {
+        return SIRIUS_OK;
+    }
+
+    /* a placement that cannot be applied must not cost the thread */
+    I_LOG_WARN("thread [%s] placed by default\n", p_name);
+    sirius_thread_attr_t def = {
+        .p_name = p_name,
+        .detached = detached,
+    };
+    return sirius_thread_create(p_id, &def, p_fn, p_arg);
+}
+
+/* topology */
+
+static sirius_topo_t g_topo;
+static pthread_once_t g_topo_once = PTHREAD_ONCE_INIT;
+
+static bool
+i_thread_sysfs_list(const char *p_path, sirius_cpuset_t *p_set)
+{
+    int fd = open(p_path, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd) return false;
+
+    char buf[I_THREAD_LIST_SIZE];
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) return false;
+    buf[len] = '\0';
+
+    return SIRIUS_OK == sirius_cpuset_parse(buf, p_set) &&
+        sirius_cpuset_count(p_set) > 0;
+}
+
+static int
+i_thread_sysfs_int(const char *p_path)
+{
+    int fd = open(p_path, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd) return -1;
+
+    char buf[32];
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) return -1;
+    buf[len] = '\0';
+    return atoi(buf);
+}
+
+static int
+i_thread_lowest(const sirius_cpuset_t *p_set)
+{
+    for (unsigned int i = 0; i < SIRIUS_THREAD_CPU_MAX / 64; i++) {
+        if (p_set->bits[i]) {
+            return (int)(i * 64 + (unsigned int)__builtin_ctzll(
+                p_set->bits[i]));
+        }
+    }
+    return -1;
+}
+
+/* the cpus sharing the cache of the highest level with `cpu` */
+static bool
+i_thread_llc(unsigned int cpu, sirius_cpuset_t *p_set)
+{
+    char path[128];
+    int best = 0;
+
+    for (int i = 0; i < I_THREAD_CACHE_MAX; i++) {
+        snprintf(path, sizeof(path),
+            I_THREAD_SYSFS_CPU "/cpu%u/cache/index%d/level", cpu, i);
+        int level = i_thread_sysfs_int(path);
+        if (level < 0) break;
+        if (level <= best) continue;
+
+        sirius_cpuset_t set;
+        snprintf(path, sizeof(path),
+            I_THREAD_SYSFS_CPU "/cpu%u/cache/index%d/shared_cpu_list",
+            cpu, i);
+        if (i_thread_sysfs_list(path, &set)) {
+            *p_set = set;
+            best = level;
+        }
+    }
+    return best > 0;
+}
+
+static void
+i_thread_topo_detect()
+{
+    sirius_topo_t *p_t = &g_topo;
+    char path[128];
+
+    if (!(i_thread_sysfs_list(I_THREAD_SYSFS_CPU "/online",
+            &(p_t->online)))) {
+        long nr = sysconf(_SC_NPROCESSORS_ONLN);
+        sirius_cpuset_zero(&(p_t->online));
+        for (long c = 0; c < (nr > 0 ? nr : 1); c++) {
+            sirius_cpuset_add(&(p_t->online), (unsigned int)c);
+        }
+    }
+    p_t->cpu_nr = sirius_cpuset_count(&(p_t->online));
+
+    /* the key of every cpu at every level, -1 while unknown */
+    static int key[SIRIUS_THREAD_CPU_MAX][SIRIUS_TOPO_MAX];
+    for (unsigned int c = 0; c < SIRIUS_THREAD_CPU_MAX; c++) {
+        for (int l = 0; l < SIRIUS_TOPO_MAX; l++) key[c][l] = -1;
+    }
+
+    sirius_cpuset_t set;
+    for (unsigned int c = 0; c < SIRIUS_THREAD_CPU_MAX; c++) {
+        if (!(sirius_cpuset_has(&(p_t->online), c))) continue;
+
+        snprintf(path, sizeof(path),
+            I_THREAD_SYSFS_CPU "/cpu%u/topology/thread_siblings_list", c);
+        key[c][SIRIUS_TOPO_CORE] = i_thread_sysfs_list(path, &set) ?
+            i_thread_lowest(&set) : (int)c;
+
+        key[c][SIRIUS_TOPO_LLC] = i_thread_llc(c, &set) ?
+            i_thread_lowest(&set) : 0;
+
+        snprintf(path, sizeof(path),
+            I_THREAD_SYSFS_CPU "/cpu%u/topology/physical_package_id", c);
+        int pkg = i_thread_sysfs_int(path);
+        key[c][SIRIUS_TOPO_PKG] = pkg < 0 ? 0 : pkg;
+
+        key[c][SIRIUS_TOPO_NODE] = 0;
+    }
+
+    /* a machine without numa has no node directory: one node */
+    sirius_cpuset_t nodes;
+    if (i_thread_sysfs_list(I_THREAD_SYSFS_NODE "/online", &nodes)) {
+        for (unsigned int n = 0; n < SIRIUS_THREAD_CPU_MAX; n++) {
+            if (!(sirius_cpuset_has(&nodes, n))) continue;
+            snprintf(path, sizeof(path),
+                I_THREAD_SYSFS_NODE "/node%u/cpulist", n);
+            if (!(i_thread_sysfs_list(path, &set))) continue;
+            int lowest = i_thread_lowest(&set);
+            for (unsigned int c = 0; c < SIRIUS_THREAD_CPU_MAX; c++) {
+                if (sirius_cpuset_has(&set, c) &&
+                    sirius_cpuset_has(&(p_t->online), c)) {
+                    key[c][SIRIUS_TOPO_NODE] = lowest;
+                }
+            }
+        }
+    }
+
+    /* number the keys in the order of the cpus */
+    for (int l = 0; l < SIRIUS_TOPO_MAX; l++) {
+        static int seen[SIRIUS_THREAD_CPU_MAX];
+        unsigned int nr = 0;
+        for (unsigned int c = 0; c < SIRIUS_THREAD_CPU_MAX; c++) {
+            p_t->group[c][l] = -1;
+            if (key[c][l] < 0) continue;
+
+            unsigned int g = 0;
+            for (; g < nr && seen[g] != key[c][l]; g++) {}
+            if (g == nr) seen[nr++] = key[c][l];
+            p_t->group[c][l] = (short)g;
+        }
+        p_t->nr[l] = nr;
+    }
+}
+
+const sirius_topo_t *
+sirius_thread_topo()
+{
+    pthread_once(&g_topo_once, i_thread_topo_detect);
+    return &g_topo;
+}
+
+int
+sirius_thread_topo_cpus(sirius_topo_level_t level, unsigned int group,
+    sirius_cpuset_t *p_set)
+{
+    if (!(p_set)) return SIRIUS_ERR_NULL_POINTER;
+    const sirius_topo_t *p_t = sirius_thread_topo();
+    if (level >= SIRIUS_TOPO_MAX || group >= p_t->nr[level]) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    sirius_cpuset_zero(p_set);
+    for (unsigned int c = 0; c < SIRIUS_THREAD_CPU_MAX; c++) {
+        if ((int)group == p_t->group[c][level]) {
+            sirius_cpuset_add(p_set, c);
+        }
+    }
+    return SIRIUS_OK;
+}
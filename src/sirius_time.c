@@ -0,0 +1,251 @@
+#include "sirius_time.h"
+#include "sirius_errno.h"
+
+#include "./internal/sirius_internal_sys.h"
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#define I_TIME_TSC
+#endif
+
+/**
+ * the calibration reads the cycle counter and CLOCK_MONOTONIC as a
+ * pair at two points at least `SIRIUS_TIME_CAL_MS` apart. each pair
+ * is the tightest of a few tries, the counter is taken before and
+ * after the clock and the middle is kept, so that a preemption between
+ * the reads does not skew it.
+ *
+ * nothing sleeps for it: `sirius_time_init` takes the first pair, and
+ * the first `sirius_time_ns` once the interval has passed takes the
+ * second one. until then `sirius_time_ns` reads the clock. only the
+ * callers that need the rate at once (`sirius_time_mult`, `_hz`,
+ * `_tsc`) wait for the rest of the interval. if the cpu reports the
+ * counter frequency (cpuid 0x15, or the timing leaf of a hypervisor),
+ * as the kernel trusts it for tsc_khz, it is used right away.
+ *
+ * `sirius_time_ns` then adds the scaled cycles since the second pair
+ * to its clock reading. the tsc does not follow the ntp slewing of
+ * CLOCK_MONOTONIC, the two drift apart by the calibration error,
+ * a few ppm; deadlines shared with the kernel use the clock itself.
+ *
+ * the counter is used as a clock only if it is invariant (constant
+ * rate, runs in the deep c-states) and the kernel agrees: its clock
+ * source is tsc. otherwise the tsc may differ between the cpus and
+ * the clock is read with `clock_gettime`; cycles are still converted
+ * with the calibrated rate.
+ */
+
+/* tries per pair */
+#define I_TIME_PAIR_TRY     (5)
+
+#define I_TIME_CLOCKSOURCE \
+    "/sys/devices/system/clocksource/clocksource0/current_clocksource"
+
+sirius_time_cal_t sirius_time_cal = {0};
+
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+/* serializes the second pair */
+static pthread_mutex_t g_mtx = PTHREAD_MUTEX_INITIALIZER;
+/* the calibration is published */
+static int g_done = 0;
+/* the first pair */
+static uint64_t g_tsc_a = 0;
+static uint64_t g_ns_a = 0;
+
+static inline uint64_t
+i_time_clock(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t
+sirius_time_coarse_ns()
+{
+    return i_time_clock(CLOCK_MONOTONIC_COARSE);
+}
+
+#ifdef I_TIME_TSC
+static void
+i_time_pair(uint64_t *p_tsc, uint64_t *p_ns)
+{
+    uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < I_TIME_PAIR_TRY; i++) {
+        uint64_t t1 = __builtin_ia32_rdtsc();
+        uint64_t ns = i_time_clock(CLOCK_MONOTONIC);
+        uint64_t t2 = __builtin_ia32_rdtsc();
+        if (t2 - t1 < best) {
+            best = t2 - t1;
+            *p_tsc = t1 + (t2 - t1) / 2;
+            *p_ns = ns;
+        }
+    }
+}
+
+static bool
+i_time_tsc_usable()
+{
+    unsigned int a, b, c, d;
+    if (!(__get_cpuid(0x80000007, &a, &b, &c, &d)) || !(d & (1U << 8))) {
+        return false;
+    }
+
+    /* without sysfs, trust the cpu */
+    int fd = open(I_TIME_CLOCKSOURCE, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd) return true;
+    char buf[32] = {0};
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    return len >= 3 && 0 == strncmp(buf, "tsc", 3) &&
+        ('\n' == buf[3] || '\0' == buf[3]);
+}
+
+/**
+ * @return the frequency the cpu reports for the counter, 0 if none
+ */
+static uint64_t
+i_time_cpuid_hz()
+{
+    unsigned int a, b, c, d;
+
+    /* tsc / crystal ratio, and the crystal frequency */
+    if (__get_cpuid_max(0, NULL) >= 0x15) {
+        __cpuid_count(0x15, 0, a, b, c, d);
+        if (a && b && c) return (uint64_t)c * b / a;
+    }
+
+    /* the timing leaf of kvm and vmware, in kHz */
+    if (!(__get_cpuid(1, &a, &b, &c, &d)) || !(c & (1U << 31))) return 0;
+    __cpuid(0x40000000, a, b, c, d);
+    if (a < 0x40000010) return 0;
+    __cpuid(0x40000010, a, b, c, d);
+    return (uint64_t)a * 1000;
+}
+
+static void
+i_time_publish(uint64_t hz, uint64_t mult, uint64_t tsc0, uint64_t ns0)
+{
+    sirius_time_cal_t *p_c = &sirius_time_cal;
+
+    p_c->hz = hz;
+    p_c->tsc0 = tsc0;
+    p_c->ns0 = ns0;
+    __atomic_store_n(&(p_c->mult), mult, __ATOMIC_RELEASE);
+    if (i_time_tsc_usable()) {
+        __atomic_store_n(&(p_c->tsc), 1, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&g_done, 1, __ATOMIC_RELEASE);
+}
+#endif // I_TIME_TSC
+
+static void
+i_time_start()
+{
+#ifdef I_TIME_TSC
+    i_time_pair(&g_tsc_a, &g_ns_a);
+
+    uint64_t hz = i_time_cpuid_hz();
+    if (hz) {
+        i_time_publish(hz,
+            (uint64_t)((1000000000ULL << 32) / hz), g_tsc_a, g_ns_a);
+    }
+#else
+    sirius_time_cal.hz = 1000000000ULL;
+    __atomic_store_n(&(sirius_time_cal.mult), 1ULL << 32,
+        __ATOMIC_RELEASE);
+    __atomic_store_n(&g_done, 1, __ATOMIC_RELEASE);
+#endif // I_TIME_TSC
+}
+
+/**
+ * @brief take the second pair and publish the calibration
+ *
+ * @param wait: sleep for the rest of the interval if it has not passed
+ *
+ * @return whether the calibration is published
+ */
+static bool
+i_time_finish(bool wait)
+{
+    (void)pthread_once(&g_once, i_time_start);
+    if (likely(__atomic_load_n(&g_done, __ATOMIC_ACQUIRE))) return true;
+
+#ifdef I_TIME_TSC
+    uint64_t end = g_ns_a + (uint64_t)SIRIUS_TIME_CAL_MS * 1000000ULL;
+    uint64_t now = i_time_clock(CLOCK_MONOTONIC);
+    if (!(wait) && now < end) return false;
+
+    pthread_mutex_lock(&g_mtx);
+    if (!(__atomic_load_n(&g_done, __ATOMIC_ACQUIRE))) {
+        if (now < end) {
+            struct timespec req = {
+                .tv_sec = (time_t)((end - now) / 1000000000ULL),
+                .tv_nsec = (long)((end - now) % 1000000000ULL),
+            };
+            while (0 != nanosleep(&req, &req) && EINTR == errno) {}
+        }
+
+        uint64_t tsc_b, ns_b;
+        do {
+            i_time_pair(&tsc_b, &ns_b);
+        } while (ns_b < end);
+
+        uint64_t cyc = tsc_b - g_tsc_a;
+        uint64_t ns = ns_b - g_ns_a;
+        if (0 == cyc) {
+            sirius_time_cal.hz = 1000000000ULL;
+            __atomic_store_n(&(sirius_time_cal.mult), 1ULL << 32,
+                __ATOMIC_RELEASE);
+            __atomic_store_n(&g_done, 1, __ATOMIC_RELEASE);
+        } else {
+            i_time_publish(
+                (uint64_t)((unsigned __int128)cyc * 1000000000ULL / ns),
+                (uint64_t)(((unsigned __int128)ns << 32) / cyc),
+                tsc_b, ns_b);
+        }
+    }
+    pthread_mutex_unlock(&g_mtx);
+#endif // I_TIME_TSC
+    return true;
+}
+
+uint64_t
+sirius_time_ns_slow()
+{
+    /* the calibration may have just turned it on */
+    if (i_time_finish(false) &&
+        __atomic_load_n(&(sirius_time_cal.tsc), __ATOMIC_ACQUIRE)) {
+        return sirius_time_ns();
+    }
+    return i_time_clock(CLOCK_MONOTONIC);
+}
+
+uint64_t
+sirius_time_mult()
+{
+    (void)i_time_finish(true);
+    return __atomic_load_n(&(sirius_time_cal.mult), __ATOMIC_ACQUIRE);
+}
+
+bool
+sirius_time_tsc()
+{
+    (void)i_time_finish(true);
+    return __atomic_load_n(&(sirius_time_cal.tsc), __ATOMIC_ACQUIRE);
+}
+
+uint64_t
+sirius_time_hz()
+{
+    (void)i_time_finish(true);
+    return sirius_time_cal.hz;
+}
+
+int
+sirius_time_init()
+{
+    (void)pthread_once(&g_once, i_time_start);
+    return SIRIUS_OK;
+}
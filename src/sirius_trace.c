@@ -0,0 +1,353 @@
+#include "sirius_trace.h"
+#include "sirius_errno.h"
+#include "sirius_log.h"
+#include "sirius_lock.h"
+
+#include "./internal/sirius_internal_sys.h"
+
+/**
+ * every thread records into a buffer of its own. it takes one from
+ * the global list on its first event, a buffer that is not in use
+ * or a new one pushed at the head, and gives it back when it exits;
+ * buffers are never freed, so the list can be walked without a lock.
+ *
+ * only the owner writes a buffer: it fills the next event and then
+ * publishes it with a release store of `nr`. a session is numbered
+ * by `g_gen`; the first event of a thread in a new session empties
+ * its buffer (`nr` first, `gen` last), so the writer of the file
+ * reads the `nr` events of the buffers whose `gen` is the session.
+ *
+ * timestamps are raw cycles, converted to microseconds relative to
+ * the start of the session when the file is written.
+ */
+
+#define I_TRACE_PATH_FMT    "sirius_trace_%d.json"
+
+typedef struct {
+    /* cycles */
+    uint64_t ts;
+    /* cycles, complete events only */
+    uint64_t dur;
+    const char *p_name;
+    long long arg;
+    pid_t tid;
+    /* 'B', 'E' or 'X' */
+    char ph;
+    bool has_arg;
+} i_trace_ev_t;
+
+typedef struct i_trace_buf {
+    struct i_trace_buf *p_next;
+    /* owned by a thread */
+    atomic_int used;
+    /* session of the events */
+    atomic_uint gen;
+    /* number of events published */
+    atomic_uint nr;
+    /* events lost to a full buffer in the session */
+    atomic_uint dropped;
+    i_trace_ev_t ev[SIRIUS_TRACE_BUF_EVENTS];
+} i_trace_buf_t;
+
+int sirius_trace_on = 0;
+
+/* buffer list, only pushed at the head */
+static i_trace_buf_t *_Atomic g_head = NULL;
+/* session number, 0 before the first one */
+static atomic_uint g_gen = 0;
+/* cycles at the start of the session */
+static uint64_t g_base = 0;
+/* serializes start and stop */
+static sirius_mtx_t g_lock = SIRIUS_MTX_INITIALIZER;
+
+static pthread_key_t g_key;
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+
+static __thread struct {
+    i_trace_buf_t *p_buf;
+    pid_t tid;
+} i_trace_tls = {0};
+
+static void
+i_trace_buf_put(void *p_data)
+{
+    i_trace_buf_t *p_b = (i_trace_buf_t *)p_data;
+    atomic_store_explicit(&(p_b->used), 0, memory_order_release);
+}
+
+static void
+i_trace_key_cr()
+{
+    if (pthread_key_create(&g_key, i_trace_buf_put)) {
+        SIRIUS_WARN("pthread_key_create: %s\n", strerror(errno));
+    }
+}
+
+static i_trace_buf_t *
+i_trace_buf_take()
+{
+    for (i_trace_buf_t *p_b = atomic_load_explicit(&g_head,
+            memory_order_acquire); p_b; p_b = p_b->p_next) {
+        int unused = 0;
+        if (0 == atomic_load_explicit(&(p_b->used), memory_order_relaxed) &&
+            atomic_compare_exchange_strong_explicit(&(p_b->used), &unused, 1,
+                memory_order_acquire, memory_order_relaxed)) {
+            return p_b;
+        }
+    }
+
+    i_trace_buf_t *p_b = (i_trace_buf_t *)calloc(1, sizeof(i_trace_buf_t));
+    if (!(p_b)) return NULL;
+    atomic_init(&(p_b->used), 1);
+
+    i_trace_buf_t *p_old = atomic_load_explicit(&g_head,
+        memory_order_relaxed);
+    do {
+        p_b->p_next = p_old;
+    } while (!(atomic_compare_exchange_weak_explicit(&g_head, &p_old, p_b,
+        memory_order_release, memory_order_relaxed)));
+    return p_b;
+}
+
+/**
+ * @return the slot of the next event, NULL if it is dropped
+ */
+static i_trace_ev_t *
+i_trace_ev_next(i_trace_buf_t **pp_b)
+{
+    i_trace_buf_t *p_b = i_trace_tls.p_buf;
+    if (unlikely(!(p_b))) {
+        (void)pthread_once(&g_key_once, i_trace_key_cr);
+        p_b = i_trace_buf_take();
+        if (!(p_b)) return NULL;
+        (void)pthread_setspecific(g_key, p_b);
+        i_trace_tls.p_buf = p_b;
+        i_trace_tls.tid = (pid_t)syscall(__NR_gettid);
+    }
+
+    unsigned int gen = atomic_load_explicit(&g_gen, memory_order_acquire);
+    if (unlikely(atomic_load_explicit(&(p_b->gen),
+            memory_order_relaxed) != gen)) {
+        atomic_store_explicit(&(p_b->nr), 0, memory_order_relaxed);
+        atomic_store_explicit(&(p_b->dropped), 0, memory_order_relaxed);
+        atomic_store_explicit(&(p_b->gen), gen, memory_order_release);
+    }
+
+    unsigned int nr = atomic_load_explicit(&(p_b->nr), memory_order_relaxed);
+    if (unlikely(nr >= SIRIUS_TRACE_BUF_EVENTS)) {
+        atomic_fetch_add_explicit(&(p_b->dropped), 1, memory_order_relaxed);
+        return NULL;
+    }
+    *pp_b = p_b;
+    return &(p_b->ev[nr]);
+}
+
+static inline void
+i_trace_ev_publish(i_trace_buf_t *p_b)
+{
+    atomic_store_explicit(&(p_b->nr),
+        atomic_load_explicit(&(p_b->nr), memory_order_relaxed) + 1,
+        memory_order_release);
+}
+
+static inline void
+i_trace_record(char ph, const char *p_name, uint64_t ts, uint64_t dur,
+    bool has_arg, long long arg)
+{
+    i_trace_buf_t *p_b = NULL;
+    i_trace_ev_t *p_ev = i_trace_ev_next(&p_b);
+    if (!(p_ev)) return;
+
+    p_ev->ts = ts;
+    p_ev->dur = dur;
+    p_ev->p_name = p_name;
+    p_ev->arg = arg;
+    p_ev->tid = i_trace_tls.tid;
+    p_ev->ph = ph;
+    p_ev->has_arg = has_arg;
+    i_trace_ev_publish(p_b);
+}
+
+void
+sirius_trace_begin(const char *p_name, bool has_arg, long long arg)
+{
+    i_trace_record('B', p_name, sirius_time_cycles(), 0, has_arg, arg);
+}
+
+void
+sirius_trace_end(const char *p_name)
+{
+    i_trace_record('E', p_name, sirius_time_cycles(), 0, false, 0);
+}
+
+void
+sirius_trace_complete(const sirius_trace_scope_t *p_scope)
+{
+    uint64_t now = sirius_time_cycles();
+    /* the session may have been stopped in between */
+    if (!(sirius_trace_enabled())) return;
+
+    i_trace_record('X', p_scope->p_name, p_scope->start,
+        now - p_scope->start, p_scope->has_arg, p_scope->arg);
+}
+
+int
+sirius_trace_start()
+{
+    sirius_mtx_lock(&g_lock);
+    if (sirius_trace_on) {
+        sirius_mtx_unlock(&g_lock);
+        SIRIUS_WARN("tracing is already on\n");
+        return SIRIUS_ERR_INIT_REPEATED;
+    }
+
+    g_base = sirius_time_cycles();
+    atomic_fetch_add_explicit(&g_gen, 1, memory_order_release);
+    __atomic_store_n(&sirius_trace_on, 1, __ATOMIC_RELEASE);
+    sirius_mtx_unlock(&g_lock);
+
+    SIRIUS_INFO("tracing started\n");
+    return SIRIUS_OK;
+}
+
+static void
+i_trace_json_str(FILE *p_f, const char *p_str)
+{
+    fputc('"', p_f);
+    for (const unsigned char *p = (const unsigned char *)p_str; *p; p++) {
+        if ('"' == *p || '\\' == *p) {
+            fputc('\\', p_f);
+            fputc(*p, p_f);
+        } else if (*p < 0x20) {
+            fprintf(p_f, "\\u%04x", *p);
+        } else {
+            fputc(*p, p_f);
+        }
+    }
+    fputc('"', p_f);
+}
+
+/* cycles to microseconds with 3 decimals */
+static void
+i_trace_json_us(FILE *p_f, const char *p_key, uint64_t cyc)
+{
+    uint64_t ns = sirius_time_cyc2ns(cyc);
+    fprintf(p_f, ",\"%s\":%llu.%03llu", p_key,
+        (unsigned long long)(ns / 1000), (unsigned long long)(ns % 1000));
+}
+
+/* name of a thread that is still alive */
+static void
+i_trace_json_thread(FILE *p_f, pid_t pid, pid_t tid, bool *p_first)
+{
+    char path[64];
+    char name[32] = {0};
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", (int)tid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd) return;
+    ssize_t len = read(fd, name, sizeof(name) - 1);
+    close(fd);
+    if (len <= 0) return;
+    if ('\n' == name[len - 1]) name[len - 1] = '\0';
+
+    fprintf(p_f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\","
+        "\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+        *p_first ? "" : ",", (int)pid, (int)tid);
+    i_trace_json_str(p_f, name);
+    fputs("}}", p_f);
+    *p_first = false;
+}
+
+static int
+i_trace_write(const char *p_path, unsigned int gen,
+    unsigned long long *p_nr, unsigned long long *p_dropped)
+{
+    FILE *p_f = fopen(p_path, "w");
+    if (!(p_f)) {
+        SIRIUS_WARN("fopen [%s]: %s\n", p_path, strerror(errno));
+        return SIRIUS_ERR_RESOURCE_REQUEST;
+    }
+
+    pid_t pid = getpid();
+    bool first = true;
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", p_f);
+
+    for (i_trace_buf_t *p_b = atomic_load_explicit(&g_head,
+            memory_order_acquire); p_b; p_b = p_b->p_next) {
+        if (atomic_load_explicit(&(p_b->gen), memory_order_acquire) != gen) {
+            continue;
+        }
+        unsigned int nr = atomic_load_explicit(&(p_b->nr),
+            memory_order_acquire);
+        *p_dropped += atomic_load_explicit(&(p_b->dropped),
+            memory_order_relaxed);
+
+        pid_t tid_named = 0;
+        for (unsigned int i = 0; i < nr; i++) {
+            const i_trace_ev_t *p_ev = &(p_b->ev[i]);
+            /* a buffer is handed over when its thread exits */
+            if (p_ev->tid != tid_named) {
+                i_trace_json_thread(p_f, pid, p_ev->tid, &first);
+                tid_named = p_ev->tid;
+            }
+
+            fprintf(p_f, "%s\n{\"name\":", first ? "" : ",");
+            i_trace_json_str(p_f, p_ev->p_name);
+            fprintf(p_f, ",\"ph\":\"%c\",\"pid\":%d,\"tid\":%d",
+                p_ev->ph, (int)pid, (int)p_ev->tid);
+            /* an event of a thread that was preempted around the start */
+            i_trace_json_us(p_f, "ts",
+                p_ev->ts > g_base ? p_ev->ts - g_base : 0);
+            if ('X' == p_ev->ph) {
+                i_trace_json_us(p_f, "dur", p_ev->dur);
+            }
+            if (p_ev->has_arg) {
+                fprintf(p_f, ",\"args\":{\"arg\":%lld}", p_ev->arg);
+            }
+            fputc('}', p_f);
+            first = false;
+        }
+        *p_nr += nr;
+    }
+
+    fputs("\n]}\n", p_f);
+    int ret = SIRIUS_OK;
+    if (ferror(p_f)) {
+        SIRIUS_WARN("write [%s] failed\n", p_path);
+        ret = SIRIUS_ERR;
+    }
+    if (fclose(p_f) && SIRIUS_OK == ret) {
+        SIRIUS_WARN("fclose [%s]: %s\n", p_path, strerror(errno));
+        ret = SIRIUS_ERR;
+    }
+    return ret;
+}
+
+int
+sirius_trace_stop(const char *p_path)
+{
+    sirius_mtx_lock(&g_lock);
+    if (!(sirius_trace_on)) {
+        sirius_mtx_unlock(&g_lock);
+        SIRIUS_WARN("tracing is off\n");
+        return SIRIUS_ERR_NOT_INIT;
+    }
+    __atomic_store_n(&sirius_trace_on, 0, __ATOMIC_RELEASE);
+
+    char path[64];
+    if (!(p_path) || !(p_path[0])) {
+        snprintf(path, sizeof(path), I_TRACE_PATH_FMT, (int)getpid());
+        p_path = path;
+    }
+
+    unsigned long long nr = 0, dropped = 0;
+    int ret = i_trace_write(p_path,
+        atomic_load_explicit(&g_gen, memory_order_relaxed), &nr, &dropped);
+    sirius_mtx_unlock(&g_lock);
+
+    if (SIRIUS_OK == ret) {
+        SIRIUS_INFO("tracing stopped, %llu events written to [%s], "
+            "%llu dropped\n", nr, p_path, dropped);
+    }
+    return ret;
+}
@@ -0,0 +1,467 @@
+#include "sirius_errno.h"
+#include "sirius_window.h"
+#include "sirius_attributes.h"
+
+#include "./internal/sirius_internal_sys.h"
+
+/**
+ * the samples live in a ring indexed by their sequence number modulo
+ * the capacity; the oldest one in the window is `seq - nr`.
+ * 
+ * each monotonic deque holds sequence numbers whose samples decrease
+ * (max) or increase (min) from the front, the front is the extreme
+ * of the window. every sample enters and leaves a deque once.
+ * 
+ * the running sum only holds the finite samples, the infinities and
+ * NaNs are counted apart; a sum that overflows is recomputed from the
+ * ring on eviction, a single sample would otherwise poison it for as
+ * long as the window lives.
+ */
+
+#define I_WIN_NAN           (0)
+#define I_WIN_PINF          (1)
+#define I_WIN_NINF          (2)
+
+typedef struct {
+    /* sequence numbers, a ring of `cap` entries */
+    uint64_t *p_seq;
+    size_t head;
+    size_t nr;
+} i_win_deque_t;
+
+typedef struct {
+    sirius_win_type_t win_type;
+    size_t cap;
+    uint64_t span;
+
+    double *p_val;
+    uint64_t *p_ts;
+    /* sequence number of the next sample */
+    uint64_t seq;
+    /* samples in the window */
+    size_t nr;
+
+    i_win_deque_t dq_max;
+    i_win_deque_t dq_min;
+
+    /* Neumaier summation, the sum is `sum + comp` */
+    double sum;
+    double comp;
+    /* non-finite samples in the window, `I_WIN_NAN` etc. */
+    size_t special[3];
+
+    /* percentile selection */
+    double *p_scratch;
+} i_win_t;
+
+static inline void
+i_win_sum_add(i_win_t *p_w, double x)
+{
+    double t = p_w->sum + x;
+    if (fabs(p_w->sum) >= fabs(x)) {
+        p_w->comp += (p_w->sum - t) + x;
+    } else {
+        p_w->comp += (x - t) + p_w->sum;
+    }
+    p_w->sum = t;
+}
+
+/**
+ * @return `I_WIN_NAN`, `I_WIN_PINF` or `I_WIN_NINF`, -1 if finite
+ */
+static inline int
+i_win_special(double x)
+{
+    if (likely(isfinite(x))) return -1;
+    if (isnan(x)) return I_WIN_NAN;
+    return x > 0 ? I_WIN_PINF : I_WIN_NINF;
+}
+
+static void
+i_win_sum_rebuild(i_win_t *p_w)
+{
+    p_w->sum = 0;
+    p_w->comp = 0;
+    for (uint64_t seq = p_w->seq - p_w->nr; seq != p_w->seq; seq++) {
+        double x = p_w->p_val[seq % p_w->cap];
+        if (isfinite(x)) i_win_sum_add(p_w, x);
+    }
+}
+
+static inline uint64_t
+i_win_dq_front(const i_win_deque_t *p_dq)
+{
+    return p_dq->p_seq[p_dq->head];
+}
+
+static inline uint64_t
+i_win_dq_back(const i_win_t *p_w, const i_win_deque_t *p_dq)
+{
+    size_t i = p_dq->head + p_dq->nr - 1;
+    if (i >= p_w->cap) i -= p_w->cap;
+    return p_dq->p_seq[i];
+}
+
+static inline void
+i_win_dq_push(const i_win_t *p_w, i_win_deque_t *p_dq, uint64_t seq)
+{
+    size_t i = p_dq->head + p_dq->nr;
+    if (i >= p_w->cap) i -= p_w->cap;
+    p_dq->p_seq[i] = seq;
+    p_dq->nr++;
+}
+
+static inline void
+i_win_dq_pop_front(const i_win_t *p_w, i_win_deque_t *p_dq)
+{
+    if (++(p_dq->head) == p_w->cap) p_dq->head = 0;
+    p_dq->nr--;
+}
+
+/**
+ * @brief drop the oldest sample
+ */
+static inline void
+i_win_evict(i_win_t *p_w)
+{
+    uint64_t old = p_w->seq - p_w->nr;
+
+    if (p_w->dq_max.nr && old == i_win_dq_front(&(p_w->dq_max))) {
+        i_win_dq_pop_front(p_w, &(p_w->dq_max));
+    }
+    if (p_w->dq_min.nr && old == i_win_dq_front(&(p_w->dq_min))) {
+        i_win_dq_pop_front(p_w, &(p_w->dq_min));
+    }
+
+    double x = p_w->p_val[old % p_w->cap];
+    int k = i_win_special(x);
+    if (k >= 0) p_w->special[k]--;
+
+    if (0 == --(p_w->nr)) {
+        /* a fresh start for the compensated sum */
+        p_w->sum = 0;
+        p_w->comp = 0;
+    } else if (k < 0) {
+        i_win_sum_add(p_w, -x);
+        /* inf - x stays inf, the overflow is only undone by a rebuild */
+        if (unlikely(!(isfinite(p_w->sum)) || !(isfinite(p_w->comp)))) {
+            i_win_sum_rebuild(p_w);
+        }
+    }
+}
+
+static inline void
+i_win_expire(i_win_t *p_w, uint64_t now)
+{
+    while (p_w->nr) {
+        uint64_t ts = p_w->p_ts[(p_w->seq - p_w->nr) % p_w->cap];
+        if (ts + p_w->span > now) break;
+        i_win_evict(p_w);
+    }
+}
+
+static inline void
+i_win_push(i_win_t *p_w, uint64_t ts, double x)
+{
+    if (SIRIUS_WIN_TYPE_TIME == p_w->win_type) i_win_expire(p_w, ts);
+    if (p_w->nr == p_w->cap) i_win_evict(p_w);
+
+    size_t idx = p_w->seq % p_w->cap;
+    p_w->p_val[idx] = x;
+    if (p_w->p_ts) p_w->p_ts[idx] = ts;
+
+    /* the samples a new one dominates can never be the extreme again */
+    i_win_deque_t *p_dq = &(p_w->dq_max);
+    while (p_dq->nr &&
+        p_w->p_val[i_win_dq_back(p_w, p_dq) % p_w->cap] <= x) {
+        p_dq->nr--;
+    }
+    i_win_dq_push(p_w, p_dq, p_w->seq);
+
+    p_dq = &(p_w->dq_min);
+    while (p_dq->nr &&
+        p_w->p_val[i_win_dq_back(p_w, p_dq) % p_w->cap] >= x) {
+        p_dq->nr--;
+    }
+    i_win_dq_push(p_w, p_dq, p_w->seq);
+
+    int k = i_win_special(x);
+    if (k >= 0) {
+        p_w->special[k]++;
+    } else {
+        i_win_sum_add(p_w, x);
+    }
+    p_w->nr++;
+    p_w->seq++;
+}
+
+int
+sirius_win_cr(const sirius_win_cr_t *p_cr, sirius_win_handle *p_handle)
+{
+    if (!(p_cr) || !(p_handle)) return SIRIUS_ERR_NULL_POINTER;
+    if (0 == p_cr->elem_nr ||
+        p_cr->win_type >= SIRIUS_WIN_TYPE_MAX ||
+        (SIRIUS_WIN_TYPE_TIME == p_cr->win_type && 0 == p_cr->span)) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    i_win_t *p_w = (i_win_t *)calloc(1, sizeof(i_win_t));
+    if (!(p_w)) return SIRIUS_ERR_MEMORY_ALLOC;
+
+    p_w->win_type = p_cr->win_type;
+    p_w->cap = p_cr->elem_nr;
+    p_w->span = p_cr->span;
+
+    size_t cap = p_cr->elem_nr;
+    p_w->p_val = (double *)malloc(cap * sizeof(double));
+    p_w->p_scratch = (double *)malloc(cap * sizeof(double));
+    p_w->dq_max.p_seq = (uint64_t *)malloc(cap * sizeof(uint64_t));
+    p_w->dq_min.p_seq = (uint64_t *)malloc(cap * sizeof(uint64_t));
+    if (SIRIUS_WIN_TYPE_TIME == p_cr->win_type) {
+        p_w->p_ts = (uint64_t *)malloc(cap * sizeof(uint64_t));
+        if (!(p_w->p_ts)) goto label_free;
+    }
+    if (!(p_w->p_val) || !(p_w->p_scratch) ||
+        !(p_w->dq_max.p_seq) || !(p_w->dq_min.p_seq)) {
+        goto label_free;
+    }
+
+    *p_handle = (sirius_win_handle)p_w;
+    return SIRIUS_OK;
+
+label_free:
+    (void)sirius_win_del((sirius_win_handle)p_w);
+    return SIRIUS_ERR_MEMORY_ALLOC;
+}
+
+int
+sirius_win_del(sirius_win_handle handle)
+{
+    if (!(handle)) return SIRIUS_ERR_NULL_POINTER;
+
+    i_win_t *p_w = (i_win_t *)handle;
+    free(p_w->p_val);
+    free(p_w->p_ts);
+    free(p_w->p_scratch);
+    free(p_w->dq_max.p_seq);
+    free(p_w->dq_min.p_seq);
+    free(p_w);
+    return SIRIUS_OK;
+}
+
+int
+sirius_win_reset(sirius_win_handle handle)
+{
+    if (!(handle)) return SIRIUS_ERR_NULL_POINTER;
+
+    i_win_t *p_w = (i_win_t *)handle;
+    p_w->nr = 0;
+    p_w->dq_max.head = p_w->dq_max.nr = 0;
+    p_w->dq_min.head = p_w->dq_min.nr = 0;
+    p_w->sum = 0;
+    p_w->comp = 0;
+    memset(p_w->special, 0, sizeof(p_w->special));
+    return SIRIUS_OK;
+}
+
+int
+sirius_win_push(sirius_win_handle handle, uint64_t ts, double x)
+{
+    if (!(handle)) return SIRIUS_ERR_NULL_POINTER;
+
+    i_win_push((i_win_t *)handle, ts, x);
+    return SIRIUS_OK;
+}
+
+int
+sirius_win_push_batch(sirius_win_handle handle,
+    const uint64_t *p_ts, const double *p_x, size_t n)
+{
+    if (!(handle) || (n && !(p_x))) return SIRIUS_ERR_NULL_POINTER;
+
+    i_win_t *p_w = (i_win_t *)handle;
+    if (SIRIUS_WIN_TYPE_TIME == p_w->win_type && n && !(p_ts)) {
+        return SIRIUS_ERR_NULL_POINTER;
+    }
+
+    /* only the latest `cap` samples can survive the batch */
+    if (n > p_w->cap) {
+        size_t skip = n - p_w->cap;
+        p_x += skip;
+        if (p_ts) p_ts += skip;
+        n = p_w->cap;
+    }
+
+    if (p_ts) {
+        for (size_t i = 0; i < n; i++) i_win_push(p_w, p_ts[i], p_x[i]);
+    } else {
+        for (size_t i = 0; i < n; i++) i_win_push(p_w, 0, p_x[i]);
+    }
+    return SIRIUS_OK;
+}
+
+int
+sirius_win_expire(sirius_win_handle handle, uint64_t now)
+{
+    if (!(handle)) return SIRIUS_ERR_NULL_POINTER;
+
+    i_win_t *p_w = (i_win_t *)handle;
+    if (SIRIUS_WIN_TYPE_TIME == p_w->win_type) i_win_expire(p_w, now);
+    return SIRIUS_OK;
+}
+
+int
+sirius_win_get(sirius_win_handle handle, sirius_win_res_t *p_res)
+{
+    if (!(handle) || !(p_res)) return SIRIUS_ERR_NULL_POINTER;
+
+    i_win_t *p_w = (i_win_t *)handle;
+    p_res->count = p_w->nr;
+    if (0 == p_w->nr) {
+        p_res->min = NAN;
+        p_res->max = NAN;
+        p_res->sum = 0;
+        p_res->avg = 0;
+        return SIRIUS_OK;
+    }
+
+    p_res->max = p_w->p_val[i_win_dq_front(&(p_w->dq_max)) % p_w->cap];
+    p_res->min = p_w->p_val[i_win_dq_front(&(p_w->dq_min)) % p_w->cap];
+    const size_t *p_sp = p_w->special;
+    if (p_sp[I_WIN_NAN] || (p_sp[I_WIN_PINF] && p_sp[I_WIN_NINF])) {
+        p_res->sum = NAN;
+    } else if (p_sp[I_WIN_PINF]) {
+        p_res->sum = INFINITY;
+    } else if (p_sp[I_WIN_NINF]) {
+        p_res->sum = -INFINITY;
+    } else if (!(isfinite(p_w->sum))) {
+        /* overflowed, the compensation is meaningless */
+        p_res->sum = p_w->sum;
+    } else {
+        p_res->sum = p_w->sum + p_w->comp;
+    }
+    p_res->avg = p_res->sum / (double)(p_w->nr);
+    return SIRIUS_OK;
+}
+
+/**
+ * @brief the `k`th smallest element, `p_a` is reordered
+ */
+static double
+i_win_select(double *p_a, long n, long k)
+{
+    long lo = 0;
+    long hi = n - 1;
+
+    while (lo < hi) {
+        /* median of three as the pivot */
+        long mid = lo + (hi - lo) / 2;
+        double a = p_a[lo], b = p_a[mid], c = p_a[hi];
+        double pivot = a < b ? (b < c ? b : (a < c ? c : a)) :
+            (a < c ? a : (b < c ? c : b));
+
+        long i = lo;
+        long j = hi;
+        while (i <= j) {
+            while (p_a[i] < pivot) i++;
+            while (p_a[j] > pivot) j--;
+            if (i <= j) {
+                double t = p_a[i];
+                p_a[i++] = p_a[j];
+                p_a[j--] = t;
+            }
+        }
+
+        /* [lo, j] <= pivot <= [i, hi], the elements between equal it */
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+    return p_a[k];
+}
+
+int
+sirius_win_percentile(sirius_win_handle handle, double q, double *p_val)
+{
+    if (!(handle) || !(p_val)) return SIRIUS_ERR_NULL_POINTER;
+
+    i_win_t *p_w = (i_win_t *)handle;
+    if (!(q >= 0 && q <= 100) || 0 == p_w->nr) {
+        return SIRIUS_ERR_INVALID_PARAMETER;
+    }
+
+    size_t rank = (size_t)ceil(q / 100 * (double)(p_w->nr));
+    if (rank < 1) rank = 1;
+    if (rank > p_w->nr) rank = p_w->nr;
+
+    /* the window is at most two runs of the ring */
+    size_t first = (p_w->seq - p_w->nr) % p_w->cap;
+    size_t run = p_w->cap - first;
+    if (run > p_w->nr) run = p_w->nr;
+    memcpy(p_w->p_scratch, p_w->p_val + first, run * sizeof(double));
+    memcpy(p_w->p_scratch + run, p_w->p_val,
+        (p_w->nr - run) * sizeof(double));
+
+    *p_val = i_win_select(p_w->p_scratch, (long)(p_w->nr),
+        (long)rank - 1);
+    return SIRIUS_OK;
+}
+
+/**
+ * van Herk / Gil-Werman: split the array into blocks of `w`.
+ * a window ending at `i` starts in the previous block (or at the
+ * start of the same one), so its extreme is that of the suffix of
+ * the previous block and the prefix of the current one. the prefix
+ * scan is serial, the combining loop has no dependencies and
+ * vectorizes.
+ */
+#define I_WIN_SLIDING(name, OP) \
+int \
+sirius_win_sliding_##name(const double *p_in, double *p_out, \
+    size_t n, size_t w) \
+{ \
+    if (!(p_in) || !(p_out)) return SIRIUS_ERR_NULL_POINTER; \
+    if (0 == w) return SIRIUS_ERR_INVALID_PARAMETER; \
+    if (0 == n) return SIRIUS_OK; \
+    if (w > n) w = n; \
+ \
+    /* suffix extremes of the previous block */ \
+    double *p_suf = (double *)malloc(w * sizeof(double)); \
+    if (!(p_suf)) return SIRIUS_ERR_MEMORY_ALLOC; \
+ \
+    for (size_t b = 0; b < n; b += w) { \
+        size_t end = b + w < n ? b + w : n; \
+ \
+        p_out[b] = p_in[b]; \
+        for (size_t i = b + 1; i < end; i++) { \
+            p_out[i] = OP(p_out[i - 1], p_in[i]); \
+        } \
+ \
+        if (b) { \
+            size_t len = end - b < w - 1 ? end - b : w - 1; \
+            for (size_t k = 0; k < len; k++) { \
+                p_out[b + k] = OP(p_out[b + k], p_suf[k + 1]); \
+            } \
+        } \
+ \
+        if (end - b == w) { \
+            p_suf[w - 1] = p_in[end - 1]; \
+            for (size_t k = w - 1; k > 0; k--) { \
+                p_suf[k - 1] = OP(p_suf[k], p_in[b + k - 1]); \
+            } \
+        } \
+    } \
+ \
+    free(p_suf); \
+    return SIRIUS_OK; \
+}
+
+#define I_WIN_MAX(a, b) ((a) > (b) ? (a) : (b))
+#define I_WIN_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+I_WIN_SLIDING(max, I_WIN_MAX)
+I_WIN_SLIDING(min, I_WIN_MIN)
@@ -0,0 +1,92 @@
+/**
+ * @name sirius_logrec.c
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief print the records of a flight recorder file in the order
+ *  they were logged, refer to `sirius_log_recorder_t`
+ * 
+ * @details
+ * sirius_logrec file
+ *  file: `p_path` of the recorder, or `<p_path>.1` for the previous
+ *  run; the file of a running process is read as it is
+ */
+
+#include "internal/sirius_internal_log_rec.h"
+
+#include <sys/mman.h>
+
+int
+main(int argc, char *argv[])
+{
+    if (2 != argc || '-' == argv[1][0]) {
+        fprintf(stderr, "usage: %s file\n", argv[0]);
+        return 2 == argc && 0 == strcmp(argv[1], "-h") ? 0 : 1;
+    }
+
+    int fd = open(argv[1], O_RDONLY | O_CLOEXEC);
+    if (-1 == fd) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(i_log_rec_hdr_t)) {
+        fprintf(stderr, "%s: not a flight recorder file\n", argv[1]);
+        close(fd);
+        return 1;
+    }
+
+    size_t map_size = (size_t)st.st_size;
+    i_log_rec_hdr_t *p_hdr = (i_log_rec_hdr_t *)mmap(NULL, map_size,
+        PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == (void *)p_hdr) {
+        perror("mmap");
+        return 1;
+    }
+
+    int ret = 1;
+    i_log_rec_ent_t *p_ent = NULL;
+    char *p_buf = NULL;
+
+    if (I_LOG_REC_MAGIC != p_hdr->magic ||
+        I_LOG_REC_VERSION != p_hdr->version ||
+        p_hdr->slot_size <= sizeof(i_log_rec_slot_t) ||
+        p_hdr->slice_nr > I_LOG_REC_SLICE_NR_MAX ||
+        i_log_rec_map_size(p_hdr) > map_size) {
+        fprintf(stderr, "%s: not a flight recorder file\n", argv[1]);
+        goto label_exit;
+    }
+
+    p_ent = (i_log_rec_ent_t *)malloc(
+        (i_log_rec_slot_total(p_hdr) + 1) * sizeof(i_log_rec_ent_t));
+    p_buf = (char *)malloc(p_hdr->slot_size);
+    if (!(p_ent) || !(p_buf)) {
+        perror("malloc");
+        goto label_exit;
+    }
+
+    size_t n = i_log_rec_collect(p_hdr, p_ent);
+    i_log_rec_sort(p_ent, n);
+    size_t torn = i_log_rec_emit(p_hdr, STDOUT_FILENO, p_ent, n, p_buf);
+
+    unsigned long long trunc = atomic_load_explicit(
+        &(p_hdr->trunc_nr), memory_order_relaxed);
+    unsigned long long busy = atomic_load_explicit(
+        &(p_hdr->busy_nr), memory_order_relaxed);
+    if (torn || trunc || busy) {
+        fprintf(stderr, "[sirius_logrec] %zu records rewritten while "
+            "reading, %llu records truncated, %llu records dropped "
+            "on a busy slot\n", torn, trunc, busy);
+    }
+    ret = 0;
+
+label_exit:
+    free(p_ent);
+    free(p_buf);
+    munmap(p_hdr, map_size);
+    return ret;
+}
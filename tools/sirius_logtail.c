@@ -0,0 +1,245 @@
+/**
+ * @name sirius_logtail.c
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief drain the shared-memory log ring of a process
+ *  to stdout, refer to `sirius_log_shm_t`
+ * 
+ * @details
+ * sirius_logtail [-n name] [-a]
+ *  -n: name of the shared-memory object, default "/sirius-log"
+ *  -a: start from the oldest record instead of the newest
+ */
+
+#include "internal/sirius_internal_log_shm.h"
+
+#include <signal.h>
+#include <sched.h>
+
+/* futex wait timeout while idle, unit: ms */
+#define I_TAIL_IDLE_MS      (100)
+/* spins on a slot that is being written */
+#define I_TAIL_SPIN_MAX     (1024)
+/**
+ * a slot still being written after this long belongs to a writer that
+ * died or hangs in the middle of it, it is skipped; unit: ms
+ */
+#define I_TAIL_STALE_MS     (1000)
+
+typedef struct {
+    int fd;
+    i_log_shm_hdr_t *p_hdr;
+    size_t map_size;
+} i_tail_map_t;
+
+static volatile sig_atomic_t g_exit = 0;
+
+static void
+i_tail_sig_handler(int sig)
+{
+    (void)sig;
+    g_exit = 1;
+}
+
+static void
+i_tail_unmap(i_tail_map_t *p_m)
+{
+    if (p_m->p_hdr) munmap(p_m->p_hdr, p_m->map_size);
+    if (-1 != p_m->fd) close(p_m->fd);
+    p_m->p_hdr = NULL;
+    p_m->fd = -1;
+}
+
+/**
+ * @return 0 on success, -1 if the object does not exist yet
+ */
+static int
+i_tail_map(i_tail_map_t *p_m, const char *p_name)
+{
+    struct stat st;
+
+    p_m->fd = shm_open(p_name, O_RDWR, 0);
+    if (-1 == p_m->fd) return -1;
+
+    if (fstat(p_m->fd, &st) ||
+        (size_t)st.st_size < sizeof(i_log_shm_hdr_t)) {
+        goto label_fail;
+    }
+
+    p_m->map_size = (size_t)st.st_size;
+    p_m->p_hdr = (i_log_shm_hdr_t *)mmap(NULL, p_m->map_size,
+        PROT_READ | PROT_WRITE, MAP_SHARED, p_m->fd, 0);
+    if (MAP_FAILED == (void *)p_m->p_hdr) {
+        p_m->p_hdr = NULL;
+        goto label_fail;
+    }
+
+    if (I_LOG_SHM_MAGIC != p_m->p_hdr->magic ||
+        I_LOG_SHM_VERSION != p_m->p_hdr->version ||
+        sizeof(i_log_shm_hdr_t) +
+            (size_t)p_m->p_hdr->slot_nr * p_m->p_hdr->slot_size >
+            p_m->map_size) {
+        goto label_fail;
+    }
+
+    return 0;
+
+label_fail:
+    i_tail_unmap(p_m);
+    return -1;
+}
+
+/* the writer unlinked the object, e.g. it exited or restarted */
+static bool
+i_tail_stale(i_tail_map_t *p_m)
+{
+    struct stat st;
+    return fstat(p_m->fd, &st) || 0 == st.st_nlink;
+}
+
+static void
+i_tail_wait(i_log_shm_hdr_t *p_hdr, unsigned long long rd)
+{
+    struct timespec ts = {
+        .tv_sec = I_TAIL_IDLE_MS / 1000,
+        .tv_nsec = (I_TAIL_IDLE_MS % 1000) * 1000000,
+    };
+
+    atomic_fetch_add_explicit(&(p_hdr->waiters), 1,
+        memory_order_seq_cst);
+    unsigned int notify = atomic_load_explicit(
+        &(p_hdr->notify), memory_order_seq_cst);
+    if (rd == atomic_load_explicit(
+            &(p_hdr->head), memory_order_seq_cst)) {
+        (void)i_log_shm_futex(&(p_hdr->notify),
+            FUTEX_WAIT, notify, &ts);
+    }
+    atomic_fetch_sub_explicit(&(p_hdr->waiters), 1,
+        memory_order_seq_cst);
+}
+
+static uint64_t
+i_tail_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static void
+i_tail_lost(unsigned long long lost, unsigned long long *p_total)
+{
+    *p_total += lost;
+    fprintf(stderr, "[sirius_logtail] %llu records lost "
+        "(total %llu)\n", lost, *p_total);
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *p_name = I_LOG_SHM_NAME_DEF;
+    bool from_oldest = false;
+    int opt;
+
+    while (-1 != (opt = getopt(argc, argv, "n:ah"))) {
+        switch (opt) {
+            case 'n':
+                p_name = optarg;
+                break;
+            case 'a':
+                from_oldest = true;
+                break;
+            default:
+                fprintf(stderr,
+                    "usage: %s [-n name] [-a]\n", argv[0]);
+                return 'h' == opt ? 0 : 1;
+        }
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = i_tail_sig_handler;
+    sigemptyset(&(sa.sa_mask));
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    i_tail_map_t m = {.fd = -1, .p_hdr = NULL};
+    unsigned long long lost_total = 0;
+    char *p_buf = NULL;
+
+    while (!(g_exit)) {
+        if (i_tail_map(&m, p_name)) {
+            usleep(I_TAIL_IDLE_MS * 1000);
+            continue;
+        }
+
+        i_log_shm_hdr_t *p_hdr = m.p_hdr;
+        unsigned long long slot_nr = p_hdr->slot_nr;
+        size_t cap = p_hdr->slot_size - sizeof(i_log_shm_slot_t);
+        free(p_buf);
+        p_buf = (char *)malloc(cap);
+        if (!(p_buf)) {
+            perror("malloc");
+            break;
+        }
+
+        unsigned long long rd = atomic_load_explicit(
+            &(p_hdr->head), memory_order_acquire);
+        if (from_oldest) {
+            rd = rd > slot_nr ? rd - slot_nr : 0;
+        }
+
+        unsigned int spin = 0;
+        /* when the current slot was first found unpublished, 0 if not */
+        uint64_t slot_wait = 0;
+        while (!(g_exit)) {
+            unsigned long long lost = 0;
+            long len = i_log_shm_read(p_hdr, &rd, p_buf, &lost);
+            if (lost) {
+                i_tail_lost(lost, &lost_total);
+                spin = 0;
+                slot_wait = 0;
+            }
+
+            if (len >= 0) {
+                fwrite(p_buf, 1, (size_t)len, stdout);
+                spin = 0;
+                slot_wait = 0;
+            } else if (I_LOG_SHM_READ_EMPTY == len) {
+                fflush(stdout);
+                if (i_tail_stale(&m)) break;
+                i_tail_wait(p_hdr, rd);
+            } else if (++spin > I_TAIL_SPIN_MAX) {
+                /* the writer is preempted in the middle of the slot */
+                spin = 0;
+                uint64_t now = i_tail_ms();
+                if (0 == slot_wait) {
+                    slot_wait = now;
+                } else if (now - slot_wait > I_TAIL_STALE_MS) {
+                    fprintf(stderr, "[sirius_logtail] record %llu "
+                        "never completed, skipped\n", rd);
+                    i_tail_lost(1, &lost_total);
+                    rd++;
+                    slot_wait = 0;
+                    continue;
+                }
+                sched_yield();
+            }
+        }
+
+        i_tail_unmap(&m);
+    }
+
+    fflush(stdout);
+    if (lost_total) {
+        fprintf(stderr, "[sirius_logtail] %llu records lost in total\n",
+            lost_total);
+    }
+
+    free(p_buf);
+    i_tail_unmap(&m);
+    return 0;
+}
@@ -0,0 +1,220 @@
+/**
+ * @name sirius_test_config.cpp
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief registration, snapshots and concurrent updates
+ * 
+ * @details
+ * the keys live for the whole process, every test registers
+ * names of its own.
+ */
+
+#include "sirius_config.h"
+#include "sirius_errno.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<long long> i_notified{-1};
+
+int
+i_check_even(long long val)
+{
+    return val % 2 ? SIRIUS_ERR_INVALID_PARAMETER : SIRIUS_OK;
+}
+
+void
+i_notify(long long val)
+{
+    i_notified = val;
+}
+
+int
+i_reg(const char *p_name, long long def, long long min, long long max)
+{
+    sirius_cfg_attr_t attr = {};
+    attr.p_name = p_name;
+    attr.def = def;
+    attr.min = min;
+    attr.max = max;
+    return sirius_cfg_register(&attr);
+}
+
+} // namespace
+
+TEST(SiriusConfig, Register)
+{
+    sirius_cfg_attr_t attr = {};
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_cfg_register(nullptr));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_cfg_register(&attr));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, i_reg("test.reg.bad", 5, 0, 4));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, i_reg("test.reg.bad", 0, 1, 0));
+
+    int id = i_reg("test.reg", 3, 0, 10);
+    ASSERT_GE(id, 0);
+    EXPECT_EQ(3, sirius_cfg_get(id));
+    EXPECT_EQ(id, sirius_cfg_find("test.reg"));
+    EXPECT_STREQ("test.reg", sirius_cfg_name(id));
+    EXPECT_EQ(nullptr, sirius_cfg_name(-1));
+    EXPECT_GT(0, sirius_cfg_find("test.reg.none"));
+
+    /* registering again keeps the value */
+    EXPECT_EQ(SIRIUS_OK, sirius_cfg_set(id, 7));
+    EXPECT_EQ(id, i_reg("test.reg", 3, 0, 10));
+    EXPECT_EQ(7, sirius_cfg_get(id));
+
+    const sirius_cfg_snap_t *p_s = sirius_cfg_snap_acquire();
+    EXPECT_LT((unsigned int)id, p_s->nr);
+    EXPECT_EQ(7, p_s->vals[id]);
+    sirius_cfg_snap_release();
+}
+
+TEST(SiriusConfig, Set)
+{
+    sirius_cfg_attr_t attr = {};
+    attr.p_name = "test.set";
+    attr.def = 0;
+    attr.min = -100;
+    attr.max = 100;
+    attr.p_check = i_check_even;
+    attr.p_notify = i_notify;
+    int id = sirius_cfg_register(&attr);
+    ASSERT_GE(id, 0);
+
+    EXPECT_EQ(SIRIUS_ERR_INVALID_ENTRY, sirius_cfg_set(-1, 0));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_ENTRY, sirius_cfg_set(SIRIUS_CFG_KEY_MAX, 0));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_cfg_set(id, 101));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_cfg_set(id, 3));
+    EXPECT_EQ(0, sirius_cfg_get(id));
+    EXPECT_EQ(-1, i_notified.load());
+
+    EXPECT_EQ(SIRIUS_OK, sirius_cfg_set(id, -100));
+    EXPECT_EQ(-100, sirius_cfg_get(id));
+    EXPECT_EQ(-100, i_notified.load());
+
+    EXPECT_EQ(SIRIUS_OK, sirius_cfg_set_name("test.set", 42));
+    EXPECT_EQ(42, sirius_cfg_get(id));
+    EXPECT_GT(0, sirius_cfg_set_name("test.set.none", 42));
+}
+
+TEST(SiriusConfig, SetInReadSection)
+{
+    int id = i_reg("test.read", 0, 0, 10);
+    ASSERT_GE(id, 0);
+
+    /* the grace period would wait for this very thread */
+    (void)sirius_cfg_snap_acquire();
+    (void)sirius_cfg_snap_acquire();
+    EXPECT_EQ(SIRIUS_ERR_RESOURCE_REQUEST, sirius_cfg_set(id, 1));
+    EXPECT_EQ(SIRIUS_ERR_RESOURCE_REQUEST, i_reg("test.read.2", 0, 0, 1));
+    sirius_cfg_snap_release();
+    EXPECT_EQ(SIRIUS_ERR_RESOURCE_REQUEST, sirius_cfg_set(id, 1));
+    sirius_cfg_snap_release();
+
+    EXPECT_EQ(SIRIUS_OK, sirius_cfg_set(id, 1));
+    EXPECT_EQ(1, sirius_cfg_get(id));
+    /* an unbalanced release is ignored */
+    sirius_cfg_snap_release();
+    EXPECT_EQ(SIRIUS_OK, sirius_cfg_set(id, 2));
+}
+
+TEST(SiriusConfig, Snapshot)
+{
+    int id = i_reg("test.snap", 1, 0, 10);
+    ASSERT_GE(id, 0);
+
+    const sirius_cfg_snap_t *p_s = sirius_cfg_snap_acquire();
+    EXPECT_EQ(p_s, sirius_cfg_snap_acquire());
+    sirius_cfg_snap_release();
+    unsigned long long version = p_s->version;
+
+    /* the writer publishes, then waits for this reader */
+    std::atomic<bool> done{false};
+    std::thread wr([&]() {
+        EXPECT_EQ(SIRIUS_OK, sirius_cfg_set(id, 2));
+        done = true;
+    });
+    while (2 != sirius_cfg_get(id)) std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    EXPECT_FALSE(done);
+    EXPECT_EQ(1, p_s->vals[id]);
+    EXPECT_EQ(version, p_s->version);
+    sirius_cfg_snap_release();
+    wr.join();
+    EXPECT_TRUE(done);
+
+    p_s = sirius_cfg_snap_acquire();
+    EXPECT_EQ(2, p_s->vals[id]);
+    EXPECT_LT(version, p_s->version);
+    sirius_cfg_snap_release();
+}
+
+TEST(SiriusConfig, Concurrent)
+{
+    int x = i_reg("test.conc.x", 0, 0, 1LL << 40);
+    int y = i_reg("test.conc.y", 0, 0, 1LL << 40);
+    int z = i_reg("test.conc.z", 0, 0, 1LL << 40);
+    ASSERT_GE(x, 0);
+    ASSERT_GE(y, 0);
+    ASSERT_GE(z, 0);
+
+    /* more readers than slots, the rest share the counter */
+    const int rd_nr = 140;
+    const long long loop = 300;
+    std::atomic<bool> stop{false}, bad{false};
+    std::atomic<int> ready{0};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < rd_nr; t++) {
+        readers.emplace_back([&]() {
+            unsigned long long version = 0;
+            long long last = 0;
+            ready++;
+            while (!(stop.load())) {
+                /* `x` is set before `y`, a snapshot sees y <= x <= y + 1 */
+                const sirius_cfg_snap_t *p_s = sirius_cfg_snap_acquire();
+                long long vx = p_s->vals[x], vy = p_s->vals[y];
+                if (vy > vx || vx > vy + 1 || p_s->version < version) {
+                    bad = true;
+                }
+                version = p_s->version;
+                sirius_cfg_snap_release();
+
+                long long v = sirius_cfg_get(x);
+                if (v < last) bad = true;
+                last = v;
+                std::this_thread::yield();
+            }
+        });
+    }
+    while (rd_nr != ready.load()) std::this_thread::yield();
+
+    /* a second writer on another key, the writers are serialized */
+    std::thread wr([&]() {
+        for (long long i = 1; i <= loop; i++) {
+            EXPECT_EQ(SIRIUS_OK, sirius_cfg_set(z, i));
+        }
+    });
+    for (long long i = 1; i <= loop; i++) {
+        EXPECT_EQ(SIRIUS_OK, sirius_cfg_set(x, i));
+        EXPECT_EQ(SIRIUS_OK, sirius_cfg_set(y, i));
+    }
+    wr.join();
+    stop = true;
+    for (auto &t : readers) t.join();
+
+    EXPECT_FALSE(bad);
+    EXPECT_EQ(loop, sirius_cfg_get(x));
+    EXPECT_EQ(loop, sirius_cfg_get(y));
+    EXPECT_EQ(loop, sirius_cfg_get(z));
+}
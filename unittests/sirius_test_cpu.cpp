@@ -0,0 +1,113 @@
+/**
+ * @name sirius_test_cpu.cpp
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief cpu feature detection and implementation selection
+ */
+
+#include "sirius_cpu.h"
+#include "sirius_errno.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace {
+
+int i_impl_a() { return 1; }
+int i_impl_b() { return 2; }
+int i_impl_c() { return 3; }
+
+int
+i_call(sirius_cpu_fn_t p_fn)
+{
+    return ((int (*)())p_fn)();
+}
+
+} // namespace
+
+TEST(SiriusCpu, Features)
+{
+    unsigned int feat = sirius_cpu_features();
+    EXPECT_EQ(feat, sirius_cpu_features());
+    EXPECT_TRUE(sirius_cpu_has(0));
+    EXPECT_TRUE(sirius_cpu_has(feat));
+
+#if defined(__x86_64__) || defined(__i386__)
+    /* the compiler runtime checks cpuid and xgetbv the same way */
+    __builtin_cpu_init();
+    EXPECT_EQ(!!__builtin_cpu_supports("sse2"),
+        sirius_cpu_has(SIRIUS_CPU_SSE2));
+    EXPECT_EQ(!!__builtin_cpu_supports("sse4.2"),
+        sirius_cpu_has(SIRIUS_CPU_SSE42));
+    EXPECT_EQ(!!__builtin_cpu_supports("popcnt"),
+        sirius_cpu_has(SIRIUS_CPU_POPCNT));
+    EXPECT_EQ(!!__builtin_cpu_supports("avx"),
+        sirius_cpu_has(SIRIUS_CPU_AVX));
+    EXPECT_EQ(!!__builtin_cpu_supports("avx2"),
+        sirius_cpu_has(SIRIUS_CPU_AVX2));
+    EXPECT_EQ(!!__builtin_cpu_supports("fma"),
+        sirius_cpu_has(SIRIUS_CPU_FMA));
+    EXPECT_EQ(!!__builtin_cpu_supports("bmi"),
+        sirius_cpu_has(SIRIUS_CPU_BMI1));
+    EXPECT_EQ(!!__builtin_cpu_supports("bmi2"),
+        sirius_cpu_has(SIRIUS_CPU_BMI2));
+    EXPECT_EQ(!!__builtin_cpu_supports("avx512f"),
+        sirius_cpu_has(SIRIUS_CPU_AVX512F));
+    EXPECT_EQ(!!__builtin_cpu_supports("avx512bw"),
+        sirius_cpu_has(SIRIUS_CPU_AVX512BW));
+    EXPECT_EQ(!!__builtin_cpu_supports("avx512dq"),
+        sirius_cpu_has(SIRIUS_CPU_AVX512DQ));
+    EXPECT_EQ(!!__builtin_cpu_supports("avx512vl"),
+        sirius_cpu_has(SIRIUS_CPU_AVX512VL));
+#endif
+}
+
+TEST(SiriusCpu, FeatName)
+{
+    EXPECT_STREQ("sse2", sirius_cpu_feat_name(SIRIUS_CPU_SSE2));
+    EXPECT_STREQ("avx512vl", sirius_cpu_feat_name(SIRIUS_CPU_AVX512VL));
+    EXPECT_EQ(nullptr, sirius_cpu_feat_name((sirius_cpu_feat_t)0));
+    EXPECT_EQ(nullptr, sirius_cpu_feat_name(
+        (sirius_cpu_feat_t)(SIRIUS_CPU_AVX | SIRIUS_CPU_AVX2)));
+}
+
+TEST(SiriusCpu, Cache)
+{
+    EXPECT_EQ(SIRIUS_OK, sirius_cpu_init());
+    const sirius_cpu_cache_t *p_c = sirius_cpu_cache();
+    ASSERT_NE(nullptr, p_c);
+    EXPECT_EQ(p_c, sirius_cpu_cache());
+
+    /* a power of 2, and the caches grow with the level */
+    EXPECT_NE(0u, p_c->line);
+    EXPECT_EQ(0u, p_c->line & (p_c->line - 1));
+    if (p_c->l1d && p_c->l2) {
+        EXPECT_LE(p_c->l1d, p_c->l2);
+    }
+    if (p_c->l1d) {
+        EXPECT_EQ(0u, p_c->l1d % p_c->line);
+    }
+}
+
+TEST(SiriusCpu, Select)
+{
+    /* a feature no cpu reports */
+    const unsigned int none = 1U << 30;
+    sirius_cpu_impl_t impl[] = {
+        {none, (sirius_cpu_fn_t)i_impl_a},
+        {sirius_cpu_features(), (sirius_cpu_fn_t)i_impl_b},
+        {0, (sirius_cpu_fn_t)i_impl_c},
+    };
+
+    EXPECT_EQ(2, i_call(sirius_cpu_select(impl, 3)));
+    /* the first match wins, even if a later one needs more */
+    sirius_cpu_impl_t rev[] = {impl[2], impl[1]};
+    EXPECT_EQ(3, i_call(sirius_cpu_select(rev, 2)));
+    EXPECT_EQ(nullptr, sirius_cpu_select(impl, 1));
+    EXPECT_EQ(nullptr, sirius_cpu_select(impl, 0));
+    EXPECT_EQ(nullptr, sirius_cpu_select(nullptr, 3));
+}
@@ -0,0 +1,429 @@
+/**
+ * @name sirius_test_hashmap.cpp
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief open-addressing hash map, run once per probing instruction set
+ */
+
+#include "sirius_hashmap.h"
+#include "sirius_errno.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+sirius_hashmap_handle
+i_cr(sirius_hashmap_key_t type, unsigned int stripes = 0,
+    sirius_hashmap_hash_t p_hash = nullptr, size_t capacity = 0)
+{
+    sirius_hashmap_cr_t cr = {};
+    cr.key_type = type;
+    cr.p_hash = p_hash;
+    cr.seed = 0x5eed;
+    cr.capacity = capacity;
+    cr.stripes = stripes;
+    sirius_hashmap_handle h = nullptr;
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_cr(&cr, &h));
+    return h;
+}
+
+/* everything collides */
+uint64_t
+i_hash_const(const void *, size_t, uint64_t)
+{
+    return 0x1234;
+}
+
+} // namespace
+
+TEST(SiriusHashmap, Isa)
+{
+    std::string isa = sirius_hashmap_isa();
+    const char *p_env = getenv("SIRIUS_MATH_ISA");
+    if (p_env && std::string(p_env) == "scalar") {
+        EXPECT_EQ("scalar", isa);
+    }
+    EXPECT_TRUE(isa == "scalar" || isa == "sse2" || isa == "avx2");
+}
+
+TEST(SiriusHashmap, Invalid)
+{
+    sirius_hashmap_cr_t cr = {};
+    sirius_hashmap_handle h = nullptr;
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_hashmap_cr(nullptr, &h));
+    cr.key_type = SIRIUS_HASHMAP_KEY_MAX;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_hashmap_cr(&cr, &h));
+    cr.key_type = SIRIUS_HASHMAP_KEY_INT;
+    cr.stripes = SIRIUS_HASHMAP_STRIPE_MAX + 1;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_hashmap_cr(&cr, &h));
+
+    h = i_cr(SIRIUS_HASHMAP_KEY_INT);
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_hashmap_put(h, "a", 1, 1));
+    EXPECT_EQ(SIRIUS_ERR_NOT_FOUND, sirius_hashmap_get_int(h, 1, nullptr));
+    EXPECT_EQ(SIRIUS_ERR_NOT_FOUND, sirius_hashmap_erase_int(h, 1));
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+
+    h = i_cr(SIRIUS_HASHMAP_KEY_BYTES);
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_hashmap_put_int(h, 1, 1));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_hashmap_put(h, nullptr, 1, 1));
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+}
+
+TEST(SiriusHashmap, Int)
+{
+    sirius_hashmap_handle h = i_cr(SIRIUS_HASHMAP_KEY_INT);
+    size_t v = 0;
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_put_int(h, 0, 100));
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_put_int(h, UINT64_MAX, 200));
+    EXPECT_EQ(2u, sirius_hashmap_size(h));
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_get_int(h, 0, &v));
+    EXPECT_EQ(100u, v);
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_get_int(h, UINT64_MAX, &v));
+    EXPECT_EQ(200u, v);
+
+    /* replace */
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_put_int(h, 0, 101));
+    EXPECT_EQ(2u, sirius_hashmap_size(h));
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_get_int(h, 0, &v));
+    EXPECT_EQ(101u, v);
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_erase_int(h, 0));
+    EXPECT_EQ(SIRIUS_ERR_NOT_FOUND, sirius_hashmap_get_int(h, 0, &v));
+    EXPECT_EQ(SIRIUS_ERR_NOT_FOUND, sirius_hashmap_erase_int(h, 0));
+    EXPECT_EQ(1u, sirius_hashmap_size(h));
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+}
+
+TEST(SiriusHashmap, Bytes)
+{
+    sirius_hashmap_handle h = i_cr(SIRIUS_HASHMAP_KEY_BYTES);
+    size_t v = 0;
+
+    /* the key is copied */
+    std::string key = "alpha";
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_put(h, key.data(), key.size(), 1));
+    key[0] = 'A';
+    EXPECT_EQ(SIRIUS_ERR_NOT_FOUND,
+        sirius_hashmap_get(h, key.data(), key.size(), &v));
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_get(h, "alpha", 5, &v));
+    EXPECT_EQ(1u, v);
+
+    /* prefixes and the empty key are distinct keys */
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_put(h, "alph", 4, 2));
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_put(h, nullptr, 0, 3));
+    EXPECT_EQ(3u, sirius_hashmap_size(h));
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_get(h, "", 0, &v));
+    EXPECT_EQ(3u, v);
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_get(h, "alph", 4, &v));
+    EXPECT_EQ(2u, v);
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_put(h, "alpha", 5, 4));
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_get(h, "alpha", 5, &v));
+    EXPECT_EQ(4u, v);
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_erase(h, "alpha", 5));
+    EXPECT_EQ(SIRIUS_ERR_NOT_FOUND, sirius_hashmap_get(h, "alpha", 5, &v));
+    EXPECT_EQ(2u, sirius_hashmap_size(h));
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+}
+
+TEST(SiriusHashmap, Hash)
+{
+    /* every length up to a few blocks */
+    std::set<uint64_t> seen;
+    std::string s;
+    for (int i = 0; i < 100; i++) {
+        seen.insert(sirius_hashmap_hash(s.data(), s.size(), 0));
+        s.push_back((char)('a' + i % 26));
+    }
+    EXPECT_EQ(100u, seen.size());
+    EXPECT_EQ(sirius_hashmap_hash("abc", 3, 1), sirius_hashmap_hash("abc", 3, 1));
+    EXPECT_NE(sirius_hashmap_hash("abc", 3, 1), sirius_hashmap_hash("abc", 3, 2));
+}
+
+TEST(SiriusHashmap, Grow)
+{
+    const uint64_t n = 100000;
+    sirius_hashmap_handle h = i_cr(SIRIUS_HASHMAP_KEY_INT);
+    for (uint64_t i = 0; i < n; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_put_int(h, i * 7919, i));
+    }
+    EXPECT_EQ(n, sirius_hashmap_size(h));
+    EXPECT_GE(sirius_hashmap_capacity(h), n);
+    for (uint64_t i = 0; i < n; i++) {
+        size_t v = 0;
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_get_int(h, i * 7919, &v));
+        ASSERT_EQ(i, v);
+    }
+    EXPECT_EQ(SIRIUS_ERR_NOT_FOUND, sirius_hashmap_get_int(h, 1, nullptr));
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+
+    h = i_cr(SIRIUS_HASHMAP_KEY_BYTES);
+    for (uint64_t i = 0; i < n; i++) {
+        std::string key = "key-" + std::to_string(i);
+        ASSERT_EQ(SIRIUS_OK,
+            sirius_hashmap_put(h, key.data(), key.size(), i));
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        std::string key = "key-" + std::to_string(i);
+        size_t v = 0;
+        ASSERT_EQ(SIRIUS_OK,
+            sirius_hashmap_get(h, key.data(), key.size(), &v));
+        ASSERT_EQ(i, v);
+    }
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+}
+
+TEST(SiriusHashmap, Churn)
+{
+    /* a sliding window of keys leaves deletion marks behind */
+    sirius_hashmap_handle h = i_cr(SIRIUS_HASHMAP_KEY_INT);
+    const uint64_t window = 1000;
+    for (uint64_t i = 0; i < 200000; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_put_int(h, i, i));
+        if (i >= window) {
+            ASSERT_EQ(SIRIUS_OK, sirius_hashmap_erase_int(h, i - window));
+        }
+    }
+    EXPECT_EQ(window, sirius_hashmap_size(h));
+    /* rebuilt in place rather than grown without bound */
+    EXPECT_LT(sirius_hashmap_capacity(h), window * 4);
+    for (uint64_t i = 200000 - window; i < 200000; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_get_int(h, i, nullptr));
+    }
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+}
+
+TEST(SiriusHashmap, Collide)
+{
+    sirius_hashmap_handle h =
+        i_cr(SIRIUS_HASHMAP_KEY_BYTES, 0, i_hash_const);
+    for (int i = 0; i < 500; i++) {
+        std::string key = std::to_string(i);
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_put(h, key.data(), key.size(), i));
+    }
+    for (int i = 0; i < 500; i += 2) {
+        std::string key = std::to_string(i);
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_erase(h, key.data(), key.size()));
+    }
+    for (int i = 0; i < 500; i++) {
+        std::string key = std::to_string(i);
+        size_t v = 0;
+        int ret = sirius_hashmap_get(h, key.data(), key.size(), &v);
+        if (i % 2) {
+            ASSERT_EQ(SIRIUS_OK, ret);
+            ASSERT_EQ((size_t)i, v);
+        } else {
+            ASSERT_EQ(SIRIUS_ERR_NOT_FOUND, ret);
+        }
+    }
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+
+    h = i_cr(SIRIUS_HASHMAP_KEY_INT, 0, i_hash_const);
+    for (uint64_t i = 0; i < 300; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_put_int(h, i, i + 1));
+    }
+    for (uint64_t i = 0; i < 300; i++) {
+        size_t v = 0;
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_get_int(h, i, &v));
+        ASSERT_EQ(i + 1, v);
+    }
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+}
+
+TEST(SiriusHashmap, Reserve)
+{
+    sirius_hashmap_handle h = i_cr(SIRIUS_HASHMAP_KEY_INT, 0, nullptr, 1000);
+    size_t cap = sirius_hashmap_capacity(h);
+    EXPECT_GE(cap, 1000u);
+
+    for (uint64_t i = 0; i < 1000; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_put_int(h, i, i));
+    }
+    EXPECT_EQ(cap, sirius_hashmap_capacity(h));
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_reserve(h, 10000));
+    EXPECT_GE(sirius_hashmap_capacity(h), 10000u);
+    /* reserve never shrinks */
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_reserve(h, 10));
+    EXPECT_GE(sirius_hashmap_capacity(h), 10000u);
+
+    for (uint64_t i = 10; i < 1000; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_erase_int(h, i));
+    }
+    /* rehash shrinks down to the elements left */
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_rehash(h, 0));
+    EXPECT_LT(sirius_hashmap_capacity(h), 100u);
+    EXPECT_EQ(10u, sirius_hashmap_size(h));
+    for (uint64_t i = 0; i < 10; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_get_int(h, i, nullptr));
+    }
+
+    cap = sirius_hashmap_capacity(h);
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_clear(h));
+    EXPECT_EQ(0u, sirius_hashmap_size(h));
+    EXPECT_EQ(cap, sirius_hashmap_capacity(h));
+    EXPECT_EQ(SIRIUS_ERR_NOT_FOUND, sirius_hashmap_get_int(h, 0, nullptr));
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+}
+
+TEST(SiriusHashmap, Iterate)
+{
+    sirius_hashmap_handle h = i_cr(SIRIUS_HASHMAP_KEY_BYTES);
+    std::map<std::string, size_t> ref;
+    for (size_t i = 0; i < 1000; i++) {
+        std::string key = "k" + std::to_string(i);
+        ref[key] = i;
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_put(h, key.data(), key.size(), i));
+    }
+
+    std::map<std::string, size_t> seen;
+    sirius_hashmap_iter_t it = SIRIUS_HASHMAP_ITER_INIT;
+    sirius_hashmap_entry_t ent;
+    while (sirius_hashmap_next(h, &it, &ent)) {
+        std::string key((const char *)ent.p_key, ent.len);
+        EXPECT_TRUE(seen.emplace(key, *ent.p_value).second);
+        /* the value may be written, the current element erased */
+        if (*ent.p_value % 2) {
+            EXPECT_EQ(SIRIUS_OK,
+                sirius_hashmap_erase(h, key.data(), key.size()));
+        } else {
+            *ent.p_value += 1000000;
+        }
+    }
+    EXPECT_EQ(ref, seen);
+    EXPECT_EQ(500u, sirius_hashmap_size(h));
+
+    size_t sum = 0;
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_foreach(h,
+        [](const sirius_hashmap_entry_t *p_ent, void *p_arg) -> int {
+            *(size_t *)p_arg += *p_ent->p_value - 1000000;
+            return 0;
+        }, &sum));
+    EXPECT_EQ(499u * 500u / 2 * 2, sum);
+
+    /* stopped by a non-zero return */
+    int calls = 0;
+    EXPECT_EQ(7, sirius_hashmap_foreach(h,
+        [](const sirius_hashmap_entry_t *, void *p_arg) -> int {
+            return ++*(int *)p_arg == 3 ? 7 : 0;
+        }, &calls));
+    EXPECT_EQ(3, calls);
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+}
+
+TEST(SiriusHashmap, Striped)
+{
+    const unsigned int n_writers = 2;
+    const unsigned int n_readers = 4;
+    const uint64_t per_writer = 20000;
+
+    sirius_hashmap_handle h = i_cr(SIRIUS_HASHMAP_KEY_INT, 6);
+    /* keys that are never erased */
+    for (uint64_t i = 0; i < 1000; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_put_int(h, i, i));
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned long> bad(0);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < n_readers; t++) {
+        threads.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (uint64_t i = 0; i < 1000; i++) {
+                    size_t v = 0;
+                    if (sirius_hashmap_get_int(h, i, &v) || v != i) bad++;
+                }
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (unsigned int t = 0; t < n_writers; t++) {
+        writers.emplace_back([&, t] {
+            uint64_t base = (t + 1) * 1000000;
+            for (uint64_t i = 0; i < per_writer; i++) {
+                sirius_hashmap_put_int(h, base + i, i);
+                if (i % 2) sirius_hashmap_erase_int(h, base + i - 1);
+            }
+        });
+    }
+    for (auto &w : writers) w.join();
+    stop = true;
+    for (auto &t : threads) t.join();
+
+    EXPECT_EQ(0u, bad.load());
+    EXPECT_EQ(1000u + n_writers * per_writer / 2, sirius_hashmap_size(h));
+
+    size_t n = 0;
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_foreach(h,
+        [](const sirius_hashmap_entry_t *, void *p_arg) -> int {
+            ++*(size_t *)p_arg;
+            return 0;
+        }, &n));
+    EXPECT_EQ(sirius_hashmap_size(h), n);
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_reserve(h, 100000));
+    EXPECT_GE(sirius_hashmap_capacity(h), 100000u);
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_get_int(h, 999, nullptr));
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+}
+
+TEST(SiriusHashmap, StripedForeachWrite)
+{
+    sirius_hashmap_handle h = i_cr(SIRIUS_HASHMAP_KEY_INT, 4);
+    for (uint64_t i = 0; i < 1000; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_put_int(h, i, 2 * i));
+    }
+
+    /* foreach writes the values while readers get them */
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned long> bad(0);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < 2; t++) {
+        threads.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (uint64_t i = 0; i < 1000; i++) {
+                    size_t v = 0;
+                    if (sirius_hashmap_get_int(h, i, &v) || v % 2 ||
+                        v < 2 * i) {
+                        bad++;
+                    }
+                }
+            }
+        });
+    }
+    const int rounds = 50;
+    for (int r = 0; r < rounds; r++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_foreach(h,
+            [](const sirius_hashmap_entry_t *p_ent, void *) -> int {
+                *p_ent->p_value += 2;
+                return 0;
+            }, nullptr));
+    }
+    stop = true;
+    for (auto &t : threads) t.join();
+
+    EXPECT_EQ(0u, bad.load());
+    for (uint64_t i = 0; i < 1000; i++) {
+        size_t v = 0;
+        ASSERT_EQ(SIRIUS_OK, sirius_hashmap_get_int(h, i, &v));
+        EXPECT_EQ(2 * i + 2 * rounds, v);
+    }
+    EXPECT_EQ(SIRIUS_OK, sirius_hashmap_del(h));
+}
@@ -0,0 +1,315 @@
+/**
+ * @name sirius_test_lock.cpp
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief mutex, ticket lock, rwlock and seqlock under contention
+ * 
+ * @details
+ * the ordering tests park threads on a held lock and poll the lock
+ * words until every waiter is queued, then release it and check the
+ * order in which they got in.
+ */
+
+#include "sirius_lock.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int i_thd_nr = 4;
+
+/* poll until `fn` holds, false after about 5 seconds */
+template <typename F>
+bool
+i_until(F fn)
+{
+    for (int i = 0; i < 5000; i++) {
+        if (fn()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+struct i_order_t {
+    std::mutex mtx;
+    std::vector<int> v;
+
+    void add(int id)
+    {
+        std::lock_guard<std::mutex> g(mtx);
+        v.push_back(id);
+    }
+};
+
+} // namespace
+
+TEST(SiriusLock, Mutex)
+{
+    sirius_mtx_t mtx = SIRIUS_MTX_INITIALIZER;
+    const int loop = 20000;
+    long cnt = 0;
+    std::atomic<int> inside{0};
+    std::atomic<bool> bad{false};
+
+    std::vector<std::thread> thds;
+    for (int t = 0; t < i_thd_nr; t++) {
+        thds.emplace_back([&, t]() {
+            for (int i = 0; i < loop; i++) {
+                sirius_mtx_lock(&mtx);
+                if (1 != ++inside) bad = true;
+                cnt++;
+                /* now and then hold it long enough for the futex path */
+                if (0 == (i + t) % 1000) {
+                    std::this_thread::sleep_for(
+                        std::chrono::microseconds(200));
+                }
+                --inside;
+                sirius_mtx_unlock(&mtx);
+            }
+        });
+    }
+    for (auto &t : thds) t.join();
+
+    EXPECT_FALSE(bad);
+    EXPECT_EQ((long)i_thd_nr * loop, cnt);
+    EXPECT_EQ(0u, mtx.state);
+
+    EXPECT_TRUE(sirius_mtx_trylock(&mtx));
+    std::thread([&]() {
+        EXPECT_FALSE(sirius_mtx_trylock(&mtx));
+    }).join();
+    sirius_mtx_unlock(&mtx);
+}
+
+TEST(SiriusLock, Ticket)
+{
+    sirius_ticket_t tk = SIRIUS_TICKET_INITIALIZER;
+    const int loop = 20000;
+    long cnt = 0;
+
+    std::vector<std::thread> thds;
+    for (int t = 0; t < i_thd_nr; t++) {
+        thds.emplace_back([&]() {
+            for (int i = 0; i < loop; i++) {
+                sirius_ticket_lock(&tk);
+                cnt++;
+                sirius_ticket_unlock(&tk);
+            }
+        });
+    }
+    for (auto &t : thds) t.join();
+    EXPECT_EQ((long)i_thd_nr * loop, cnt);
+
+    EXPECT_TRUE(sirius_ticket_trylock(&tk));
+    EXPECT_FALSE(sirius_ticket_trylock(&tk));
+    sirius_ticket_unlock(&tk);
+}
+
+TEST(SiriusLock, TicketFifo)
+{
+    sirius_ticket_t tk = SIRIUS_TICKET_INITIALIZER;
+    i_order_t order;
+
+    sirius_ticket_lock(&tk);
+    std::vector<std::thread> thds;
+    for (int t = 0; t < i_thd_nr; t++) {
+        unsigned int next = __atomic_load_n(&(tk.next), __ATOMIC_RELAXED);
+        thds.emplace_back([&, t]() {
+            sirius_ticket_lock(&tk);
+            order.add(t);
+            sirius_ticket_unlock(&tk);
+        });
+        /* the tickets are taken one thread at a time */
+        ASSERT_TRUE(i_until([&]() {
+            return __atomic_load_n(&(tk.next), __ATOMIC_RELAXED) != next;
+        }));
+    }
+    sirius_ticket_unlock(&tk);
+    for (auto &t : thds) t.join();
+
+    std::vector<int> want;
+    for (int t = 0; t < i_thd_nr; t++) want.push_back(t);
+    EXPECT_EQ(want, order.v);
+}
+
+TEST(SiriusLock, Rwlock)
+{
+    sirius_rwlock_t rw = SIRIUS_RWLOCK_INITIALIZER;
+    const int loop = 5000;
+    /* the writers keep `a == b`, readers must never see otherwise */
+    long a = 0, b = 0;
+    std::atomic<int> rd_in{0}, wr_in{0};
+    std::atomic<bool> bad{false};
+
+    std::vector<std::thread> thds;
+    for (int t = 0; t < i_thd_nr; t++) {
+        thds.emplace_back([&, t]() {
+            for (int i = 0; i < loop; i++) {
+                if (0 == t % 2) {
+                    sirius_rwlock_wrlock(&rw);
+                    if (1 != ++wr_in || rd_in) bad = true;
+                    a++;
+                    b++;
+                    --wr_in;
+                    sirius_rwlock_wrunlock(&rw);
+                } else {
+                    sirius_rwlock_rdlock(&rw);
+                    ++rd_in;
+                    if (wr_in || a != b) bad = true;
+                    --rd_in;
+                    sirius_rwlock_rdunlock(&rw);
+                }
+            }
+        });
+    }
+    for (auto &t : thds) t.join();
+
+    EXPECT_FALSE(bad);
+    EXPECT_EQ((long)(i_thd_nr / 2) * loop, a);
+    EXPECT_EQ(0u, rw.state);
+    EXPECT_EQ(0u, rw.writers);
+}
+
+TEST(SiriusLock, RwlockWriterFirst)
+{
+    sirius_rwlock_t rw = SIRIUS_RWLOCK_INITIALIZER;
+    i_order_t order;
+
+    sirius_rwlock_rdlock(&rw);
+
+    /* two writers queue behind the reader */
+    std::vector<std::thread> thds;
+    for (int t = 0; t < 2; t++) {
+        thds.emplace_back([&, t]() {
+            sirius_rwlock_wrlock(&rw);
+            order.add(t);
+            sirius_rwlock_wrunlock(&rw);
+        });
+    }
+    ASSERT_TRUE(i_until([&]() {
+        return 2 == __atomic_load_n(&(rw.writers), __ATOMIC_SEQ_CST) &&
+            (__atomic_load_n(&(rw.state), __ATOMIC_SEQ_CST) &
+                SIRIUS_RWLOCK_WAIT);
+    }));
+
+    /* a reader arriving now waits for both of them */
+    thds.emplace_back([&]() {
+        sirius_rwlock_rdlock(&rw);
+        order.add(2);
+        sirius_rwlock_rdunlock(&rw);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    {
+        std::lock_guard<std::mutex> g(order.mtx);
+        EXPECT_TRUE(order.v.empty());
+    }
+
+    sirius_rwlock_rdunlock(&rw);
+    for (auto &t : thds) t.join();
+
+    ASSERT_EQ(3u, order.v.size());
+    EXPECT_EQ(2, order.v[2]);
+    EXPECT_EQ(0u, rw.state);
+}
+
+TEST(SiriusLock, RwlockWriterProgress)
+{
+    sirius_rwlock_t rw = SIRIUS_RWLOCK_INITIALIZER;
+    const int wr_loop = 100;
+    std::atomic<bool> stop{false};
+    std::atomic<long> rd_nr{0};
+    std::atomic<int> wr_done{0};
+
+    /* overlapping readers, the lock is never free on its own */
+    std::vector<std::thread> readers;
+    for (int t = 0; t < i_thd_nr; t++) {
+        readers.emplace_back([&]() {
+            while (!(stop.load())) {
+                sirius_rwlock_rdlock(&rw);
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                sirius_rwlock_rdunlock(&rw);
+                rd_nr++;
+            }
+        });
+    }
+
+    ASSERT_TRUE(i_until([&]() { return rd_nr.load() >= 20; }));
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; t++) {
+        writers.emplace_back([&]() {
+            for (int i = 0; i < wr_loop; i++) {
+                sirius_rwlock_wrlock(&rw);
+                sirius_rwlock_wrunlock(&rw);
+            }
+            wr_done++;
+        });
+    }
+
+    bool done = i_until([&]() { return 2 == wr_done.load(); });
+    stop = true;
+    for (auto &t : readers) t.join();
+    for (auto &t : writers) t.join();
+
+    EXPECT_TRUE(done);
+    EXPECT_GT(rd_nr.load(), 0);
+    EXPECT_EQ(0u, rw.state);
+}
+
+TEST(SiriusLock, Seqlock)
+{
+    sirius_seqlock_t sl = SIRIUS_SEQLOCK_INITIALIZER;
+    const int loop = 20000;
+    /* the writers keep `b == 3 * a` */
+    std::atomic<long> a{0}, b{0};
+    std::atomic<bool> stop{false}, bad{false};
+    std::atomic<long> rd_nr{0};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; t++) {
+        readers.emplace_back([&]() {
+            while (!(stop.load())) {
+                long x, y;
+                unsigned int seq;
+                do {
+                    seq = sirius_seqlock_read_begin(&sl);
+                    x = a.load(std::memory_order_relaxed);
+                    y = b.load(std::memory_order_relaxed);
+                } while (sirius_seqlock_read_retry(&sl, seq));
+                if (y != 3 * x) bad = true;
+                rd_nr++;
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; t++) {
+        writers.emplace_back([&]() {
+            for (int i = 0; i < loop; i++) {
+                sirius_seqlock_wrlock(&sl);
+                long x = a.load(std::memory_order_relaxed) + 1;
+                a.store(x, std::memory_order_relaxed);
+                b.store(3 * x, std::memory_order_relaxed);
+                sirius_seqlock_wrunlock(&sl);
+            }
+        });
+    }
+    for (auto &t : writers) t.join();
+    stop = true;
+    for (auto &t : readers) t.join();
+
+    EXPECT_FALSE(bad);
+    EXPECT_GT(rd_nr.load(), 0);
+    /* the writers are serialized by the sequence */
+    EXPECT_EQ(2L * loop, a.load());
+    EXPECT_EQ(0u, sl.seq & 1);
+}
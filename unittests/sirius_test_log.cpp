@@ -0,0 +1,869 @@
+/**
+ * @name sirius_test_log.cpp
+ *
+ * @author 胡益华
+ *
+ * @date 2026-10-19
+ *
+ * @brief the log sinks, the control pipe and the flight recorder
+ *
+ * @details
+ * every test initializes the library with the sinks it needs and
+ * deinitializes it before returning; the files are named after the
+ * test and the pid.
+ */
+
+/* the `basename` of libgen.h takes a `char *`, not `__FILE__` in C++ */
+#define SIRIUS_FILE     (__FILE__)
+
+#include "sirius_common.h"
+#include "sirius_log.h"
+#include "sirius_config.h"
+#include "sirius_metrics.h"
+#include "sirius_errno.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::string
+i_read(const std::string &path)
+{
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+size_t
+i_count(const std::string &s, const std::string &sub)
+{
+    size_t n = 0;
+    for (size_t pos = s.find(sub); pos != std::string::npos;
+        pos = s.find(sub, pos + sub.size())) {
+        n++;
+    }
+    return n;
+}
+
+std::string
+i_path(const char *p_tag)
+{
+    return std::string("/tmp/sirius_test_log_") + p_tag + "_" +
+        std::to_string(getpid()) + ".log";
+}
+
+bool
+i_exists(const std::string &path)
+{
+    struct stat st;
+    return 0 == stat(path.c_str(), &st);
+}
+
+/* unlink `path` and its rotated files */
+void
+i_unlink(const std::string &path, unsigned int retention)
+{
+    (void)unlink(path.c_str());
+    for (unsigned int i = 1; i <= retention + 1; i++) {
+        (void)unlink((path + "." + std::to_string(i)).c_str());
+    }
+}
+
+/* poll `pred` every 10 ms, at most `ms` */
+bool
+i_wait(const std::function<bool()> &pred, int ms)
+{
+    for (int i = 0; i < ms / 10; i++) {
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+}
+
+/* the "seq N" records of `s`, in file order */
+std::vector<int>
+i_seqs(const std::string &s)
+{
+    std::vector<int> v;
+    for (size_t pos = s.find("seq "); pos != std::string::npos;
+        pos = s.find("seq ", pos + 4)) {
+        v.push_back(std::stoi(s.substr(pos + 4)));
+    }
+    return v;
+}
+
+/* the Prometheus text of the registry */
+std::string
+i_export()
+{
+    char *p_buf = nullptr;
+    size_t size = 0;
+    FILE *p_f = open_memstream(&p_buf, &size);
+    EXPECT_EQ(SIRIUS_OK, sirius_metrics_write(p_f));
+    fclose(p_f);
+    std::string s(p_buf, size);
+    free(p_buf);
+    return s;
+}
+
+int
+i_threshold()
+{
+    return __atomic_load_n(&sirius_log_lv_threshold, __ATOMIC_RELAXED);
+}
+
+void
+i_init_file(sirius_init_t *p_in, std::string &path)
+{
+    p_in->log_lv = SIRIUS_LOG_LV_INFO;
+    p_in->log_sink = SIRIUS_LOG_SINK_FILE;
+    p_in->log_file.p_path = &path[0];
+}
+
+} // namespace
+
+/* sirius_test_log_c.c */
+extern "C" {
+int i_test_c_shm_drain(const char *p_name, unsigned long long *p_rd,
+    unsigned long long *p_read, unsigned long long *p_lost,
+    unsigned long long *p_trunc);
+}
+
+TEST(SiriusLog, FileRotateSize)
+{
+    std::string path = i_path("rotate");
+    const unsigned int retention = 2;
+    i_unlink(path, retention);
+
+    sirius_init_t in = {};
+    i_init_file(&in, path);
+    in.log_file.buf_size = 1024;
+    in.log_file.flush_ms = 10;
+    in.log_file.rotate_size = 4096;
+    in.log_file.retention = retention;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    /* about 100 bytes a record, a rotation every 40 */
+    for (int i = 0; i < 400; i++) {
+        SIRIUS_INFO("seq %d\n", i);
+        if (0 == i % 40) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+    sirius_deinit();
+
+    /* `retention` files are kept, the oldest records are gone */
+    ASSERT_TRUE(i_exists(path));
+    ASSERT_TRUE(i_exists(path + ".1"));
+    ASSERT_TRUE(i_exists(path + ".2"));
+    EXPECT_FALSE(i_exists(path + ".3"));
+
+    std::vector<int> seqs;
+    for (const std::string &p : {path + ".2", path + ".1", path}) {
+        std::vector<int> v = i_seqs(i_read(p));
+        EXPECT_FALSE(v.empty()) << p;
+        seqs.insert(seqs.end(), v.begin(), v.end());
+    }
+    ASSERT_FALSE(seqs.empty());
+    EXPECT_GT(seqs.front(), 0);
+    EXPECT_EQ(399, seqs.back());
+    /* the chain holds a contiguous tail, oldest file first */
+    for (size_t i = 1; i < seqs.size(); i++) {
+        ASSERT_EQ(seqs[i - 1] + 1, seqs[i]) << i;
+    }
+
+    i_unlink(path, retention);
+}
+
+TEST(SiriusLog, FileRotateNoRetention)
+{
+    std::string path = i_path("noretention");
+    i_unlink(path, 0);
+
+    sirius_init_t in = {};
+    i_init_file(&in, path);
+    in.log_file.flush_ms = 10;
+    in.log_file.rotate_size = 2048;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    for (int i = 0; i < 200; i++) {
+        SIRIUS_INFO("seq %d\n", i);
+        if (0 == i % 20) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+    sirius_deinit();
+
+    /* the rotated file is removed */
+    EXPECT_TRUE(i_exists(path));
+    EXPECT_FALSE(i_exists(path + ".1"));
+    std::vector<int> v = i_seqs(i_read(path));
+    ASSERT_FALSE(v.empty());
+    EXPECT_GT(v.front(), 0);
+    EXPECT_EQ(199, v.back());
+
+    i_unlink(path, 0);
+}
+
+TEST(SiriusLog, FileRotateTime)
+{
+    std::string path = i_path("rotatetime");
+    i_unlink(path, 1);
+
+    sirius_init_t in = {};
+    i_init_file(&in, path);
+    in.log_file.flush_ms = 10;
+    in.log_file.rotate_sec = 1;
+    in.log_file.retention = 1;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    SIRIUS_INFO("seq 0\n");
+    /* the boundary is the next whole second */
+    EXPECT_TRUE(i_wait([&]() {
+        return i_count(i_read(path + ".1"), "seq 0") > 0;
+    }, 3000));
+    SIRIUS_INFO("seq 1\n");
+    sirius_deinit();
+
+    EXPECT_EQ(1u, i_count(i_read(path + ".1"), "seq 0"));
+    EXPECT_EQ(1u, i_count(i_read(path), "seq 1"));
+
+    i_unlink(path, 1);
+}
+
+TEST(SiriusLog, FileReopenRetry)
+{
+    std::string dir = std::string("/tmp/sirius_test_log_reopen_") +
+        std::to_string(getpid());
+    std::string path = dir + "/sirius.log";
+    (void)unlink(path.c_str());
+    (void)rmdir(dir.c_str());
+    ASSERT_EQ(0, mkdir(dir.c_str(), 0755));
+
+    sirius_init_t in = {};
+    i_init_file(&in, path);
+    in.log_file.flush_ms = 10;
+    in.log_file.sighup_reopen = true;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    SIRIUS_INFO("before the reopen\n");
+    EXPECT_TRUE(i_wait([&]() {
+        return i_count(i_read(path), "before the reopen") > 0;
+    }, 1000));
+
+    /* the reopen fails, the records keep going to the old file */
+    ASSERT_EQ(0, unlink(path.c_str()));
+    ASSERT_EQ(0, rmdir(dir.c_str()));
+    ASSERT_EQ(0, raise(SIGHUP));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    SIRIUS_INFO("while the directory is gone\n");
+
+    /* the open is retried about every second */
+    ASSERT_EQ(0, mkdir(dir.c_str(), 0755));
+    EXPECT_TRUE(i_wait([&]() { return i_exists(path); }, 3000));
+    SIRIUS_INFO("after the reopen\n");
+    sirius_deinit();
+
+    std::string s = i_read(path);
+    EXPECT_EQ(1u, i_count(s, "after the reopen"));
+    EXPECT_EQ(0u, i_count(s, "before the reopen"));
+    EXPECT_EQ(0u, i_count(s, "while the directory is gone"));
+
+    (void)unlink(path.c_str());
+    (void)rmdir(dir.c_str());
+}
+
+TEST(SiriusLog, RatelimitBurst)
+{
+    sirius_log_rl_t rl = {};
+
+    /* a burst of 4, then one record every 250 ms */
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(0, sirius_log_ratelimit(&rl, 1000, 4)) << i;
+    }
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(-1, sirius_log_ratelimit(&rl, 1000, 4)) << i;
+    }
+    EXPECT_EQ(3u, rl.missed);
+
+    /* the next allowed record reports the suppressed ones */
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_EQ(3, sirius_log_ratelimit(&rl, 1000, 4));
+    EXPECT_EQ(0u, rl.missed);
+    EXPECT_EQ(-1, sirius_log_ratelimit(&rl, 1000, 4));
+
+    /* a full interval refills the whole burst */
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_EQ(1, sirius_log_ratelimit(&rl, 1000, 4));
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(0, sirius_log_ratelimit(&rl, 1000, 4)) << i;
+    }
+    EXPECT_EQ(-1, sirius_log_ratelimit(&rl, 1000, 4));
+
+    /* no limit */
+    sirius_log_rl_t off = {};
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(0, sirius_log_ratelimit(&off, 0, 4));
+        EXPECT_EQ(0, sirius_log_ratelimit(&off, 1000, 0));
+    }
+}
+
+TEST(SiriusLog, RatelimitConcurrent)
+{
+    sirius_log_rl_t rl = {};
+    std::atomic<int> allowed{0};
+    std::atomic<int> missed{0};
+
+    /* the threads finish well within one step of 1 s */
+    std::vector<std::thread> ths;
+    for (int t = 0; t < 4; t++) {
+        ths.emplace_back([&]() {
+            for (int i = 0; i < 1000; i++) {
+                int ret = sirius_log_ratelimit(&rl, 10000, 10);
+                if (ret >= 0) {
+                    allowed++;
+                    missed += ret;
+                }
+            }
+        });
+    }
+    for (auto &th : ths) th.join();
+
+    EXPECT_EQ(10, allowed.load());
+    EXPECT_EQ(0, missed.load());
+    EXPECT_EQ(4000u - 10, rl.missed);
+}
+
+TEST(SiriusLog, RatelimitMacro)
+{
+    std::string path = i_path("ratelimit");
+    i_unlink(path, 0);
+
+    sirius_init_t in = {};
+    i_init_file(&in, path);
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    for (int i = 0; i < 10; i++) {
+        SIRIUS_INFO_RATELIMIT(60000, 3, "storm %d\n", i);
+    }
+    std::string metrics = i_export();
+    sirius_deinit();
+
+    std::string s = i_read(path);
+    EXPECT_EQ(3u, i_count(s, "storm "));
+    EXPECT_EQ(1u, i_count(s, "storm 2\n"));
+    EXPECT_EQ(0u, i_count(s, "storm 3\n"));
+    EXPECT_EQ(1u, i_count(metrics,
+        "sirius_log_dropped_total{reason=\"ratelimit\"} 7\n"));
+
+    i_unlink(path, 0);
+}
+
+TEST(SiriusLog, DupSuppress)
+{
+    std::string path = i_path("dup");
+    i_unlink(path, 0);
+
+    sirius_init_t in = {};
+    i_init_file(&in, path);
+    in.log_dup_suppress = true;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    for (int i = 0; i < 10; i++) {
+        SIRIUS_INFO("same record\n");
+    }
+    SIRIUS_INFO("another record\n");
+    /* a repetition pending at deinit is summarized too */
+    for (int i = 0; i < 3; i++) {
+        SIRIUS_WARN("tail record\n");
+    }
+    std::string metrics = i_export();
+    sirius_deinit();
+
+    std::string s = i_read(path);
+    /**
+     * a summary is also printed when a second boundary passes,
+     * so the printed and the repeated records add up to 10
+     */
+    size_t printed = i_count(s, "] same record\n");
+    size_t repeated = 0;
+    for (size_t pos = s.find("repeated "); pos != std::string::npos;
+        pos = s.find("repeated ", pos + 9)) {
+        repeated += std::stoul(s.substr(pos + 9));
+    }
+    EXPECT_LE(1u, printed);
+    EXPECT_EQ(10u + 3, printed + repeated + i_count(s, "] tail record\n"));
+
+    /* the summary comes before the next different record */
+    size_t summary = s.find("last message repeated");
+    ASSERT_NE(std::string::npos, summary);
+    EXPECT_LT(summary, s.find("] another record\n"));
+    EXPECT_NE(std::string::npos, s.find("last message repeated",
+        s.find("] tail record\n")));
+
+    EXPECT_EQ(1u, i_count(metrics,
+        "sirius_log_dropped_total{reason=\"duplicate\"} "));
+
+    i_unlink(path, 0);
+}
+
+TEST(SiriusLog, PipeCommands)
+{
+    std::string path = i_path("pipe");
+    std::string dump = i_path("pipedump");
+    std::string pipe = std::string("/tmp/sirius_test_log_fifo_") +
+        std::to_string(getpid());
+    i_unlink(path, 0);
+    (void)unlink(dump.c_str());
+
+    sirius_init_t in = {};
+    i_init_file(&in, path);
+    in.p_pipe = &pipe[0];
+    /* nothing is written out but by `logflush` and at deinit */
+    in.log_file.flush_ms = 60000;
+    in.log_recorder.size = 64 * 1024;
+    in.log_recorder.log_lv = SIRIUS_LOG_LV_DEBG;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    int fd = open(pipe.c_str(), O_WRONLY | O_NONBLOCK);
+    ASSERT_NE(-1, fd);
+    auto i_cmd = [fd](const std::string &cmd) {
+        std::string line = cmd + "\n";
+        ASSERT_EQ((ssize_t)line.size(),
+            write(fd, line.data(), line.size()));
+    };
+
+    i_cmd("loglevel 5");
+    EXPECT_TRUE(i_wait([]() {
+        return SIRIUS_LOG_LV_DEBG == sirius_log_lv_get(nullptr);
+    }, 1000));
+
+    i_cmd("loglevel pipe-mod 2");
+    EXPECT_TRUE(i_wait([]() {
+        return SIRIUS_LOG_LV_ERROR == sirius_log_lv_get("pipe-mod");
+    }, 1000));
+    EXPECT_EQ(SIRIUS_LOG_LV_DEBG, sirius_log_lv_get(nullptr));
+
+    /* an unknown command is reported, the next one still works */
+    i_cmd("no-such-command");
+    i_cmd("config log.lv 3");
+    EXPECT_TRUE(i_wait([]() {
+        return SIRIUS_LOG_LV_WARN == sirius_log_lv_get(nullptr);
+    }, 1000));
+
+    SIRIUS_WARN("flushed by the pipe\n");
+    EXPECT_EQ(0u, i_count(i_read(path), "flushed by the pipe"));
+    i_cmd("logflush");
+    EXPECT_TRUE(i_wait([&]() {
+        return i_count(i_read(path), "flushed by the pipe") > 0;
+    }, 1000));
+
+    /* the recorder keeps the filtered levels */
+    SIRIUS_DEBG("recorded only\n");
+    i_cmd("logdump " + dump);
+    EXPECT_TRUE(i_wait([&]() {
+        return i_count(i_read(dump), "recorded only") > 0;
+    }, 1000));
+
+    i_cmd("logsink stdout");
+    EXPECT_TRUE(i_wait([]() {
+        return SIRIUS_LOG_SINK_STDOUT ==
+            sirius_cfg_get(sirius_cfg_find("log.sink"));
+    }, 1000));
+    SIRIUS_WARN("to stdout\n");
+    i_cmd("logsink file");
+    EXPECT_TRUE(i_wait([]() {
+        return SIRIUS_LOG_SINK_FILE ==
+            sirius_cfg_get(sirius_cfg_find("log.sink"));
+    }, 1000));
+    SIRIUS_WARN("to the file\n");
+    close(fd);
+
+    /* no polling or shell on the way out */
+    auto t0 = std::chrono::steady_clock::now();
+    sirius_deinit();
+    EXPECT_LT(std::chrono::steady_clock::now() - t0,
+        std::chrono::milliseconds(200));
+    EXPECT_FALSE(i_exists(pipe));
+
+    std::string s = i_read(path);
+    EXPECT_EQ(0u, i_count(s, "to stdout"));
+    EXPECT_EQ(1u, i_count(s, "to the file"));
+
+    i_unlink(path, 0);
+    (void)unlink(dump.c_str());
+}
+
+TEST(SiriusLog, RecorderOrder)
+{
+    std::string dump = i_path("recorder");
+    (void)unlink(dump.c_str());
+
+    sirius_init_t in = {};
+    /* the sinks print nothing, the recorder keeps everything */
+    in.log_lv = SIRIUS_LOG_LV_0;
+    in.log_recorder.size = 2 * 1024 * 1024;
+    in.log_recorder.slice_nr = 4;
+    in.log_recorder.log_lv = SIRIUS_LOG_LV_DEBG;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    /* the threads take turns, so the records have a global order */
+    std::mutex mtx;
+    int next = 0;
+    std::vector<std::thread> ths;
+    for (int t = 0; t < 4; t++) {
+        ths.emplace_back([&]() {
+            for (int i = 0; i < 200; i++) {
+                std::lock_guard<std::mutex> lk(mtx);
+                SIRIUS_DEBG("seq %d\n", next++);
+            }
+        });
+    }
+    for (auto &th : ths) th.join();
+
+    ASSERT_EQ(SIRIUS_OK, sirius_log_rec_dump(dump.c_str()));
+    sirius_deinit();
+
+    /* the slices are merged back into the logging order */
+    std::vector<int> seqs = i_seqs(i_read(dump));
+    ASSERT_EQ(800u, seqs.size());
+    for (int i = 0; i < 800; i++) {
+        ASSERT_EQ(i, seqs[i]);
+    }
+
+    (void)unlink(dump.c_str());
+}
+
+TEST(SiriusLog, RecorderWrap)
+{
+    std::string dump = i_path("recorderwrap");
+    std::string ring = i_path("recorderring");
+    (void)unlink(dump.c_str());
+    i_unlink(ring, 1);
+
+    sirius_init_t in = {};
+    in.log_lv = SIRIUS_LOG_LV_0;
+    in.log_recorder.size = 64 * 256;
+    in.log_recorder.slice_nr = 1;
+    in.log_recorder.slot_size = 256;
+    in.log_recorder.log_lv = SIRIUS_LOG_LV_INFO;
+    in.log_recorder.p_path = &ring[0];
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    for (int i = 0; i < 1000; i++) {
+        SIRIUS_INFO("seq %d\n", i);
+    }
+    /* a filtered level is not recorded either */
+    SIRIUS_DEBG("seq -1\n");
+    ASSERT_EQ(SIRIUS_OK, sirius_log_rec_dump(dump.c_str()));
+    sirius_deinit();
+
+    /* the newest records, oldest first */
+    std::vector<int> seqs = i_seqs(i_read(dump));
+    ASSERT_EQ(64u, seqs.size());
+    for (size_t i = 0; i < seqs.size(); i++) {
+        ASSERT_EQ(1000 - 64 + (int)i, seqs[i]);
+    }
+
+    /* the ring of the previous run is kept aside */
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+    sirius_deinit();
+    EXPECT_TRUE(i_exists(ring + ".1"));
+
+    (void)unlink(dump.c_str());
+    i_unlink(ring, 1);
+}
+
+TEST(SiriusLog, RecorderSharedSlice)
+{
+    std::string dump = i_path("recordershared");
+    (void)unlink(dump.c_str());
+
+    sirius_init_t in = {};
+    in.log_lv = SIRIUS_LOG_LV_0;
+    in.log_recorder.size = 64 * 1024;
+    in.log_recorder.slice_nr = 1;
+    in.log_recorder.log_lv = SIRIUS_LOG_LV_INFO;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    /* the threads share the slice, a record is never torn */
+    const std::string pad(200, 'x');
+    std::vector<std::thread> ths;
+    for (int t = 0; t < 4; t++) {
+        ths.emplace_back([&, t]() {
+            std::string body = std::string(1, (char)('a' + t)) + pad;
+            for (int i = 0; i < 5000; i++) {
+                SIRIUS_INFO("rec %d %s %d\n", t, body.c_str(), t);
+            }
+        });
+    }
+    for (auto &th : ths) th.join();
+
+    ASSERT_EQ(SIRIUS_OK, sirius_log_rec_dump(dump.c_str()));
+    sirius_deinit();
+
+    std::istringstream lines(i_read(dump));
+    size_t nr = 0;
+    for (std::string l; std::getline(lines, l); ) {
+        size_t pos = l.find("] rec ");
+        if (std::string::npos == pos) continue;
+        int t = l[pos + 6] - '0';
+        ASSERT_TRUE(t >= 0 && t < 4) << l;
+        std::string want = std::to_string(t) + " " +
+            std::string(1, (char)('a' + t)) + pad + " " +
+            std::to_string(t);
+        ASSERT_EQ(want, l.substr(pos + 6)) << l;
+        nr++;
+    }
+    EXPECT_LT(0u, nr);
+
+    (void)unlink(dump.c_str());
+}
+
+TEST(SiriusLog, ShmLoss)
+{
+    std::string name = std::string("/sirius_test_log_shm_") +
+        std::to_string(getpid());
+
+    sirius_init_t in = {};
+    in.log_lv = SIRIUS_LOG_LV_INFO;
+    in.log_shm.enable = true;
+    in.log_shm.p_name = &name[0];
+    in.log_shm.size = 64 * 256;
+    in.log_shm.slot_size = 256;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    for (int i = 0; i < 1000; i++) {
+        SIRIUS_INFO("seq %d\n", i);
+    }
+
+    /* a reader at 0 lost everything but the ring */
+    unsigned long long rd = 0, read = 0, lost = 0, trunc = 0;
+    ASSERT_EQ(0, i_test_c_shm_drain(name.c_str(), &rd,
+        &read, &lost, &trunc));
+    EXPECT_EQ(64u, read);
+    EXPECT_LE(1000u, rd);
+    EXPECT_EQ(rd, read + lost);
+    EXPECT_EQ(0u, trunc);
+
+    /* a record longer than a slot is cut and counted */
+    SIRIUS_INFO("%s\n", std::string(300, 'x').c_str());
+    ASSERT_EQ(0, i_test_c_shm_drain(name.c_str(), &rd,
+        &read, &lost, &trunc));
+    EXPECT_EQ(1u, read);
+    EXPECT_EQ(0u, lost);
+    EXPECT_EQ(1u, trunc);
+
+    sirius_deinit();
+}
+
+TEST(SiriusLog, ShmConcurrent)
+{
+    std::string name = std::string("/sirius_test_log_shmcc_") +
+        std::to_string(getpid());
+
+    sirius_init_t in = {};
+    in.log_lv = SIRIUS_LOG_LV_INFO;
+    in.log_shm.enable = true;
+    in.log_shm.p_name = &name[0];
+    in.log_shm.size = 256 * 256;
+    in.log_shm.slot_size = 256;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    /* the reader starts at the current head */
+    unsigned long long rd = 0, read = 0, lost = 0, trunc = 0;
+    ASSERT_EQ(0, i_test_c_shm_drain(name.c_str(), &rd,
+        &read, &lost, &trunc));
+    unsigned long long start = rd;
+
+    std::atomic<bool> done{false};
+    unsigned long long read_total = 0, lost_total = 0;
+    std::thread reader([&]() {
+        while (true) {
+            bool last = done.load();
+            ASSERT_EQ(0, i_test_c_shm_drain(name.c_str(), &rd,
+                &read, &lost, &trunc));
+            read_total += read;
+            lost_total += lost;
+            if (last) break;
+        }
+    });
+
+    std::vector<std::thread> ths;
+    for (int t = 0; t < 4; t++) {
+        ths.emplace_back([t]() {
+            for (int i = 0; i < 5000; i++) {
+                SIRIUS_INFO("writer %d seq %d\n", t, i);
+            }
+        });
+    }
+    for (auto &th : ths) th.join();
+    done = true;
+    reader.join();
+
+    /* every record is either read or counted as lost */
+    EXPECT_LT(0u, read_total);
+    EXPECT_EQ(4u * 5000, read_total + lost_total);
+    EXPECT_EQ(start + 4u * 5000, rd);
+
+    sirius_deinit();
+}
+
+TEST(SiriusLog, BytesLarge)
+{
+    std::string path = i_path("bytes");
+    i_unlink(path, 0);
+
+    sirius_init_t in = {};
+    i_init_file(&in, path);
+    in.log_file.buf_size = 4096;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    /* binary, larger than every buffer, no trailing newline */
+    std::string frame(100 * 1024, '\0');
+    for (size_t i = 0; i < frame.size(); i++) {
+        frame[i] = (char)(i * 7 + 1);
+    }
+    frame[10] = '\0';
+    frame.back() = 'z';
+    SIRIUS_INFO_BYTES(frame.data(), frame.size());
+    int ret = sirius_log_bytes(SIRIUS_LOG_LV_INFO, LOG_NONE, "bytes-mod",
+        "file", "func", 1, "tail", 4);
+    EXPECT_LT(4, ret);
+
+    /* formatted past the stack buffer, not truncated */
+    std::string text(50 * 1024, 'y');
+    SIRIUS_INFO("long %s end\n", text.c_str());
+    sirius_deinit();
+
+    std::string s = i_read(path);
+    size_t pos = s.find(frame);
+    ASSERT_NE(std::string::npos, pos);
+    EXPECT_EQ("] ", s.substr(pos - 2, 2));
+    EXPECT_EQ('\n', s[pos + frame.size()]);
+    EXPECT_EQ(1u, i_count(s, "bytes-mod"));
+    EXPECT_EQ(1u, i_count(s, "] tail\n"));
+    EXPECT_EQ(1u, i_count(s, "long " + text + " end\n"));
+
+    i_unlink(path, 0);
+}
+
+TEST(SiriusLog, BytesConcurrent)
+{
+    std::string path = i_path("bytescc");
+    i_unlink(path, 0);
+
+    sirius_init_t in = {};
+    i_init_file(&in, path);
+    in.log_file.buf_size = 4096;
+    in.log_file.flush_ms = 10;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+
+    /**
+     * the large records bypass the buffer, they are written
+     * between the buffered ones without breaking either
+     */
+    std::vector<std::thread> ths;
+    for (int t = 0; t < 4; t++) {
+        ths.emplace_back([t]() {
+            std::string big(16 * 1024, (char)('a' + t));
+            for (int i = 0; i < 200; i++) {
+                SIRIUS_INFO("writer %d seq %d\n", t, i);
+                if (0 == i % 20) {
+                    SIRIUS_INFO_BYTES(big.data(), big.size());
+                }
+            }
+        });
+    }
+    for (auto &th : ths) th.join();
+    sirius_deinit();
+
+    std::istringstream lines(i_read(path));
+    int next[4] = {0};
+    int big_nr[4] = {0};
+    for (std::string l; std::getline(lines, l); ) {
+        size_t pos = l.find("] ");
+        ASSERT_NE(std::string::npos, pos) << l.substr(0, 64);
+        std::string body = l.substr(pos + 2);
+        if (body.size() == 16 * 1024) {
+            int t = body[0] - 'a';
+            ASSERT_TRUE(t >= 0 && t < 4);
+            ASSERT_EQ(std::string(body.size(), body[0]), body);
+            big_nr[t]++;
+        } else if (0 == body.compare(0, 7, "writer ")) {
+            int t = std::stoi(body.substr(7));
+            ASSERT_EQ(next[t], std::stoi(body.substr(body.find("seq ") + 4)));
+            next[t]++;
+        }
+    }
+    for (int t = 0; t < 4; t++) {
+        EXPECT_EQ(200, next[t]) << t;
+        EXPECT_EQ(10, big_nr[t]) << t;
+    }
+
+    i_unlink(path, 0);
+}
+
+TEST(SiriusLog, ModuleLevel)
+{
+    std::string path = i_path("module");
+    i_unlink(path, 0);
+
+    sirius_init_t in = {};
+    i_init_file(&in, path);
+    in.log_lv = SIRIUS_LOG_LV_WARN;
+    ASSERT_EQ(SIRIUS_OK, sirius_init(&in));
+    EXPECT_EQ(SIRIUS_LOG_LV_WARN, i_threshold());
+
+    /* one module is raised, the threshold follows the highest */
+    ASSERT_EQ(SIRIUS_OK, sirius_log_lv_set("loud-mod", SIRIUS_LOG_LV_DEBG));
+    EXPECT_EQ(SIRIUS_LOG_LV_DEBG, sirius_log_lv_get("loud-mod"));
+    EXPECT_EQ(SIRIUS_LOG_LV_WARN, sirius_log_lv_get("quiet-mod"));
+    EXPECT_EQ(SIRIUS_LOG_LV_DEBG, i_threshold());
+
+    EXPECT_LT(0, sirius_log_print(SIRIUS_LOG_LV_DEBG, LOG_NONE,
+        "loud-mod", "file", "func", 1, "loud debug\n"));
+    EXPECT_EQ(0, sirius_log_print(SIRIUS_LOG_LV_INFO, LOG_NONE,
+        "quiet-mod", "file", "func", 1, "quiet info\n"));
+
+    /* the call site keeps its key, a new level is still seen */
+    sirius_log_mod_t mod = SIRIUS_LOG_MOD_INIT("loud-mod");
+    EXPECT_LT(0, sirius_log_print_mod(SIRIUS_LOG_LV_INFO, LOG_NONE,
+        &mod, "file", "func", 1, "site %d\n", 1));
+    ASSERT_EQ(SIRIUS_OK, sirius_log_lv_set("loud-mod", SIRIUS_LOG_LV_ERROR));
+    EXPECT_EQ(0, sirius_log_print_mod(SIRIUS_LOG_LV_INFO, LOG_NONE,
+        &mod, "file", "func", 1, "site %d\n", 2));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_log_print_mod(
+        SIRIUS_LOG_LV_INFO, LOG_NONE, nullptr, "file", "func", 1, "x\n"));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_log_bytes_mod(
+        SIRIUS_LOG_LV_INFO, LOG_NONE, nullptr, "file", "func", 1, "x", 1));
+
+    /* the arguments of a disabled level are not evaluated */
+    int calls = 0;
+    SIRIUS_DEBG("not evaluated %d\n", ++calls);
+    EXPECT_EQ(0, calls);
+    sirius_deinit();
+
+    std::string s = i_read(path);
+    EXPECT_EQ(1u, i_count(s, "loud debug"));
+    EXPECT_EQ(0u, i_count(s, "quiet info"));
+    EXPECT_EQ(1u, i_count(s, "site 1"));
+    EXPECT_EQ(0u, i_count(s, "site 2"));
+
+    i_unlink(path, 0);
+}
@@ -0,0 +1,68 @@
+/**
+ * @name sirius_test_log_c.c
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief a reader of the shared-memory log ring, with the read step
+ *  of `sirius_logtail`, called from sirius_test_log.cpp
+ */
+
+#include "internal/sirius_internal_log_shm.h"
+
+#include <sched.h>
+
+/**
+ * @brief read the ring of `p_name` from `*p_rd` until it is empty
+ * 
+ * @param[in,out] p_rd: position of the reader
+ * @param[out] p_read: number of records read
+ * @param[out] p_lost: number of records lost
+ * @param[out] p_trunc: number of records truncated by the writers
+ * 
+ * @return 0 on success, -1 if the ring cannot be mapped
+ */
+int
+i_test_c_shm_drain(const char *p_name, unsigned long long *p_rd,
+    unsigned long long *p_read, unsigned long long *p_lost,
+    unsigned long long *p_trunc)
+{
+    int fd = shm_open(p_name, O_RDWR, 0);
+    if (-1 == fd) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st)) {
+        close(fd);
+        return -1;
+    }
+    i_log_shm_hdr_t *p_hdr = (i_log_shm_hdr_t *)mmap(NULL,
+        (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == (void *)p_hdr) return -1;
+
+    char *p_buf = (char *)malloc(p_hdr->slot_size);
+    if (!(p_buf)) {
+        munmap(p_hdr, (size_t)st.st_size);
+        return -1;
+    }
+
+    *p_read = 0;
+    *p_lost = 0;
+    while (true) {
+        long len = i_log_shm_read(p_hdr, p_rd, p_buf, p_lost);
+        if (len >= 0) {
+            (*p_read)++;
+        } else if (I_LOG_SHM_READ_EMPTY == len) {
+            break;
+        } else {
+            sched_yield();
+        }
+    }
+    *p_trunc = atomic_load_explicit(&(p_hdr->trunc_nr),
+        memory_order_relaxed);
+
+    free(p_buf);
+    munmap(p_hdr, (size_t)st.st_size);
+    return 0;
+}
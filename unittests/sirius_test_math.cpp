@@ -0,0 +1,554 @@
+/**
+ * @name sirius_test_math.cpp
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief correctness of the `sirius_math_*` array kernels
+ * 
+ * @details
+ * every kernel is checked against a plain loop over lengths that
+ * cover the vector heads, bodies and tails. the kernels run on the
+ * instruction set picked at load time; ctest runs this binary once
+ * per set with `SIRIUS_MATH_ISA_ENV`, so one machine covers them all.
+ */
+
+#include "sirius_math.h"
+#include "sirius_errno.h"
+#include "sirius_config.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+/* lengths around every vector width, and a few long ones */
+const size_t g_len[] = {
+    1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65,
+    127, 128, 129, 255, 256, 257, 1000, 4099, 65537,
+};
+
+template <typename T>
+std::vector<T>
+i_fill(size_t n, unsigned int seed)
+{
+    std::mt19937_64 r(seed);
+    std::vector<T> v(n);
+    for (size_t i = 0; i < n; i++) {
+        if (std::is_floating_point<T>::value) {
+            v[i] = (T)std::ldexp((double)(r() >> 11) / (1ULL << 53) - 0.5,
+                (int)(r() % 21) - 10);
+        } else {
+            v[i] = (T)r();
+        }
+    }
+    return v;
+}
+
+/* few distinct values, so that the ties are exercised */
+template <typename T>
+std::vector<T>
+i_fill_dup(size_t n, unsigned int seed)
+{
+    std::mt19937_64 r(seed);
+    std::vector<T> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = (T)(r() % 7);
+    return v;
+}
+
+template <typename T>
+struct i_api;
+
+#define I_TEST_API(name, T) \
+template <> \
+struct i_api<T> { \
+    static T max(const T *p, size_t n) { return sirius_math_max_##name(p, n); } \
+    static T min(const T *p, size_t n) { return sirius_math_min_##name(p, n); } \
+    static int minmax(const T *p, size_t n, T *p_mn, T *p_mx) { \
+        return sirius_math_minmax_##name(p, n, p_mn, p_mx); \
+    } \
+    static T max_par(const T *p, size_t n) { \
+        return sirius_math_max_##name##_par(p, n); \
+    } \
+    static T min_par(const T *p, size_t n) { \
+        return sirius_math_min_##name##_par(p, n); \
+    } \
+    static int minmax_par(const T *p, size_t n, T *p_mn, T *p_mx) { \
+        return sirius_math_minmax_##name##_par(p, n, p_mn, p_mx); \
+    } \
+    static int sort(T *p, size_t n) { return sirius_math_sort_##name(p, n); } \
+    static int topk(const T *p, size_t n, size_t k, sirius_math_topk_t o, \
+        T *p_val, size_t *p_idx) { \
+        return sirius_math_topk_##name(p, n, k, o, p_val, p_idx); \
+    } \
+};
+
+I_TEST_API(i8, int8_t)
+I_TEST_API(i16, int16_t)
+I_TEST_API(i32, int32_t)
+I_TEST_API(i64, int64_t)
+I_TEST_API(u8, uint8_t)
+I_TEST_API(u16, uint16_t)
+I_TEST_API(u32, uint32_t)
+I_TEST_API(u64, uint64_t)
+I_TEST_API(f32, float)
+I_TEST_API(f64, double)
+
+template <typename T>
+class SiriusMathTyped : public ::testing::Test {};
+
+typedef ::testing::Types<int8_t, int16_t, int32_t, int64_t,
+    uint8_t, uint16_t, uint32_t, uint64_t, float, double> i_types_t;
+TYPED_TEST_SUITE(SiriusMathTyped, i_types_t);
+
+} // namespace
+
+/* sirius_test_math_c.c */
+extern "C" {
+int i_test_c_max_int_mixed();
+int i_test_c_min_int_mixed();
+int i_test_c_max_int_many(int *p_calls);
+double i_test_c_min_dbl_many();
+long long i_test_c_max_generic();
+int i_test_c_min_small_unsigned();
+}
+
+TEST(SiriusMath, MaxMinMacro)
+{
+    /* each value is converted to int or double before the comparison */
+    static_assert(SIRIUS_MAX_INT(2, -1, 1u) == 1, "");
+    static_assert(SIRIUS_MIN_INT(2, 1u, -1) == -1, "");
+    static_assert(SIRIUS_MAX_INT(12, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+        12) == 12, "");
+    static_assert(SIRIUS_MIN_DBL(2, 1, 0.5f) == 0.5, "");
+    static_assert(SIRIUS_MAX(1, 2.5, 2) == 2.5, "");
+    EXPECT_EQ(1, i_test_c_max_int_mixed());
+    EXPECT_EQ(-1, i_test_c_min_int_mixed());
+
+    /* no limit on the number of values, each evaluated once */
+    int calls = 20;
+    EXPECT_EQ(21, i_test_c_max_int_many(&calls));
+    EXPECT_EQ(21, calls);
+    EXPECT_EQ(-0.5, i_test_c_min_dbl_many());
+    EXPECT_EQ('a', i_test_c_max_generic());
+
+    /*
+     * a signed and an unsigned operand of the same rank do not compile,
+     * the narrower unsigned types and the wider signed ones do
+     */
+    EXPECT_EQ(-3, i_test_c_min_small_unsigned());
+    static_assert(SIRIUS_MIN((short)-3, (unsigned char)200) == -3, "");
+    static_assert(SIRIUS_MAX(-1LL, 1u) == 1, "");
+    static_assert(SIRIUS_MIN(-5LL, 3LL, 2.5) == -5, "");
+}
+
+TEST(SiriusMath, Isa)
+{
+    const char *p_isa = sirius_math_isa();
+    ASSERT_NE(nullptr, p_isa);
+
+    /* a forced set the cpu supports must be the one dispatched */
+    const char *p_env = std::getenv(SIRIUS_MATH_ISA_ENV);
+    if (!(p_env) || 0 == std::strcmp(p_env, p_isa))
+        return;
+
+    static const char *names[] = {"scalar", "sse2", "avx2", "avx512"};
+    int forced = -1, got = -1;
+    for (int i = 0; i < 4; i++) {
+        if (0 == std::strcmp(names[i], p_env)) forced = i;
+        if (0 == std::strcmp(names[i], p_isa)) got = i;
+    }
+    /* only a set above the cpu is ignored */
+    EXPECT_LT(got, forced) << "forced " << p_env << ", got " << p_isa;
+}
+
+TYPED_TEST(SiriusMathTyped, MinMax)
+{
+    typedef TypeParam T;
+    typedef i_api<T> A;
+
+    for (size_t n : g_len) {
+        std::vector<T> v = i_fill<T>(n, (unsigned int)n);
+        /* the extreme at the head, in the body and at the tail */
+        for (size_t at : {(size_t)0, n / 2, n - 1}) {
+            std::vector<T> w = v;
+            w[at] = std::numeric_limits<T>::max();
+            EXPECT_EQ(*std::max_element(w.begin(), w.end()),
+                A::max(w.data(), n)) << "n " << n << " at " << at;
+            w[at] = std::numeric_limits<T>::lowest();
+            EXPECT_EQ(*std::min_element(w.begin(), w.end()),
+                A::min(w.data(), n)) << "n " << n << " at " << at;
+        }
+
+        T mn, mx;
+        ASSERT_EQ(SIRIUS_OK, A::minmax(v.data(), n, &mn, &mx));
+        EXPECT_EQ(*std::min_element(v.begin(), v.end()), mn) << "n " << n;
+        EXPECT_EQ(*std::max_element(v.begin(), v.end()), mx) << "n " << n;
+    }
+}
+
+TYPED_TEST(SiriusMathTyped, MinMaxEmpty)
+{
+    typedef TypeParam T;
+    typedef i_api<T> A;
+    T x = 0;
+
+    if (std::is_floating_point<T>::value) {
+        EXPECT_EQ(-std::numeric_limits<T>::infinity(), A::max(&x, 0));
+        EXPECT_EQ(std::numeric_limits<T>::infinity(), A::min(&x, 0));
+    } else {
+        EXPECT_EQ(std::numeric_limits<T>::lowest(), A::max(&x, 0));
+        EXPECT_EQ(std::numeric_limits<T>::max(), A::min(&x, 0));
+    }
+    T mn, mx;
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, A::minmax(nullptr, 1, &mn, &mx));
+}
+
+TYPED_TEST(SiriusMathTyped, MinMaxPar)
+{
+    typedef TypeParam T;
+    typedef i_api<T> A;
+
+    /* the first call registers the keys, then every array is split */
+    std::vector<T> v = i_fill<T>(3 * 1024 * 1024 / sizeof(T) + 13, 7);
+    size_t n = v.size();
+    EXPECT_EQ(*std::max_element(v.begin(), v.end()), A::max_par(v.data(), n));
+    ASSERT_EQ(SIRIUS_OK, sirius_cfg_set_name("math.par.min", 0));
+    ASSERT_EQ(SIRIUS_OK, sirius_cfg_set_name("math.par.threads", 4));
+
+    EXPECT_EQ(*std::max_element(v.begin(), v.end()), A::max_par(v.data(), n));
+    EXPECT_EQ(*std::min_element(v.begin(), v.end()), A::min_par(v.data(), n));
+    T mn, mx;
+    ASSERT_EQ(SIRIUS_OK, A::minmax_par(v.data(), n, &mn, &mx));
+    EXPECT_EQ(*std::min_element(v.begin(), v.end()), mn);
+    EXPECT_EQ(*std::max_element(v.begin(), v.end()), mx);
+}
+
+TYPED_TEST(SiriusMathTyped, Sort)
+{
+    typedef TypeParam T;
+    typedef i_api<T> A;
+
+    for (size_t n = 1; n <= SIRIUS_MATH_SORT_MAX; n++) {
+        for (unsigned int seed = 0; seed < 4; seed++) {
+            std::vector<T> v = seed & 1 ? i_fill_dup<T>(n, seed) :
+                i_fill<T>(n, seed);
+            std::vector<T> ref = v;
+            std::sort(ref.begin(), ref.end());
+            ASSERT_EQ(SIRIUS_OK, A::sort(v.data(), n));
+            EXPECT_EQ(ref, v) << "n " << n << " seed " << seed;
+        }
+    }
+
+    T buf[SIRIUS_MATH_SORT_MAX + 1] = {};
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER,
+        A::sort(buf, SIRIUS_MATH_SORT_MAX + 1));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, A::sort(nullptr, 1));
+}
+
+TYPED_TEST(SiriusMathTyped, TopK)
+{
+    typedef TypeParam T;
+    typedef i_api<T> A;
+
+    for (size_t n : g_len) {
+        for (int dup = 0; dup < 2; dup++) {
+            std::vector<T> v = dup ? i_fill_dup<T>(n, (unsigned int)n) :
+                i_fill<T>(n, (unsigned int)n);
+            for (size_t k : {(size_t)1, (size_t)10, n / 3, n}) {
+                if (0 == k || k > n) continue;
+                for (int o = 0; o < 2; o++) {
+                    sirius_math_topk_t order = (sirius_math_topk_t)o;
+                    /* a stable sort by value gives the expected order */
+                    std::vector<size_t> ref(n);
+                    std::iota(ref.begin(), ref.end(), 0);
+                    std::stable_sort(ref.begin(), ref.end(),
+                        [&](size_t a, size_t b) {
+                            return SIRIUS_MATH_TOPK_LARGEST == order ?
+                                v[a] > v[b] : v[a] < v[b];
+                        });
+
+                    std::vector<T> val(k);
+                    std::vector<size_t> idx(k);
+                    ASSERT_EQ(SIRIUS_OK, A::topk(v.data(), n, k, order,
+                        val.data(), idx.data()));
+                    for (size_t i = 0; i < k; i++) {
+                        ASSERT_EQ(ref[i], idx[i]) << "n " << n << " k " << k
+                            << " order " << o << " dup " << dup << " i " << i;
+                        ASSERT_EQ(v[ref[i]], val[i]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST(SiriusMathTyped, TopKArgs)
+{
+    typedef TypeParam T;
+    typedef i_api<T> A;
+    T v[4] = {3, 1, 2, 0};
+    T val[4];
+    size_t idx[4];
+
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER,
+        A::topk(nullptr, 4, 1, SIRIUS_MATH_TOPK_LARGEST, val, idx));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER,
+        A::topk(v, 4, 1, SIRIUS_MATH_TOPK_LARGEST, nullptr, nullptr));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER,
+        A::topk(v, 4, 5, SIRIUS_MATH_TOPK_LARGEST, val, idx));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER,
+        A::topk(v, 4, 1, (sirius_math_topk_t)2, val, idx));
+    EXPECT_EQ(SIRIUS_OK,
+        A::topk(v, 4, 0, SIRIUS_MATH_TOPK_LARGEST, val, idx));
+
+    /* either output may be left out */
+    ASSERT_EQ(SIRIUS_OK,
+        A::topk(v, 4, 2, SIRIUS_MATH_TOPK_SMALLEST, nullptr, idx));
+    EXPECT_EQ(3u, idx[0]);
+    EXPECT_EQ(1u, idx[1]);
+    ASSERT_EQ(SIRIUS_OK,
+        A::topk(v, 4, 2, SIRIUS_MATH_TOPK_LARGEST, val, nullptr));
+    EXPECT_EQ((T)3, val[0]);
+    EXPECT_EQ((T)2, val[1]);
+}
+
+namespace {
+
+template <typename T>
+struct i_sum_api;
+
+template <>
+struct i_sum_api<float> {
+    static float sum(const float *p, size_t n, sirius_math_acc_t a) {
+        return sirius_math_sum_f32(p, n, a);
+    }
+    static float dot(const float *x, const float *y, size_t n,
+        sirius_math_acc_t a) {
+        return sirius_math_dot_f32(x, y, n, a);
+    }
+    static float l2norm(const float *p, size_t n, sirius_math_acc_t a) {
+        return sirius_math_l2norm_f32(p, n, a);
+    }
+    static float mean(const float *p, size_t n, sirius_math_acc_t a) {
+        return sirius_math_mean_f32(p, n, a);
+    }
+    static float sum_par(const float *p, size_t n) {
+        return sirius_math_sum_f32_par(p, n);
+    }
+    /* unit roundoff */
+    static constexpr double eps = 0x1p-24;
+};
+
+template <>
+struct i_sum_api<double> {
+    static double sum(const double *p, size_t n, sirius_math_acc_t a) {
+        return sirius_math_sum_f64(p, n, a);
+    }
+    static double dot(const double *x, const double *y, size_t n,
+        sirius_math_acc_t a) {
+        return sirius_math_dot_f64(x, y, n, a);
+    }
+    static double l2norm(const double *p, size_t n, sirius_math_acc_t a) {
+        return sirius_math_l2norm_f64(p, n, a);
+    }
+    static double mean(const double *p, size_t n, sirius_math_acc_t a) {
+        return sirius_math_mean_f64(p, n, a);
+    }
+    static double sum_par(const double *p, size_t n) {
+        return sirius_math_sum_f64_par(p, n);
+    }
+    static constexpr double eps = 0x1p-53;
+};
+
+template <typename T>
+class SiriusMathSum : public ::testing::Test {};
+
+typedef ::testing::Types<float, double> i_flt_types_t;
+TYPED_TEST_SUITE(SiriusMathSum, i_flt_types_t);
+
+/**
+ * the error bound of a sum, relative to the sum of the magnitudes:
+ * log2(n) roundings for the pairwise one, a few for the compensated
+ */
+double
+i_bound(size_t n, sirius_math_acc_t acc, double eps)
+{
+    double r = SIRIUS_MATH_ACC_COMP == acc ? 4 :
+        std::ceil(std::log2((double)n + 1)) + 4;
+    return r * eps;
+}
+
+} // namespace
+
+TYPED_TEST(SiriusMathSum, SumDot)
+{
+    typedef TypeParam T;
+    typedef i_sum_api<T> A;
+
+    for (size_t n : g_len) {
+        std::vector<T> x = i_fill<T>(n, (unsigned int)n);
+        std::vector<T> y = i_fill<T>(n, (unsigned int)n + 1);
+        long double s = 0, s_abs = 0, d = 0, d_abs = 0, q = 0;
+        for (size_t i = 0; i < n; i++) {
+            s += x[i];
+            s_abs += std::fabs((long double)x[i]);
+            /* the kernels round the product to `T` first */
+            T p = x[i] * y[i];
+            d += p;
+            d_abs += std::fabs((long double)p);
+            T sq = x[i] * x[i];
+            q += sq;
+        }
+
+        for (sirius_math_acc_t acc :
+            {SIRIUS_MATH_ACC_FAST, SIRIUS_MATH_ACC_COMP}) {
+            double b = i_bound(n, acc, A::eps);
+            EXPECT_NEAR((double)s, A::sum(x.data(), n, acc),
+                b * (double)s_abs) << "n " << n << " acc " << acc;
+            EXPECT_NEAR((double)d, A::dot(x.data(), y.data(), n, acc),
+                b * (double)d_abs) << "n " << n << " acc " << acc;
+            EXPECT_NEAR((double)std::sqrt(q), A::l2norm(x.data(), n, acc),
+                (b + A::eps) * (double)std::sqrt(q))
+                << "n " << n << " acc " << acc;
+            EXPECT_NEAR((double)(s / n), A::mean(x.data(), n, acc),
+                (b + A::eps) * (double)(s_abs / n))
+                << "n " << n << " acc " << acc;
+        }
+    }
+}
+
+TYPED_TEST(SiriusMathSum, Empty)
+{
+    typedef TypeParam T;
+    typedef i_sum_api<T> A;
+    T x = 1;
+
+    EXPECT_EQ((T)0, A::sum(&x, 0, SIRIUS_MATH_ACC_FAST));
+    EXPECT_EQ((T)0, A::dot(&x, &x, 0, SIRIUS_MATH_ACC_COMP));
+    EXPECT_TRUE(std::isnan(A::mean(&x, 0, SIRIUS_MATH_ACC_FAST)));
+}
+
+TYPED_TEST(SiriusMathSum, Compensated)
+{
+    typedef TypeParam T;
+    typedef i_sum_api<T> A;
+
+    /* 1 followed by many halves of an ulp: lost unless compensated */
+    size_t n = 4099;
+    std::vector<T> x(n, A::eps);
+    x[0] = 1;
+    long double ref = 1 + (long double)A::eps * (n - 1);
+    EXPECT_NEAR((double)ref, A::sum(x.data(), n, SIRIUS_MATH_ACC_COMP),
+        4 * A::eps);
+}
+
+TYPED_TEST(SiriusMathSum, NonFinite)
+{
+    typedef TypeParam T;
+    typedef i_sum_api<T> A;
+    const T inf = std::numeric_limits<T>::infinity();
+    const T big = std::numeric_limits<T>::max();
+
+    /* long enough for the vector loops, the specials in the lanes */
+    for (size_t n : {(size_t)1, (size_t)3, (size_t)100, (size_t)1000}) {
+        for (sirius_math_acc_t acc :
+            {SIRIUS_MATH_ACC_FAST, SIRIUS_MATH_ACC_COMP}) {
+            std::vector<T> x(n, 1);
+            x[n / 2] = inf;
+            EXPECT_EQ(inf, A::sum(x.data(), n, acc)) << "n " << n;
+            EXPECT_EQ(inf, A::mean(x.data(), n, acc)) << "n " << n;
+            EXPECT_EQ(inf, A::dot(x.data(), x.data(), n, acc)) << "n " << n;
+            EXPECT_EQ(inf, A::l2norm(x.data(), n, acc)) << "n " << n;
+
+            x[n / 2] = -inf;
+            EXPECT_EQ(-inf, A::sum(x.data(), n, acc)) << "n " << n;
+            EXPECT_EQ(inf, A::l2norm(x.data(), n, acc)) << "n " << n;
+
+            x[n / 2] = std::numeric_limits<T>::quiet_NaN();
+            EXPECT_TRUE(std::isnan(A::sum(x.data(), n, acc))) << "n " << n;
+            EXPECT_TRUE(std::isnan(A::mean(x.data(), n, acc))) << "n " << n;
+            EXPECT_TRUE(std::isnan(A::l2norm(x.data(), n, acc)))
+                << "n " << n;
+
+            if (n < 2) continue;
+            /* inf - inf is NaN whatever the accumulation */
+            x[n / 2] = inf;
+            x[n - 1] = -inf;
+            EXPECT_TRUE(std::isnan(A::sum(x.data(), n, acc))) << "n " << n;
+
+            /* finite elements whose sum overflows */
+            std::fill(x.begin(), x.end(), big);
+            EXPECT_EQ(inf, A::sum(x.data(), n, acc)) << "n " << n;
+            /* the compensated f32 tail is summed in double, exact here */
+            EXPECT_LE(big, A::mean(x.data(), n, acc)) << "n " << n;
+        }
+    }
+}
+
+TYPED_TEST(SiriusMathSum, L2normScaled)
+{
+    typedef TypeParam T;
+    typedef i_sum_api<T> A;
+    /* the squares overflow, or underflow to 0, the norm is exact */
+    const T huge = (T)std::sqrt((double)std::numeric_limits<T>::max()) * 4;
+    const T tiny = (T)std::sqrt((double)std::numeric_limits<T>::min()) / 4;
+
+    for (sirius_math_acc_t acc :
+        {SIRIUS_MATH_ACC_FAST, SIRIUS_MATH_ACC_COMP}) {
+        for (T s : {huge, tiny}) {
+            T x[2] = {3 * s, 4 * s};
+            EXPECT_NEAR(5 * (double)s, A::l2norm(x, 2, acc),
+                4 * A::eps * 5 * (double)s) << "acc " << acc;
+
+            /* past a block, the scaled sum is done piecewise */
+            std::vector<T> v(1000, s);
+            EXPECT_NEAR(std::sqrt(1000.0) * (double)s,
+                A::l2norm(v.data(), v.size(), acc),
+                16 * A::eps * std::sqrt(1000.0) * (double)s) << "acc " << acc;
+        }
+
+        T z[3] = {0, 0, 0};
+        EXPECT_EQ((T)0, A::l2norm(z, 3, acc));
+        EXPECT_EQ((T)0, A::l2norm(z, 0, acc));
+    }
+
+    /* 3e19 and 4e19 square past FLT_MAX, the norm does not */
+    float f[2] = {3e19f, 4e19f};
+    EXPECT_FLOAT_EQ(5e19f, sirius_math_l2norm_f32(f, 2, SIRIUS_MATH_ACC_FAST));
+    EXPECT_FLOAT_EQ(5e19f, sirius_math_l2norm_f32(f, 2, SIRIUS_MATH_ACC_COMP));
+    double d[2] = {3e200, 4e200};
+    EXPECT_DOUBLE_EQ(5e200,
+        sirius_math_l2norm_f64(d, 2, SIRIUS_MATH_ACC_COMP));
+}
+
+TYPED_TEST(SiriusMathSum, SumPar)
+{
+    typedef TypeParam T;
+    typedef i_sum_api<T> A;
+
+    /* identical for any number of threads and below "math.par.min" */
+    std::vector<T> x = i_fill<T>(5 * 1024 * 1024 / sizeof(T) + 3, 11);
+    size_t n = x.size();
+    T one = A::sum_par(x.data(), n);
+    ASSERT_EQ(SIRIUS_OK, sirius_cfg_set_name("math.par.min", 0));
+    for (long long th : {1, 2, 3, 4}) {
+        ASSERT_EQ(SIRIUS_OK, sirius_cfg_set_name("math.par.threads", th));
+        T r = A::sum_par(x.data(), n);
+        EXPECT_EQ(0, std::memcmp(&one, &r, sizeof(T))) << "threads " << th;
+    }
+    ASSERT_EQ(SIRIUS_OK,
+        sirius_cfg_set_name("math.par.min", (long long)1 << 62));
+    T r = A::sum_par(x.data(), n);
+    EXPECT_EQ(0, std::memcmp(&one, &r, sizeof(T)));
+}
@@ -0,0 +1,54 @@
+/**
+ * @name sirius_test_math_c.c
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief the C expansions of the `SIRIUS_MAX`/`SIRIUS_MIN` macros,
+ *  called from sirius_test_math.cpp
+ */
+
+#include "sirius_math.h"
+
+int
+i_test_c_max_int_mixed()
+{
+    /* -1 stays -1, not UINT_MAX */
+    return SIRIUS_MAX_INT(2, -1, 1u);
+}
+
+int
+i_test_c_min_int_mixed()
+{
+    unsigned int u = 1u;
+    return SIRIUS_MIN_INT(2, u, -1);
+}
+
+int
+i_test_c_max_int_many(int *p_calls)
+{
+    return SIRIUS_MAX_INT(12, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+        ++*p_calls);
+}
+
+double
+i_test_c_min_dbl_many()
+{
+    return SIRIUS_MIN_DBL(10, 1, 2, 3, 4, 5, 6, 7, 8, 9, -0.5f);
+}
+
+long long
+i_test_c_max_generic()
+{
+    return SIRIUS_MAX((short)-3, 2LL, 'a');
+}
+
+int
+i_test_c_min_small_unsigned()
+{
+    /* unsigned char and short promote to int, no sign mix */
+    unsigned char uc = 200;
+    unsigned short us = 7;
+    return SIRIUS_MIN((short)-3, uc, us);
+}
@@ -0,0 +1,270 @@
+/**
+ * @name sirius_test_metrics.cpp
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief metrics registry and the Prometheus text export
+ */
+
+#include "sirius_metrics.h"
+#include "sirius_queue.h"
+#include "sirius_errno.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+std::string
+i_export()
+{
+    char *p_buf = nullptr;
+    size_t size = 0;
+    FILE *p_f = open_memstream(&p_buf, &size);
+    EXPECT_EQ(SIRIUS_OK, sirius_metrics_write(p_f));
+    fclose(p_f);
+    std::string s(p_buf, size);
+    free(p_buf);
+    return s;
+}
+
+bool
+i_has_line(const std::string &text, const std::string &line)
+{
+    std::istringstream in(text);
+    for (std::string l; std::getline(in, l); ) {
+        if (l == line) return true;
+    }
+    return false;
+}
+
+sirius_metric_handle
+i_register(sirius_metric_type_t type, const char *p_name,
+    const char *p_labels = nullptr, const char *p_help = nullptr)
+{
+    sirius_metric_attr_t attr = {};
+    attr.type = type;
+    attr.p_name = p_name;
+    attr.p_labels = p_labels;
+    attr.p_help = p_help;
+    attr.sig_bits = 7;
+    sirius_metric_handle h = nullptr;
+    EXPECT_EQ(SIRIUS_OK, sirius_metrics_register(&attr, &h));
+    return h;
+}
+
+double
+i_forty_two(void *p_arg)
+{
+    return *(double *)p_arg;
+}
+
+} // namespace
+
+TEST(SiriusMetrics, Counter)
+{
+    sirius_metric_handle h = i_register(SIRIUS_METRIC_COUNTER,
+        "test_counter_total", nullptr, "A counter.\nSecond line.");
+    ASSERT_NE(nullptr, h);
+
+    const int thread_nr = 8;
+    const int per = 100000;
+    std::vector<std::thread> ths;
+    for (int t = 0; t < thread_nr; t++) {
+        ths.emplace_back([h]() {
+            for (int i = 0; i < per; i++) sirius_metrics_counter_inc(h);
+        });
+    }
+    for (auto &th : ths) th.join();
+    sirius_metrics_counter_add(h, 5);
+    EXPECT_EQ((double)thread_nr * per + 5, sirius_metrics_value(h));
+
+    std::string text = i_export();
+    EXPECT_TRUE(i_has_line(text,
+        "# HELP test_counter_total A counter.\\nSecond line."));
+    EXPECT_TRUE(i_has_line(text, "# TYPE test_counter_total counter"));
+    EXPECT_TRUE(i_has_line(text, "test_counter_total 800005"));
+
+    EXPECT_EQ(SIRIUS_OK, sirius_metrics_unregister(h));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_metrics_unregister(h));
+    EXPECT_FALSE(i_has_line(i_export(), "test_counter_total 800005"));
+}
+
+TEST(SiriusMetrics, Gauge)
+{
+    sirius_metric_handle h = i_register(SIRIUS_METRIC_GAUGE, "test_gauge",
+        "kind=\"set\"");
+    sirius_metrics_gauge_set(h, 1.5);
+    sirius_metrics_gauge_add(h, -4);
+    EXPECT_EQ(-2.5, sirius_metrics_value(h));
+    EXPECT_TRUE(i_has_line(i_export(), "test_gauge{kind=\"set\"} -2.5"));
+
+    double v = 42;
+    sirius_metric_attr_t attr = {};
+    attr.type = SIRIUS_METRIC_GAUGE;
+    attr.p_name = "test_gauge";
+    attr.p_labels = "kind=\"fn\"";
+    attr.p_fn = i_forty_two;
+    attr.p_arg = &v;
+    sirius_metric_handle h_fn = nullptr;
+    ASSERT_EQ(SIRIUS_OK, sirius_metrics_register(&attr, &h_fn));
+    v = 43;
+    EXPECT_EQ(43, sirius_metrics_value(h_fn));
+
+    std::string text = i_export();
+    EXPECT_TRUE(i_has_line(text, "test_gauge{kind=\"fn\"} 43"));
+    /* one TYPE line for both series, right before them */
+    size_t type = text.find("# TYPE test_gauge gauge\n");
+    ASSERT_NE(std::string::npos, type);
+    EXPECT_EQ(std::string::npos, text.find("# TYPE test_gauge", type + 1));
+    EXPECT_EQ(type + 24, text.find("test_gauge{kind=\"set\"}"));
+
+    v = NAN;
+    EXPECT_TRUE(i_has_line(i_export(), "test_gauge{kind=\"fn\"} NaN"));
+
+    EXPECT_EQ(SIRIUS_OK, sirius_metrics_unregister(h));
+    EXPECT_EQ(SIRIUS_OK, sirius_metrics_unregister(h_fn));
+}
+
+TEST(SiriusMetrics, Hist)
+{
+    sirius_metric_handle h = i_register(SIRIUS_METRIC_HIST, "test_latency_ns",
+        "op=\"get\"");
+    ASSERT_NE(nullptr, sirius_metrics_hist(h));
+
+    std::string text = i_export();
+    EXPECT_TRUE(i_has_line(text, "# TYPE test_latency_ns summary"));
+    EXPECT_TRUE(i_has_line(text,
+        "test_latency_ns{op=\"get\",quantile=\"0.5\"} NaN"));
+    EXPECT_TRUE(i_has_line(text, "test_latency_ns_count{op=\"get\"} 0"));
+
+    for (uint64_t v = 1; v <= 100; v++) sirius_metrics_hist_record(h, v);
+    text = i_export();
+    EXPECT_TRUE(i_has_line(text,
+        "test_latency_ns{op=\"get\",quantile=\"0.5\"} 50"));
+    EXPECT_TRUE(i_has_line(text,
+        "test_latency_ns{op=\"get\",quantile=\"0.999\"} 100"));
+    EXPECT_TRUE(i_has_line(text, "test_latency_ns_sum{op=\"get\"} 5050"));
+    EXPECT_TRUE(i_has_line(text, "test_latency_ns_count{op=\"get\"} 100"));
+    EXPECT_EQ(0, sirius_metrics_value(h));
+
+    EXPECT_EQ(SIRIUS_OK, sirius_metrics_unregister(h));
+}
+
+TEST(SiriusMetrics, Invalid)
+{
+    sirius_metric_attr_t attr = {};
+    sirius_metric_handle h = nullptr;
+    attr.type = SIRIUS_METRIC_COUNTER;
+
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_metrics_register(nullptr, &h));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_metrics_register(&attr, &h));
+    attr.p_name = "1abc";
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_metrics_register(&attr, &h));
+    attr.p_name = "a-b";
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_metrics_register(&attr, &h));
+    attr.p_name = "test_invalid";
+    attr.p_labels = "a=\"}\"";
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_metrics_register(&attr, &h));
+    attr.p_labels = nullptr;
+    attr.type = SIRIUS_METRIC_MAX;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_metrics_register(&attr, &h));
+    attr.type = SIRIUS_METRIC_HIST;
+    attr.sig_bits = 1;
+    EXPECT_NE(SIRIUS_OK, sirius_metrics_register(&attr, &h));
+
+    /* same name and labels, or same name and another type */
+    sirius_metric_handle h1 = i_register(SIRIUS_METRIC_COUNTER, "test_dup");
+    attr.type = SIRIUS_METRIC_COUNTER;
+    attr.p_name = "test_dup";
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_metrics_register(&attr, &h));
+    attr.type = SIRIUS_METRIC_GAUGE;
+    attr.p_labels = "x=\"1\"";
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_metrics_register(&attr, &h));
+    attr.type = SIRIUS_METRIC_COUNTER;
+    ASSERT_EQ(SIRIUS_OK, sirius_metrics_register(&attr, &h));
+
+    EXPECT_EQ(SIRIUS_OK, sirius_metrics_unregister(h1));
+    EXPECT_EQ(SIRIUS_OK, sirius_metrics_unregister(h));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_metrics_unregister(nullptr));
+}
+
+TEST(SiriusMetrics, Queue)
+{
+    sirius_que_cr_t cr = {};
+    cr.elem_nr = 8;
+    cr.que_type = SIRIUS_QUE_TYPE_MTX;
+    cr.p_name = "rx";
+    sirius_que_handle q = nullptr;
+    ASSERT_EQ(SIRIUS_OK, sirius_que_cr(&cr, &q));
+    for (size_t i = 0; i < 3; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_que_put(q, i, SIRIUS_QUE_TIMEOUT_NONE));
+    }
+    EXPECT_TRUE(i_has_line(i_export(), "sirius_que_depth{que=\"rx\"} 3"));
+
+    /* a second queue of the same name is not exported */
+    sirius_que_handle q2 = nullptr;
+    ASSERT_EQ(SIRIUS_OK, sirius_que_cr(&cr, &q2));
+    EXPECT_EQ(SIRIUS_OK, sirius_que_del(q2));
+
+    EXPECT_EQ(SIRIUS_OK, sirius_que_del(q));
+    EXPECT_EQ(std::string::npos, i_export().find("que=\"rx\""));
+}
+
+TEST(SiriusMetrics, Dump)
+{
+    sirius_metric_handle h = i_register(SIRIUS_METRIC_COUNTER,
+        "test_dump_total");
+    sirius_metrics_counter_add(h, 7);
+
+    std::string path = "/tmp/sirius_test_metrics_" +
+        std::to_string(getpid()) + ".prom";
+    ASSERT_EQ(SIRIUS_OK, sirius_metrics_dump(path.c_str()));
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    EXPECT_TRUE(i_has_line(ss.str(), "test_dump_total 7"));
+    EXPECT_NE(0, access((path + ".tmp").c_str(), F_OK));
+    unlink(path.c_str());
+
+    EXPECT_NE(SIRIUS_OK, sirius_metrics_dump("/nonexistent/dir/m.prom"));
+    EXPECT_EQ(SIRIUS_OK, sirius_metrics_unregister(h));
+}
+
+TEST(SiriusMetrics, Periodic)
+{
+    sirius_metric_handle h = i_register(SIRIUS_METRIC_GAUGE,
+        "test_periodic");
+    sirius_metrics_gauge_set(h, 9);
+
+    std::string path = "/tmp/sirius_test_metrics_p_" +
+        std::to_string(getpid()) + ".prom";
+    sirius_metrics_export_t exp = {};
+    exp.p_path = path.c_str();
+    exp.interval_ms = 20;
+    ASSERT_EQ(SIRIUS_OK, sirius_metrics_init(&exp));
+    EXPECT_EQ(SIRIUS_ERR_INIT_REPEATED, sirius_metrics_init(&exp));
+    usleep(100000);
+    EXPECT_EQ(0, access(path.c_str(), F_OK));
+
+    sirius_metrics_gauge_set(h, 10);
+    sirius_metrics_deinit();
+    /* the last export happens at the deinitialization */
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    EXPECT_TRUE(i_has_line(ss.str(), "test_periodic 10"));
+    unlink(path.c_str());
+
+    EXPECT_EQ(SIRIUS_OK, sirius_metrics_unregister(h));
+}
@@ -0,0 +1,354 @@
+/**
+ * @name sirius_test_stats.cpp
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief Welford statistics, EWMA and the sharded histogram
+ * 
+ * @details
+ * the bucket bounds are checked through the public API: with the
+ * samples `v` and UINT64_MAX, the 50th percentile is the highest
+ * value of the bucket of `v`, which is compared against a reference
+ * computed here from the layout described in `sirius_stats.h`.
+ */
+
+#include "sirius_stats.h"
+#include "sirius_errno.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/* highest value of the bucket of `v` */
+uint64_t
+i_ref_upper(uint64_t v, unsigned int p)
+{
+    if (v < (1ULL << p)) return v;
+    unsigned int m = 63 - __builtin_clzll(v);
+    uint64_t width = 1ULL << (m - p + 1);
+    return v | (width - 1);
+}
+
+sirius_hist_handle
+i_cr(unsigned int sig_bits)
+{
+    sirius_hist_cr_t cr = {};
+    cr.sig_bits = sig_bits;
+    sirius_hist_handle h = nullptr;
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_cr(&cr, &h));
+    return h;
+}
+
+uint64_t
+i_upper(unsigned int p, uint64_t v)
+{
+    sirius_hist_handle h = i_cr(p);
+    sirius_hist_record(h, v);
+    sirius_hist_record(h, UINT64_MAX);
+    const double q = 50;
+    uint64_t val = 0;
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_query(h, nullptr, &q, &val, 1));
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_del(h));
+    return val;
+}
+
+} // namespace
+
+TEST(SiriusStats, Welford)
+{
+    std::mt19937_64 rng(1);
+    std::normal_distribution<double> dist(1e6, 3.0);
+    std::vector<double> x(10000);
+    for (auto &v : x) v = dist(rng);
+
+    /* two-pass reference */
+    double mean = 0;
+    for (double v : x) mean += v;
+    mean /= (double)x.size();
+    double ss = 0;
+    for (double v : x) ss += (v - mean) * (v - mean);
+    double var = ss / (double)(x.size() - 1);
+
+    sirius_stats_t all;
+    sirius_stats_init(&all);
+    for (double v : x) sirius_stats_add(&all, v);
+    EXPECT_EQ(x.size(), all.n);
+    EXPECT_NEAR(mean, all.mean, 1e-9 * mean);
+    EXPECT_NEAR(var, sirius_stats_var(&all), 1e-6 * var);
+    EXPECT_NEAR(std::sqrt(var), sirius_stats_stddev(&all),
+        1e-6 * std::sqrt(var));
+
+    sirius_stats_t few;
+    sirius_stats_init(&few);
+    EXPECT_EQ(0, sirius_stats_var(&few));
+    sirius_stats_add(&few, 5);
+    EXPECT_EQ(0, sirius_stats_var(&few));
+    EXPECT_EQ(5, few.min);
+    EXPECT_EQ(5, few.max);
+}
+
+TEST(SiriusStats, Merge)
+{
+    std::mt19937_64 rng(2);
+    std::uniform_real_distribution<double> dist(-100, 100);
+    std::vector<double> x(9001);
+    for (auto &v : x) v = dist(rng);
+
+    sirius_stats_t all;
+    sirius_stats_init(&all);
+    for (double v : x) sirius_stats_add(&all, v);
+
+    /* uneven parts, one of them empty */
+    const size_t cut[] = {0, 1, 1, 4000, 9001};
+    sirius_stats_t merged;
+    sirius_stats_init(&merged);
+    for (size_t k = 0; k + 1 < sizeof(cut) / sizeof(cut[0]); k++) {
+        sirius_stats_t part;
+        sirius_stats_init(&part);
+        for (size_t i = cut[k]; i < cut[k + 1]; i++) {
+            sirius_stats_add(&part, x[i]);
+        }
+        sirius_stats_merge(&merged, &part);
+    }
+
+    EXPECT_EQ(all.n, merged.n);
+    EXPECT_NEAR(all.mean, merged.mean, 1e-9);
+    EXPECT_NEAR(sirius_stats_var(&all), sirius_stats_var(&merged),
+        1e-9 * sirius_stats_var(&all));
+    EXPECT_EQ(all.min, merged.min);
+    EXPECT_EQ(all.max, merged.max);
+
+    /* an empty source leaves the target unchanged */
+    sirius_stats_t empty;
+    sirius_stats_init(&empty);
+    sirius_stats_t copy = merged;
+    sirius_stats_merge(&merged, &empty);
+    EXPECT_EQ(copy.n, merged.n);
+    EXPECT_EQ(copy.mean, merged.mean);
+    EXPECT_EQ(copy.m2, merged.m2);
+}
+
+TEST(SiriusStats, Ewma)
+{
+    sirius_ewma_t e;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_ewma_init(&e, 0));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_ewma_init(&e, 1.5));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_ewma_init(&e, NAN));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_ewma_init(nullptr, 0.5));
+
+    ASSERT_EQ(SIRIUS_OK, sirius_ewma_init(&e, 0.5));
+    EXPECT_EQ(10, sirius_ewma_add(&e, 10));
+    EXPECT_EQ(15, sirius_ewma_add(&e, 20));
+    EXPECT_EQ(17.5, sirius_ewma_add(&e, 20));
+}
+
+TEST(SiriusStats, HistInvalid)
+{
+    sirius_hist_cr_t cr = {};
+    sirius_hist_handle h = nullptr;
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_hist_cr(nullptr, &h));
+    cr.sig_bits = SIRIUS_HIST_SIG_BITS_MIN - 1;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_hist_cr(&cr, &h));
+    cr.sig_bits = SIRIUS_HIST_SIG_BITS_MAX + 1;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_hist_cr(&cr, &h));
+
+    h = i_cr(7);
+    sirius_hist_handle other = i_cr(8);
+    double q = 101;
+    uint64_t v = 0;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER,
+        sirius_hist_query(h, nullptr, &q, &v, 1));
+    q = -1;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER,
+        sirius_hist_query(h, nullptr, &q, &v, 1));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER,
+        sirius_hist_query(h, nullptr, nullptr, &v, 1));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_hist_merge(h, other));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_hist_merge(h, h));
+
+    /* an empty histogram */
+    q = 50;
+    sirius_hist_res_t res = {};
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_query(h, &res, &q, &v, 1));
+    EXPECT_EQ(0u, res.count);
+    EXPECT_EQ(0u, res.min);
+    EXPECT_EQ(0u, v);
+
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_del(other));
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_del(h));
+}
+
+TEST(SiriusStats, HistBucket)
+{
+    for (unsigned int p = SIRIUS_HIST_SIG_BITS_MIN;
+            p <= SIRIUS_HIST_SIG_BITS_MAX; p++) {
+        std::vector<uint64_t> vs = {0, 1, (1ULL << p) - 1, 1ULL << p};
+        for (unsigned int m = p; m < 64; m++) {
+            uint64_t b = 1ULL << m;
+            vs.push_back(b - 1);
+            vs.push_back(b);
+            vs.push_back(b + 1);
+            vs.push_back(b + (b >> 1) + 3);
+        }
+        /* the last power of two */
+        vs.push_back(1ULL << 63);
+        vs.push_back((1ULL << 63) + (1ULL << 62));
+        vs.push_back(UINT64_MAX - 1);
+
+        for (uint64_t v : vs) {
+            uint64_t ub = i_upper(p, v);
+            SCOPED_TRACE(::testing::Message() << "p " << p << " v " << v);
+            EXPECT_EQ(i_ref_upper(v, p), ub);
+            EXPECT_LE(v, ub);
+            /* the relative error bound of the header */
+            if (v) {
+                EXPECT_LE((double)(ub - v) / (double)v,
+                    std::ldexp(1.0, 1 - (int)p));
+            }
+        }
+    }
+}
+
+TEST(SiriusStats, HistTop)
+{
+    /* 2^64 - 1 has the last bucket */
+    sirius_hist_handle h = i_cr(SIRIUS_HIST_SIG_BITS_MIN);
+    sirius_hist_record_n(h, UINT64_MAX, 3);
+    sirius_hist_record(h, 1ULL << 63);
+
+    const double q[] = {0, 25, 26, 100};
+    uint64_t v[4] = {};
+    sirius_hist_res_t res = {};
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_query(h, &res, q, v, 4));
+    EXPECT_EQ(4u, res.count);
+    EXPECT_EQ(1ULL << 63, res.min);
+    EXPECT_EQ(UINT64_MAX, res.max);
+    EXPECT_EQ(1ULL << 63, v[0]);
+    /* sig_bits 2: [2^63, 2^63 + 2^62) is one bucket */
+    EXPECT_EQ((1ULL << 63) + (1ULL << 62) - 1, v[1]);
+    EXPECT_EQ(UINT64_MAX, v[2]);
+    EXPECT_EQ(UINT64_MAX, v[3]);
+    /* the sum saturates instead of wrapping */
+    EXPECT_EQ((double)UINT64_MAX / 4, res.mean);
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_del(h));
+
+    h = i_cr(SIRIUS_HIST_SIG_BITS_MIN);
+    sirius_hist_record_n(h, 1ULL << 62, 2);
+    sirius_hist_record_n(h, 1ULL << 62, 2);
+    sirius_hist_handle other = i_cr(SIRIUS_HIST_SIG_BITS_MIN);
+    sirius_hist_record_n(other, 1ULL << 62, 4);
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_merge(h, other));
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_query(h, &res, nullptr, nullptr, 0));
+    EXPECT_EQ(8u, res.count);
+    EXPECT_EQ((double)UINT64_MAX / 8, res.mean);
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_del(other));
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_del(h));
+}
+
+TEST(SiriusStats, HistRank)
+{
+    /* values below 2^sig_bits are exact */
+    sirius_hist_handle h = i_cr(7);
+    for (uint64_t i = 1; i <= 100; i++) sirius_hist_record(h, i);
+
+    const double q[] = {0, 1, 1.5, 50, 50.5, 99, 99.9, 100};
+    const uint64_t want[] = {1, 1, 2, 50, 51, 99, 100, 100};
+    uint64_t v[8] = {};
+    sirius_hist_res_t res = {};
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_query(h, &res, q, v, 8));
+    EXPECT_EQ(100u, res.count);
+    EXPECT_EQ(1u, res.min);
+    EXPECT_EQ(100u, res.max);
+    EXPECT_DOUBLE_EQ(50.5, res.mean);
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(want[i], v[i]) << "q " << q[i];
+    }
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_del(h));
+
+    /* above it, the rank-th sample maps to the top of its bucket */
+    const unsigned int p = 4;
+    h = i_cr(p);
+    const uint64_t n = 5000;
+    for (uint64_t i = 1; i <= n; i++) sirius_hist_record(h, i);
+    const double q2[] = {10, 50, 90, 99, 99.99};
+    uint64_t v2[5] = {};
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_query(h, nullptr, q2, v2, 5));
+    for (int i = 0; i < 5; i++) {
+        uint64_t rank = (uint64_t)std::ceil(q2[i] / 100 * (double)n);
+        uint64_t ub = i_ref_upper(rank, p);
+        EXPECT_EQ(ub > n ? n : ub, v2[i]) << "q " << q2[i];
+    }
+
+    /* reset and merge */
+    sirius_hist_handle src = i_cr(p);
+    sirius_hist_record_n(src, 7, 10);
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_reset(h));
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_merge(h, src));
+    sirius_hist_record(h, 3);
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_query(h, &res, nullptr, nullptr, 0));
+    EXPECT_EQ(11u, res.count);
+    EXPECT_EQ(3u, res.min);
+    EXPECT_EQ(7u, res.max);
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_del(src));
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_del(h));
+}
+
+TEST(SiriusStats, HistThreads)
+{
+    /* more threads than shards, some of them share one */
+    const int thd_nr = SIRIUS_HIST_SHARD_MAX + 8;
+    const uint64_t per = 20000;
+    sirius_hist_handle h = i_cr(7);
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> bad(0);
+    std::thread reader([&]() {
+        unsigned long long last = 0;
+        const double q[] = {50, 99};
+        uint64_t v[2];
+        while (!(stop.load())) {
+            sirius_hist_res_t res = {};
+            if (sirius_hist_query(h, &res, q, v, 2)) bad++;
+            /* the count only grows, the percentiles stay in range */
+            if (res.count < last) bad++;
+            if (res.count > (unsigned long long)thd_nr * per) bad++;
+            if (res.count && (v[0] > v[1] || v[1] > 1000)) bad++;
+            last = res.count;
+            std::this_thread::yield();
+        }
+    });
+
+    std::vector<std::thread> thds;
+    for (int t = 0; t < thd_nr; t++) {
+        thds.emplace_back([&, t]() {
+            for (uint64_t i = 0; i < per; i++) {
+                sirius_hist_record(h, (i + (uint64_t)t) % 1000 + 1);
+            }
+        });
+    }
+    for (auto &t : thds) t.join();
+    stop = true;
+    reader.join();
+    EXPECT_EQ(0, bad.load());
+
+    const double q[] = {0, 50, 100};
+    uint64_t v[3] = {};
+    sirius_hist_res_t res = {};
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_query(h, &res, q, v, 3));
+    EXPECT_EQ((unsigned long long)thd_nr * per, res.count);
+    EXPECT_EQ(1u, res.min);
+    EXPECT_EQ(1000u, res.max);
+    EXPECT_DOUBLE_EQ(500.5, res.mean);
+    EXPECT_EQ(1u, v[0]);
+    EXPECT_EQ(i_ref_upper(500, 7), v[1]);
+    EXPECT_EQ(1000u, v[2]);
+    EXPECT_EQ(SIRIUS_OK, sirius_hist_del(h));
+}
@@ -0,0 +1,217 @@
+/**
+ * @name sirius_test_thread.cpp
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief thread placement and topology
+ */
+
+#include "sirius_thread.h"
+#include "sirius_errno.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+typedef struct {
+    char name[32];
+    int cpu;
+    int nice;
+    int policy;
+    int prio;
+    unsigned int cpu_nr;
+} i_seen_t;
+
+void *
+i_probe(void *p_arg)
+{
+    i_seen_t *p = (i_seen_t *)p_arg;
+    pthread_getname_np(pthread_self(), p->name, sizeof(p->name));
+    p->cpu = sched_getcpu();
+    errno = 0;
+    p->nice = getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid));
+
+    struct sched_param sp;
+    pthread_getschedparam(pthread_self(), &(p->policy), &sp);
+    p->prio = sp.sched_priority;
+
+    cpu_set_t cs;
+    pthread_getaffinity_np(pthread_self(), sizeof(cs), &cs);
+    p->cpu_nr = (unsigned int)CPU_COUNT(&cs);
+    return NULL;
+}
+
+} // namespace
+
+TEST(SiriusThread, CpusetParse)
+{
+    sirius_cpuset_t set;
+    ASSERT_EQ(SIRIUS_OK, sirius_cpuset_parse("0-3,8, 10-11\n", &set));
+    EXPECT_EQ(7u, sirius_cpuset_count(&set));
+    EXPECT_TRUE(sirius_cpuset_has(&set, 0));
+    EXPECT_TRUE(sirius_cpuset_has(&set, 3));
+    EXPECT_FALSE(sirius_cpuset_has(&set, 4));
+    EXPECT_TRUE(sirius_cpuset_has(&set, 8));
+    EXPECT_TRUE(sirius_cpuset_has(&set, 11));
+    sirius_cpuset_del(&set, 8);
+    EXPECT_FALSE(sirius_cpuset_has(&set, 8));
+
+    ASSERT_EQ(SIRIUS_OK, sirius_cpuset_parse("", &set));
+    EXPECT_EQ(0u, sirius_cpuset_count(&set));
+
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_cpuset_parse("3-1", &set));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_cpuset_parse("1,,2", &set));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_cpuset_parse("a", &set));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_cpuset_parse("1-", &set));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER,
+        sirius_cpuset_parse("0-100000", &set));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_cpuset_parse(nullptr, &set));
+}
+
+TEST(SiriusThread, Create)
+{
+    sirius_thread_attr_t attr = {};
+    attr.p_name = "sirius-test-long-name";
+    sirius_cpuset_zero(&(attr.cpus));
+    sirius_cpuset_add(&(attr.cpus), 0);
+    attr.stack_size = 100000;
+    attr.sched = SIRIUS_THREAD_SCHED_OTHER;
+    attr.prio = 5;
+
+    i_seen_t seen = {};
+    pthread_t id;
+    ASSERT_EQ(SIRIUS_OK, sirius_thread_create(&id, &attr, i_probe, &seen));
+    ASSERT_EQ(0, pthread_join(id, NULL));
+
+    /* the name is cut to what the kernel keeps */
+    EXPECT_STREQ("sirius-test-lon", seen.name);
+    EXPECT_EQ(0, seen.cpu);
+    EXPECT_EQ(1u, seen.cpu_nr);
+    EXPECT_EQ(5, seen.nice);
+    EXPECT_EQ(SCHED_OTHER, seen.policy);
+}
+
+TEST(SiriusThread, Defaults)
+{
+    i_seen_t seen = {};
+    pthread_t id;
+    ASSERT_EQ(SIRIUS_OK, sirius_thread_create(&id, nullptr, i_probe, &seen));
+    ASSERT_EQ(0, pthread_join(id, NULL));
+
+    cpu_set_t cs;
+    pthread_getaffinity_np(pthread_self(), sizeof(cs), &cs);
+    EXPECT_EQ((unsigned int)CPU_COUNT(&cs), seen.cpu_nr);
+}
+
+TEST(SiriusThread, RealTime)
+{
+    sirius_thread_attr_t attr = {};
+    attr.sched = SIRIUS_THREAD_SCHED_FIFO;
+    attr.prio = 10;
+
+    i_seen_t seen = {};
+    pthread_t id;
+    int ret = sirius_thread_create(&id, &attr, i_probe, &seen);
+    if (SIRIUS_ERR_RESOURCE_REQUEST == ret) {
+        GTEST_SKIP() << "no permission for SCHED_FIFO";
+    }
+    ASSERT_EQ(SIRIUS_OK, ret);
+    ASSERT_EQ(0, pthread_join(id, NULL));
+    EXPECT_EQ(SCHED_FIFO, seen.policy);
+    EXPECT_EQ(10, seen.prio);
+}
+
+TEST(SiriusThread, InvalidAttr)
+{
+    sirius_thread_attr_t attr = {};
+    pthread_t id;
+
+    attr.sched = SIRIUS_THREAD_SCHED_FIFO;
+    attr.prio = 0;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER,
+        sirius_thread_create(&id, &attr, i_probe, nullptr));
+    attr.sched = SIRIUS_THREAD_SCHED_OTHER;
+    attr.prio = 20;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER,
+        sirius_thread_create(&id, &attr, i_probe, nullptr));
+    attr.sched = SIRIUS_THREAD_SCHED_MAX;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_thread_apply(&attr));
+
+    /* a joinable thread needs somewhere to put its id */
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER,
+        sirius_thread_create(nullptr, nullptr, i_probe, nullptr));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER,
+        sirius_thread_create(&id, nullptr, nullptr, nullptr));
+}
+
+TEST(SiriusThread, Apply)
+{
+    sirius_thread_attr_t attr = {};
+    attr.p_name = "sirius-apply";
+    attr.sched = SIRIUS_THREAD_SCHED_BATCH;
+    attr.prio = 3;
+
+    std::thread th([&]() {
+        ASSERT_EQ(SIRIUS_OK, sirius_thread_apply(&attr));
+        i_seen_t seen = {};
+        i_probe(&seen);
+        EXPECT_STREQ("sirius-apply", seen.name);
+        EXPECT_EQ(SCHED_BATCH, seen.policy);
+        EXPECT_EQ(3, seen.nice);
+    });
+    th.join();
+}
+
+TEST(SiriusThread, Topology)
+{
+    const sirius_topo_t *p_t = sirius_thread_topo();
+    ASSERT_NE(nullptr, p_t);
+    EXPECT_EQ(p_t, sirius_thread_topo());
+    EXPECT_EQ((long)p_t->cpu_nr, sysconf(_SC_NPROCESSORS_ONLN));
+
+    /* every level partitions the online cpus */
+    for (int l = 0; l < SIRIUS_TOPO_MAX; l++) {
+        sirius_topo_level_t level = (sirius_topo_level_t)l;
+        ASSERT_GE(p_t->nr[l], 1u);
+        ASSERT_LE(p_t->nr[l], p_t->cpu_nr);
+
+        unsigned int total = 0;
+        for (unsigned int g = 0; g < p_t->nr[l]; g++) {
+            sirius_cpuset_t set;
+            ASSERT_EQ(SIRIUS_OK, sirius_thread_topo_cpus(level, g, &set));
+            EXPECT_GE(sirius_cpuset_count(&set), 1u);
+            total += sirius_cpuset_count(&set);
+        }
+        EXPECT_EQ(p_t->cpu_nr, total) << "level " << l;
+
+        sirius_cpuset_t set;
+        EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER,
+            sirius_thread_topo_cpus(level, p_t->nr[l], &set));
+    }
+
+    /* the smt siblings share a package */
+    for (unsigned int c = 0; c < SIRIUS_THREAD_CPU_MAX; c++) {
+        if (!(sirius_cpuset_has(&(p_t->online), c))) {
+            EXPECT_EQ(-1, p_t->group[c][SIRIUS_TOPO_CORE]);
+            continue;
+        }
+        sirius_cpuset_t core;
+        ASSERT_EQ(SIRIUS_OK, sirius_thread_topo_cpus(SIRIUS_TOPO_CORE,
+            (unsigned int)p_t->group[c][SIRIUS_TOPO_CORE], &core));
+        for (unsigned int s = 0; s < SIRIUS_THREAD_CPU_MAX; s++) {
+            if (sirius_cpuset_has(&core, s)) {
+                EXPECT_EQ(p_t->group[c][SIRIUS_TOPO_PKG],
+                    p_t->group[s][SIRIUS_TOPO_PKG]);
+            }
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * @name sirius_test_time.cpp
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief calibrated clock against clock_gettime
+ */
+
+#include "sirius_time.h"
+#include "sirius_errno.h"
+
+#include <gtest/gtest.h>
+
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+uint64_t
+i_mono()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+} // namespace
+
+TEST(SiriusTime, Init)
+{
+    /* only the start of the calibration, no sleep */
+    uint64_t t0 = i_mono();
+    EXPECT_EQ(SIRIUS_OK, sirius_time_init());
+    EXPECT_LT(i_mono() - t0, SIRIUS_TIME_CAL_MS * 1000000ULL / 2);
+    EXPECT_EQ(SIRIUS_OK, sirius_time_init());
+
+    /* right or not, the clock is usable before the calibration ends */
+    uint64_t a = i_mono();
+    uint64_t t = sirius_time_ns();
+    EXPECT_GE(t + 5000, a);
+    EXPECT_NE(0u, sirius_time_mult());
+    /* any cycle counter runs between 10 MHz and 100 GHz */
+    EXPECT_GT(sirius_time_hz(), 10000000u);
+    EXPECT_LT(sirius_time_hz(), 100000000000u);
+}
+
+TEST(SiriusTime, Monotonic)
+{
+    uint64_t prev = sirius_time_ns();
+    for (int i = 0; i < 1000000; i++) {
+        uint64_t now = sirius_time_ns();
+        ASSERT_LE(prev, now) << "i " << i;
+        prev = now;
+    }
+}
+
+TEST(SiriusTime, FollowsClock)
+{
+    /* the difference stays within a few us, reads included */
+    for (int i = 0; i < 5; i++) {
+        uint64_t a = i_mono();
+        uint64_t t = sirius_time_ns();
+        uint64_t b = i_mono();
+        EXPECT_GE(t + 5000, a);
+        EXPECT_LE(t, b + 5000);
+        usleep(20000);
+    }
+
+    uint64_t c = sirius_time_coarse_ns();
+    uint64_t m = i_mono();
+    /* one tick behind at most */
+    EXPECT_LE(c, m);
+    EXPECT_LT(m - c, 20000000u);
+}
+
+TEST(SiriusTime, Cycles)
+{
+    uint64_t c0 = sirius_time_cycles();
+    uint64_t t0 = i_mono();
+    usleep(50000);
+    uint64_t c1 = sirius_time_cycles();
+    uint64_t t1 = i_mono();
+
+    double ns = (double)sirius_time_cyc2ns(c1 - c0);
+    double ref = (double)(t1 - t0);
+    EXPECT_NEAR(ref, ns, ref * 0.01);
+    EXPECT_EQ(0u, sirius_time_cyc2ns(0));
+}
@@ -0,0 +1,145 @@
+/**
+ * @name sirius_test_trace.cpp
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief trace spans and the JSON trace file
+ */
+
+#include "sirius_trace.h"
+#include "sirius_errno.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+std::string
+i_read(const std::string &path)
+{
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+size_t
+i_count(const std::string &s, const std::string &sub)
+{
+    size_t n = 0;
+    for (size_t pos = s.find(sub); pos != std::string::npos;
+        pos = s.find(sub, pos + sub.size())) {
+        n++;
+    }
+    return n;
+}
+
+std::string
+i_path(const char *p_tag)
+{
+    return std::string("/tmp/sirius_test_trace_") + p_tag + "_" +
+        std::to_string(getpid()) + ".json";
+}
+
+void
+i_work(int n)
+{
+    for (int i = 0; i < n; i++) {
+        SIRIUS_TRACE_SCOPE_ARG("outer", i);
+        SIRIUS_TRACE_SCOPE("inner");
+        SIRIUS_TRACE_BEGIN("pair");
+        SIRIUS_TRACE_END("pair");
+    }
+}
+
+} // namespace
+
+TEST(SiriusTrace, Off)
+{
+    EXPECT_FALSE(sirius_trace_enabled());
+    EXPECT_EQ(SIRIUS_ERR_NOT_INIT, sirius_trace_stop(nullptr));
+    /* nothing is recorded */
+    i_work(10);
+}
+
+TEST(SiriusTrace, Spans)
+{
+    std::string path = i_path("spans");
+    ASSERT_EQ(SIRIUS_OK, sirius_trace_start());
+    EXPECT_TRUE(sirius_trace_enabled());
+    EXPECT_EQ(SIRIUS_ERR_INIT_REPEATED, sirius_trace_start());
+
+    i_work(3);
+    std::thread th([]() { i_work(2); });
+    th.join();
+
+    ASSERT_EQ(SIRIUS_OK, sirius_trace_stop(path.c_str()));
+    EXPECT_FALSE(sirius_trace_enabled());
+
+    std::string json = i_read(path);
+    ASSERT_FALSE(json.empty());
+    EXPECT_EQ(0u, json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, json.rfind("]}"));
+
+    EXPECT_EQ(5u, i_count(json, "\"name\":\"outer\",\"ph\":\"X\""));
+    EXPECT_EQ(5u, i_count(json, "\"name\":\"inner\",\"ph\":\"X\""));
+    EXPECT_EQ(5u, i_count(json, "\"name\":\"pair\",\"ph\":\"B\""));
+    EXPECT_EQ(5u, i_count(json, "\"name\":\"pair\",\"ph\":\"E\""));
+    EXPECT_EQ(1u, i_count(json, "\"args\":{\"arg\":2}"));
+    EXPECT_EQ(2u, i_count(json, "\"args\":{\"arg\":1}"));
+    /* the main thread is still alive and named */
+    EXPECT_GE(i_count(json, "\"name\":\"thread_name\""), 1u);
+    unlink(path.c_str());
+}
+
+TEST(SiriusTrace, Sessions)
+{
+    std::string path = i_path("sessions");
+    ASSERT_EQ(SIRIUS_OK, sirius_trace_start());
+    i_work(4);
+    ASSERT_EQ(SIRIUS_OK, sirius_trace_stop(path.c_str()));
+
+    /* only the events of the last session are written */
+    i_work(4);
+    ASSERT_EQ(SIRIUS_OK, sirius_trace_start());
+    i_work(1);
+    ASSERT_EQ(SIRIUS_OK, sirius_trace_stop(path.c_str()));
+
+    std::string json = i_read(path);
+    EXPECT_EQ(1u, i_count(json, "\"name\":\"outer\""));
+    unlink(path.c_str());
+}
+
+TEST(SiriusTrace, Full)
+{
+    std::string path = i_path("full");
+    ASSERT_EQ(SIRIUS_OK, sirius_trace_start());
+    /* a fresh thread, its buffer is empty */
+    std::thread th([]() {
+        for (int i = 0; i < SIRIUS_TRACE_BUF_EVENTS + 100; i++) {
+            SIRIUS_TRACE_BEGIN("many");
+        }
+    });
+    th.join();
+    ASSERT_EQ(SIRIUS_OK, sirius_trace_stop(path.c_str()));
+
+    std::string json = i_read(path);
+    EXPECT_EQ((size_t)SIRIUS_TRACE_BUF_EVENTS,
+        i_count(json, "\"name\":\"many\""));
+    unlink(path.c_str());
+}
+
+TEST(SiriusTrace, BadPath)
+{
+    ASSERT_EQ(SIRIUS_OK, sirius_trace_start());
+    i_work(1);
+    EXPECT_NE(SIRIUS_OK, sirius_trace_stop("/nonexistent/dir/trace.json"));
+    EXPECT_FALSE(sirius_trace_enabled());
+}
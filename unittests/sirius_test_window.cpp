@@ -0,0 +1,376 @@
+/**
+ * @name sirius_test_window.cpp
+ * 
+ * @author 胡益华
+ * 
+ * @date 2026-10-19
+ * 
+ * @brief sliding windows, checked against naive references
+ * 
+ * @details
+ * the reference keeps the samples of the window in a std::deque and
+ * recomputes every statistic from scratch, the sliding extremes of
+ * an array are recomputed in O(n * w).
+ */
+
+#include "sirius_window.h"
+#include "sirius_errno.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct i_ref_t {
+    sirius_win_type_t win_type;
+    size_t cap;
+    uint64_t span;
+    /* timestamp, sample */
+    std::deque<std::pair<uint64_t, double>> q;
+
+    void expire(uint64_t now)
+    {
+        while (!(q.empty()) && q.front().first + span <= now) q.pop_front();
+    }
+
+    void push(uint64_t ts, double x)
+    {
+        if (SIRIUS_WIN_TYPE_TIME == win_type) expire(ts);
+        if (q.size() == cap) q.pop_front();
+        q.emplace_back(ts, x);
+    }
+
+    double percentile(double pct) const
+    {
+        std::vector<double> v;
+        for (auto &e : q) v.push_back(e.second);
+        std::sort(v.begin(), v.end());
+        size_t rank = (size_t)std::ceil(pct / 100 * (double)v.size());
+        rank = std::min(std::max(rank, (size_t)1), v.size());
+        return v[rank - 1];
+    }
+};
+
+sirius_win_handle
+i_cr(sirius_win_type_t win_type, size_t elem_nr, uint64_t span = 0)
+{
+    sirius_win_cr_t cr = {};
+    cr.win_type = win_type;
+    cr.elem_nr = elem_nr;
+    cr.span = span;
+    sirius_win_handle h = nullptr;
+    EXPECT_EQ(SIRIUS_OK, sirius_win_cr(&cr, &h));
+    return h;
+}
+
+void
+i_check(sirius_win_handle h, const i_ref_t &ref)
+{
+    sirius_win_res_t res = {};
+    ASSERT_EQ(SIRIUS_OK, sirius_win_get(h, &res));
+    ASSERT_EQ(ref.q.size(), res.count);
+    if (ref.q.empty()) {
+        EXPECT_TRUE(std::isnan(res.min));
+        EXPECT_TRUE(std::isnan(res.max));
+        EXPECT_EQ(0, res.sum);
+        return;
+    }
+
+    double mn = INFINITY, mx = -INFINITY, sum = 0;
+    for (auto &e : ref.q) {
+        mn = std::min(mn, e.second);
+        mx = std::max(mx, e.second);
+        sum += e.second;
+    }
+    EXPECT_EQ(mn, res.min);
+    EXPECT_EQ(mx, res.max);
+    EXPECT_NEAR(sum, res.sum, 1e-9 * (1 + std::fabs(sum)));
+    EXPECT_NEAR(sum / (double)ref.q.size(), res.avg,
+        1e-9 * (1 + std::fabs(sum)));
+
+    for (double pct : {0.0, 10.0, 50.0, 90.0, 99.0, 100.0}) {
+        double v = 0;
+        ASSERT_EQ(SIRIUS_OK, sirius_win_percentile(h, pct, &v));
+        EXPECT_EQ(ref.percentile(pct), v) << "q " << pct;
+    }
+}
+
+void
+i_ref_sliding(const std::vector<double> &in, size_t w, bool max,
+    std::vector<double> &out)
+{
+    out.resize(in.size());
+    for (size_t i = 0; i < in.size(); i++) {
+        size_t lo = i + 1 >= w ? i + 1 - w : 0;
+        double v = in[lo];
+        for (size_t j = lo + 1; j <= i; j++) {
+            v = max ? std::max(v, in[j]) : std::min(v, in[j]);
+        }
+        out[i] = v;
+    }
+}
+
+} // namespace
+
+TEST(SiriusWindow, Invalid)
+{
+    sirius_win_cr_t cr = {};
+    sirius_win_handle h = nullptr;
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_win_cr(nullptr, &h));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_win_cr(&cr, &h));
+    cr.elem_nr = 4;
+    cr.win_type = SIRIUS_WIN_TYPE_TIME;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_win_cr(&cr, &h));
+    cr.win_type = SIRIUS_WIN_TYPE_MAX;
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_win_cr(&cr, &h));
+
+    h = i_cr(SIRIUS_WIN_TYPE_TIME, 4, 10);
+    double x = 1, v = 0;
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER,
+        sirius_win_push_batch(h, nullptr, &x, 1));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER,
+        sirius_win_push_batch(h, nullptr, nullptr, 1));
+    EXPECT_EQ(SIRIUS_OK, sirius_win_push_batch(h, nullptr, nullptr, 0));
+    /* an empty window has no percentile */
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_win_percentile(h, 50, &v));
+    EXPECT_EQ(SIRIUS_OK, sirius_win_push(h, 1, 1));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_win_percentile(h, 101, &v));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER, sirius_win_percentile(h, NAN, &v));
+    EXPECT_EQ(SIRIUS_OK, sirius_win_del(h));
+
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_win_push(nullptr, 0, 1));
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER, sirius_win_del(nullptr));
+}
+
+TEST(SiriusWindow, Count)
+{
+    const size_t cap = 37;
+    sirius_win_handle h = i_cr(SIRIUS_WIN_TYPE_COUNT, cap);
+    i_ref_t ref = {SIRIUS_WIN_TYPE_COUNT, cap, 0, {}};
+    i_check(h, ref);
+
+    /* duplicates on purpose: the deques must keep ties in order */
+    std::mt19937_64 rng(3);
+    std::uniform_int_distribution<int> dist(-20, 20);
+    for (int i = 0; i < 2000; i++) {
+        double x = dist(rng) * 0.5;
+        ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, x));
+        ref.push(0, x);
+        if (0 == i % 7) i_check(h, ref);
+    }
+    i_check(h, ref);
+
+    EXPECT_EQ(SIRIUS_OK, sirius_win_reset(h));
+    ref.q.clear();
+    i_check(h, ref);
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, -3));
+    ref.push(0, -3);
+    i_check(h, ref);
+    EXPECT_EQ(SIRIUS_OK, sirius_win_del(h));
+}
+
+TEST(SiriusWindow, Monotonic)
+{
+    /* the worst cases of the deques, each wraps the ring many times */
+    const size_t cap = 8;
+    for (int shape = 0; shape < 4; shape++) {
+        sirius_win_handle h = i_cr(SIRIUS_WIN_TYPE_COUNT, cap);
+        i_ref_t ref = {SIRIUS_WIN_TYPE_COUNT, cap, 0, {}};
+        for (int i = 0; i < 100; i++) {
+            double x = 0 == shape ? i : 1 == shape ? -i :
+                2 == shape ? 5 : (i % 2 ? i : -i);
+            ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, x));
+            ref.push(0, x);
+            i_check(h, ref);
+        }
+        EXPECT_EQ(SIRIUS_OK, sirius_win_del(h));
+    }
+}
+
+TEST(SiriusWindow, Time)
+{
+    const uint64_t span = 100;
+    sirius_win_handle h = i_cr(SIRIUS_WIN_TYPE_TIME, 64, span);
+    i_ref_t ref = {SIRIUS_WIN_TYPE_TIME, 64, span, {}};
+
+    /* a sample is dropped once `ts + span <= now` */
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 1000, 1));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 1099, 2));
+    ref.push(1000, 1);
+    ref.push(1099, 2);
+    i_check(h, ref);
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 1100, 3));
+    ref.push(1100, 3);
+    i_check(h, ref);
+    EXPECT_EQ(2u, ref.q.size());
+
+    /* expire without a new sample */
+    EXPECT_EQ(SIRIUS_OK, sirius_win_expire(h, 1199));
+    ref.expire(1199);
+    i_check(h, ref);
+    EXPECT_EQ(1u, ref.q.size());
+    EXPECT_EQ(SIRIUS_OK, sirius_win_expire(h, 5000));
+    ref.expire(5000);
+    i_check(h, ref);
+
+    /* bursts of equal timestamps, gaps, and more samples than fit */
+    std::mt19937_64 rng(4);
+    std::uniform_int_distribution<int> gap(0, 30);
+    std::normal_distribution<double> dist(0, 10);
+    uint64_t ts = 6000;
+    for (int i = 0; i < 3000; i++) {
+        ts += 0 == i % 50 ? 500 : (uint64_t)(gap(rng) / 10);
+        double x = dist(rng);
+        ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, ts, x));
+        ref.push(ts, x);
+        if (0 == i % 11) i_check(h, ref);
+    }
+    i_check(h, ref);
+
+    /* a count window ignores expiry */
+    sirius_win_handle c = i_cr(SIRIUS_WIN_TYPE_COUNT, 4);
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(c, 1, 1));
+    EXPECT_EQ(SIRIUS_OK, sirius_win_expire(c, UINT64_MAX));
+    sirius_win_res_t res = {};
+    EXPECT_EQ(SIRIUS_OK, sirius_win_get(c, &res));
+    EXPECT_EQ(1u, res.count);
+
+    EXPECT_EQ(SIRIUS_OK, sirius_win_del(c));
+    EXPECT_EQ(SIRIUS_OK, sirius_win_del(h));
+}
+
+TEST(SiriusWindow, Batch)
+{
+    std::mt19937_64 rng(5);
+    std::uniform_real_distribution<double> dist(-1e3, 1e3);
+
+    for (sirius_win_type_t type :
+            {SIRIUS_WIN_TYPE_COUNT, SIRIUS_WIN_TYPE_TIME}) {
+        const size_t cap = 50;
+        sirius_win_handle h = i_cr(type, cap, 40);
+        i_ref_t ref = {type, cap, 40, {}};
+        uint64_t ts = 0;
+
+        /* shorter and longer than the window, the latter skips */
+        for (size_t n : {1, 7, 49, 50, 51, 333, 0, 12}) {
+            std::vector<uint64_t> t(n);
+            std::vector<double> x(n);
+            for (size_t i = 0; i < n; i++) {
+                ts += (rng() % 3);
+                t[i] = ts;
+                x[i] = dist(rng);
+                ref.push(t[i], x[i]);
+            }
+            ASSERT_EQ(SIRIUS_OK, sirius_win_push_batch(h,
+                SIRIUS_WIN_TYPE_TIME == type ? t.data() : nullptr,
+                x.data(), n));
+            SCOPED_TRACE(::testing::Message() << "type " << type
+                << " n " << n);
+            i_check(h, ref);
+        }
+        EXPECT_EQ(SIRIUS_OK, sirius_win_del(h));
+    }
+}
+
+TEST(SiriusWindow, NonFinite)
+{
+    sirius_win_handle h = i_cr(SIRIUS_WIN_TYPE_COUNT, 4);
+    sirius_win_res_t res = {};
+
+    /* the sum is IEEE while the specials are in the window */
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, INFINITY));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, 1));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_get(h, &res));
+    EXPECT_EQ(INFINITY, res.sum);
+    EXPECT_EQ(INFINITY, res.avg);
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, -INFINITY));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_get(h, &res));
+    EXPECT_TRUE(std::isnan(res.sum));
+
+    /* and back to finite once they have left */
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, 1));
+    }
+    ASSERT_EQ(SIRIUS_OK, sirius_win_get(h, &res));
+    EXPECT_EQ(4, res.sum);
+    EXPECT_EQ(1, res.avg);
+    EXPECT_EQ(1, res.min);
+    EXPECT_EQ(1, res.max);
+
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, NAN));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_get(h, &res));
+    EXPECT_TRUE(std::isnan(res.sum));
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, 2));
+    }
+    ASSERT_EQ(SIRIUS_OK, sirius_win_get(h, &res));
+    EXPECT_EQ(8, res.sum);
+
+    /* finite samples whose sum overflows */
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, 1e308));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, 1e308));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_get(h, &res));
+    EXPECT_EQ(INFINITY, res.sum);
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, -1e308));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, 5));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_get(h, &res));
+    EXPECT_EQ(INFINITY, res.sum);
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, 3));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_get(h, &res));
+    EXPECT_EQ(1e308 - 1e308 + 5 + 3, res.sum);
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, -1));
+    }
+    ASSERT_EQ(SIRIUS_OK, sirius_win_get(h, &res));
+    EXPECT_EQ(-4, res.sum);
+    EXPECT_EQ(-1, res.avg);
+
+    /* a reset forgets the specials */
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, INFINITY));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_reset(h));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_push(h, 0, 7));
+    ASSERT_EQ(SIRIUS_OK, sirius_win_get(h, &res));
+    EXPECT_EQ(7, res.sum);
+    EXPECT_EQ(SIRIUS_OK, sirius_win_del(h));
+}
+
+TEST(SiriusWindow, Sliding)
+{
+    std::mt19937_64 rng(6);
+    std::uniform_int_distribution<int> dist(-50, 50);
+
+    for (size_t n : {1, 2, 3, 10, 64, 257, 1000}) {
+        std::vector<double> in(n);
+        for (auto &v : in) v = dist(rng);
+
+        for (size_t w : {(size_t)1, (size_t)2, (size_t)3, (size_t)7,
+                (size_t)16, n - 1, n, n + 5}) {
+            if (0 == w) continue;
+            SCOPED_TRACE(::testing::Message() << "n " << n << " w " << w);
+            std::vector<double> out(n), want;
+
+            ASSERT_EQ(SIRIUS_OK,
+                sirius_win_sliding_max(in.data(), out.data(), n, w));
+            i_ref_sliding(in, w, true, want);
+            EXPECT_EQ(want, out);
+
+            ASSERT_EQ(SIRIUS_OK,
+                sirius_win_sliding_min(in.data(), out.data(), n, w));
+            i_ref_sliding(in, w, false, want);
+            EXPECT_EQ(want, out);
+        }
+    }
+
+    double x = 1, y = 0;
+    EXPECT_EQ(SIRIUS_ERR_NULL_POINTER,
+        sirius_win_sliding_max(nullptr, &y, 1, 1));
+    EXPECT_EQ(SIRIUS_ERR_INVALID_PARAMETER,
+        sirius_win_sliding_min(&x, &y, 1, 0));
+    EXPECT_EQ(SIRIUS_OK, sirius_win_sliding_max(&x, &y, 0, 3));
+}